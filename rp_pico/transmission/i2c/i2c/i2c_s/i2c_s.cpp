@@ -103,36 +103,43 @@ void I2c::WriteMem(uint8_t slave_addr, uint8_t memory_addr, uint8_t *output_data
 
 // ----ここから，スレーブ用の関数-----
 
-static std::deque<uint8_t> kInputData0(0);
-static std::deque<uint8_t> kOutputData0(0);
-static std::deque<uint8_t> kInputData1(0);
-static std::deque<uint8_t> kOutputData1(0);
+// 割り込み処理の中でメモリを確保しないように，容量が決まったリングバッファを使う
+static const std::size_t kSlaveBufferSize = 256;  // 一時保存できるデータの最大バイト数 (2の累乗)
+static RingBuffer<uint8_t, kSlaveBufferSize> kInputData0;
+static RingBuffer<uint8_t, kSlaveBufferSize> kOutputData0;
+static RingBuffer<uint8_t, kSlaveBufferSize> kInputData1;
+static RingBuffer<uint8_t, kSlaveBufferSize> kOutputData1;
 
 /*
 マスターからの受信があったとき，この関数が割り込み処理で実行される
 (メモリアドレスを受信しない)
 */
 static void I2cSlaveHandler(i2c_inst_t *i2c, i2c_slave_event_t event) {
-    std::deque<uint8_t> &input_data = (i2c == i2c1 ? kInputData1 : kInputData0);
-    std::deque<uint8_t> &output_data = (i2c == i2c1 ? kInputData1 : kInputData0);
+    RingBuffer<uint8_t, kSlaveBufferSize> &input_data = (i2c == i2c1 ? kInputData1 : kInputData0);
+    RingBuffer<uint8_t, kSlaveBufferSize> &output_data = (i2c == i2c1 ? kOutputData1 : kOutputData0);
     switch (event) {
         case I2C_SLAVE_RECEIVE: {  // マスターがデータを書き込んだとき
-            input_data.push_back(i2c_read_byte_raw(i2c));  // 読み込んだデータを保存
-            printf(" >%c", input_data.back());
+            uint8_t byte = i2c_read_byte_raw(i2c);
+            if (input_data.Push(byte)) {  // 読み込んだデータを保存
+                I2cTrace(kI2cTraceReceive, byte);  // printfは時間がかかるので，記録だけしてメインループで表示する (PrintI2cTrace)
+            } else {
+                // エラー  受信したデータを保存する場所がありません (データは捨てられます)
+            }
             break;
         }
         case I2C_SLAVE_REQUEST: {  // マスターがデータを要求しているとき
-            if (output_data.size()) {
-                i2c_write_byte_raw(i2c, output_data.front());  // データを送信
-                printf(" <%c", output_data.front());
-                output_data.pop_front();
+            uint8_t byte;
+            if (output_data.Pop(byte)) {
+                i2c_write_byte_raw(i2c, byte);  // データを送信
+                I2cTrace(kI2cTraceRequest, byte);
             } else {
                 // エラー  マスターからデータ送信のリクエストが来ていますが，送信できるデータがありません
+                I2cTrace(kI2cTraceEmpty);
             }
         break;
         }
         case I2C_SLAVE_FINISH: {  // マスターが停止／再起動の信号を送信したとき
-            printf("\n");
+            I2cTrace(kI2cTraceFinish);
             break;
         }
         default: {
@@ -144,41 +151,33 @@ static void I2cSlaveHandler(i2c_inst_t *i2c, i2c_slave_event_t event) {
 // すでに受信した，読み取り可能なデータのバイト数を返す
 std::size_t I2c::DataReceivable() {
     if (i2c_id_) {
-        return kInputData1.size();
+        return kInputData1.Size();
     } else {
-        return kInputData0.size();
+        return kInputData0.Size();
     }
     
 }
 
 //  マスターから受信し，一時保存してあったたデータを読み取る
 std::size_t I2c::GetInputData(uint8_t *input_data, std::size_t input_data_bytes) {
-    int i = 0;
-    if (i2c_id_) {
-        while (kInputData1.size() && i < input_data_bytes) {
-            input_data[i++] = kInputData1.front();
-            kInputData1.pop_front();
-        }
-    } else {
-        while (kInputData0.size() && i < input_data_bytes) {
-            input_data[i++] = kInputData0.front();
-            kInputData0.pop_front();
-        }
+    RingBuffer<uint8_t, kSlaveBufferSize> &buffer = (i2c_id_ ? kInputData1 : kInputData0);
+    std::size_t i = 0;
+    while (i < input_data_bytes && buffer.Pop(input_data[i])) {
+        ++i;
     }
     return i;
 }
 
 //  マスターに送信するためのデータをセットする
+//  一時保存できる量を超えた分のデータは捨てられます
 void I2c::SetOutputData(uint8_t *output_data, std::size_t output_data_bytes) {
-    int i = 0;
-    if (i2c_id_) {
-        while (i < output_data_bytes) {
-            kOutputData1.push_back(output_data[i++]);
-        }
-    } else {
-        while (i <  output_data_bytes) {
-            kOutputData0.push_back(output_data[i++]);
-        }
+    RingBuffer<uint8_t, kSlaveBufferSize> &buffer = (i2c_id_ ? kOutputData1 : kOutputData0);
+    std::size_t i = 0;
+    while (i < output_data_bytes && buffer.Push(output_data[i])) {
+        ++i;
+    }
+    if (i < output_data_bytes) {
+        // エラー  送信するデータを保存する場所がありません
     }
 }
 
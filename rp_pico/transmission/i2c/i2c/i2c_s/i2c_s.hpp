@@ -2,12 +2,14 @@
 #define GENERIC_EXAMPLE_RP_PICO_TRANSMISSION_I2C_S_HPP_
 
 #include <stdio.h>
-#include <deque>
 
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 #include "pico/i2c_slave.h"
 
+#include "ring_buffer.hpp"
+#include "i2c_trace.hpp"
+
 /*
 -----I2C通信とは-----
 I2C通信は1台のマスターと複数台のスレーブの間の通信です．
@@ -0,0 +1,76 @@
+#ifndef GENERIC_EXAMPLE_RP_PICO_TRANSMISSION_RING_BUFFER_HPP_
+#define GENERIC_EXAMPLE_RP_PICO_TRANSMISSION_RING_BUFFER_HPP_
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * 割り込み処理とメインループの間でデータを受け渡すためのリングバッファです
+ * 書き込む側(Push)と読み込む側(Pop)がそれぞれ一つだけの場合に，割り込みを禁止せずに使えます
+ * メモリを確保し直さないため，割り込み処理の中で使っても処理時間が一定です
+ * kCapacity は2の累乗である必要があります (インデックスの計算を余りの代わりにビット演算で行うため)
+*/
+template<typename T, std::size_t kCapacity>
+class RingBuffer {
+    static_assert(kCapacity && !(kCapacity & (kCapacity - 1)), "RingBuffer capacity must be a power of two");  // 容量は2の累乗である必要があります
+
+  private:
+    static const std::size_t kMask = kCapacity - 1;
+
+    T data_[kCapacity];
+    std::atomic<std::size_t> head_{0};  // 次に書き込む位置 (書き込む側だけが変更する)  オーバーフローしてもかまわない
+    std::atomic<std::size_t> tail_{0};  // 次に読み込む位置 (読み込む側だけが変更する)  オーバーフローしてもかまわない
+
+  public:
+    RingBuffer() = default;
+
+    /*!
+    \brief 読み書きする位置の初期値を指定する  (テスト用)
+    \param start_index 位置の初期値  SIZE_MAXの近くにすると，インデックスのオーバーフローを短い時間で試せる
+    */
+    explicit RingBuffer(std::size_t start_index) : head_(start_index), tail_(start_index) {}
+
+    /*!
+    \brief データを一つ書き込む  (書き込む側からのみ呼び出す)
+    \param value 書き込むデータ
+    \return 書き込めたか  いっぱいの場合はfalse
+    */
+    bool Push(const T &value) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= kCapacity) return false;  // いっぱい
+        data_[head & kMask] = value;
+        head_.store(head + 1, std::memory_order_release);  // データを書き込んでから位置を進める
+        return true;
+    }
+
+    /*!
+    \brief データを一つ読み込む  (読み込む側からのみ呼び出す)
+    \param value 読み込んだデータを保存する変数
+    \return 読み込めたか  空の場合はfalse
+    */
+    bool Pop(T &value) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (head_.load(std::memory_order_acquire) == tail) return false;  // 空
+        value = data_[tail & kMask];
+        tail_.store(tail + 1, std::memory_order_release);  // データを読み込んでから位置を進める
+        return true;
+    }
+
+    //! \brief 読み込めるデータの数
+    std::size_t Size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    //! \brief 空か
+    bool Empty() const {return Size() == 0;}
+
+    //! \brief 最大で何個のデータを保存できるか
+    static constexpr std::size_t Capacity() {return kCapacity;}
+};
+
+/*
+このプログラムの作成にあたり以下を参考にしました
+https://en.cppreference.com/w/cpp/atomic/memory_order
+*/
+
+#endif
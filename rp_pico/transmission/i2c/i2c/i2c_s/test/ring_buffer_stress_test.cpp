@@ -0,0 +1,149 @@
+// RingBufferのストレステスト
+// 割り込み処理の代わりのスレッドが書き込み(Push)，メインスレッドが読み込み(Pop)を同時に行い，
+// データが欠けたり，順番が入れ替わったり，書きかけのまま読み込まれたりしないことを確認する
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+#include "ring_buffer.hpp"
+
+namespace {
+
+// 書きかけのまま読み込まれたことを見つけるため，2つの値の組を受け渡す
+struct Sample {
+    uint32_t seq;  // 何番目のデータか
+    uint32_t inverted;  // seqのビットを反転した値
+};
+
+int failures = 0;
+
+void Check(bool ok, const char *message) {
+    if (ok) return;
+    std::printf("FAILED  %s\n", message);
+    ++failures;
+}
+
+/*!
+\brief 書き込む側がいっぱいの間待つ場合  すべてのデータが順番どおりに届くことを確認する
+\param count 受け渡すデータの数
+*/
+void TestLossless(uint32_t count) {
+    RingBuffer<Sample, 64> buffer;
+    std::thread interrupt([&] {
+        for (uint32_t seq = 0; seq < count; ) {
+            if (buffer.Push(Sample{seq, ~seq})) ++seq;
+            else std::this_thread::yield();
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t expected = 0;
+    bool ordered = true, intact = true, bounded = true;
+    while (expected < count) {
+        bounded &= (buffer.Size() <= buffer.Capacity());
+        Sample sample;
+        if (!buffer.Pop(sample)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered &= (sample.seq == expected);
+        intact &= (sample.inverted == ~sample.seq);
+        ++expected;
+    }
+    interrupt.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("lossless: %u items, %.1f Mitems/s\n", static_cast<unsigned>(count), count / seconds / 1e6);
+    Check(ordered, "lossless: items arrived out of order or were lost");
+    Check(intact, "lossless: an item was read before it was completely written");
+    Check(bounded, "lossless: Size() exceeded Capacity()");
+    Check(buffer.Empty(), "lossless: buffer is not empty after draining");
+}
+
+/*!
+\brief 割り込み処理と同じく，書き込む側が待たずにいっぱいのときは捨てる場合
+\brief 届いたデータは順番どおりで，届いた数と捨てた数の合計が書き込もうとした数と一致することを確認する
+\param count 書き込もうとするデータの数
+*/
+void TestDropWhenFull(uint32_t count) {
+    RingBuffer<Sample, 16> buffer;
+    std::atomic<bool> done{false};
+    uint32_t dropped = 0;
+    std::thread interrupt([&] {
+        uint32_t seq = 0;
+        while (seq < count) {
+            // 割り込みが続けて起きたように，数個ずつまとめて書き込む  読み込む側を待たないので，読み込みが遅れるといっぱいになる
+            for (uint32_t burst = seq % 7 + 1; burst && seq < count; --burst, ++seq)
+                if (!buffer.Push(Sample{seq, ~seq})) ++dropped;
+            if (seq % 4096 < 8) std::this_thread::yield();
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    uint32_t received = 0;
+    int64_t last = -1;
+    bool ordered = true, intact = true;
+    for (;;) {
+        bool finished = done.load(std::memory_order_acquire);  // 先に読み込み，その後に残りをすべて取り出す
+        Sample sample;
+        // 終わるまでは1回に3個ずつしか取り出さず，書き込む側より遅いメインループにする
+        for (int n = 0; (finished || n < 3) && buffer.Pop(sample); ++n) {
+            ordered &= (static_cast<int64_t>(sample.seq) > last);
+            intact &= (sample.inverted == ~sample.seq);
+            last = sample.seq;
+            ++received;
+        }
+        if (finished) break;
+        std::this_thread::yield();
+    }
+    interrupt.join();
+
+    std::printf("drop when full: %u items, %u received, %u dropped\n", static_cast<unsigned>(count), static_cast<unsigned>(received), static_cast<unsigned>(dropped));
+    Check(ordered, "drop when full: items arrived out of order");
+    Check(intact, "drop when full: an item was read before it was completely written");
+    Check(received + dropped == count, "drop when full: received + dropped does not match the number of pushes");
+    Check(dropped > 0, "drop when full: the buffer never became full");
+}
+
+}  // namespace
+
+int main() {
+    TestLossless(2000000);
+    TestDropWhenFull(2000000);
+
+    // 何度も書き込みと読み込みを繰り返しても使い続けられる
+    RingBuffer<uint8_t, 4> small;
+    uint8_t value = 0;
+    bool repeats = true;
+    for (uint32_t i = 0; i < 100000; ++i) {
+        repeats &= small.Push(static_cast<uint8_t>(i)) && small.Pop(value) && value == static_cast<uint8_t>(i);
+    }
+    for (uint8_t i = 0; i < 4; ++i) repeats &= small.Push(i);
+    repeats &= !small.Push(4) && small.Size() == 4;
+    Check(repeats, "small buffer: repeated push/pop or full detection failed");
+
+    // インデックスがSIZE_MAXを越えて0に戻っても使い続けられる  (実機で何年も動かした後と同じ状態から始める)
+    // いっぱい・空の判定と Size() が，書き込む位置だけが0に戻った間も正しいことを確認する
+    bool wraps = true;
+    for (std::size_t before = 0; before <= 4; ++before) {
+        RingBuffer<uint8_t, 4> near_max(SIZE_MAX - before);
+        for (uint8_t i = 0; i < 4; ++i) wraps &= near_max.Push(i) && near_max.Size() == i + 1u;
+        wraps &= !near_max.Push(4) && near_max.Size() == 4;  // 位置の差は4のまま
+        for (uint8_t i = 0; i < 4; ++i) wraps &= near_max.Pop(value) && value == i;
+        wraps &= near_max.Empty() && !near_max.Pop(value);
+        for (uint32_t i = 0; i < 20; ++i) {
+            wraps &= near_max.Push(static_cast<uint8_t>(i)) && near_max.Push(static_cast<uint8_t>(i + 100));
+            wraps &= near_max.Pop(value) && value == static_cast<uint8_t>(i) && near_max.Pop(value) && value == static_cast<uint8_t>(i + 100);
+        }
+    }
+    Check(wraps, "small buffer: push/pop across the SIZE_MAX index wrap-around failed");
+
+    if (failures) {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -8,6 +8,8 @@
 #include "hardware/i2c.h"
 #include "pico/i2c_slave.h"
 
+#include "i2c_trace.hpp"
+
 void SetupI2c(bool, uint32_t, std::initializer_list<uint8_t>);
 
 void ReadI2c(bool, uint8_t, uint8_t*, size_t, uint8_t);
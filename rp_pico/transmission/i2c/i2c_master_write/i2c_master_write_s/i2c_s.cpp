@@ -163,10 +163,11 @@ static void I2cSlaveHandler(i2c_inst_t *i2c, i2c_slave_event_t event) {
             // 最初にレジスタアドレスが書き込まれるので，記録する
             kI2cSlaveMemoryAddr = i2c_read_byte_raw(i2c);
             kI2cSlaveMemoryAddrWritten = true;
+            I2cTrace(kI2cTraceAddress, kI2cSlaveMemoryAddr);
         } else {
             // マスターがデータを送信したい場合
             *(kI2cSlaveMemory + kI2cSlaveMemoryAddr) = i2c_read_byte_raw(i2c);  // 初めに記録したレジスタアドレスのメモリに，受信した内容を記録する
-            printf(">%c", *(kI2cSlaveMemory + kI2cSlaveMemoryAddr));
+            I2cTrace(kI2cTraceReceive, *(kI2cSlaveMemory + kI2cSlaveMemoryAddr));  // printfは時間がかかるので，記録だけしてメインループで表示する (PrintI2cTrace)
             ++kI2cSlaveMemoryAddr;
         }
         break;
@@ -174,13 +175,14 @@ static void I2cSlaveHandler(i2c_inst_t *i2c, i2c_slave_event_t event) {
       case I2C_SLAVE_REQUEST: {  // マスターがデータを要求しているとき
         // マスターがデータを受信したい場合
         i2c_write_byte_raw(i2c, *(kI2cSlaveMemory + kI2cSlaveMemoryAddr));  // 初めに記録したレジスタアドレスのメモリの内容を送信する．
-        printf("<%c", *(kI2cSlaveMemory + kI2cSlaveMemoryAddr));
+        I2cTrace(kI2cTraceRequest, *(kI2cSlaveMemory + kI2cSlaveMemoryAddr));
         ++kI2cSlaveMemoryAddr;
         break;
       }
       case I2C_SLAVE_FINISH: {  // マスターが停止／再起動の信号を送信したとき
         // レジスタアドレスをリセットする
         kI2cSlaveMemoryAddrWritten = false;
+        I2cTrace(kI2cTraceFinish);
         break;
       }
       default: {
@@ -203,19 +205,20 @@ static void I2cSlaveHandler_Direct(i2c_inst_t *i2c, i2c_slave_event_t event) {
       case I2C_SLAVE_RECEIVE: {  // マスターがデータを書き込んだとき
         kInputData[kI2cSlaveMemoryAddr] = i2c_read_byte_raw(i2c);  // 初めに記録したレジスタアドレスのメモリに，受信した内容を記録する
         read = true;
-        printf(">%c", kInputData[kI2cSlaveMemoryAddr]);
+        I2cTrace(kI2cTraceReceive, kInputData[kI2cSlaveMemoryAddr]);  // printfは時間がかかるので，記録だけしてメインループで表示する (PrintI2cTrace)
         ++kI2cSlaveMemoryAddr;
         break;
       }
       case I2C_SLAVE_REQUEST: {  // マスターがデータを要求しているとき
         i2c_write_byte_raw(i2c, kOutputData[kI2cSlaveMemoryAddr]);  // 初めに記録したレジスタアドレスのメモリの内容を送信する．
-        printf("<%c", kOutputData[kI2cSlaveMemoryAddr]);
+        I2cTrace(kI2cTraceRequest, kOutputData[kI2cSlaveMemoryAddr]);
         ++kI2cSlaveMemoryAddr;
         break;
       }
       case I2C_SLAVE_FINISH: {  // マスターが停止／再起動の信号を送信したとき
         if(read) for (int i = kI2cSlaveMemoryAddr, len = sizeof(kInputData) / sizeof(*kInputData); i < len; ++i) kInputData[i] = 0;  // InputDataの最後は0で埋める
         kI2cSlaveMemoryAddr = 0x00;  // レジスタアドレスを0にリセットする
+        I2cTrace(kI2cTraceFinish);
         break;
       }
       default: {
@@ -163,10 +163,11 @@ static void I2cSlaveHandler(i2c_inst_t *i2c, i2c_slave_event_t event) {
             // 最初にレジスタアドレスが書き込まれるので，記録する
             kI2cSlaveMemoryAddr = i2c_read_byte_raw(i2c);
             kI2cSlaveMemoryAddrWritten = true;
+            I2cTrace(kI2cTraceAddress, kI2cSlaveMemoryAddr);
         } else {
             // マスターがデータを送信したい場合
             *(kI2cSlaveMemory + kI2cSlaveMemoryAddr) = i2c_read_byte_raw(i2c);  // 初めに記録したレジスタアドレスのメモリに，受信した内容を記録する
-            printf(">%c", *(kI2cSlaveMemory + kI2cSlaveMemoryAddr));
+            I2cTrace(kI2cTraceReceive, *(kI2cSlaveMemory + kI2cSlaveMemoryAddr));  // printfは時間がかかるので，記録だけしてメインループで表示する (PrintI2cTrace)
             ++kI2cSlaveMemoryAddr;
         }
         break;
@@ -174,13 +175,14 @@ static void I2cSlaveHandler(i2c_inst_t *i2c, i2c_slave_event_t event) {
       case I2C_SLAVE_REQUEST: {  // マスターがデータを要求しているとき
         // マスターがデータを受信したい場合
         i2c_write_byte_raw(i2c, *(kI2cSlaveMemory + kI2cSlaveMemoryAddr));  // 初めに記録したレジスタアドレスのメモリの内容を送信する．
-        printf("<%c", *(kI2cSlaveMemory + kI2cSlaveMemoryAddr));
+        I2cTrace(kI2cTraceRequest, *(kI2cSlaveMemory + kI2cSlaveMemoryAddr));
         ++kI2cSlaveMemoryAddr;
         break;
       }
       case I2C_SLAVE_FINISH: {  // マスターが停止／再起動の信号を送信したとき
         // レジスタアドレスをリセットする
         kI2cSlaveMemoryAddrWritten = false;
+        I2cTrace(kI2cTraceFinish);
         break;
       }
       default: {
@@ -203,19 +205,20 @@ static void I2cSlaveHandler_Direct(i2c_inst_t *i2c, i2c_slave_event_t event) {
       case I2C_SLAVE_RECEIVE: {  // マスターがデータを書き込んだとき
         kInputData[kI2cSlaveMemoryAddr] = i2c_read_byte_raw(i2c);  // 初めに記録したレジスタアドレスのメモリに，受信した内容を記録する
         read = true;
-        printf(">%c", kInputData[kI2cSlaveMemoryAddr]);
+        I2cTrace(kI2cTraceReceive, kInputData[kI2cSlaveMemoryAddr]);  // printfは時間がかかるので，記録だけしてメインループで表示する (PrintI2cTrace)
         ++kI2cSlaveMemoryAddr;
         break;
       }
       case I2C_SLAVE_REQUEST: {  // マスターがデータを要求しているとき
         i2c_write_byte_raw(i2c, kOutputData[kI2cSlaveMemoryAddr]);  // 初めに記録したレジスタアドレスのメモリの内容を送信する．
-        printf("<%c", kOutputData[kI2cSlaveMemoryAddr]);
+        I2cTrace(kI2cTraceRequest, kOutputData[kI2cSlaveMemoryAddr]);
         ++kI2cSlaveMemoryAddr;
         break;
       }
       case I2C_SLAVE_FINISH: {  // マスターが停止／再起動の信号を送信したとき
         if(read) for (int i = kI2cSlaveMemoryAddr, len = sizeof(kInputData) / sizeof(*kInputData); i < len; ++i) kInputData[i] = 0;  // InputDataの最後は0で埋める
         kI2cSlaveMemoryAddr = 0x00;  // レジスタアドレスを0にリセットする
+        I2cTrace(kI2cTraceFinish);
         break;
       }
       default: {
@@ -284,6 +287,198 @@ void SetupI2cSlave_Direct(bool i2c_num, uint32_t i2c_baud_rate, std::initializer
     sleep_ms(10);  // 要検証
 }
 
+// ----ここから，レジスタマップ(ダブルバッファ)を使うスレーブ用の関数-----
+
+/*
+SetupI2cSlave ではマスターが読み込んでいる途中にメインループが配列を書き換えると，
+複数バイトの値の前半が古い値，後半が新しい値になることがあります．
+そこで，マスターが読み込む面(表)と，メインループが次の値を用意する面(裏)の二つの配列を用意し，
+通信の区切り(停止／再起動の信号)でのみ表と裏を入れ替えることで，マスターは常に揃った値を読み込めるようにします．
+*/
+
+const std::size_t kRegisterMapSize = 256;  // レジスタの数 (レジスタアドレスは8bitなので256)
+const std::size_t kRegisterMapBlockSize = 16;  // 変更されたかを記録する単位のバイト数
+const std::size_t kRegisterMapBlocks = kRegisterMapSize / kRegisterMapBlockSize;
+
+// I2Cごとのレジスタマップの状態
+struct RegisterMap {
+    uint8_t *memory;  // メインループが書き換える配列 (ユーザーが用意したもの)
+    uint8_t banks[2][kRegisterMapSize];  // マスターが読み込む面と，次の値を用意する面
+    volatile uint8_t front;  // マスターが読み込んでいる面の番号
+    volatile bool swap_requested;  // 次の通信の区切りで表と裏を入れ替えるか
+    uint16_t dirty;  // メインループが書き換えた，まだ裏に写していないブロック (1bitが1ブロック)
+    uint16_t copied;  // 前回入れ替えてから裏に写したブロック
+    uint16_t stale;  // 裏が古いままになっているブロック (入れ替え前の表に写していなかったもの)
+    volatile uint16_t received;  // マスターが書き込んだブロック  割り込み処理からのみ立てる
+    uint8_t memory_addr;  // レジスタアドレス（配列のインデックス）
+    bool memory_addr_written;  // 最初に受信するはずのレジスタアドレスをすでに受信したか
+};
+static RegisterMap kRegisterMaps[2];
+
+// レジスタアドレスの範囲に含まれるブロックを表すビットを返す
+static inline uint16_t RegisterMapBlocks(uint8_t reg, std::size_t len) {
+    if (!len) return 0;
+    std::size_t first = reg / kRegisterMapBlockSize;
+    std::size_t last = (reg + len - 1) / kRegisterMapBlockSize;
+    if (last >= kRegisterMapBlocks) last = kRegisterMapBlocks - 1;
+    return (uint16_t)(((1u << (last + 1)) - 1) & ~((1u << first) - 1));
+}
+
+/*
+マスターからの受信があったとき，この関数が割り込み処理で実行される
+(レジスタアドレスを受信する  マスターへは表の面から送信する)
+*/
+static void I2cSlaveHandler_RegisterMap(i2c_inst_t *i2c, i2c_slave_event_t event) {
+    RegisterMap &map = kRegisterMaps[i2c == i2c1];
+
+    switch (event) {
+      case I2C_SLAVE_RECEIVE: {  // マスターがデータを書き込んだとき
+        if (!map.memory_addr_written) {
+            // 最初にレジスタアドレスが書き込まれるので，記録する
+            map.memory_addr = i2c_read_byte_raw(i2c);
+            map.memory_addr_written = true;
+            I2cTrace(kI2cTraceAddress, map.memory_addr);
+        } else {
+            // マスターが書き込んだ値は，メインループの配列と表の面に記録し，次のPublishI2cSlaveで裏の面にも写す
+            uint8_t byte = i2c_read_byte_raw(i2c);
+            map.memory[map.memory_addr] = byte;
+            map.banks[map.front][map.memory_addr] = byte;
+            map.received = map.received | (1u << (map.memory_addr / kRegisterMapBlockSize));
+            I2cTrace(kI2cTraceReceive, byte);
+            ++map.memory_addr;
+        }
+        break;
+      }
+      case I2C_SLAVE_REQUEST: {  // マスターがデータを要求しているとき
+        uint8_t byte = map.banks[map.front][map.memory_addr];  // 表の面から送信する (通信の途中で入れ替わることはない)
+        i2c_write_byte_raw(i2c, byte);
+        I2cTrace(kI2cTraceRequest, byte);
+        ++map.memory_addr;
+        break;
+      }
+      case I2C_SLAVE_FINISH: {  // マスターが停止／再起動の信号を送信したとき
+        // 通信の区切りなので，値が用意されていれば表と裏を入れ替える
+        if (map.swap_requested) {
+            map.front = !map.front;
+            map.stale = map.copied;  // 入れ替え前の表(新しい裏)には，前回写したブロックが反映されていない
+            map.copied = 0;
+            map.swap_requested = false;
+        }
+        map.memory_addr_written = false;  // レジスタアドレスをリセットする
+        I2cTrace(kI2cTraceFinish);
+        break;
+      }
+      default: {
+        break;
+      }
+    }
+}
+
+/*
+I2Cをスレーブとしてセットアップする (送受信にレジスタアドレスを使用し，読み込み中の値が途中で変わらないようにする)
+memoryの内容はPublishI2cSlaveを呼び出すまでマスターから読み込まれません
+マスターが読み込んでいる間は古い値を送信し続け，通信の区切りで新しい値に切り替えます
+i2c_num : i2c0かi2c12か
+i2c_baud_rate : 通信速度  Hz  通常は400kHz以下を使う
+i2c_gpios : i2cのSDAとSCLのピン番号，{ }の中に入れて，{SDA,SCL}の順番で並べて書く
+i2c_slave_addr : 自身のスレーブアドレス
+memory : グローバル変数!!  入出力するデータを保存しておく配列へのポインタ  256バイト
+*/
+void SetupI2cSlave_RegisterMap(bool i2c_num, uint32_t i2c_baud_rate, std::initializer_list<uint8_t> i2c_gpios, uint8_t i2c_slave_addr, uint8_t *memory) {
+    RegisterMap &map = kRegisterMaps[i2c_num];
+    map.memory = memory;
+    for (std::size_t i = 0; i < kRegisterMapSize; ++i) {
+        map.banks[0][i] = map.banks[1][i] = memory[i];  // 最初は両方の面を同じ値にしておく
+    }
+    map.front = 0;
+    map.swap_requested = false;
+    map.dirty = map.copied = map.stale = map.received = 0;
+    map.memory_addr = 0x00;
+    map.memory_addr_written = false;
+
+    for (uint8_t i2c_gpio : i2c_gpios) {
+        gpio_init(i2c_gpio);
+        gpio_set_function(i2c_gpio, GPIO_FUNC_I2C);
+        gpio_pull_up(i2c_gpio);
+    }
+
+    if (i2c_num) {
+        i2c_init(i2c1, i2c_baud_rate);
+        i2c_slave_init(i2c1, i2c_slave_addr, &I2cSlaveHandler_RegisterMap);
+    } else {
+        i2c_init(i2c0, i2c_baud_rate);
+        i2c_slave_init(i2c0, i2c_slave_addr, &I2cSlaveHandler_RegisterMap);
+    }
+
+    sleep_ms(10);  // 要検証
+}
+
+/*
+SetupI2cSlave_RegisterMapで渡した配列を書き換え，書き換えた範囲を記録する
+書き換えた値は，PublishI2cSlaveを呼び出すまでマスターから読み込まれません
+i2c_num : i2c0かi2c1か
+reg : 書き換えるレジスタアドレス (配列のインデックス)
+data : 書き込むデータ  配列の先頭へのポインタ
+len : 何バイト(文字)書き込むか
+*/
+void WriteI2cSlave(bool i2c_num, uint8_t reg, const uint8_t *data, size_t len) {
+    RegisterMap &map = kRegisterMaps[i2c_num];
+    if (len > kRegisterMapSize - reg) len = kRegisterMapSize - reg;  // 配列の外には書き込まない
+    for (std::size_t i = 0; i < len; ++i) {
+        map.memory[reg + i] = data[i];
+    }
+    map.dirty |= RegisterMapBlocks(reg, len);
+}
+
+/*
+配列を直接書き換えた場合に，書き換えた範囲を記録する
+i2c_num : i2c0かi2c1か
+reg : 書き換えたレジスタアドレス (配列のインデックス)
+len : 何バイト(文字)書き換えたか
+*/
+void MarkI2cSlaveDirty(bool i2c_num, uint8_t reg, size_t len) {
+    kRegisterMaps[i2c_num].dirty |= RegisterMapBlocks(reg, len);
+}
+
+/*
+書き換えた値をマスターから読み込めるようにする
+書き換えたブロックだけを裏の面に写し，次の通信の区切りで表と裏を入れ替えます
+(マスターが通信していなければ，次の通信の始まりで入れ替わります)
+割り込みを禁止する必要はありません
+i2c_num : i2c0かi2c1か
+*/
+void PublishI2cSlave(bool i2c_num) {
+    RegisterMap &map = kRegisterMaps[i2c_num];
+
+    // 裏の面に写している間に入れ替わらないように，入れ替えの予約を取り消す
+    // (割り込み処理はメインループに割り込むだけなので，これ以降はfrontとstaleは変化しない)
+    map.swap_requested = false;
+    __compiler_memory_barrier();
+
+    // マスターが書き込んだブロックを受け取る (割り込み処理と同時に書き換えないように，この2行の間だけ割り込みを禁止する)
+    uint32_t status = save_and_disable_interrupts();
+    uint16_t received = map.received;
+    map.received = 0;
+    restore_interrupts(status);
+
+    uint16_t blocks = map.dirty | map.stale | received;
+    if (!blocks && !map.copied) return;  // 何も変わっていない
+
+    uint8_t *back = map.banks[!map.front];
+    for (std::size_t block = 0; block < kRegisterMapBlocks; ++block) {
+        if (!(blocks & (1u << block))) continue;
+        for (std::size_t i = block * kRegisterMapBlockSize, end = i + kRegisterMapBlockSize; i < end; ++i) {
+            back[i] = map.memory[i];
+        }
+    }
+    map.copied |= blocks;
+    map.dirty = 0;
+    map.stale = 0;
+
+    __compiler_memory_barrier();
+    map.swap_requested = true;  // 写し終わってから入れ替えを予約する
+}
+
 /*
 このプログラムの作成にあたり以下を参考にしました
 https://stemship.com/arduino-beginner-i2c/
@@ -8,6 +8,8 @@
 #include "hardware/i2c.h"
 #include "pico/i2c_slave.h"
 
+#include "i2c_trace.hpp"
+
 void SetupI2c(bool, uint32_t, std::initializer_list<uint8_t>);
 
 void ReadI2c(bool, uint8_t, uint8_t*, size_t, uint8_t);
@@ -18,4 +20,9 @@ void WriteI2c_Direct(bool, uint8_t, uint8_t*, size_t);
 void SetupI2cSlave(bool, uint32_t, std::initializer_list<uint8_t>, uint8_t, uint8_t*);
 void SetupI2cSlave_Direct(bool, uint32_t, std::initializer_list<uint8_t>, uint8_t, uint8_t*, uint8_t*);
 
+void SetupI2cSlave_RegisterMap(bool, uint32_t, std::initializer_list<uint8_t>, uint8_t, uint8_t*);
+void WriteI2cSlave(bool, uint8_t, const uint8_t*, size_t);
+void MarkI2cSlaveDirty(bool, uint8_t, size_t);
+void PublishI2cSlave(bool);
+
 #endif
\ No newline at end of file
@@ -48,6 +48,9 @@ void loop() {
     // 入力データkI2cInputDataは入力を受けたときに勝手に更新されます
     // ここで，入力データを読み取り，利用してください
     // 出力データの更新も行えます
+
+    // 割り込み処理で記録した送受信の内容を表示する
+    PrintI2cTrace();
 }
 
 int main() {
@@ -0,0 +1,73 @@
+#include "i2c_trace.hpp"
+
+/*
+割り込み処理の中で送受信したデータを記録し，後からメインループで表示するための関数です
+*/
+
+static RingBuffer<I2cTraceRecord, kI2cTraceSize> kI2cTraceRecords;  // 表示されていない記録
+static uint32_t kI2cTraceLastTime = 0;  // 前の記録の時刻 (μs)  割り込み処理からのみ変更する
+static volatile uint32_t kI2cTraceDropped = 0;  // 記録がいっぱいで捨てられた数  割り込み処理からのみ変更する
+
+/*
+送受信したデータを記録する  (割り込み処理の中で呼び出す)
+記録がいっぱいの場合は捨てられ，捨てられた数が数えられます
+同じ優先度の割り込み処理(I2C0とI2C1の割り込みなど)からのみ呼び出してください
+event : 出来事の種類
+byte : 送受信したデータ
+*/
+void I2cTrace(I2cTraceEvent event, uint8_t byte) {
+    uint32_t now = time_us_32();
+    uint32_t time_delta = now - kI2cTraceLastTime;  // 符号なしの引き算なので，時刻がオーバーフローしても正しく計算できる
+    kI2cTraceLastTime = now;
+
+    I2cTraceRecord record;
+    record.event = event;
+    record.byte = byte;
+    record.time_delta = (time_delta > 0xffff ? 0xffff : time_delta);
+    if (!kI2cTraceRecords.Push(record)) {
+        kI2cTraceDropped = kI2cTraceDropped + 1;
+    }
+}
+
+/*
+記録したデータを読み取り，標準出力に表示する  (メインループで呼び出す)
+戻り値 : 表示した記録の数
+*/
+std::size_t PrintI2cTrace() {
+    std::size_t count = 0;
+    I2cTraceRecord record;
+    while (kI2cTraceRecords.Pop(record)) {
+        switch (record.event) {
+            case kI2cTraceReceive: {
+                printf(" >%c(+%uus)", record.byte, record.time_delta);
+                break;
+            }
+            case kI2cTraceRequest: {
+                printf(" <%c(+%uus)", record.byte, record.time_delta);
+                break;
+            }
+            case kI2cTraceAddress: {
+                printf(" @0x%02x(+%uus)", record.byte, record.time_delta);
+                break;
+            }
+            case kI2cTraceFinish: {
+                printf(" /(+%uus)\n", record.time_delta);
+                break;
+            }
+            case kI2cTraceEmpty: {
+                printf(" <!(+%uus)", record.time_delta);  // 送信できるデータがなかった
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+        ++count;
+    }
+    return count;
+}
+
+// 記録がいっぱいで捨てられた数
+uint32_t I2cTraceDropped() {
+    return kI2cTraceDropped;
+}
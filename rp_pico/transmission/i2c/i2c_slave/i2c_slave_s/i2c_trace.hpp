@@ -0,0 +1,52 @@
+#ifndef GENERIC_EXAMPLE_RP_PICO_TRANSMISSION_I2C_TRACE_HPP_
+#define GENERIC_EXAMPLE_RP_PICO_TRANSMISSION_I2C_TRACE_HPP_
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+
+#include "ring_buffer.hpp"
+
+/*
+割り込み処理の中で送受信したデータを記録し，後からメインループで表示するための関数です
+割り込み処理の中でprintfを使うと，表示が終わるまで次のバイトの処理が遅れ，通信のタイミングが崩れます
+割り込み処理では4バイトの記録を固定の大きさの配列に書き込むだけにして，表示はメインループで行います
+*/
+
+// 記録する出来事の種類
+enum I2cTraceEvent : uint8_t {
+    kI2cTraceReceive = 0,  // マスターからデータを受信した
+    kI2cTraceRequest,  // マスターにデータを送信した
+    kI2cTraceAddress,  // マスターからレジスタアドレスを受信した
+    kI2cTraceFinish,  // マスターが停止／再起動の信号を送信した
+    kI2cTraceEmpty  // マスターからデータを要求されたが，送信できるデータがなかった
+};
+
+// 1回分の記録 (4バイト)
+struct I2cTraceRecord {
+    uint8_t event;  // 出来事の種類 (I2cTraceEvent)
+    uint8_t byte;  // 送受信したデータ
+    uint16_t time_delta;  // 前の記録からの経過時間 (μs)  65535μs以上は65535
+};
+
+const std::size_t kI2cTraceSize = 256;  // 表示されるまでに保存できる記録の数 (2の累乗)
+
+/*
+送受信したデータを記録する  (割り込み処理の中で呼び出す)
+記録がいっぱいの場合は捨てられ，捨てられた数が数えられます
+同じ優先度の割り込み処理(I2C0とI2C1の割り込みなど)からのみ呼び出してください
+event : 出来事の種類
+byte : 送受信したデータ
+*/
+void I2cTrace(I2cTraceEvent event, uint8_t byte = 0);
+
+/*
+記録したデータを読み取り，標準出力に表示する  (メインループで呼び出す)
+戻り値 : 表示した記録の数
+*/
+std::size_t PrintI2cTrace();
+
+// 記録がいっぱいで捨てられた数
+uint32_t I2cTraceDropped();
+
+#endif
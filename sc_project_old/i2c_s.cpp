@@ -22,6 +22,10 @@ I2c::I2c(bool i2c_id, uint8_t scl_gpio, uint8_t sda_gpio, uint32_t i2c_freq)
         (i2c_id_ ? kAlreadyUseI2c1 : kAlreadyUseI2c0) = true;
     }
 
+    scl_gpio_ = scl_gpio;
+    sda_gpio_ = sda_gpio;
+    i2c_freq_ = i2c_freq;
+
     i2c_init((i2c_id_ ? i2c1 : i2c0), i2c_freq);  // I2Cの初期化
 
     gpio_set_function(scl_gpio, GPIO_FUNC_I2C);  // GPIOピンの有効化
@@ -183,6 +187,163 @@ void I2c::WriteMem(uint8_t slave_addr, uint8_t memory_addr, uint8_t *output_data
     }
 }
 
+// I2Cで受信 (マイコンなどから)  時間内に通信できなければ例外を投げる
+void I2c::ReadTimeout(uint8_t slave_addr, uint8_t *input_data, std::size_t input_data_bytes, uint32_t timeout_us) {
+    i2c_inst_t *i2c = (i2c_id_ ? i2c1 : i2c0);
+    TransferTimeout(slave_addr, input_data_bytes, timeout_us, [&](absolute_time_t deadline) -> int {
+        return i2c_read_blocking_until(i2c, slave_addr, input_data, input_data_bytes, false, deadline);
+    });
+}
+
+// I2Cで受信 (メモリから)  時間内に通信できなければ例外を投げる
+void I2c::ReadMemTimeout(uint8_t slave_addr, uint8_t memory_addr, uint8_t *input_data, std::size_t input_data_bytes, uint32_t timeout_us) {
+    i2c_inst_t *i2c = (i2c_id_ ? i2c1 : i2c0);
+    TransferTimeout(slave_addr, input_data_bytes, timeout_us, [&](absolute_time_t deadline) -> int {
+        int written_bytes = i2c_write_blocking_until(i2c, slave_addr, &memory_addr, 1, true, deadline);  // メモリアドレス(スレーブのメモリの何番地から読み込むか)を先に送信
+        if (written_bytes != 1)
+            return (written_bytes < 0 ? written_bytes : PICO_ERROR_GENERIC);
+        return i2c_read_blocking_until(i2c, slave_addr, input_data, input_data_bytes, false, deadline);  // データを受信
+    });
+}
+
+// I2Cで送信 (マイコンなどへ)  時間内に通信できなければ例外を投げる
+void I2c::WriteTimeout(uint8_t slave_addr, uint8_t *output_data, std::size_t output_data_bytes, uint32_t timeout_us) {
+    i2c_inst_t *i2c = (i2c_id_ ? i2c1 : i2c0);
+    TransferTimeout(slave_addr, output_data_bytes, timeout_us, [&](absolute_time_t deadline) -> int {
+        return i2c_write_blocking_until(i2c, slave_addr, output_data, output_data_bytes, false, deadline);
+    });
+}
+
+// I2Cで送信 (メモリへ)  時間内に通信できなければ例外を投げる
+void I2c::WriteMemTimeout(uint8_t slave_addr, uint8_t memory_addr, uint8_t *output_data, std::size_t output_data_bytes, uint32_t timeout_us) {
+    if (output_data_bytes > kMaxWriteMemBytes)
+        throw Error(__FILE__, __LINE__, "Too many bytes for one I2C memory write");  // I2Cによるメモリへの書き込みのバイト数が多すぎます
+
+    // メモリアドレス(スレーブのメモリの何番地に書き込むか)とデータを続けて1回で送信する
+    // メモリアドレスの後に再開始信号を送ると，多くのデバイスはそこで書き込みを終えてしまう
+    uint8_t buffer[kMaxWriteMemBytes + 1];
+    buffer[0] = memory_addr;
+    for (std::size_t i = 0; i < output_data_bytes; ++i)
+        buffer[i + 1] = output_data[i];
+
+    i2c_inst_t *i2c = (i2c_id_ ? i2c1 : i2c0);
+    TransferTimeout(slave_addr, output_data_bytes, timeout_us, [&](absolute_time_t deadline) -> int {
+        int written_bytes = i2c_write_blocking_until(i2c, slave_addr, buffer, output_data_bytes + 1, false, deadline);
+        return (written_bytes > 0 ? written_bytes - 1 : written_bytes);  // 送信できたデータのバイト数 (メモリアドレスの分を除く)
+    });
+}
+
+// タイムアウト付きの通信を，再試行しながら行う
+// 失敗するたびに待ち時間を2倍にして再試行し，タイムアウトした場合はバスを復旧してから再試行する
+template<typename TransferOnce> void I2c::TransferTimeout(uint8_t slave_addr, std::size_t data_bytes, uint32_t timeout_us, TransferOnce transfer_once) {
+    absolute_time_t deadline = make_timeout_time_us(timeout_us);  // 通信全体の締め切り
+    uint32_t backoff_us = backoff_us_;
+    for (uint8_t retry = 0; ; ++retry)
+    {
+        uint32_t start_us = time_us_32();
+        int result = transfer_once(deadline);
+        RecordStats(slave_addr, time_us_32() - start_us, result == static_cast<int>(data_bytes), result == PICO_ERROR_TIMEOUT);
+        if (result == static_cast<int>(data_bytes))
+    return;
+
+        if (result == PICO_ERROR_TIMEOUT)
+        {
+            // スレーブがバスを離さずに止まっている可能性があるため，バスを復旧する
+            RecoverBus();
+            for (std::size_t i = 0; i < stats_num_; ++i)
+                if (stats_[i].slave_addr == slave_addr) ++stats_[i].recovery_count;
+        }
+
+        // 再試行の回数を超えたか，待っている間に締め切りを過ぎる場合は諦める
+        if (retry >= max_retries_ || absolute_time_diff_us(get_absolute_time(), deadline) <= static_cast<int64_t>(backoff_us))
+        {
+            if (result == PICO_ERROR_TIMEOUT)
+                throw Error(__FILE__, __LINE__, "I2C communication timed out");  // I2Cによる通信がタイムアウトしました
+            else
+                throw Error(__FILE__, __LINE__, "Communication via I2C failed");  // I2Cによる通信に失敗しました
+        }
+
+        sleep_us(backoff_us);
+        backoff_us = (backoff_us * 2 < max_backoff_us_ ? backoff_us * 2 : max_backoff_us_);
+    }
+}
+
+// 再試行の方法を設定  再試行するたびに待ち時間を2倍にする
+void I2c::SetBackoff(uint32_t backoff_us, uint32_t max_backoff_us, uint8_t max_retries) {
+    backoff_us_ = backoff_us;
+    max_backoff_us_ = (max_backoff_us < backoff_us ? backoff_us : max_backoff_us);
+    max_retries_ = max_retries;
+}
+
+// スレーブがSDAをLowにしたまま止まってしまったバスを復旧する
+void I2c::RecoverBus() {
+    // ピンをI2Cから切り離し，プログラムから直接動かす
+    // I2Cのピンはプルアップされているので，出力にするとLow，入力にするとHighになる (オープンドレイン)
+    gpio_set_function(scl_gpio_, GPIO_FUNC_SIO);
+    gpio_set_function(sda_gpio_, GPIO_FUNC_SIO);
+    gpio_put(scl_gpio_, 0);
+    gpio_put(sda_gpio_, 0);
+    gpio_set_dir(scl_gpio_, GPIO_IN);
+    gpio_set_dir(sda_gpio_, GPIO_IN);
+    busy_wait_us_32(5);
+
+    // SDAが離されるまで，SCLを最大9回動かす (スレーブに送信途中の1バイトとACKを送り切らせる)
+    for (int i = 0; i < 9 && !gpio_get(sda_gpio_); ++i)
+    {
+        gpio_set_dir(scl_gpio_, GPIO_OUT);  // SCLをLow
+        busy_wait_us_32(5);
+        gpio_set_dir(scl_gpio_, GPIO_IN);  // SCLをHigh
+        busy_wait_us_32(5);
+    }
+
+    // 停止信号(STOP)を送る  SCLがHighの間にSDAをLowからHighにする
+    gpio_set_dir(scl_gpio_, GPIO_OUT);
+    gpio_set_dir(sda_gpio_, GPIO_OUT);
+    busy_wait_us_32(5);
+    gpio_set_dir(scl_gpio_, GPIO_IN);
+    busy_wait_us_32(5);
+    gpio_set_dir(sda_gpio_, GPIO_IN);
+    busy_wait_us_32(5);
+
+    // I2Cを初期化し直し，ピンをI2Cに戻す
+    i2c_deinit(i2c_id_ ? i2c1 : i2c0);
+    i2c_init((i2c_id_ ? i2c1 : i2c0), i2c_freq_);
+    gpio_set_function(scl_gpio_, GPIO_FUNC_I2C);
+    gpio_set_function(sda_gpio_, GPIO_FUNC_I2C);
+}
+
+// デバイスごとの通信時間と失敗回数の記録を取得
+const I2c::DeviceStats* I2c::GetStats(uint8_t slave_addr) const {
+    for (std::size_t i = 0; i < stats_num_; ++i)
+        if (stats_[i].slave_addr == slave_addr) return &stats_[i];
+    return nullptr;
+}
+
+// 通信1回分の結果をデバイスごとの記録に加える
+// 記録できるデバイスの数(kStatsDevices)を超えた場合は記録しない
+void I2c::RecordStats(uint8_t slave_addr, uint32_t latency_us, bool success, bool timeout) {
+    DeviceStats *stats = nullptr;
+    for (std::size_t i = 0; i < stats_num_; ++i)
+        if (stats_[i].slave_addr == slave_addr) stats = &stats_[i];
+    if (!stats)
+    {
+        if (stats_num_ >= kStatsDevices)
+    return;
+        stats = &stats_[stats_num_++];
+        stats->slave_addr = slave_addr;
+    }
+
+    std::size_t bucket = 0;  // 通信時間が 2^bucket μs以上 2^(bucket+1) μs未満になる区間
+    while (bucket < kLatencyBuckets - 1 && (latency_us >> (bucket + 1))) ++bucket;
+    ++stats->latency_histogram[bucket];
+
+    if (success)
+        ++stats->success_count;
+    else
+        ++stats->failure_count;
+    if (timeout) ++stats->timeout_count;
+}
+
 
 /*
 このプログラムの作成にあたり以下を参考にしました
@@ -12,9 +12,42 @@
 // I2C通信を簡単に行うためのクラスです
 class I2c : public Communication
 {
+public:
+    static const std::size_t kLatencyBuckets = 16;  // 通信時間のヒストグラムの区間の数
+    static const std::size_t kStatsDevices = 8;  // 通信時間や失敗回数を記録するデバイスの最大数
+    static const std::size_t kMaxWriteMemBytes = 32;  // WriteMemTimeoutで一度に書き込めるデータの最大のバイト数
+
+    //! \brief デバイスごとの通信時間と失敗回数の記録
+    struct DeviceStats
+    {
+        uint8_t slave_addr;  // 通信先のデバイスのスレーブアドレス
+        uint32_t latency_histogram[kLatencyBuckets];  // 通信時間のヒストグラム  i番目の区間は 2^i μs以上 2^(i+1) μs未満 (最後の区間はそれ以上すべて)
+        uint32_t success_count;  // 成功した通信の回数
+        uint32_t failure_count;  // 失敗した通信の回数 (再試行した分も含む)
+        uint32_t timeout_count;  // タイムアウトした通信の回数
+        uint32_t recovery_count;  // バスの復旧を行った回数
+    };
+
+private:
     static bool kAlreadyUseI2c0;
     static bool kAlreadyUseI2c1;
     bool i2c_id_;
+    uint8_t scl_gpio_;
+    uint8_t sda_gpio_;
+    uint32_t i2c_freq_;
+
+    uint32_t backoff_us_ = 100;  // 1回目の再試行までの待ち時間 (μs)
+    uint32_t max_backoff_us_ = 10000;  // 再試行までの待ち時間の最大値 (μs)
+    uint8_t max_retries_ = 3;  // 再試行の最大回数
+
+    DeviceStats stats_[kStatsDevices] = {};
+    std::size_t stats_num_ = 0;
+
+    // 通信1回分の結果をデバイスごとの記録に加える
+    void RecordStats(uint8_t slave_addr, uint32_t latency_us, bool success, bool timeout);
+
+    // タイムアウト付きの通信を，再試行しながら行う  TransferOnceは1回分の通信を行い，i2c_*_blocking_untilの戻り値を返す関数
+    template<typename TransferOnce> void TransferTimeout(uint8_t slave_addr, std::size_t data_bytes, uint32_t timeout_us, TransferOnce transfer_once);
 public:
     /*!
     \brief I2Cのセットアップ  I2C0とI2C1を使う際にそれぞれ一回だけ呼び出す
@@ -62,6 +95,70 @@ public:
     */
     void WriteMem(uint8_t slave_addr, uint8_t memory_addr, uint8_t *output_data, std::size_t output_data_bytes);
     template<typename T, std::size_t SIZE> inline void WriteMem(uint8_t slave_addr, uint8_t memory_addr, T (&output_data)[SIZE]) {WriteMem(slave_addr, memory_addr, (uint8_t*)output_data, SIZE);}
+
+    /*!
+    \brief I2Cで受信 (マイコンなどから)  時間内に通信できなければ例外を投げる
+    \param slave_addr 通信先のデバイスのスレーブアドレス (どのデバイスからデータを読み込むか) 通常は8~119の間を使用する  7bit
+    \param input_data 受信したデータを保存するための配列
+    \param input_data_bytes 何バイト(文字)読み込むか
+    \param timeout_us 再試行を含めた通信全体の制限時間 (μs)
+    */
+    void ReadTimeout(uint8_t slave_addr, uint8_t *input_data, std::size_t input_data_bytes, uint32_t timeout_us);
+    template<typename T, std::size_t SIZE> inline void ReadTimeout(uint8_t slave_addr, T (&input_data)[SIZE], uint32_t timeout_us) {ReadTimeout(slave_addr, (uint8_t*)input_data, SIZE, timeout_us);}
+
+    /*!
+    \brief I2Cで受信 (メモリから)  時間内に通信できなければ例外を投げる
+    \param slave_addr 通信先のデバイスのスレーブアドレス (どのデバイスからデータを読み込むか) 通常は8~119の間を使用する  7bit
+    \param memory_addr 受信元のデバイスのメモリアドレス (スレーブ内のメモリの何番地からデータを読み込むか)
+    \param input_data 受信したデータを保存するための配列
+    \param input_data_bytes 何バイト(文字)読み込むか
+    \param timeout_us 再試行を含めた通信全体の制限時間 (μs)
+    */
+    void ReadMemTimeout(uint8_t slave_addr, uint8_t memory_addr, uint8_t *input_data, std::size_t input_data_bytes, uint32_t timeout_us);
+    template<typename T, std::size_t SIZE> inline void ReadMemTimeout(uint8_t slave_addr, uint8_t memory_addr, T (&input_data)[SIZE], uint32_t timeout_us) {ReadMemTimeout(slave_addr, memory_addr, (uint8_t*)input_data, SIZE, timeout_us);}
+
+    /*!
+    \brief I2Cで送信 (マイコンなどへ)  時間内に通信できなければ例外を投げる
+    \param slave_addr 通信先のデバイスのスレーブアドレス (どのデバイスにデータを書き込むか) 通常は8~119の間を使用する  7bit
+    \param output_data 送信するデータの配列
+    \param output_data_bytes 何バイト(文字)書き込むか
+    \param timeout_us 再試行を含めた通信全体の制限時間 (μs)
+    */
+    void WriteTimeout(uint8_t slave_addr, uint8_t *output_data, std::size_t output_data_bytes, uint32_t timeout_us);
+    template<typename T, std::size_t SIZE> inline void WriteTimeout(uint8_t slave_addr, T (&output_data)[SIZE], uint32_t timeout_us) {WriteTimeout(slave_addr, (uint8_t*)output_data, SIZE, timeout_us);}
+
+    /*!
+    \brief I2Cで送信 (メモリへ)  時間内に通信できなければ例外を投げる
+    \param slave_addr 通信先のデバイスのスレーブアドレス (どのデバイスにデータを書き込むか) 通常は8~119の間を使用する  7bit
+    \param memory_addr 送信先のデバイスのメモリアドレス (スレーブ内のメモリの何番地にデータを書き込むか)
+    \param output_data 送信するデータの配列
+    \param output_data_bytes 何バイト(文字)書き込むか (kMaxWriteMemBytes以下)
+    \param timeout_us 再試行を含めた通信全体の制限時間 (μs)
+    \note メモリアドレスとデータを1回の通信で送信するため，途中で停止信号や再開始信号は送らない
+    */
+    void WriteMemTimeout(uint8_t slave_addr, uint8_t memory_addr, uint8_t *output_data, std::size_t output_data_bytes, uint32_t timeout_us);
+    template<typename T, std::size_t SIZE> inline void WriteMemTimeout(uint8_t slave_addr, uint8_t memory_addr, T (&output_data)[SIZE], uint32_t timeout_us) {WriteMemTimeout(slave_addr, memory_addr, (uint8_t*)output_data, SIZE, timeout_us);}
+
+    /*!
+    \brief 再試行の方法を設定  再試行するたびに待ち時間を2倍にする
+    \param backoff_us 1回目の再試行までの待ち時間 (μs)
+    \param max_backoff_us 再試行までの待ち時間の最大値 (μs)
+    \param max_retries 再試行の最大回数
+    */
+    void SetBackoff(uint32_t backoff_us, uint32_t max_backoff_us, uint8_t max_retries);
+
+    /*!
+    \brief スレーブがSDAをLowにしたまま止まってしまったバスを復旧する
+    SCLを9回動かしてスレーブに残りのデータを送り切らせた後，停止信号(STOP)を送り，I2Cを初期化し直す
+    */
+    void RecoverBus();
+
+    /*!
+    \brief デバイスごとの通信時間と失敗回数の記録を取得
+    \param slave_addr 通信先のデバイスのスレーブアドレス
+    \return 記録へのポインタ  まだ通信していないデバイスの場合はnullptr
+    */
+    const DeviceStats* GetStats(uint8_t slave_addr) const;
 };
 bool I2c::kAlreadyUseI2c0 = false;
 bool I2c::kAlreadyUseI2c1 = false;
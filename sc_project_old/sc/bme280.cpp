@@ -1,22 +1,39 @@
 #include "bme280.hpp"
+#include "crc.hpp"
+
+#include "pico/flash.h"
 
 namespace sc
 {
     // BME280のセットアップ (I2CとSPI共通)
     // device_addr : 通信相手のデバイスを選択するためのアドレス
     // i2c_or spi : I2C型かSPI型のオブジェクト (一時オブジェクト不可)
-    BME280::BME280(uint8_t select_device, Communication& i2c_or_spi):
+    // [set_default_parameter] : 標準の測定方法を設定するか (省略時:設定する)  BME280Fixedでは設定を自身で書き込むためfalse
+    BME280::BME280(uint8_t select_device, Communication& i2c_or_spi, bool set_default_parameter):
         _i2c_or_spi(i2c_or_spi),
         _select_device(select_device)
     {
         // 接続を確認
         check_connection();
 
-        // 測定方法などの設定
-        set_parameter();
+        // センサが接続されていない場合も，I2Cの read_mem が投げる例外をここで止め，セットアップ全体は続けられるようにする  (measure は測定できなかったことを返す)
+        try
+        {
+            // 測定方法などの設定
+            if (set_default_parameter) set_parameter();
 
-        // 補正用データ読み取り
-        read_compensation_data();
+            // 補正用データ読み取り
+            // フラッシュに保存した補正用データがあれば，センサからは読み込まずにそれを使い，measure のたびに少しずつ照合する
+            if (!load_cached_calibration())
+            {
+                read_compensation_data();
+                _calibration_store_pending = true;  // フラッシュへの書き込みの間はプログラムを実行できないので，セットアップの中では保存せず store_pending_calibration に任せる
+            }
+        }
+        catch(const std::exception& e)
+        {
+            Error(__FILE__, __LINE__, "BME280 setup failed", e.what());  // BME280のセットアップに失敗しました
+        }
     }
 
     // センサが正常に接続されていることを確認
@@ -25,8 +42,13 @@ namespace sc
     {
         try
         {
-            uint8_t chip_id;
-            _i2c_or_spi.read(1, &chip_id, _select_device);  // チップIDを読み取り，接続されているセンサがBME280であるか確認
+            if (!_i2c_or_spi.is_present(_select_device))  // 起動時のスキャンで見つからなかった場合は，通信せずに終了
+            {
+                log("BME280 connection could not be verified");  // BME280の接続が確認できませんでした
+    return false;
+            }
+            uint8_t chip_id = _i2c_or_spi.device_id(0xd0, _select_device);  // チップIDを読み取り，接続されているセンサがBME280であるか確認 (I2Cでは記録したIDを使う)
+            _chip_id = chip_id;
             switch (chip_id)
             {
                 case 0x60:
@@ -59,24 +81,19 @@ namespace sc
         try
         {
             // 最初にエラー値を代入
-            _temperature = ErrorValue;
-            _pressure = ErrorValue;
-            _humidity = ErrorValue;
+            _has_temperature = _has_pressure = _has_humidity = false;
+
+            if (_mode == MODE_FORCED) wait_for_conversion();  // is_ready で終わりを確認済みの場合は通信も待機もしない
 
             // 生データ読み取り (一般的な単位にはなっていない)
             read_raw();
+            _result_ready = false;
+            if (_mode != MODE_FORCED) _sample_time_us = time_us_32();
+            verify_cached_calibration();  // フラッシュから読み込んだ補正用データを少しずつ照合する
 
-            // 補正用のパラメータを計算
-            calc_conversion_parameter();
-
-            // 気温データを補正して保存
-            convert_temperature();
-
-            // 気圧データを補正して保存
-            convert_pressure();
-
-            // 湿度データを補正して保存
-            convert_humidity();
+            // 補正して固定小数点のまま保存  (一般的な単位へは temperature などで変換する)
+            _data = _calibration.compensate(_raw);
+            _has_temperature = _has_pressure = _has_humidity = true;
         }
         catch(const std::exception& e)
         {
@@ -87,19 +104,104 @@ namespace sc
     // 測定した気温を返す
     Temperature BME280::temperature() const noexcept
     {
-        return _temperature;
+        if (!_has_temperature)
+    return ErrorValue;
+        return _data.temperature / 100.0;
     }
 
     // 測定した気圧を返す
     Pressure BME280::pressure() const noexcept
     {
-        return _pressure;
+        if (!_has_pressure)
+    return ErrorValue;
+        return _data.pressure / 25600.0;  // (Pa)×256 → (hPa)
     }
 
     // 測定した湿度を返す
     Humidity BME280::humidity() const noexcept
     {
-        return _humidity;
+        if (!_has_humidity)
+    return ErrorValue;
+        return _data.humidity / 1024.0;
+    }
+
+    // 強制モード(測定を指示したときに1回だけ変換するモード)に切り替える
+    // measure を呼び出すたびに変換を開始し，変換にかかる最大の時間だけ待ってから読み込むため，常に最新のデータを読み込めます
+    // start_measurement で変換を開始しておき，is_ready がtrueになってから measure を呼び出せば待機せずに読み込めます
+    // [over_sampling_t] : 気温のオーバーサンプリング (測定の精度を高めるが測定時間が伸びる) (省略時:1回)
+    // [over_sampling_p] : 気圧のオーバーサンプリング (測定の精度を高めるが測定時間が伸びる) (省略時:1回)
+    // [over_sampling_h] : 湿度のオーバーサンプリング (測定の精度を高めるが測定時間が伸びる) (省略時:1回)
+    // [filter] : ノイズ除去フィルタの係数 (省略時:フィルターなし)
+    void BME280::set_forced_mode(OverSampling over_sampling_t, OverSampling over_sampling_p, OverSampling over_sampling_h, Filter filter)
+    {
+        _converting = _result_ready = false;
+        set_parameter(MODE_SLEEP, over_sampling_t, over_sampling_p, over_sampling_h, ST_0_5ms, filter);  // 変換を開始するまではスリープモードにしておく
+        _mode = MODE_FORCED;
+    }
+
+    // 強制モードで変換を開始  変換中か，まだ measure で読み込んでいない変換の結果がある場合は何もしない
+    void BME280::start_measurement()
+    {
+        if (_mode != MODE_FORCED) throw Error(__FILE__, __LINE__, "BME280 is not in forced mode");  // BME280が強制モードになっていません
+        if (_converting || _result_ready)
+    return;
+        _i2c_or_spi.write_byte_mem(0xf4, (_ctrl_meas | MODE_FORCED), _select_device);  // 強制モードを書き込むと1回だけ変換し，スリープモードに戻る
+        _ready_time_us = time_us_32() + _conversion_time_us;
+        _converting = true;
+    }
+
+    // 開始した変換が終わったか
+    // 変換にかかる最大の時間が経つまでは通信せずにfalseを返し，経った後は状態レジスタ(0xF3)を1回だけ読み込む
+    // 一度trueを返した後は，measure で読み込むまで通信せずにtrueを返す
+    bool BME280::is_ready()
+    {
+        if (_result_ready)
+    return true;
+        if (!_converting)
+    return false;
+        if (static_cast<int32_t>(time_us_32() - _ready_time_us) < 0)
+    return false;
+
+        uint8_t status;
+        _i2c_or_spi.read_mem(0xf3, 1, &status, _select_device);
+        ++_status_polls;
+        if (status & 0x08)
+    return false;  // measuring  変換中
+        _converting = false;
+        _result_ready = true;
+        _sample_time_us = _ready_time_us;
+        return true;
+    }
+
+    // 強制モードで，まだ読み込んでいない変換の結果ができるまで待つ
+    // is_ready で終わりを確認済みの場合は通信も待機もしない  変換を開始していなければここで開始する
+    // 状態レジスタの変換中のビットが消えないまま，変換にかかる最大の時間の2倍が経った場合は例外を投げる (measure の中で止まり続けないようにする)
+    void BME280::wait_for_conversion()
+    {
+        if (_result_ready)
+    return;
+        start_measurement();
+        int32_t remaining_us = static_cast<int32_t>(_ready_time_us - time_us_32());
+        if (remaining_us > 0) sleep_us(remaining_us);  // 変換が終わるはずの時刻までは通信せずに待つ
+        while (!is_ready())
+        {
+            if (static_cast<int32_t>(time_us_32() - (_ready_time_us + _conversion_time_us)) >= 0)
+            {
+                _converting = false;  // 次の measure では変換を開始し直す
+                throw Error(__FILE__, __LINE__, "BME280 conversion did not finish in time");  // BME280の変換が時間内に終わりませんでした
+            }
+            tight_loop_contents();
+        }
+    }
+
+    // 測定したデータが何μs前のものか
+    // 強制モードでは変換が終わった時刻からの経過時間，ノーマルモードでは読み込んだ時刻からの経過時間に待機時間と変換時間を足した最大値
+    uint32_t BME280::sample_age_us() const noexcept
+    {
+        uint32_t age = time_us_32() - _sample_time_us;
+        if (_mode == MODE_FORCED)
+    return age;
+        return age + _standby_time_us + _conversion_time_us;  // 読み込んだデータは，最大で1回分の待機と変換の時間だけ古い
     }
 
     // 測定方法などを設定
@@ -110,113 +212,205 @@ namespace sc
     // [stanby_time] : 測定と測定の間の待機時間の長さ (省略時:125ms)
     // [filter] : ノイズ除去フィルタの係数 (ノイズを減らすが測定時間が伸びる) (省略時:フィルター2)
     // [spi_wire_num] : SPI使用時に，3線式を使用するか，4線式を使用するか (省略時:4線式)
-    void BME280::set_parameter(Mode mode = MODE_NORMAL, OverSampling over_sampling_t = OSRS_x2, OverSampling over_sampling_p = OSRS_x4, OverSampling over_sampling_h = OSRS_x1, StanbyTime stanby_time = ST_125ms, Filter filter = FILTER_2, SpiWireNum spi_wire_num = SPI_WIRE_4) const
+    void BME280::set_parameter(Mode mode, OverSampling over_sampling_t, OverSampling over_sampling_p, OverSampling over_sampling_h, StanbyTime stanby_time, Filter filter, SpiWireNum spi_wire_num)
     {
         // メモリに書き込み
         _i2c_or_spi.write_byte_mem(0xf2, over_sampling_h, _select_device);
         _i2c_or_spi.write_byte_mem(0xf4, ((over_sampling_t << 5) | (over_sampling_p << 2) | mode), _select_device);
         _i2c_or_spi.write_byte_mem(0xf5, ((stanby_time << 5) | (filter << 2) | spi_wire_num), _select_device);
+
+        // 1回の変換にかかる最大の時間 (データシート 9.1)  オーバーサンプリングの回数ごとに2.3ms，気圧と湿度は測定する場合に0.575ms増える
+        static const uint32_t Samples[] = {0, 1, 2, 4, 8, 16, 16, 16};  // オーバーサンプリングの設定値に対応する回数 (5以上はすべて16回)
+        static const uint32_t StandbyTimes[] = {500, 62500, 125000, 250000, 500000, 1000000, 10000, 20000};  // 待機時間の設定値に対応する時間 (μs)
+        _conversion_time_us = 1250 + 2300 * Samples[over_sampling_t];
+        if (over_sampling_p != OSRS_SKIPPED) _conversion_time_us += 2300 * Samples[over_sampling_p] + 575;
+        if (over_sampling_h != OSRS_SKIPPED) _conversion_time_us += 2300 * Samples[over_sampling_h] + 575;
+        _standby_time_us = StandbyTimes[stanby_time];
+        _ctrl_meas = (over_sampling_t << 5) | (over_sampling_p << 2);
+        _mode = mode;
     }
 
     // 補正用データ読み取り
     void BME280::read_compensation_data()
     {
-        uint8_t input_data[26];
+        uint8_t* temperature_pressure = _calibration_bytes;
+        uint8_t* humidity = _calibration_bytes + BME280Calibration::TemperaturePressureBytes;
+        _i2c_or_spi.read_mem(0x88, BME280Calibration::TemperaturePressureBytes, temperature_pressure, _select_device);
+        _i2c_or_spi.read_mem(0xe1, BME280Calibration::HumidityBytes, humidity, _select_device);
+        _calibration.load(temperature_pressure, humidity);
+        _calibration_verified = true;
+    }
 
-        _i2c_or_spi.read_mem(0x88, 24, input_data, _select_device);
+    // 生データ読み取り (一般的な単位にはなっていない)
+    void BME280::read_raw()
+    {
+        uint8_t input_data[BME280Raw::FrameBytes];
+        _i2c_or_spi.read_mem(0xf7, BME280Raw::FrameBytes, input_data, _select_device);
 
-        dig_T1 = input_data[0] | (input_data[1] << 8);
-        dig_T2 = input_data[2] | (input_data[3] << 8);
-        dig_T3 = input_data[4] | (input_data[5] << 8);
+        _raw = BME280Raw::from_frame(input_data);
+    }
 
-        dig_P1 = input_data[6] | (input_data[7] << 8);
-        dig_P2 = input_data[8] | (input_data[9] << 8);
-        dig_P3 = input_data[10] | (input_data[11] << 8);
-        dig_P4 = input_data[12] | (input_data[13] << 8);
-        dig_P5 = input_data[14] | (input_data[15] << 8);
-        dig_P6 = input_data[16] | (input_data[17] << 8);
-        dig_P7 = input_data[18] | (input_data[19] << 8);
-        dig_P8 = input_data[20] | (input_data[21] << 8);
-        dig_P9 = input_data[22] | (input_data[23] << 8);
+    /***** 補正用データのフラッシュへの保存 *****/
 
-        dig_H1 = input_data[24];
+    // フラッシュに保存する補正用データの記録
+    // セクタの先頭から1ページ(256バイト)に1つずつ追記し，同じキー(バス，デバイスの番号，チップID)の記録が複数ある場合は後のものを使う
+    // チップIDはどのBME280でも同じ(0x60)なので，別のバスの同じアドレスのセンサを区別するためにバスもキーに含める
+    // セクタが一杯になったら消去して最初から書き込む (そのときは他のBME280の記録も消えるため，次の起動後の store_pending_calibration で保存し直される)
+    struct BME280CalibrationRecord
+    {
+        uint32_t magic;  // 記録があることを示す値と形式の番号  (消去したページは0xFFFFFFFF)
+        uint16_t crc;  // bus から calibration の最後までのCRC-16
+        uint8_t bus;  // 通信の種類とバスの番号 (Communication::bus_id)
+        uint8_t select_device;  // スレーブアドレスかCSピンのGPIO番号
+        uint8_t chip_id;  // チップID
+        uint8_t calibration[BME280Calibration::TemperaturePressureBytes + BME280Calibration::HumidityBytes];  // 0x88〜0xA1 と 0xE1〜0xE7 の補正用データ
+    };
+    static const uint32_t BME280CalibrationMagic = 0x42453202;  // "BE2" + 形式の番号2  形式を変えたら番号を増やす
+    static const uint32_t BME280CalibrationSlots = FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE;  // 1つのセクタに書き込める記録の数
+    static_assert(sizeof(BME280CalibrationRecord) <= FLASH_PAGE_SIZE, "BME280CalibrationRecord must fit in one flash page");  // 記録は1ページに収まる必要があります
+    static const uint32_t BME280FlashTimeoutMs = 100;  // flash_safe_execute で，もう一方のコアを止めるまで待つ時間 (ms)
 
-        _i2c_or_spi.read_mem(0xE1, 8, input_data, _select_device);
+    // flash_safe_execute から呼び出して書き込む内容
+    struct BME280FlashWrite
+    {
+        uint32_t offset;  // 書き込むページの位置 (フラッシュの先頭からのバイト数)
+        const uint8_t* page;  // 書き込む1ページ分のデータ
+        bool erase;  // 書き込む前にセクタを消去するか
+    };
 
-        dig_H2 = input_data[0] | (input_data[1] << 8);
-        dig_H3 = (int8_t) input_data[2];
-        dig_H4 = input_data[3] << 4 | (input_data[4] & 0xf);
-        dig_H5 = (input_data[5] >> 4) | (input_data[6] << 4);
-        dig_H6 = (int8_t) input_data[7];
+    // flash_safe_execute から，割り込みを禁止し，もう一方のコアを止めた状態で呼び出される
+    static void write_calibration_page(void* param)
+    {
+        const BME280FlashWrite& write = *static_cast<const BME280FlashWrite*>(param);
+        if (write.erase) flash_range_erase(BME280::CalibrationFlashOffset, FLASH_SECTOR_SIZE);
+        flash_range_program(write.offset, write.page, FLASH_PAGE_SIZE);
     }
 
-    // 生データ読み取り (一般的な単位にはなっていない)
-    void BME280::read_raw()
+    // 記録のCRCを求める
+    static uint16_t calibration_record_crc(const BME280CalibrationRecord& record)
     {
-        uint8_t input_data[8];
-        _i2c_or_spi.read_mem(0xf7, 8, input_data, _select_device);
+        return crc16(&record.bus, 3 + sizeof(record.calibration));
+    }
 
-        _raw_pressure = ((uint32_t) input_data[0] << 12) | ((uint32_t) input_data[1] << 4) | (input_data[2] >> 4);
-        _raw_temperature = ((uint32_t) input_data[3] << 12) | ((uint32_t) input_data[4] << 4) | (input_data[5] >> 4);
-        _raw_humidity = (uint32_t) input_data[6] << 8 | input_data[7];
+    // slot番目のページの記録  フラッシュはXIP_BASEからのアドレスで読み込める
+    static const BME280CalibrationRecord* calibration_record(uint32_t slot)
+    {
+        return reinterpret_cast<const BME280CalibrationRecord*>(XIP_BASE + BME280::CalibrationFlashOffset + slot * FLASH_PAGE_SIZE);
     }
 
-    // 補正用のパラメータを計算
-    void BME280::calc_conversion_parameter()
+    // キーが一致する最新の記録を探す
+    // 戻り値 : 見つかった記録 (見つからなかったらnullptr)
+    static const BME280CalibrationRecord* find_calibration_record(uint8_t bus, uint8_t select_device, uint8_t chip_id)
     {
-        _conversion_parameter = (((((_raw_temperature >> 3) - ((int32_t) dig_T1 << 1))) * ((int32_t) dig_T2)) >> 11) + ((((((_raw_temperature >> 4) - ((int32_t) dig_T1)) * ((_raw_temperature >> 4) - ((int32_t) dig_T1))) >> 12) * ((int32_t) dig_T3)) >> 14);
+        const BME280CalibrationRecord* found = nullptr;
+        for (uint32_t slot = 0; slot < BME280CalibrationSlots; ++slot)
+        {
+            const BME280CalibrationRecord* record = calibration_record(slot);
+            if (record->magic == 0xffffffff)
+        break;  // これ以降は書き込まれていない
+            if (record->magic != BME280CalibrationMagic || record->bus != bus || record->select_device != select_device || record->chip_id != chip_id)
+        continue;
+            if (record->crc != calibration_record_crc(*record))
+        continue;  // 書き込み中に電源が切れたなど
+            found = record;
+        }
+        return found;
     }
 
-    // 気温データを補正して保存
-    void BME280::convert_temperature()
+    // フラッシュに保存した補正用データを読み込む
+    // 戻り値 : バス，デバイスの番号，チップIDが一致し，CRCが正しい記録があった:true, なかった:false
+    bool BME280::load_cached_calibration() noexcept
     {
-        _temperature = ((_conversion_parameter * 5 + 128) >> 8) / 100.0;
+        if (_chip_id != 0x60 && _chip_id != 0x58)
+    return false;  // 接続を確認できていない
+        const BME280CalibrationRecord* record = find_calibration_record(_i2c_or_spi.bus_id(), _select_device, _chip_id);
+        if (!record)
+    return false;
+
+        std::memcpy(_calibration_bytes, record->calibration, sizeof(_calibration_bytes));
+        _calibration.load(_calibration_bytes, _calibration_bytes + BME280Calibration::TemperaturePressureBytes);
+        _calibration_verified = false;
+        _verify_index = 0;
+        return true;
     }
 
-    // 気圧データを補正して保存
-    void BME280::convert_pressure()
+    // 補正用データをフラッシュに保存  同じ内容が保存されている場合は書き込まない
+    // 戻り値 : 保存したか，同じ内容が保存されていた:true, 書き込めなかった:false
+    // 書き込み中はフラッシュからプログラムを読み込めなくなるため，flash_safe_execute で割り込みを禁止し，もう一方のコアも止める
+    bool BME280::store_cached_calibration() noexcept
     {
-        int32_t var1, var2;
-        uint32_t p;
-        var1 = (((int32_t) _conversion_parameter) >> 1) - (int32_t) 64000;
-        var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * ((int32_t) dig_P6);
-        var2 = var2 + ((var1 * ((int32_t) dig_P5)) << 1);
-        var2 = (var2 >> 2) + (((int32_t) dig_P4) << 16);
-        var1 = (((dig_P3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) + ((((int32_t) dig_P2) * var1) >> 1)) >> 18;
-        var1 = ((((32768 + var1)) * ((int32_t) dig_P1)) >> 15);
-        if (var1 == 0)
-        {
-            _pressure = 0;
-            return;
-        }
+        if (_chip_id != 0x60 && _chip_id != 0x58)
+    return true;  // 接続を確認できていないので保存しない
+        const BME280CalibrationRecord* found = find_calibration_record(_i2c_or_spi.bus_id(), _select_device, _chip_id);
+        if (found && !std::memcmp(found->calibration, _calibration_bytes, sizeof(_calibration_bytes)))
+    return true;  // 同じ内容が保存されている
 
-        p = (((uint32_t) (((int32_t) 1048576) - _raw_pressure) - (var2 >> 12))) * 3125;
-        if (p < 0x80000000)
-            p = (p << 1) / ((uint32_t) var1);
-        else
-            p = (p / (uint32_t) var1) * 2;
+        uint32_t slot = 0;
+        while (slot < BME280CalibrationSlots && calibration_record(slot)->magic != 0xffffffff) ++slot;  // 書き込まれていない最初のページ
 
-        var1 = (((int32_t) dig_P9) * ((int32_t) (((p >> 3) * (p >> 3)) >> 13))) >> 12;
-        var2 = (((int32_t) (p >> 2)) * ((int32_t) dig_P8)) >> 13;
-        p = (uint32_t) ((int32_t) p + ((var1 + var2 + dig_P7) >> 4));
+        // 書き込まないバイトは0xFFにしておく (フラッシュは0xFFを書き込んでも変化しない)
+        uint8_t page[FLASH_PAGE_SIZE];
+        std::memset(page, 0xff, sizeof(page));
+        BME280CalibrationRecord record;
+        record.magic = BME280CalibrationMagic;
+        record.bus = _i2c_or_spi.bus_id();
+        record.select_device = _select_device;
+        record.chip_id = _chip_id;
+        std::memcpy(record.calibration, _calibration_bytes, sizeof(record.calibration));
+        record.crc = calibration_record_crc(record);
+        std::memcpy(page, &record, sizeof(record));
 
-        _pressure = p / 100.0;
+        BME280FlashWrite write;
+        write.erase = (slot == BME280CalibrationSlots);  // セクタが一杯なので消去する
+        write.offset = CalibrationFlashOffset + (write.erase ? 0 : slot * FLASH_PAGE_SIZE);
+        write.page = page;
+        if (flash_safe_execute(write_calibration_page, &write, BME280FlashTimeoutMs) != PICO_OK)
+        {
+            log("BME280 calibration data could not be stored in flash");  // BME280の補正用データをフラッシュに保存できませんでした
+    return false;
+        }
+        return true;
+    }
+
+    // 保存する必要がある補正用データをフラッシュに保存する  必要がない場合は何もしない
+    // 消去と書き込みの間はどちらのコアもフラッシュ上のプログラムを実行できないため，測定の合間など時間に余裕があるときに呼び出してください
+    // もう一方のコアを使う場合は，そのコアで flash_safe_execute_core_init を呼び出しておくと，書き込みの間だけ止められます
+    // 戻り値 : 保存し直す必要がなくなったか  (もう一方のコアを止められなかった場合などはfalse  後で呼び出し直す)
+    bool BME280::store_pending_calibration() noexcept
+    {
+        if (_calibration_store_pending && store_cached_calibration()) _calibration_store_pending = false;
+        return !_calibration_store_pending;
     }
 
-    // 湿度データを補正して保存
-    void BME280::convert_humidity()
+    // 照合する補正用データの範囲  1回の measure で1つずつ読み込み，測定の通信を長く止めないようにする
+    struct BME280CalibrationRange
     {
-        int32_t v_x1_u32r;
-        v_x1_u32r = (_conversion_parameter - ((int32_t) 76800));
-        v_x1_u32r = (((((_raw_humidity << 14) - (((int32_t) dig_H4) << 20) - (((int32_t) dig_H5) * v_x1_u32r)) +
-                    ((int32_t) 16384)) >> 15) * (((((((v_x1_u32r * ((int32_t) dig_H6)) >> 10) * (((v_x1_u32r *
-                                                                                                    ((int32_t) dig_H3))
-                >> 11) + ((int32_t) 32768))) >> 10) + ((int32_t) 2097152)) *
-                                                    ((int32_t) dig_H2) + 8192) >> 14));
-        v_x1_u32r = (v_x1_u32r - (((((v_x1_u32r >> 15) * (v_x1_u32r >> 15)) >> 7) * ((int32_t) dig_H1)) >> 4));
-        v_x1_u32r = (v_x1_u32r < 0 ? 0 : v_x1_u32r);
-        v_x1_u32r = (v_x1_u32r > 419430400 ? 419430400 : v_x1_u32r);
+        uint8_t memory_addr;  // センサのメモリアドレス
+        uint8_t bytes;  // バイト数
+        uint8_t offset;  // _calibration_bytes の何バイト目から対応するか
+    };
+    static const BME280CalibrationRange BME280VerifyRanges[] = {
+        {0x88, 8, 0}, {0x90, 8, 8}, {0x98, 8, 16}, {0xa0, 2, 24},
+        {0xe1, 7, BME280Calibration::TemperaturePressureBytes}
+    };
 
-        _humidity = uint32_t(v_x1_u32r >> 12) / 1024.0;
+    // フラッシュから読み込んだ補正用データの一部をセンサから読み込んで照合する  照合が済んでいる場合は何もしない
+    // 一致しなかった場合はセンサから読み込み直すが，フラッシュには書き込まずに _calibration_store_pending をtrueにする
+    void BME280::verify_cached_calibration()
+    {
+        if (_calibration_verified)
+    return;
+
+        const BME280CalibrationRange& range = BME280VerifyRanges[_verify_index];
+        uint8_t data[8];
+        _i2c_or_spi.read_mem(range.memory_addr, range.bytes, data, _select_device);
+        if (std::memcmp(data, _calibration_bytes + range.offset, range.bytes))
+        {
+            log("BME280 calibration data in flash does not match the sensor; reloading");  // フラッシュに保存した補正用データがセンサと一致しないため，読み込み直します
+            read_compensation_data();
+            _calibration_store_pending = true;  // 消去に時間がかかるので，ここではフラッシュに書き込まない
+    return;
+        }
+        if (++_verify_index == sizeof(BME280VerifyRanges) / sizeof(BME280VerifyRanges[0])) _calibration_verified = true;
     }
-}
\ No newline at end of file
+}
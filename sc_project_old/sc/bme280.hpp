@@ -2,16 +2,21 @@
 #define SC_PROJECT_RP_PICO_PICO_SDK_SC_BME280_HPP_
 
 #include "sc.hpp"
+#include "bme280_compensation.hpp"
+
+#include "hardware/flash.h"
 
 namespace sc
 {
     // BME280 (気温，気圧，湿度センサ) の読み取り
     class BME280 : public Sensor
     {
+    protected:
         // BME280のセットアップ (I2CとSPI共通)
         // device_addr : 通信相手のデバイスを選択するためのアドレス
         // i2c_or spi : I2C型かSPI型のオブジェクト (一時オブジェクト不可)
-        BME280(uint8_t select_device, Communication& i2c_or_spi);
+        // [set_default_parameter] : 標準の測定方法を設定するか (省略時:設定する)  BME280Fixedでは設定を自身で書き込むためfalse
+        BME280(uint8_t select_device, Communication& i2c_or_spi, bool set_default_parameter = true);
     public:
         // BME280のセットアップ (I2C)
         // i2c : I2C型のオブジェクト (一時オブジェクト不可)
@@ -40,26 +45,10 @@ namespace sc
 
         // 測定した湿度を返す
         Humidity humidity() const noexcept;
-    private:
-        // I2C型かSPI型のオブジェクト
-        // BME280はI2CとSPIの両方で通信ができる．
-        // Communication型はI2c型とSpi型の両方のオブジェクトを入れられる
-        Communication& _i2c_or_spi;
-
-        // 通信相手のデバイスを選択するためのアドレス
-        // I2C通信の場合のスレーブアドレス
-        // SPI通信の場合のCS(チップセレクト)ピンのGPIO番号
-        uint8_t _select_device;
-
-        int32_t _raw_temperature; // 受信したデータを一時保管しておくための変数 (一般的な単位にはなっていない)
-        int32_t _raw_pressure;    // 受信したデータを一時保管しておくための変数 (一般的な単位にはなっていない)
-        int32_t _raw_humidity;    // 受信したデータを一時保管しておくための変数 (一般的な単位にはなっていない)
 
-        int32_t _conversion_parameter;  // 気温，温度，湿度を補正する際に使用するパラメータ  (気温によって変わる)
-
-        Temperature _temperature;  // 気温 (補正済)
-        Pressure _pressure;  // 気圧 (補正済)
-        Humidity _humidity;  // 湿度 (補正済)
+        // 測定した値を固定小数点のまま返す  (気温(℃)×100, 気圧(Pa)×256, 湿度(%)×1024)
+        // temperature などと違い浮動小数点数の計算をしないため，記録や送信にはこちらを使うと速い
+        const BME280Data& data() const noexcept {return _data;}
 
         // 測定のモード
         enum Mode
@@ -112,13 +101,85 @@ namespace sc
             SPI_WIRE_3
         };
 
-        uint16_t dig_T1;  // 気温補正用データ
-        int16_t dig_T2, dig_T3;  // 気温補正用データ
-        uint16_t dig_P1;  // 気圧補正用データ
-        int16_t dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;  // 気圧補正用データ
-        uint8_t dig_H1, dig_H3;  // 湿度補正用データ
-        int8_t dig_H6;  // 湿度補正用データ
-        int16_t dig_H2, dig_H4, dig_H5;  // 湿度補正用データ
+        // 強制モード(測定を指示したときに1回だけ変換するモード)に切り替える
+        // measure を呼び出すたびに変換を開始し，変換にかかる最大の時間だけ待ってから読み込むため，常に最新のデータを読み込めます
+        // start_measurement で変換を開始しておき，is_ready がtrueになってから measure を呼び出せば待機せずに読み込めます
+        // [over_sampling_t] : 気温のオーバーサンプリング (測定の精度を高めるが測定時間が伸びる) (省略時:1回)
+        // [over_sampling_p] : 気圧のオーバーサンプリング (測定の精度を高めるが測定時間が伸びる) (省略時:1回)
+        // [over_sampling_h] : 湿度のオーバーサンプリング (測定の精度を高めるが測定時間が伸びる) (省略時:1回)
+        // [filter] : ノイズ除去フィルタの係数 (省略時:フィルターなし)
+        void set_forced_mode(OverSampling over_sampling_t = OSRS_x1, OverSampling over_sampling_p = OSRS_x1, OverSampling over_sampling_h = OSRS_x1, Filter filter = FILTER_OFF);
+
+        // 強制モードで変換を開始  変換中か，まだ measure で読み込んでいない変換の結果がある場合は何もしない
+        void start_measurement();
+
+        // 開始した変換が終わったか
+        // 変換にかかる最大の時間が経つまでは通信せずにfalseを返し，経った後は状態レジスタ(0xF3)を1回だけ読み込む
+        // 一度trueを返した後は，measure で読み込むまで通信せずにtrueを返す
+        bool is_ready();
+
+        // 測定したデータが何μs前のものか
+        // 強制モードでは変換が終わった時刻からの経過時間，ノーマルモードでは読み込んだ時刻からの経過時間に待機時間と変換時間を足した最大値
+        uint32_t sample_age_us() const noexcept;
+
+        // 設定から求めた，1回の変換にかかる最大の時間 (μs)
+        uint32_t conversion_time_us() const noexcept {return _conversion_time_us;}
+
+        // 変換が終わったかを確認するために状態レジスタを読み込んだ回数
+        uint32_t status_polls() const noexcept {return _status_polls;}
+
+        // 補正用データを保存するフラッシュのセクタの位置 (フラッシュの先頭からのバイト数)  フラッシュの最後のセクタ(4KB)を使うため，プログラムや他のデータを置かないでください
+        static constexpr uint32_t CalibrationFlashOffset = PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE;
+
+        // 使っている補正用データがセンサのものと一致することを確認済みか
+        // フラッシュに保存した補正用データを使って起動した場合は，measure のたびに一部ずつセンサから読み込んで照合し，すべて一致するとtrueになる
+        // 一致しなかった場合はセンサから読み込み直し，store_pending_calibration でフラッシュに保存し直せるようにする  (センサから読み込んで起動した場合は最初からtrue)
+        bool calibration_verified() const noexcept {return _calibration_verified;}
+
+        // 補正用データをフラッシュに保存し直す必要があるか
+        // フラッシュに記録がなくセンサから読み込んで起動した場合と，measure の照合で一致しなかった場合にtrueになる
+        // セクタの消去には数十〜数百msかかるため，セットアップや measure の中ではフラッシュに書き込まない
+        bool calibration_store_pending() const noexcept {return _calibration_store_pending;}
+
+        // 保存する必要がある補正用データをフラッシュに保存する  必要がない場合は何もしない
+        // 消去と書き込みの間はどちらのコアもフラッシュ上のプログラムを実行できないため，測定の合間など時間に余裕があるときに呼び出してください
+        // もう一方のコアを使う場合は，そのコアで flash_safe_execute_core_init を呼び出しておくと，書き込みの間だけ止められます
+        // 戻り値 : 保存し直す必要がなくなったか  (もう一方のコアを止められなかった場合などはfalse  後で呼び出し直す)
+        bool store_pending_calibration() noexcept;
+
+    protected:  // BME280Fixedから使う
+        // I2C型かSPI型のオブジェクト
+        // BME280はI2CとSPIの両方で通信ができる．
+        // Communication型はI2c型とSpi型の両方のオブジェクトを入れられる
+        Communication& _i2c_or_spi;
+
+        // 通信相手のデバイスを選択するためのアドレス
+        // I2C通信の場合のスレーブアドレス
+        // SPI通信の場合のCS(チップセレクト)ピンのGPIO番号
+        uint8_t _select_device;
+
+        BME280Raw _raw;  // 受信したデータを一時保管しておくための変数 (一般的な単位にはなっていない)
+        BME280Data _data;  // 補正済みのデータ (固定小数点)  一般的な単位へは temperature などで必要になったときに変換する
+        bool _has_temperature = false;  // 気温を測定できたか
+        bool _has_pressure = false;  // 気圧を測定できたか
+        bool _has_humidity = false;  // 湿度を測定できたか
+
+        uint8_t _chip_id = 0;  // check_connection で読み取ったチップID
+        uint8_t _calibration_bytes[BME280Calibration::TemperaturePressureBytes + BME280Calibration::HumidityBytes];  // 補正用データ (0x88〜0xA1, 0xE1〜0xE7)  フラッシュへの保存と照合に使う
+        BME280Calibration _calibration;  // 補正用データから求めた定数
+        bool _calibration_verified = true;  // 補正用データがセンサのものと一致することを確認済みか
+        bool _calibration_store_pending = false;  // 補正用データをフラッシュに保存し直す必要があるか
+        uint8_t _verify_index = 0;  // 次に照合する補正用データの範囲の番号
+
+        Mode _mode = MODE_SLEEP;  // 測定のモード
+        uint8_t _ctrl_meas = 0;  // 0xF4に書き込む値 (モード以外)
+        uint32_t _conversion_time_us = 0;  // 1回の変換にかかる最大の時間 (μs)
+        uint32_t _standby_time_us = 0;  // ノーマルモードでの測定と測定の間の待機時間 (μs)
+        bool _converting = false;  // 強制モードで変換中か
+        bool _result_ready = false;  // 強制モードで変換が終わり，まだ measure で読み込んでいない結果があるか
+        uint32_t _ready_time_us = 0;  // 強制モードで変換が終わる時刻 (μs)
+        uint32_t _sample_time_us = 0;  // 測定したデータの時刻 (μs)  強制モードでは変換が終わった時刻，ノーマルモードでは読み込んだ時刻
+        uint32_t _status_polls = 0;
         
         // 測定方法などを設定
         // [mode] : 測定のモード (省略時:ノーマル)
@@ -128,29 +189,152 @@ namespace sc
         // [stanby_time] : 測定と測定の間の待機時間の長さ (省略時:125ms)
         // [filter] : ノイズ除去フィルタの係数 (ノイズを減らすが測定時間が伸びる) (省略時:フィルター2)
         // [spi_wire_num] : SPI使用時に，3線式を使用するか，4線式を使用するか (省略時:4線式)
-        void set_parameter(Mode mode = MODE_NORMAL, OverSampling over_sampling_t = OSRS_x2, OverSampling over_sampling_p = OSRS_x4, OverSampling over_sampling_h = OSRS_x1, StanbyTime stanby_time = ST_125ms, Filter filter = FILTER_2, SpiWireNum spi_wire_num = SPI_WIRE_4) const;
+        void set_parameter(Mode mode = MODE_NORMAL, OverSampling over_sampling_t = OSRS_x2, OverSampling over_sampling_p = OSRS_x4, OverSampling over_sampling_h = OSRS_x1, StanbyTime stanby_time = ST_125ms, Filter filter = FILTER_2, SpiWireNum spi_wire_num = SPI_WIRE_4);
 
         // 補正用データ読み取り
         void read_compensation_data();
 
-        // 生データ読み取り (一般的な単位にはなっていない)
-        void read_raw();
+        // フラッシュに保存した補正用データを読み込む
+        // 戻り値 : バス，デバイスの番号，チップIDが一致し，CRCが正しい記録があった:true, なかった:false
+        bool load_cached_calibration() noexcept;
+
+        // 補正用データをフラッシュに保存  同じ内容が保存されている場合は書き込まない
+        // 戻り値 : 保存したか，同じ内容が保存されていた:true, 書き込めなかった:false
+        bool store_cached_calibration() noexcept;
 
-        // 補正用のパラメータを計算
-        void calc_conversion_parameter();
+        // フラッシュから読み込んだ補正用データの一部をセンサから読み込んで照合する  照合が済んでいる場合は何もしない
+        // 一致しなかった場合はセンサから読み込み直すが，フラッシュには書き込まずに _calibration_store_pending をtrueにする
+        void verify_cached_calibration();
 
-        // 気温データを補正して保存
-        void convert_temperature();
+        // 強制モードで，まだ読み込んでいない変換の結果ができるまで待つ
+        // is_ready で終わりを確認済みの場合は通信も待機もしない  変換を開始していなければここで開始する
+        // 状態レジスタの変換中のビットが消えないまま，変換にかかる最大の時間の2倍が経った場合は例外を投げる (measure の中で止まり続けないようにする)
+        void wait_for_conversion();
 
-        // 気圧データを補正して保存
-        void convert_pressure();
+        // 生データ読み取り (一般的な単位にはなっていない)
+        void read_raw();
 
-        // 湿度データを補正して保存
-        void convert_humidity();
     };
     // このクラスの作成にあたり以下の資料を参考にしました
     // https://akizukidenshi.com/download/ds/bosch/BST-BME280_DS001-10.pdf
     // https://qiita.com/nanase/items/f34e03c29410add9c4d0
+
+    // BME280Fixedの測定方法  設定をテンプレート引数で指定し，レジスタに書き込む値や変換時間をコンパイル時に求める
+    // 例: BME280Fixed<BME280Config<BME280::MODE_FORCED, BME280::OSRS_x2, BME280::OSRS_x4, BME280::OSRS_SKIPPED>> bme280(i2c, 0x76);
+    // [mode_] : 測定のモード (省略時:強制モード)
+    // [over_sampling_t] : 気温のオーバーサンプリング  気温は気圧と湿度の補正に使うため，測定しないことはできない (省略時:1回)
+    // [over_sampling_p] : 気圧のオーバーサンプリング  OSRS_SKIPPEDの場合は気圧を読み込まない (省略時:1回)
+    // [over_sampling_h] : 湿度のオーバーサンプリング  OSRS_SKIPPEDの場合は湿度を読み込まない (省略時:1回)
+    // [filter] : ノイズ除去フィルタの係数 (省略時:フィルターなし)
+    // [stanby_time] : ノーマルモードでの測定と測定の間の待機時間の長さ (省略時:0.5ms)
+    // [spi_wire_num] : SPI使用時に，3線式を使用するか，4線式を使用するか (省略時:4線式)
+    template<BME280::Mode mode_ = BME280::MODE_FORCED, BME280::OverSampling over_sampling_t = BME280::OSRS_x1, BME280::OverSampling over_sampling_p = BME280::OSRS_x1, BME280::OverSampling over_sampling_h = BME280::OSRS_x1,
+        BME280::Filter filter = BME280::FILTER_OFF, BME280::StanbyTime stanby_time = BME280::ST_0_5ms, BME280::SpiWireNum spi_wire_num = BME280::SPI_WIRE_4>
+    struct BME280Config
+    {
+        static_assert(over_sampling_t != BME280::OSRS_SKIPPED, "BME280 temperature measurement cannot be skipped");  // BME280の気温の測定は省略できません
+        static_assert(mode_ != BME280::MODE_SLEEP, "BME280Fixed needs forced or normal mode");  // BME280Fixedには強制モードかノーマルモードが必要です
+
+        // オーバーサンプリングの設定値に対応する回数 (5以上はすべて16回)
+        static constexpr uint32_t samples(BME280::OverSampling over_sampling) {return over_sampling == BME280::OSRS_SKIPPED ? 0 : (over_sampling >= BME280::OSRS_x16 ? 16 : 1u << (over_sampling - 1));}
+
+        static constexpr BME280::Mode Mode = mode_;
+        static constexpr bool HasPressure = (over_sampling_p != BME280::OSRS_SKIPPED);
+        static constexpr bool HasHumidity = (over_sampling_h != BME280::OSRS_SKIPPED);
+
+        static constexpr uint8_t CtrlHum = over_sampling_h;  // 0xF2に書き込む値
+        static constexpr uint8_t CtrlMeas = (over_sampling_t << 5) | (over_sampling_p << 2) | mode_;  // 0xF4に書き込む値
+        static constexpr uint8_t ConfigRegister = (stanby_time << 5) | (filter << 2) | spi_wire_num;  // 0xF5に書き込む値
+
+        // 1回の変換にかかる最大の時間 (μs)  (データシート 9.1)
+        static constexpr uint32_t ConversionTimeUs = 1250 + 2300 * samples(over_sampling_t) + (HasPressure ? 2300 * samples(over_sampling_p) + 575 : 0) + (HasHumidity ? 2300 * samples(over_sampling_h) + 575 : 0);
+
+        // ノーマルモードでの測定と測定の間の待機時間 (μs)
+        static constexpr uint32_t StandbyTimeUs = (stanby_time == BME280::ST_0_5ms ? 500 : stanby_time == BME280::ST_10ms ? 10000 : stanby_time == BME280::ST_20ms ? 20000 : 62500u << (stanby_time - BME280::ST_62_5ms));
+
+        // 一度に読み込むデータ  気圧(0xF7〜0xF9)，気温(0xFA〜0xFC)，湿度(0xFD〜0xFE)の順に並んでいるので，測定しない気圧と湿度は読み込まない
+        static constexpr uint8_t ReadAddress = (HasPressure ? 0xf7 : 0xfa);
+        static constexpr std::size_t ReadBytes = (HasPressure ? 3 : 0) + 3 + (HasHumidity ? 2 : 0);
+    };
+
+    // 測定方法をコンパイル時に決めたBME280 (気温，気圧，湿度センサ) の読み取り
+    // レジスタに書き込む値，変換時間，読み込むバイト数がすべて定数になるため，measure の中で設定による分岐をしません
+    // Config : 測定方法  BME280Config<...> を指定する
+    template<typename Config>
+    class BME280Fixed : public BME280
+    {
+    public:
+        // BME280のセットアップ (I2C)
+        // i2c : I2C型のオブジェクト (一時オブジェクト不可)
+        // slave_addr : I2Cのスレーブアドレス
+        BME280Fixed(I2C& i2c, uint8_t slave_addr):
+            BME280(slave_addr, i2c, false) {set_fixed_parameter();}
+
+        // BME280のセットアップ (SPI)
+        // spi : SPI型のオブジェクト (一時オブジェクト不可)
+        // cs_gpio : CSピンのGPIO番号
+        BME280Fixed(SPI& spi, uint8_t cs_gpio):
+            BME280(cs_gpio, spi, false) {set_fixed_parameter();}
+
+        // 測定を実行
+        // 強制モードの場合は BME280::measure と同じく，変換を開始していなければ開始し，終わるまで待ってから読み込む
+        // start_measurement で変換を開始しておき，is_ready がtrueになってから呼び出せば待機せずに読み込めます
+        void measure() noexcept
+        {
+            try
+            {
+                // 最初にエラー値を代入
+                _has_temperature = _has_pressure = _has_humidity = false;
+
+                if (Config::Mode == MODE_FORCED) wait_for_conversion();  // 0xF4に書き込む値と変換時間は set_fixed_parameter で設定した定数
+
+                // 生データ読み取り (一般的な単位にはなっていない)  測定しない気圧と湿度は読み込まない
+                uint8_t input_data[Config::ReadBytes];
+                _i2c_or_spi.read_mem(Config::ReadAddress, Config::ReadBytes, input_data, _select_device);
+                _result_ready = false;
+                if (Config::Mode != MODE_FORCED) _sample_time_us = time_us_32();
+
+                const uint8_t* data = input_data;
+                if (Config::HasPressure)
+                {
+                    _raw.pressure = ((uint32_t) data[0] << 12) | ((uint32_t) data[1] << 4) | (data[2] >> 4);
+                    data += 3;
+                }
+                _raw.temperature = ((uint32_t) data[0] << 12) | ((uint32_t) data[1] << 4) | (data[2] >> 4);
+                if (Config::HasHumidity) _raw.humidity = (uint32_t) data[3] << 8 | data[4];
+                verify_cached_calibration();  // フラッシュから読み込んだ補正用データを少しずつ照合する
+
+                // 補正  測定しない値は補正しない
+                int32_t t_fine = _calibration.t_fine(_raw.temperature);
+                _data.temperature = BME280Calibration::temperature(t_fine);
+                if (Config::HasPressure) _data.pressure = _calibration.pressure(_raw.pressure, t_fine);
+                if (Config::HasHumidity) _data.humidity = _calibration.humidity(_raw.humidity, t_fine);
+                _has_temperature = true;
+                _has_pressure = Config::HasPressure;
+                _has_humidity = Config::HasHumidity;
+            }
+            catch(const std::exception& e)
+            {
+                Error(__FILE__, __LINE__, "Measurement with BME280 failed", e.what());  // BME280での測定に失敗しました
+            }
+        }
+
+    private:
+        // コンパイル時に求めた設定を書き込む
+        void set_fixed_parameter()
+        {
+            // 0xF5はスリープモードのときに書き込み，モードは最後に書き込む (0xF2は0xF4を書き込んだときに反映される)
+            _i2c_or_spi.write_byte_mem(0xf2, Config::CtrlHum, _select_device);
+            _i2c_or_spi.write_byte_mem(0xf4, Config::CtrlMeas & ~0x03, _select_device);
+            _i2c_or_spi.write_byte_mem(0xf5, Config::ConfigRegister, _select_device);
+            if (Config::Mode == MODE_NORMAL) _i2c_or_spi.write_byte_mem(0xf4, Config::CtrlMeas, _select_device);
+
+            _mode = Config::Mode;
+            _conversion_time_us = Config::ConversionTimeUs;
+            _standby_time_us = Config::StandbyTimeUs;
+            _ctrl_meas = Config::CtrlMeas & ~0x03;
+        }
+    };
 }
 
 #endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_BME280_HPP_
\ No newline at end of file
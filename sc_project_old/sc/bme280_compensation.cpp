@@ -0,0 +1,155 @@
+#include "bme280_compensation.hpp"
+
+#if !defined(PICO_ON_DEVICE) || !PICO_ON_DEVICE
+#include <functional>
+#include <system_error>
+#include <thread>
+#include <vector>
+#endif
+
+namespace sc
+{
+    static constexpr std::size_t BME280BlockSize = 256;  // まとめて補正するときに一度に処理する数  中間の配列(約4KB)がL1キャッシュに収まる大きさ
+    /***** struct BME280Calibration *****/
+
+    // 補正用データから定数を求める
+    // temperature_pressure : 0x88〜0xA1 から読み込んだ26バイト
+    // humidity : 0xE1〜0xE7 から読み込んだ7バイト
+    void BME280Calibration::load(const uint8_t* temperature_pressure, const uint8_t* humidity)
+    {
+        const uint8_t* data = temperature_pressure;
+        uint16_t dig_T1 = data[0] | (data[1] << 8);
+        int16_t dig_T2 = data[2] | (data[3] << 8);
+        int16_t dig_T3 = data[4] | (data[5] << 8);
+        uint16_t dig_P1 = data[6] | (data[7] << 8);
+        int16_t dig_P2 = data[8] | (data[9] << 8);
+        int16_t dig_P3 = data[10] | (data[11] << 8);
+        int16_t dig_P4 = data[12] | (data[13] << 8);
+        int16_t dig_P5 = data[14] | (data[15] << 8);
+        int16_t dig_P6 = data[16] | (data[17] << 8);
+        int16_t dig_P7 = data[18] | (data[19] << 8);
+        int16_t dig_P8 = data[20] | (data[21] << 8);
+        int16_t dig_P9 = data[22] | (data[23] << 8);
+        uint8_t dig_H1 = data[25];  // 0xA1  (0xA0は使われていない)
+
+        data = humidity;
+        int16_t dig_H2 = data[0] | (data[1] << 8);  // 0xE1, 0xE2
+        uint8_t dig_H3 = data[2];  // 0xE3
+        int16_t dig_H4 = (static_cast<int8_t>(data[3]) * 16) | (data[4] & 0x0f);  // 0xE4が上位8ビット(符号付き)，0xE5の下位4ビットが下位4ビット
+        int16_t dig_H5 = (static_cast<int8_t>(data[5]) * 16) | (data[4] >> 4);  // 0xE6が上位8ビット(符号付き)，0xE5の上位4ビットが下位4ビット
+        int8_t dig_H6 = static_cast<int8_t>(data[6]);  // 0xE7
+
+        // シフトは掛け算で行い，負の数を左シフトしないようにする
+        t1 = dig_T1;
+        t1_x2 = dig_T1 * 2;
+        t2 = dig_T2;
+        t3 = dig_T3;
+
+        p1 = dig_P1;
+        p2_x2_12 = static_cast<int64_t>(dig_P2) * (1 << 12);
+        p3 = dig_P3;
+        p4_x2_35 = static_cast<int64_t>(dig_P4) * (static_cast<int64_t>(1) << 35);
+        p5_x2_17 = static_cast<int64_t>(dig_P5) * (1 << 17);
+        p6 = dig_P6;
+        p7_x2_4 = static_cast<int64_t>(dig_P7) * (1 << 4);
+        p8 = dig_P8;
+        p9 = dig_P9;
+
+        h1 = dig_H1;
+        h2 = dig_H2;
+        h3 = dig_H3;
+        h4_x2_20 = static_cast<int32_t>(dig_H4) * (1 << 20);
+        h5 = dig_H5;
+        h6 = dig_H6;
+    }
+
+    /***** function bme280_compensate *****/
+
+    // BME280BlockSize 個以下の生データを補正する
+    // 計算の種類ごとに別のループにし，分岐のない同じ計算を配列に対して繰り返すことで，コンパイラがSIMD命令に置き換えられるようにする
+    static void bme280_compensate_block(const BME280Calibration& calibration, std::size_t count, const uint8_t* frames,
+        int32_t* temperature, uint32_t* pressure, uint32_t* humidity)
+    {
+        const BME280Calibration c = calibration;  // ローカルにコピーし，出力の配列と重なっていないことをコンパイラに分からせる
+        int32_t raw_temperature[BME280BlockSize];
+        int32_t raw_pressure[BME280BlockSize];
+        int32_t raw_humidity[BME280BlockSize];
+        int32_t t_fine[BME280BlockSize];
+
+        // 8バイトずつ並んだ生データを，種類ごとの配列に並べ替える
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const uint8_t* frame = frames + i * BME280Raw::FrameBytes;
+            raw_pressure[i] = ((uint32_t) frame[0] << 12) | ((uint32_t) frame[1] << 4) | (frame[2] >> 4);
+            raw_temperature[i] = ((uint32_t) frame[3] << 12) | ((uint32_t) frame[4] << 4) | (frame[5] >> 4);
+            raw_humidity[i] = (uint32_t) frame[6] << 8 | frame[7];
+        }
+
+        for (std::size_t i = 0; i < count; ++i) t_fine[i] = c.t_fine(raw_temperature[i]);
+        for (std::size_t i = 0; i < count; ++i) temperature[i] = BME280Calibration::temperature(t_fine[i]);
+        if (humidity)
+        {
+            for (std::size_t i = 0; i < count; ++i) humidity[i] = c.humidity(raw_humidity[i], t_fine[i]);
+        }
+        if (pressure)  // 64ビットの割り算があるためSIMD命令にはならないが，ほかの計算と分けておく
+        {
+            for (std::size_t i = 0; i < count; ++i) pressure[i] = c.pressure(raw_pressure[i], t_fine[i]);
+        }
+    }
+
+    // 記録した生データ(0xF7〜0xFEの8バイト)をまとめて補正する  地上でログを処理するときに使う
+    // 結果は BME280Calibration::compensate と1ビットも違いません
+    // calibration : 補正用データ
+    // count : 生データの数
+    // frames : 生データ  (count×8バイト)
+    // temperature : 気温 (℃)×100 を書き込む配列  (count個)
+    // [pressure] : 気圧 (Pa)×256 を書き込む配列  (count個，nullptrなら計算しない)
+    // [humidity] : 湿度 (%)×1024 を書き込む配列  (count個，nullptrなら計算しない)
+    void bme280_compensate(const BME280Calibration& calibration, std::size_t count, const uint8_t* frames,
+        int32_t* temperature, uint32_t* pressure, uint32_t* humidity)
+    {
+        for (std::size_t begin = 0; begin < count; begin += BME280BlockSize)
+        {
+            std::size_t size = (count - begin < BME280BlockSize) ? count - begin : BME280BlockSize;
+            bme280_compensate_block(calibration, size, frames + begin * BME280Raw::FrameBytes, temperature + begin,
+                pressure ? pressure + begin : nullptr, humidity ? humidity + begin : nullptr);
+        }
+    }
+
+#if !defined(PICO_ON_DEVICE) || !PICO_ON_DEVICE
+    // bme280_compensate を複数のスレッドで分担して行う  引数は bme280_compensate と同じ
+    // [threads] : スレッドの数 (省略時:0  0ならCPUのスレッド数)
+    void bme280_compensate_parallel(const BME280Calibration& calibration, std::size_t count, const uint8_t* frames,
+        int32_t* temperature, uint32_t* pressure, uint32_t* humidity, unsigned threads)
+    {
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;  // スレッド数が分からなかったとき
+
+        // 1スレッドあたりの数  少なすぎるとスレッドを作る時間の方が長くなるため，BME280BlockSize の倍数で16ブロック以上にする
+        std::size_t blocks = (count + BME280BlockSize - 1) / BME280BlockSize;
+        std::size_t blocks_per_thread = (blocks + threads - 1) / threads;
+        if (blocks_per_thread < 16) blocks_per_thread = 16;
+        std::size_t chunk = blocks_per_thread * BME280BlockSize;
+
+        std::vector<std::thread> workers;
+        workers.reserve((count + chunk - 1) / chunk);
+        for (std::size_t begin = chunk; begin < count; begin += chunk)  // 最初の分担は呼び出したスレッドで行う
+        {
+            std::size_t size = (count - begin < chunk) ? count - begin : chunk;
+            const uint8_t* chunk_frames = frames + begin * BME280Raw::FrameBytes;
+            uint32_t* chunk_pressure = pressure ? pressure + begin : nullptr;
+            uint32_t* chunk_humidity = humidity ? humidity + begin : nullptr;
+            try
+            {
+                workers.emplace_back(bme280_compensate, std::cref(calibration), size, chunk_frames, temperature + begin, chunk_pressure, chunk_humidity);
+            }
+            catch (const std::system_error&)
+            {
+                bme280_compensate(calibration, size, chunk_frames, temperature + begin, chunk_pressure, chunk_humidity);  // スレッドを作れなかったときは呼び出したスレッドで行う
+            }
+        }
+        bme280_compensate(calibration, (count < chunk) ? count : chunk, frames, temperature, pressure, humidity);
+        for (auto& worker : workers) worker.join();
+    }
+#endif
+}
@@ -0,0 +1,134 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_BME280_COMPENSATION_HPP_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_BME280_COMPENSATION_HPP_
+
+// 記録した生データをパソコン(Linuxなど)でも同じ計算で補正できるように，pico-sdkやsc.hppは読み込まない
+#include <cstddef>
+#include <cstdint>
+
+namespace sc
+{
+    // BME280の生データ (一般的な単位にはなっていない)
+    struct BME280Raw
+    {
+        int32_t temperature = 0;  // 20ビット
+        int32_t pressure = 0;  // 20ビット
+        int32_t humidity = 0;  // 16ビット
+
+        static const std::size_t FrameBytes = 8;  // 0xF7〜0xFE から一度に読み込むバイト数
+
+        // 0xF7〜0xFE から読み込んだ8バイトを生データに分解する
+        // frame : 0xF7〜0xFE から読み込んだ8バイト (記録したデータでもよい)
+        static BME280Raw from_frame(const uint8_t* frame)
+        {
+            BME280Raw raw;
+            raw.pressure = ((uint32_t) frame[0] << 12) | ((uint32_t) frame[1] << 4) | (frame[2] >> 4);
+            raw.temperature = ((uint32_t) frame[3] << 12) | ((uint32_t) frame[4] << 4) | (frame[5] >> 4);
+            raw.humidity = (uint32_t) frame[6] << 8 | frame[7];
+            return raw;
+        }
+    };
+
+    // BME280の補正済みのデータ  小数を使わず，整数(固定小数点)で保存する
+    // RP2040には浮動小数点数の計算回路がないため，一般的な単位(double)への変換は必要になったときにだけ行う
+    struct BME280Data
+    {
+        int32_t temperature = 0;  // 気温 (℃)×100
+        uint32_t pressure = 0;  // 気圧 (Pa)×256
+        uint32_t humidity = 0;  // 湿度 (%)×1024
+    };
+
+    // BME280の補正用データと，そこから求めた補正の計算に使う定数
+    // 補正用データを読み込んだときに係数のシフトや符号の拡張を済ませておき，測定のたびに行う計算を減らします
+    // 計算結果はデータシートの整数による計算(BME280_compensate_T_int32, BME280_compensate_P_int64, bme280_compensate_H_int32)と1ビットも違いません
+    struct BME280Calibration
+    {
+        static const std::size_t TemperaturePressureBytes = 26;  // 0x88〜0xA1 の補正用データのバイト数
+        static const std::size_t HumidityBytes = 7;  // 0xE1〜0xE7 の補正用データのバイト数
+
+        // 補正用データから定数を求める
+        // temperature_pressure : 0x88〜0xA1 から読み込んだ26バイト
+        // humidity : 0xE1〜0xE7 から読み込んだ7バイト
+        void load(const uint8_t* temperature_pressure, const uint8_t* humidity);
+
+        // 気温の補正  気圧と湿度の補正に使う値(t_fine)を返す
+        // 以下の補正の関数はすべての測定で呼び出すため，ヘッダーに書いてインライン展開させる
+        int32_t t_fine(int32_t raw_temperature) const
+        {
+            int32_t var1 = (((raw_temperature >> 3) - t1_x2) * t2) >> 11;
+            int32_t var2 = (raw_temperature >> 4) - t1;
+            var2 = (((var2 * var2) >> 12) * t3) >> 14;
+            return var1 + var2;
+        }
+
+        // 気温を求める (℃)×100
+        static int32_t temperature(int32_t t_fine)
+        {
+            return (t_fine * 5 + 128) >> 8;
+        }
+
+        // 気圧を求める (Pa)×256
+        uint32_t pressure(int32_t raw_pressure, int32_t t_fine) const
+        {
+            int64_t var1 = static_cast<int64_t>(t_fine) - 128000;
+            int64_t var2 = var1 * (var1 * p6 + p5_x2_17) + p4_x2_35;
+            var1 = ((var1 * var1 * p3) >> 8) + var1 * p2_x2_12;
+            var1 = ((static_cast<int64_t>(1) << 47) + var1) * p1 >> 33;
+            if (var1 == 0)
+        return 0;  // 0で割らないようにする
+            int64_t p = 1048576 - raw_pressure;
+            p = ((p * (static_cast<int64_t>(1) << 31) - var2) * 3125) / var1;
+            var1 = (p9 * (p >> 13) * (p >> 13)) >> 25;
+            var2 = (p8 * p) >> 19;
+            return static_cast<uint32_t>(((p + var1 + var2) >> 8) + p7_x2_4);
+        }
+
+        // 湿度を求める (%)×1024
+        uint32_t humidity(int32_t raw_humidity, int32_t t_fine) const
+        {
+            int32_t v = t_fine - 76800;
+            v = ((((raw_humidity << 14) - h4_x2_20 - (h5 * v)) + 16384) >> 15) * (((((((v * h6) >> 10) * (((v * h3) >> 11) + 32768)) >> 10) + 2097152) * h2 + 8192) >> 14);
+            v = v - (((((v >> 15) * (v >> 15)) >> 7) * h1) >> 4);
+            v = (v < 0 ? 0 : v);
+            v = (v > 419430400 ? 419430400 : v);
+            return static_cast<uint32_t>(v >> 12);
+        }
+
+        // 生データをまとめて補正する
+        BME280Data compensate(const BME280Raw& raw) const
+        {
+            BME280Data data;
+            int32_t fine = t_fine(raw.temperature);
+            data.temperature = temperature(fine);
+            data.pressure = pressure(raw.pressure, fine);
+            data.humidity = humidity(raw.humidity, fine);
+            return data;
+        }
+
+        // 補正の計算に使う定数  (dig_XXを型を揃え，シフトを済ませたもの)
+        int32_t t1, t1_x2, t2, t3;
+        int64_t p1, p2_x2_12, p3, p4_x2_35, p5_x2_17, p6, p7_x2_4, p8, p9;
+        int32_t h1, h2, h3, h4_x2_20, h5, h6;
+    };
+    // このクラスの作成にあたり以下の資料を参考にしました
+    // https://akizukidenshi.com/download/ds/bosch/BST-BME280_DS001-10.pdf  (4.2.3 Compensation formulas, 8.2 Pressure compensation in 64 bit format)
+
+    // 記録した生データ(0xF7〜0xFEの8バイト)をまとめて補正する  地上でログを処理するときに使う
+    // 結果は BME280Calibration::compensate と1ビットも違いません
+    // calibration : 補正用データ
+    // count : 生データの数
+    // frames : 生データ  (count×8バイト)
+    // temperature : 気温 (℃)×100 を書き込む配列  (count個)
+    // [pressure] : 気圧 (Pa)×256 を書き込む配列  (count個，nullptrなら計算しない)
+    // [humidity] : 湿度 (%)×1024 を書き込む配列  (count個，nullptrなら計算しない)
+    void bme280_compensate(const BME280Calibration& calibration, std::size_t count, const uint8_t* frames,
+        int32_t* temperature, uint32_t* pressure = nullptr, uint32_t* humidity = nullptr);
+
+#if !defined(PICO_ON_DEVICE) || !PICO_ON_DEVICE  // std::threadはRP2040では使えないため，パソコン向けにビルドしたときだけ使えるようにする
+    // bme280_compensate を複数のスレッドで分担して行う  引数は bme280_compensate と同じ
+    // [threads] : スレッドの数 (省略時:0  0ならCPUのスレッド数)
+    void bme280_compensate_parallel(const BME280Calibration& calibration, std::size_t count, const uint8_t* frames,
+        int32_t* temperature, uint32_t* pressure = nullptr, uint32_t* humidity = nullptr, unsigned threads = 0);
+#endif
+}
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_BME280_COMPENSATION_HPP_
@@ -0,0 +1,23 @@
+#include "crc.hpp"
+
+namespace sc
+{
+    // CRC-16/CCITT-FALSE (多項式0x1021, 初期値0xFFFF)  テレメトリのフレームや，フラッシュに保存するデータの確認に使う
+    // 4ビットずつ表を引くことで，表を小さく(32バイト)したまま1ビットずつ計算するより速くする
+    // data : CRCを求めるデータ
+    // data_bytes : データのバイト数
+    uint16_t crc16(const uint8_t* data, std::size_t data_bytes)
+    {
+        static const uint16_t Table[16] = {
+            0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+            0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+        };
+        uint16_t crc = 0xffff;
+        for (std::size_t i = 0; i < data_bytes; ++i)
+        {
+            crc = (crc << 4) ^ Table[(crc >> 12) ^ (data[i] >> 4)];
+            crc = (crc << 4) ^ Table[(crc >> 12) ^ (data[i] & 0x0f)];
+        }
+        return crc;
+    }
+}
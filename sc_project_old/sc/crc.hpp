@@ -0,0 +1,16 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_CRC_HPP_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_CRC_HPP_
+
+// テレメトリ(地上局のパソコンでも使う)とセンサのドライバの両方から使うため，pico-sdkやsc.hppは読み込まない
+#include <cstddef>
+#include <cstdint>
+
+namespace sc
+{
+    // CRC-16/CCITT-FALSE (多項式0x1021, 初期値0xFFFF)  テレメトリのフレームや，フラッシュに保存するデータの確認に使う
+    // data : CRCを求めるデータ
+    // data_bytes : データのバイト数
+    uint16_t crc16(const uint8_t* data, std::size_t data_bytes);
+}
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_CRC_HPP_
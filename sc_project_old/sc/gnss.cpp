@@ -0,0 +1,529 @@
+#include "gnss.hpp"
+
+namespace sc
+{
+    /***** class NMEAParser *****/
+
+    // 数字の並びを固定小数点の整数として読む  (strtodを使わない)
+    // field : 読み込む文字列 (終端文字は不要)
+    // length : 文字列の長さ
+    // decimals : 小数点以下を何桁まで読むか  それより後の桁は切り捨て，足りない桁は0で埋める
+    // value : 読み込んだ値×10^decimals
+    // 戻り値 : 数字として読めたか (空の場合はfalse)
+    static bool parse_fixed(const char* field, std::size_t length, int decimals, int64_t& value)
+    {
+        if (!length)
+    return false;
+
+        std::size_t i = 0;
+        bool negative = (field[0] == '-');
+        if (negative) ++i;
+
+        int64_t result = 0;
+        int fraction = -1;  // 小数点以下の何桁目まで読んだか  -1のときは小数点より前
+        for (; i < length; ++i)
+        {
+            char c = field[i];
+            if (c == '.')
+            {
+                if (fraction >= 0)
+    return false;  // 小数点が2つある
+                fraction = 0;
+    continue;
+            }
+            if (c < '0' || c > '9')
+    return false;
+            if (fraction >= decimals)
+    continue;  // 必要な桁数より後は切り捨てる
+            result = result * 10 + (c - '0');
+            if (fraction >= 0) ++fraction;
+        }
+        if (fraction < 0) fraction = 0;
+        for (; fraction < decimals; ++fraction) result *= 10;
+
+        value = (negative ? -result : result);
+        return true;
+    }
+
+    // NMEAの緯度・経度 (ddmm.mmmm または dddmm.mmmm) を (°)×10^7 に変換
+    // 戻り値 : 数字として読めたか
+    static bool parse_coordinate(const char* field, std::size_t length, int32_t& coordinate_e7)
+    {
+        int64_t value;  // ddmm.mmmm×10^7
+        if (!parse_fixed(field, length, 7, value))
+    return false;
+        int64_t degrees = value / 1000000000;  // 上2桁(経度は3桁)が度
+        int64_t minutes_e7 = value % 1000000000;  // 下2桁と小数部分が分
+        coordinate_e7 = static_cast<int32_t>(degrees * 10000000 + (minutes_e7 + 30) / 60);  // 1分 = 1/60度  四捨五入する
+        return true;
+    }
+
+    // NMEAの時刻 (hhmmss.ss) を0時からの経過時間 (ms) に変換
+    // 戻り値 : 数字として読めたか
+    static bool parse_time(const char* field, std::size_t length, uint32_t& time_ms)
+    {
+        int64_t value;  // hhmmss.sss×10^3
+        if (!parse_fixed(field, length, 3, value))
+    return false;
+        uint32_t hours = value / 10000000;
+        uint32_t minutes = (value / 100000) % 100;
+        uint32_t seconds_ms = value % 100000;
+        time_ms = (hours * 3600 + minutes * 60) * 1000 + seconds_ms;
+        return true;
+    }
+
+    // 16進数の1文字を数値に変換  16進数でない場合は-1
+    static int hex_value(char c)
+    {
+        if (c >= '0' && c <= '9')
+    return c - '0';
+        if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+        return -1;
+    }
+
+    // 1文字読み込む
+    // c : 受信した文字
+    // fix : 測位結果  チェックサムが正しい文を読み終えたときにだけ更新する
+    // 戻り値 : 文を読み終え，fixを更新したか
+    bool NMEAParser::feed(char c, GNSSFix& fix)
+    {
+        if (c == '$')  // どの状態からでも，$は新しい文の始まりとみなす (途中で途切れた文は捨てる)
+        {
+            if (_state != State::WAIT_START) ++_errors;
+            _state = State::SENTENCE;
+            _type = Type::UNKNOWN;
+            _checksum = 0;
+            _length = 1;
+            _field_index = 0;
+            _field_length = 0;
+            _pending = fix;  // 文に含まれない値はそのまま残す
+    return false;
+        }
+
+        switch (_state)
+        {
+            case State::WAIT_START:
+            {
+    return false;
+            }
+            case State::SENTENCE:
+            {
+                if (++_length > MaxSentenceLength || c == '\r' || c == '\n')  // 長すぎる文や，チェックサムのない文は捨てる
+                {
+                    ++_errors;
+                    _state = State::WAIT_START;
+    return false;
+                }
+                if (c == '*')
+                {
+                    parse_field();
+                    _state = State::CHECKSUM_HIGH;
+    return false;
+                }
+                _checksum ^= c;  // $と*の間の文字の排他的論理和がチェックサム
+                if (c == ',')
+                {
+                    parse_field();
+                    ++_field_index;
+                    _field_length = 0;
+    return false;
+                }
+                if (_field_length < MaxFieldLength) _field[_field_length] = c;
+                if (_field_length <= MaxFieldLength) ++_field_length;  // 長すぎるフィールドはMaxFieldLength+1として，解釈しない
+    return false;
+            }
+            case State::CHECKSUM_HIGH:
+            {
+                int value = hex_value(c);
+                if (value < 0)
+                {
+                    ++_errors;
+                    _state = State::WAIT_START;
+    return false;
+                }
+                _received_checksum = value << 4;
+                _state = State::CHECKSUM_LOW;
+    return false;
+            }
+            case State::CHECKSUM_LOW:
+            {
+                int value = hex_value(c);
+                _state = State::WAIT_START;
+                if (value < 0 || (_received_checksum | value) != _checksum)
+                {
+                    ++_errors;
+    return false;
+                }
+                if (_type == Type::UNKNOWN)
+    return false;  // 対応していない文
+                fix = _pending;
+                ++_sentences;
+    return true;
+            }
+        }
+        return false;
+    }
+
+    // 読み終えたフィールドを解釈する
+    void NMEAParser::parse_field()
+    {
+        if (_field_length > MaxFieldLength)
+    return;
+        const char* field = _field;
+        std::size_t length = _field_length;
+
+        // 最初のフィールドは文の種類  (GPGGA, GNGGA など先頭の2文字は問わない)
+        if (_field_index == 0)
+        {
+            _type = Type::UNKNOWN;
+            if (length != 5)
+    return;
+            const char* name = field + 2;
+            if (name[0] == 'G' && name[1] == 'G' && name[2] == 'A') _type = Type::GGA;
+            else if (name[0] == 'R' && name[1] == 'M' && name[2] == 'C') _type = Type::RMC;
+            else if (name[0] == 'V' && name[1] == 'T' && name[2] == 'G') _type = Type::VTG;
+    return;
+        }
+
+        int64_t value;
+        switch (_type)
+        {
+            case Type::GGA:  // $GPGGA,時刻,緯度,N/S,経度,E/W,品質,衛星数,HDOP,標高,M,...
+            {
+                switch (_field_index)
+                {
+                    case 1: parse_time(field, length, _pending.time_ms); break;
+                    case 2: case 4: _has_coordinate = parse_coordinate(field, length, _coordinate_e7); break;
+                    case 3: case 5: apply_coordinate(field, length); break;
+                    case 6: if (parse_fixed(field, length, 0, value)) _pending.valid = (value > 0); break;  // 品質が0のときは測位できていない
+                    case 7: if (parse_fixed(field, length, 0, value)) _pending.satellites = value; break;
+                    case 9: if (parse_fixed(field, length, 3, value)) {_pending.altitude_mm = value; _pending.has_altitude = true;} break;
+                    default: break;
+                }
+                break;
+            }
+            case Type::RMC:  // $GPRMC,時刻,状態(A/V),緯度,N/S,経度,E/W,速度(ノット),進行方向,日付,...
+            {
+                switch (_field_index)
+                {
+                    case 1: parse_time(field, length, _pending.time_ms); break;
+                    case 2: _pending.valid = (length == 1 && field[0] == 'A'); break;  // A:有効, V:無効
+                    case 3: case 5: _has_coordinate = parse_coordinate(field, length, _coordinate_e7); break;
+                    case 4: case 6: apply_coordinate(field, length); break;
+                    case 7: if (parse_fixed(field, length, 3, value)) _pending.speed_mm_s = value * 463 / 900; break;  // 1ノット = 1852m/h
+                    case 8: if (parse_fixed(field, length, 5, value)) _pending.course_e5 = value; break;
+                    default: break;
+                }
+                break;
+            }
+            case Type::VTG:  // $GPVTG,進行方向(真北),T,進行方向(磁北),M,速度(ノット),N,速度(km/h),K,...
+            {
+                switch (_field_index)
+                {
+                    case 1: if (parse_fixed(field, length, 5, value)) _pending.course_e5 = value; break;
+                    case 7: if (parse_fixed(field, length, 3, value)) _pending.speed_mm_s = value * 10 / 36; break;  // 1km/h = 1000/3600 m/s
+                    default: break;
+                }
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+    }
+
+    // 保留していた緯度・経度を，N/S/E/Wに合わせて測位結果に反映する
+    void NMEAParser::apply_coordinate(const char* field, std::size_t length)
+    {
+        if (!_has_coordinate || length != 1)
+    return;
+        _has_coordinate = false;
+        switch (field[0])
+        {
+            case 'N': _pending.latitude_e7 = _coordinate_e7; break;
+            case 'S': _pending.latitude_e7 = -_coordinate_e7; break;
+            case 'E': _pending.longitude_e7 = _coordinate_e7; break;
+            case 'W': _pending.longitude_e7 = -_coordinate_e7; break;
+            default: break;
+        }
+    }
+
+    /***** class UBXParser *****/
+
+    // リトルエンディアンの整数を読む
+    static uint32_t read_u32(const uint8_t* data)
+    {
+        return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    }
+    static int32_t read_i32(const uint8_t* data)
+    {
+        return static_cast<int32_t>(read_u32(data));
+    }
+
+    // 1バイト読み込む
+    // c : 受信したバイト
+    // fix : 測位結果  チェックサムが正しいNAV-PVTを読み終えたときにだけ更新する
+    // 戻り値 : NAV-PVTを読み終え，fixを更新したか
+    bool UBXParser::feed(uint8_t c, GNSSFix& fix)
+    {
+        switch (_state)
+        {
+            case State::SYNC1:
+            {
+                if (c == Sync1) _state = State::SYNC2;
+    return false;
+            }
+            case State::SYNC2:
+            {
+                if (c == Sync2)
+                {
+                    _state = State::CLASS;
+                    _checksum_a = 0;
+                    _checksum_b = 0;
+                }
+                else if (c != Sync1) _state = State::SYNC1;  // 同期バイトが続いた場合は，2つ目を1つ目とみなす
+    return false;
+            }
+            case State::CHECKSUM_A:
+            {
+                if (c != _checksum_a)
+                {
+                    ++_errors;
+                    _state = State::SYNC1;
+    return false;
+                }
+                _state = State::CHECKSUM_B;
+    return false;
+            }
+            case State::CHECKSUM_B:
+            {
+                _state = State::SYNC1;
+                if (c != _checksum_b)
+                {
+                    ++_errors;
+    return false;
+                }
+                ++_frames;
+    return parse_frame(fix);
+            }
+            default:
+            {
+                break;
+            }
+        }
+
+        // クラスからペイロードの終わりまでがチェックサムの対象
+        _checksum_a += c;
+        _checksum_b += _checksum_a;
+        switch (_state)
+        {
+            case State::CLASS: _class = c; _state = State::ID; break;
+            case State::ID: _id = c; _state = State::LENGTH_LOW; break;
+            case State::LENGTH_LOW: _length = c; _state = State::LENGTH_HIGH; break;
+            case State::LENGTH_HIGH:
+            {
+                _length |= c << 8;
+                _received = 0;
+                if (_length > MaxFrameLength)  // 長さを受信し間違えた可能性が高いので，次の同期バイトを探す
+                {
+                    ++_errors;
+                    _state = State::SYNC1;
+    return false;
+                }
+                _state = (_length ? State::PAYLOAD : State::CHECKSUM_A);
+                break;
+            }
+            case State::PAYLOAD:
+            {
+                if (_received < NavPvtLength) _payload[_received] = c;
+                if (++_received == _length) _state = State::CHECKSUM_A;
+                break;
+            }
+            default:
+            {
+                break;
+            }
+        }
+        return false;
+    }
+
+    // UBXのメッセージを作成
+    // message_class : メッセージのクラス
+    // message_id : メッセージのID
+    // payload_bytes : ペイロードのバイト数
+    // payload : ペイロード
+    // frame : 作成したメッセージを保存するための配列  payload_bytes+FrameOverheadバイト以上必要
+    // 戻り値 : 作成したメッセージのバイト数
+    std::size_t UBXParser::build_frame(uint8_t message_class, uint8_t message_id, std::size_t payload_bytes, const uint8_t* payload, uint8_t* frame)
+    {
+        frame[0] = Sync1;
+        frame[1] = Sync2;
+        frame[2] = message_class;
+        frame[3] = message_id;
+        frame[4] = payload_bytes & 0xff;
+        frame[5] = payload_bytes >> 8;
+        for (std::size_t i = 0; i < payload_bytes; ++i) frame[6 + i] = payload[i];
+
+        uint8_t checksum_a = 0, checksum_b = 0;
+        for (std::size_t i = 2; i < 6 + payload_bytes; ++i)
+        {
+            checksum_a += frame[i];
+            checksum_b += checksum_a;
+        }
+        frame[6 + payload_bytes] = checksum_a;
+        frame[7 + payload_bytes] = checksum_b;
+        return payload_bytes + FrameOverhead;
+    }
+
+    // チェックサムが正しいメッセージを解釈する
+    // 戻り値 : fixを更新したか
+    bool UBXParser::parse_frame(GNSSFix& fix)
+    {
+        if (_class == 0x05)  // ACK  設定を受け付けたか
+        {
+            if (_id == 0x01) ++_acks;
+            else if (_id == 0x00) ++_naks;
+    return false;
+        }
+        if (_class != 0x01 || _id != 0x07 || _length != NavPvtLength)
+    return false;  // NAV-PVT以外のメッセージ
+
+        // NAV-PVTのペイロードを，受信した位置のまま読む
+        const uint8_t* payload = _payload;
+        uint8_t fix_type = payload[20];  // 0:測位なし, 1:推測航法のみ, 2:2D, 3:3D, 4:GNSS+推測航法, 5:時刻のみ
+        bool fix_ok = payload[21] & 0x01;  // gnssFixOK  精度の条件を満たしているか
+        fix.valid = fix_ok && fix_type >= 2 && fix_type <= 4;
+        fix.has_altitude = fix_ok && (fix_type == 3 || fix_type == 4);
+        fix.satellites = payload[23];
+        fix.longitude_e7 = read_i32(payload + 24);  // (°)×10^7 でNMEAと同じ単位
+        fix.latitude_e7 = read_i32(payload + 28);
+        fix.altitude_mm = read_i32(payload + 36);  // 海水面(ジオイド)からの高さ  (楕円体からの高さは+32)
+        fix.speed_mm_s = read_i32(payload + 60);
+        fix.course_e5 = read_i32(payload + 64);
+
+        int32_t nano = read_i32(payload + 16);  // 秒の端数 (ns)  時・分・秒が切り上げられている場合は負になる
+        int32_t time_ms = (payload[8] * 3600 + payload[9] * 60 + payload[10]) * 1000 + nano / 1000000;
+        fix.time_ms = (time_ms < 0 ? 0 : time_ms);
+        return true;
+    }
+
+    /***** class GNSS *****/
+
+    // GNSS受信機のセットアップ
+    // uart : UART型のオブジェクト (一時オブジェクト不可)  このメソッドの中で UART::set_dma を呼び出します
+    GNSS::GNSS(UART& uart):
+        _uart(uart)
+    {
+        _uart.set_dma();  // 受信機は休まずにデータを送ってくるので，DMAで受信し続ける
+    }
+
+    // 受信機の出力をNMEAからUBXのNAV-PVTに切り替え，測位の間隔を設定  (u-blox M8など)
+    // 設定は受信機のRAMにだけ保存されるため，電源を切ると元に戻ります
+    // 受信機が設定を受け付けたかは ubx().acks() で確認できます
+    // [measure_period_ms] : 測位の間隔 (ms)  NAV-PVTは1回100バイトなので，9600bpsでは100ms(10Hz)に足りません (省略時:200ms)
+    void GNSS::set_ubx(uint16_t measure_period_ms)
+    {
+        if (!measure_period_ms) throw Error(__FILE__, __LINE__, "The measurement period must be at least 1ms");  // 測位の間隔は1ms以上にする必要があります
+
+        uint8_t frame[16];
+        std::size_t frame_bytes;
+
+        // CFG-MSG : NAV-PVTを測位のたびに出力する  (設定を送ったポートの出力間隔が変わる)
+        const uint8_t nav_pvt[] = {0x01, 0x07, 1};
+        frame_bytes = UBXParser::build_frame(0x06, 0x01, sizeof(nav_pvt), nav_pvt, frame);
+        _uart.write(frame_bytes, frame);
+
+        // CFG-MSG : 標準で出力されるNMEAの文 (GGA, GLL, GSA, GSV, RMC, VTG) を止める
+        for (uint8_t nmea_id = 0x00; nmea_id <= 0x05; ++nmea_id)
+        {
+            const uint8_t nmea[] = {0xF0, nmea_id, 0};
+            frame_bytes = UBXParser::build_frame(0x06, 0x01, sizeof(nmea), nmea, frame);
+            _uart.write(frame_bytes, frame);
+        }
+
+        // CFG-RATE : 測位の間隔  (測位1回ごとに出力し，時刻はGPS時刻に合わせる)
+        const uint8_t rate[] = {static_cast<uint8_t>(measure_period_ms & 0xff), static_cast<uint8_t>(measure_period_ms >> 8), 1, 0, 1, 0};
+        frame_bytes = UBXParser::build_frame(0x06, 0x08, sizeof(rate), rate, frame);
+        _uart.write(frame_bytes, frame);
+    }
+
+    // 受信機から文が届いているかを確認
+    // 戻り値 : 正常:true, 異常:false
+    bool GNSS::check_connection() noexcept
+    {
+        measure();
+        if (!_nmea.sentences() && !_ubx.frames())
+        {
+            log("GNSS connection could not be verified");  // GNSS受信機の接続が確認できませんでした
+    return false;
+        }
+        log("GNSS is connected normally");  // GNSS受信機は正常に接続されています
+        return true;
+    }
+
+    // 受信済みのデータをすべて読み込み，測位結果を更新
+    void GNSS::measure() noexcept
+    {
+        try
+        {
+            uint8_t input_data[64];
+            std::size_t read_bytes;
+            while ((read_bytes = _uart.read_some(input_data)) > 0)
+                for (std::size_t i = 0; i < read_bytes; ++i)
+                {
+                    // UBXのメッセージの途中のバイトはNMEAとして読まない  (ペイロードに'$'が含まれることがある)
+                    bool in_ubx_frame = !_ubx.idle();
+                    _ubx.feed(input_data[i], _fix);
+                    if (!in_ubx_frame && _ubx.idle()) _nmea.feed(input_data[i], _fix);
+                }
+        }
+        catch(const std::exception& e)
+        {
+            Error(__FILE__, __LINE__, "Measurement with GNSS failed", e.what());  // GNSSでの測定に失敗しました
+        }
+    }
+
+    // 測位した緯度を返す  測位できていない場合はErrorValue
+    Latitude GNSS::latitude() const noexcept
+    {
+        if (!_fix.valid)
+    return ErrorValue;
+        return _fix.latitude_e7 / 1e7;
+    }
+
+    // 測位した経度を返す  測位できていない場合はErrorValue
+    Longitude GNSS::longitude() const noexcept
+    {
+        if (!_fix.valid)
+    return ErrorValue;
+        return _fix.longitude_e7 / 1e7;
+    }
+
+    // 測位した標高を返す  測位できていない場合はErrorValue
+    Altitude GNSS::altitude() const noexcept
+    {
+        if (!_fix.valid || !_fix.has_altitude)
+    return ErrorValue;
+        return _fix.altitude_mm / 1e3;
+    }
+
+    // 対地速度を返す (m/s)  測位できていない場合はErrorValue
+    double GNSS::speed() const noexcept
+    {
+        if (!_fix.valid)
+    return ErrorValue;
+        return _fix.speed_mm_s / 1e3;
+    }
+
+    // 進行方向を返す  測位できていない場合はErrorValue
+    A_Direction GNSS::course() const noexcept
+    {
+        if (!_fix.valid)
+    return ErrorValue;
+        return _fix.course_e5 / 1e5;
+    }
+}
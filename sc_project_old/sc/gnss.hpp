@@ -0,0 +1,219 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_GNSS_HPP_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_GNSS_HPP_
+
+#include "sc.hpp"
+
+namespace sc
+{
+    // GNSS(GPSなど)の測位結果
+    // 小数を使わず，整数(固定小数点)で保存する
+    struct GNSSFix
+    {
+        int32_t latitude_e7 = 0;  // 緯度 (°)×10^7  正:北緯, 負:南緯
+        int32_t longitude_e7 = 0;  // 経度 (°)×10^7  正:東経, 負:西経
+        int32_t altitude_mm = 0;  // 標高 (mm)  海水面(ジオイド)からの高さ
+        int32_t speed_mm_s = 0;  // 対地速度 (mm/s)
+        int32_t course_e5 = 0;  // 進行方向 (°)×10^5  0°:北, 90°:東, 180°:南, 270°:西
+        uint32_t time_ms = 0;  // 測位した時刻 (UTC)  0時からの経過時間 (ms)
+        uint8_t satellites = 0;  // 測位に使用している衛星の数
+        bool valid = false;  // 測位できているか
+        bool has_altitude = false;  // 標高を受信したか
+    };
+
+    // NMEAの文を1文字ずつ読み込み，測位結果を取り出します
+    // 文全体を保存せずに，フィールドごとに読み込みながらチェックサムを計算するため，メモリを確保しません
+    // GGA, RMC, VTG の文に対応しています (先頭の2文字(GP, GN など)は問いません)
+    class NMEAParser
+    {
+    public:
+        static const std::size_t MaxSentenceLength = 82;  // NMEAの文の最大の長さ ($から改行まで)
+
+        // 1文字読み込む
+        // c : 受信した文字
+        // fix : 測位結果  チェックサムが正しい文を読み終えたときにだけ更新する
+        // 戻り値 : 文を読み終え，fixを更新したか
+        bool feed(char c, GNSSFix& fix);
+
+        // チェックサムが正しく読み込めた文の数
+        uint32_t sentences() const {return _sentences;}
+
+        // チェックサムが一致しなかったか，長すぎたため捨てた文の数
+        uint32_t errors() const {return _errors;}
+
+    private:
+        // 読み込み中の文の種類
+        enum class Type : uint8_t
+        {
+            UNKNOWN,
+            GGA,
+            RMC,
+            VTG
+        };
+
+        // 読み込みの状態
+        enum class State : uint8_t
+        {
+            WAIT_START,  // $を待っている
+            SENTENCE,  // $から*までを読み込んでいる
+            CHECKSUM_HIGH,  // チェックサムの1文字目を待っている
+            CHECKSUM_LOW  // チェックサムの2文字目を待っている
+        };
+
+        static const std::size_t MaxFieldLength = 15;  // 1つのフィールドの最大の長さ
+
+        State _state = State::WAIT_START;
+        Type _type = Type::UNKNOWN;
+        uint8_t _checksum = 0;  // $と*の間の文字の排他的論理和
+        uint8_t _received_checksum = 0;  // *の後に書かれたチェックサム
+        uint8_t _length = 0;  // 読み込み中の文の長さ
+        uint8_t _field_index = 0;  // 読み込み中のフィールドの番号 (0は文の種類)
+        char _field[MaxFieldLength + 1];  // 読み込み中のフィールド
+        uint8_t _field_length = 0;
+        bool _has_coordinate = false;  // 緯度・経度の直後の N/S/E/W を読むまで，値を保留する
+        int32_t _coordinate_e7 = 0;  // 保留中の緯度・経度
+        GNSSFix _pending;  // 読み込み中の文の内容  チェックサムが正しければfixにコピーする
+        uint32_t _sentences = 0;
+        uint32_t _errors = 0;
+
+        // 読み終えたフィールドを解釈する
+        void parse_field();
+
+        // 保留していた緯度・経度を，N/S/E/Wに合わせて測位結果に反映する
+        void apply_coordinate(const char* field, std::size_t length);
+    };
+
+    // u-blox受信機のバイナリ形式(UBX)のメッセージを1バイトずつ読み込み，NAV-PVTから測位結果を取り出します
+    // ペイロードは受信した位置のまま読み込み，チェックサム(Fletcher)は受信しながら計算します
+    // NMEAと比べて1回の測位結果が短く(100バイト)，文字列を数値に変換する必要もありません
+    class UBXParser
+    {
+    public:
+        static const uint8_t Sync1 = 0xB5;  // UBXのメッセージの最初のバイト
+        static const uint8_t Sync2 = 0x62;  // UBXのメッセージの2バイト目
+        static const std::size_t FrameOverhead = 8;  // ペイロード以外のバイト数 (同期2, クラス, ID, 長さ2, チェックサム2)
+        static const std::size_t NavPvtLength = 92;  // NAV-PVTのペイロードの長さ
+        static const std::size_t MaxFrameLength = 1024;  // これより長いペイロードは受信の誤りとみなす
+
+        // 1バイト読み込む
+        // c : 受信したバイト
+        // fix : 測位結果  チェックサムが正しいNAV-PVTを読み終えたときにだけ更新する
+        // 戻り値 : NAV-PVTを読み終え，fixを更新したか
+        bool feed(uint8_t c, GNSSFix& fix);
+
+        // メッセージの途中ではなく，次の同期バイトを待っているか
+        bool idle() const {return _state == State::SYNC1;}
+
+        // UBXのメッセージを作成
+        // message_class : メッセージのクラス
+        // message_id : メッセージのID
+        // payload_bytes : ペイロードのバイト数
+        // payload : ペイロード
+        // frame : 作成したメッセージを保存するための配列  payload_bytes+FrameOverheadバイト以上必要
+        // 戻り値 : 作成したメッセージのバイト数
+        static std::size_t build_frame(uint8_t message_class, uint8_t message_id, std::size_t payload_bytes, const uint8_t* payload, uint8_t* frame);
+
+        // チェックサムが正しく読み込めたメッセージの数 (NAV-PVT以外も含む)
+        uint32_t frames() const {return _frames;}
+
+        // チェックサムが一致しなかったか，長すぎたため捨てたメッセージの数
+        uint32_t errors() const {return _errors;}
+
+        // 受信機が設定を受け付けた(ACK-ACK)数
+        uint32_t acks() const {return _acks;}
+
+        // 受信機が設定を拒否した(ACK-NAK)数
+        uint32_t naks() const {return _naks;}
+
+    private:
+        // 読み込みの状態
+        enum class State : uint8_t
+        {
+            SYNC1,  // 1つ目の同期バイトを待っている
+            SYNC2,  // 2つ目の同期バイトを待っている
+            CLASS,
+            ID,
+            LENGTH_LOW,
+            LENGTH_HIGH,
+            PAYLOAD,
+            CHECKSUM_A,
+            CHECKSUM_B
+        };
+
+        State _state = State::SYNC1;
+        uint8_t _class = 0;
+        uint8_t _id = 0;
+        uint16_t _length = 0;  // ペイロードの長さ
+        uint16_t _received = 0;  // 読み込んだペイロードのバイト数
+        uint8_t _checksum_a = 0;  // クラスからペイロードの終わりまでのFletcherチェックサム
+        uint8_t _checksum_b = 0;
+        uint8_t _payload[NavPvtLength];  // ペイロード  これより長いメッセージはチェックサムだけ計算して捨てる
+        uint32_t _frames = 0;
+        uint32_t _errors = 0;
+        uint32_t _acks = 0;
+        uint32_t _naks = 0;
+
+        // チェックサムが正しいメッセージを解釈する
+        // 戻り値 : fixを更新したか
+        bool parse_frame(GNSSFix& fix);
+    };
+    // このクラスの作成にあたり以下の資料を参考にしました
+    // https://www.u-blox.com/en/docs/UBX-13003221  (u-blox 8 / M8 Receiver description, UBX Protocol)
+
+    // GNSS受信機 (u-bloxなど) から，UARTで受信したNMEAの文かUBXのメッセージを読み込んで位置を求めます
+    // どちらの形式も自動で判別するため，set_ubxで切り替えた後も同じように使えます
+    // UARTはDMAで受信し続けるため，1バイトごとの割り込みは発生しません
+    class GNSS : public Sensor
+    {
+    public:
+        // GNSS受信機のセットアップ
+        // uart : UART型のオブジェクト (一時オブジェクト不可)  このメソッドの中で UART::set_dma を呼び出します
+        GNSS(UART& uart);
+
+        // 受信機の出力をNMEAからUBXのNAV-PVTに切り替え，測位の間隔を設定  (u-blox M8など)
+        // 設定は受信機のRAMにだけ保存されるため，電源を切ると元に戻ります
+        // 受信機が設定を受け付けたかは ubx().acks() で確認できます
+        // [measure_period_ms] : 測位の間隔 (ms)  NAV-PVTは1回100バイトなので，9600bpsでは100ms(10Hz)に足りません (省略時:200ms)
+        void set_ubx(uint16_t measure_period_ms = 200);
+
+        // 受信機から文が届いているかを確認
+        // 戻り値 : 正常:true, 異常:false
+        bool check_connection() noexcept;
+
+        // 受信済みのデータをすべて読み込み，測位結果を更新
+        void measure() noexcept;
+
+        // 測位した緯度を返す  測位できていない場合はErrorValue
+        Latitude latitude() const noexcept;
+
+        // 測位した経度を返す  測位できていない場合はErrorValue
+        Longitude longitude() const noexcept;
+
+        // 測位した標高を返す  測位できていない場合はErrorValue
+        Altitude altitude() const noexcept;
+
+        // 対地速度を返す (m/s)  測位できていない場合はErrorValue
+        double speed() const noexcept;
+
+        // 進行方向を返す  測位できていない場合はErrorValue
+        A_Direction course() const noexcept;
+
+        // 固定小数点のままの測位結果を返す
+        const GNSSFix& fix() const noexcept {return _fix;}
+
+        // NMEAの文の読み込み状況
+        const NMEAParser& nmea() const noexcept {return _nmea;}
+
+        // UBXのメッセージの読み込み状況
+        const UBXParser& ubx() const noexcept {return _ubx;}
+
+    private:
+        UART& _uart;
+        NMEAParser _nmea;
+        UBXParser _ubx;
+        GNSSFix _fix;
+    };
+    // このクラスの作成にあたり以下の資料を参考にしました
+    // https://www.u-blox.com/en/docs/UBX-13003221  (u-blox 8 / M8 Receiver description, NMEA Protocol, UBX Protocol)
+}
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_GNSS_HPP_
@@ -0,0 +1,251 @@
+#include "i2c_async.hpp"
+
+namespace sc
+{
+    I2CAsync* I2CAsync::Instance[2] = {nullptr, nullptr};
+
+    // I2Cの非同期通信のセットアップ  I2C0とI2C1でそれぞれ一回だけ呼び出す
+    // i2c : セットアップ済みのI2C型のオブジェクト (一時オブジェクト不可)
+    I2CAsync::I2CAsync(const I2C& i2c):
+        _i2c_master(i2c),
+        _i2c(i2c.i2c_id() ? i2c1 : i2c0)
+    {
+        if (Instance[i2c.i2c_id()]) throw Error(__FILE__, __LINE__, "I2CAsync cannot be initialized twice for the same I2C");  // 同じI2Cに対してI2CAsyncを二回初期化することはできません
+        Instance[i2c.i2c_id()] = this;
+
+        _tx_dma = dma_claim_unused_channel(true);  // 空いているDMAのチャンネルを確保
+        _rx_dma = dma_claim_unused_channel(true);
+
+        _i2c->hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;  // I2CのDMAを有効にする
+        _i2c->hw->intr_mask = 0;  // 割り込みは予約された通信を実行している間だけ発生させる (start_next)
+
+        irq_set_exclusive_handler(i2c.i2c_id() ? I2C1_IRQ : I2C0_IRQ, i2c.i2c_id() ? i2c1_irq_handler : i2c0_irq_handler);  // 割り込み処理で実行する関数をセット
+        irq_set_enabled(i2c.i2c_id() ? I2C1_IRQ : I2C0_IRQ, true);  // 割り込み処理を有効にする
+    }
+
+    I2CAsync::~I2CAsync()
+    {
+        bool i2c_id = (_i2c == i2c1);
+        irq_set_enabled(i2c_id ? I2C1_IRQ : I2C0_IRQ, false);
+        _i2c->hw->intr_mask = 0;
+        _i2c->hw->dma_cr = 0;
+
+        dma_channel_abort(_tx_dma);
+        dma_channel_abort(_rx_dma);
+        dma_channel_unclaim(_tx_dma);
+        dma_channel_unclaim(_rx_dma);
+
+        Instance[i2c_id] = nullptr;
+    }
+
+    // メモリからの読み込みを予約
+    // memory_addr : 相手のデバイスの何番地のメモリーからデータを読み込むか
+    // input_data_bytes : 何バイト(文字)データを読み込むか (1以上MaxDataBytes以下)
+    // input_data : 受信したデータを保存するための配列  !通信が完了するまで使用できる状態にしておいてください!
+    // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+    // [callback] : 通信が完了したときに呼び出す関数 (省略時:呼び出さない)
+    // [context] : callbackに渡すポインタ (省略時:nullptr)
+    // 戻り値 : 予約した通信を識別する番号
+    I2CAsync::Handle I2CAsync::read_mem(uint8_t memory_addr, std::size_t input_data_bytes, uint8_t* input_data, uint8_t slave_addr, Callback callback, void* context)
+    {
+        if (!input_data_bytes) throw Error(__FILE__, __LINE__, "At least one byte must be read");  // 1バイト以上読み込む必要があります
+        if (input_data_bytes > MaxDataBytes) throw Error(__FILE__, __LINE__, "Too many bytes for one asynchronous I2C transfer");  // 1回の非同期I2C通信のバイト数が多すぎます
+
+        uint32_t status = save_and_disable_interrupts();  // 割り込み処理と同時に予約を書き換えないように，割り込みを禁止する
+        if (is_full())
+        {
+            restore_interrupts(status);
+            throw Error(__FILE__, __LINE__, "The asynchronous I2C queue is full");  // 非同期I2C通信の予約がいっぱいです
+        }
+        Request& request = submit(Type::READ_MEM, memory_addr, input_data_bytes, slave_addr, callback, context);
+        request.input_data = input_data;
+        if (!_running) start_next();
+        restore_interrupts(status);
+        return request.handle;
+    }
+
+    // メモリへの書き込みを予約
+    // memory_addr : 相手のデバイスの何番地のメモリーにデータを書き込むか
+    // output_data_bytes : 何バイト(文字)データを書き込むか (MaxDataBytes以下)
+    // output_data : 送信するデータの配列  (予約時にコピーするため，予約後すぐに変更してもかまいません)
+    // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+    // [callback] : 通信が完了したときに呼び出す関数 (省略時:呼び出さない)
+    // [context] : callbackに渡すポインタ (省略時:nullptr)
+    // 戻り値 : 予約した通信を識別する番号
+    I2CAsync::Handle I2CAsync::write_mem(uint8_t memory_addr, std::size_t output_data_bytes, const uint8_t* output_data, uint8_t slave_addr, Callback callback, void* context)
+    {
+        if (output_data_bytes > MaxDataBytes) throw Error(__FILE__, __LINE__, "Too many bytes for one asynchronous I2C transfer");  // 1回の非同期I2C通信のバイト数が多すぎます
+
+        uint32_t status = save_and_disable_interrupts();  // 割り込み処理と同時に予約を書き換えないように，割り込みを禁止する
+        if (is_full())
+        {
+            restore_interrupts(status);
+            throw Error(__FILE__, __LINE__, "The asynchronous I2C queue is full");  // 非同期I2C通信の予約がいっぱいです
+        }
+        Request& request = submit(Type::WRITE_MEM, memory_addr, output_data_bytes, slave_addr, callback, context);
+        for (std::size_t i = 0; i < output_data_bytes; ++i) request.output_data[i] = output_data[i];
+        if (!_running) start_next();
+        restore_interrupts(status);
+        return request.handle;
+    }
+
+    // 予約した通信が完了したか
+    // handle : 予約時に返された番号
+    bool I2CAsync::is_done(Handle handle) const
+    {
+        return static_cast<int32_t>(_completed - handle) > 0;  // 符号なしの引き算なので，番号がオーバーフローしても正しく比較できる
+    }
+
+    // 予約した通信が成功したか
+    // handle : 予約時に返された番号
+    // 完了していない場合や，その後にQueueSize個以上の通信を予約して結果が上書きされた場合はfalse
+    bool I2CAsync::is_succeeded(Handle handle) const
+    {
+        const Request& request = _queue[handle % QueueSize];
+        return is_done(handle) && request.handle == handle && request.success;
+    }
+
+    // 予約した通信が完了するまで待つ
+    // handle : 予約時に返された番号
+    // 戻り値 : 通信が成功したか
+    bool I2CAsync::wait(Handle handle) const
+    {
+        while (!is_done(handle)) tight_loop_contents();
+        return is_succeeded(handle);
+    }
+
+    // 完了していない通信の数
+    std::size_t I2CAsync::pending() const
+    {
+        return _submitted - _completed;
+    }
+
+    // メモリからの読み込みにかかる時間の目安 (μs)
+    // input_data_bytes : 何バイト(文字)データを読み込むか
+    // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+    // 信号のビット数とデバイスの通信速度から計算するため，クロックストレッチや通信速度の切り替えの時間は含みません
+    uint32_t I2CAsync::read_mem_time_us(std::size_t input_data_bytes, uint8_t slave_addr) const
+    {
+        // 開始信号とアドレス(10bit)，メモリアドレス(9bit)，再開始信号とアドレス(10bit)，データ(1バイトあたり9bit)，停止信号(1bit)
+        uint64_t bits = 30 + 9 * static_cast<uint64_t>(input_data_bytes);
+        uint32_t freq = _i2c_master.freq(slave_addr);
+        return static_cast<uint32_t>((bits * 1000000 + freq - 1) / freq);  // 切り上げ
+    }
+
+    // 通信を予約する  (割り込みを禁止し，予約に空きがあることを確認した状態で呼び出す)
+    // 戻り値 : 予約した通信  例外を投げないので，割り込みを禁止したまま戻ることはない
+    I2CAsync::Request& I2CAsync::submit(Type type, uint8_t memory_addr, std::size_t data_bytes, uint8_t slave_addr, Callback callback, void* context)
+    {
+        Handle handle = _submitted;
+        Request& request = _queue[handle % QueueSize];
+        request.handle = handle;
+        request.type = type;
+        request.slave_addr = slave_addr;
+        request.memory_addr = memory_addr;
+        request.data_bytes = data_bytes;
+        request.input_data = nullptr;
+        request.callback = callback;
+        request.context = context;
+        request.success = false;
+        _submitted = handle + 1;
+        return request;
+    }
+
+    // 次の通信を開始  (割り込みを禁止した状態か，割り込み処理の中で呼び出す)
+    void I2CAsync::start_next()
+    {
+        if (_completed == _submitted)
+        {
+            // 予約された通信がもうない  待機する通信(I2C::readなど)が停止信号のフラグを待てるように，割り込みを止める
+            _i2c->hw->intr_mask = 0;
+            _running = false;
+    return;
+        }
+        _running = true;
+        _aborted = false;
+
+        // 前の通信が残したフラグですぐに完了とみなさないように，フラグを消してから停止信号とエラーの割り込みを有効にする
+        (void)_i2c->hw->clr_stop_det;  // 読み取るとフラグが消える
+        (void)_i2c->hw->clr_tx_abrt;
+        _i2c->hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+
+        Request& request = _queue[_completed % QueueSize];
+
+        // 通信するデバイスに合わせて通信速度を切り替える (速度が変わらない場合は何もしない)
+        _i2c_master.select_freq(request.slave_addr);
+
+        // 通信先のスレーブアドレスを設定 (I2Cを無効にしている間しか変更できない)
+        _i2c->hw->enable = 0;
+        _i2c->hw->tar = request.slave_addr;
+        _i2c->hw->enable = 1;
+
+        // I2Cに送るコマンドを作成  メモリアドレスに続けて，書き込むデータか読み込みの命令を並べる
+        std::size_t commands_len = 0;
+        _commands[commands_len++] = request.memory_addr;
+        if (request.type == Type::READ_MEM)
+        {
+            for (std::size_t i = 0; i < request.data_bytes; ++i)
+                _commands[commands_len++] = I2C_IC_DATA_CMD_CMD_BITS | (i == 0 ? I2C_IC_DATA_CMD_RESTART_BITS : 0);  // 最初の読み込みの前に再開始信号(リピーテッドスタート)を送る
+
+            // 受信したデータを配列に移すDMA
+            dma_channel_config rx_config = dma_channel_get_default_config(_rx_dma);
+            channel_config_set_transfer_data_size(&rx_config, DMA_SIZE_8);
+            channel_config_set_read_increment(&rx_config, false);
+            channel_config_set_write_increment(&rx_config, true);
+            channel_config_set_dreq(&rx_config, i2c_get_dreq(_i2c, false));
+            dma_channel_configure(_rx_dma, &rx_config, request.input_data, &_i2c->hw->data_cmd, request.data_bytes, true);
+        } else {
+            for (std::size_t i = 0; i < request.data_bytes; ++i)
+                _commands[commands_len++] = request.output_data[i];
+        }
+        _commands[commands_len - 1] |= I2C_IC_DATA_CMD_STOP_BITS;  // 最後に停止信号を送る
+
+        // コマンドをI2Cに送るDMA
+        dma_channel_config tx_config = dma_channel_get_default_config(_tx_dma);
+        channel_config_set_transfer_data_size(&tx_config, DMA_SIZE_32);
+        channel_config_set_read_increment(&tx_config, true);
+        channel_config_set_write_increment(&tx_config, false);
+        channel_config_set_dreq(&tx_config, i2c_get_dreq(_i2c, true));
+        dma_channel_configure(_tx_dma, &tx_config, &_i2c->hw->data_cmd, _commands, commands_len, true);
+    }
+
+    // I2Cの割り込み処理
+    // 停止信号を検出したら通信を完了とし，次の通信を開始する
+    void I2CAsync::on_irq()
+    {
+        if (!_running)
+        {
+            // 予約された通信を実行していない間のフラグは待機する通信のものなので，消さずに割り込みだけを止める
+            _i2c->hw->intr_mask = 0;
+    return;
+        }
+
+        uint32_t interrupt_status = _i2c->hw->intr_stat;
+
+        if (interrupt_status & I2C_IC_INTR_MASK_M_TX_ABRT_BITS)
+        {
+            (void)_i2c->hw->clr_tx_abrt;  // 読み取るとフラグが消える
+            dma_channel_abort(_tx_dma);
+            dma_channel_abort(_rx_dma);
+            _aborted = true;  // エラーが発生した後も停止信号は送られるので，完了の処理はそちらで行う
+        }
+
+        if (!(interrupt_status & I2C_IC_INTR_MASK_M_STOP_DET_BITS))
+    return;
+        (void)_i2c->hw->clr_stop_det;  // 読み取るとフラグが消える
+
+        Request& request = _queue[_completed % QueueSize];
+        if (!_aborted && request.type == Type::READ_MEM)
+            dma_channel_wait_for_finish_blocking(_rx_dma);  // 最後の1バイトがDMAで移されるのを待つ (数サイクル)
+        request.success = !_aborted;
+
+        // 次の通信を先に開始してから，コールバック関数を呼び出す
+        bool success = request.success;
+        Callback callback = request.callback;
+        void* context = request.context;
+        _completed = _completed + 1;
+        start_next();
+
+        if (callback) callback(success, context);
+    }
+}
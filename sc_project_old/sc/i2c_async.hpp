@@ -0,0 +1,141 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_I2C_ASYNC_HPP_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_I2C_ASYNC_HPP_
+
+#include "sc.hpp"
+
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+namespace sc
+{
+    // I2Cの通信を，DMAと割り込み処理によって裏で行います
+    // 通信を予約するとすぐに戻るため，通信している間にほかの処理を行えます
+    // 通信の完了はコールバック関数か，予約時に返される番号(Handle)で確認できます
+    // I2Cの割り込みは予約した通信を実行している間だけ有効にするため，予約した通信がすべて完了した後は I2C::read などの待機する通信も使えます
+    // 通信中に同じI2Cで待機する通信を行った場合の動作は未定義です  (pending() が0になるまで待ってください)
+    class I2CAsync : Noncopyable
+    {
+    public:
+        static const std::size_t QueueSize = 8;  // 同時に予約できる通信の数 (2の累乗)
+        static const std::size_t MaxDataBytes = 32;  // 1回の通信で読み書きできる最大のバイト数
+
+        // 予約した通信を識別する番号
+        typedef uint32_t Handle;
+
+        // 通信が完了したときに呼び出される関数
+        // success : 通信に成功したか
+        // context : 予約時に渡したポインタ
+        // !割り込み処理の中で呼び出されます!  時間のかかる処理は行わないでください
+        typedef void (*Callback)(bool success, void* context);
+
+        // I2Cの非同期通信のセットアップ  I2C0とI2C1でそれぞれ一回だけ呼び出す
+        // i2c : セットアップ済みのI2C型のオブジェクト (一時オブジェクト不可)
+        I2CAsync(const I2C& i2c);
+
+        ~I2CAsync();
+
+        // メモリからの読み込みを予約
+        // memory_addr : 相手のデバイスの何番地のメモリーからデータを読み込むか
+        // input_data_bytes : 何バイト(文字)データを読み込むか (1以上MaxDataBytes以下)
+        // input_data : 受信したデータを保存するための配列  !通信が完了するまで使用できる状態にしておいてください!
+        // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+        // [callback] : 通信が完了したときに呼び出す関数 (省略時:呼び出さない)
+        // [context] : callbackに渡すポインタ (省略時:nullptr)
+        // 戻り値 : 予約した通信を識別する番号
+        Handle read_mem(uint8_t memory_addr, std::size_t input_data_bytes, uint8_t* input_data, uint8_t slave_addr, Callback callback = nullptr, void* context = nullptr);
+        template<typename T, std::size_t Size> Handle read_mem(uint8_t memory_addr, T (&input_data)[Size], uint8_t slave_addr, Callback callback = nullptr, void* context = nullptr) {return read_mem(memory_addr, Size, (uint8_t*)input_data, slave_addr, callback, context);}
+
+        // メモリへの書き込みを予約
+        // memory_addr : 相手のデバイスの何番地のメモリーにデータを書き込むか
+        // output_data_bytes : 何バイト(文字)データを書き込むか (MaxDataBytes以下)
+        // output_data : 送信するデータの配列  (予約時にコピーするため，予約後すぐに変更してもかまいません)
+        // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+        // [callback] : 通信が完了したときに呼び出す関数 (省略時:呼び出さない)
+        // [context] : callbackに渡すポインタ (省略時:nullptr)
+        // 戻り値 : 予約した通信を識別する番号
+        Handle write_mem(uint8_t memory_addr, std::size_t output_data_bytes, const uint8_t* output_data, uint8_t slave_addr, Callback callback = nullptr, void* context = nullptr);
+        template<typename T, std::size_t Size> Handle write_mem(uint8_t memory_addr, const T (&output_data)[Size], uint8_t slave_addr, Callback callback = nullptr, void* context = nullptr) {return write_mem(memory_addr, Size, (const uint8_t*)output_data, slave_addr, callback, context);}
+
+        // 予約した通信が完了したか
+        // handle : 予約時に返された番号
+        bool is_done(Handle handle) const;
+
+        // 予約した通信が成功したか
+        // handle : 予約時に返された番号
+        // 完了していない場合や，その後にQueueSize個以上の通信を予約して結果が上書きされた場合はfalse
+        bool is_succeeded(Handle handle) const;
+
+        // 予約した通信が完了するまで待つ
+        // handle : 予約時に返された番号
+        // 戻り値 : 通信が成功したか
+        bool wait(Handle handle) const;
+
+        // 完了していない通信の数
+        std::size_t pending() const;
+
+        // これ以上通信を予約できないか
+        bool is_full() const {return pending() >= QueueSize;}
+
+        // メモリからの読み込みにかかる時間の目安 (μs)
+        // input_data_bytes : 何バイト(文字)データを読み込むか
+        // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+        // 信号のビット数とデバイスの通信速度から計算するため，クロックストレッチや通信速度の切り替えの時間は含みません
+        uint32_t read_mem_time_us(std::size_t input_data_bytes, uint8_t slave_addr) const;
+
+        // I2C0かI2C1か
+        bool i2c_id() const {return _i2c == i2c1;}
+
+    private:
+        // 通信の種類
+        enum class Type : uint8_t
+        {
+            READ_MEM,
+            WRITE_MEM
+        };
+
+        // 予約された通信
+        struct Request
+        {
+            Handle handle;
+            Type type;
+            uint8_t slave_addr;
+            uint8_t memory_addr;
+            uint8_t data_bytes;
+            uint8_t* input_data;
+            uint8_t output_data[MaxDataBytes];
+            Callback callback;
+            void* context;
+            volatile bool success;
+        };
+
+        static I2CAsync* Instance[2];  // 割り込み処理から呼び出すためのオブジェクト
+
+        const I2C& _i2c_master;  // 通信速度の切り替えに使う
+        i2c_inst_t* _i2c;
+        uint _tx_dma;  // I2Cへコマンドを送るDMAのチャンネル
+        uint _rx_dma;  // I2Cから受信したデータを受け取るDMAのチャンネル
+
+        Request _queue[QueueSize];  // 予約された通信 (リングバッファ)
+        volatile Handle _submitted = 0;  // これまでに予約された通信の数 (次に予約される通信の番号)
+        volatile Handle _completed = 0;  // これまでに完了した通信の数 (次に実行する通信の番号)
+        volatile bool _running = false;  // 通信中か
+        volatile bool _aborted = false;  // 通信中にエラーが発生したか
+
+        uint32_t _commands[MaxDataBytes + 1];  // DMAでI2Cに送るコマンド (メモリアドレス + データ)
+
+        // 通信を予約する  (割り込みを禁止し，予約に空きがあることを確認した状態で呼び出す)
+        Request& submit(Type type, uint8_t memory_addr, std::size_t data_bytes, uint8_t slave_addr, Callback callback, void* context);
+
+        // 次の通信を開始  (割り込みを禁止した状態か，割り込み処理の中で呼び出す)
+        void start_next();
+
+        // I2Cの割り込み処理
+        void on_irq();
+        static void i2c0_irq_handler() {Instance[0]->on_irq();}
+        static void i2c1_irq_handler() {Instance[1]->on_irq();}
+    };
+    // このクラスの作成にあたり以下の資料を参考にしました
+    // https://datasheets.raspberrypi.com/rp2040/rp2040-datasheet.pdf  (4.3. I2C, 2.5. DMA)
+}
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_I2C_ASYNC_HPP_
@@ -0,0 +1,178 @@
+#include "i2c_scheduler.hpp"
+
+namespace sc
+{
+    // I2C0とI2C1の両方を使う場合のセットアップ
+    // i2c0_async : I2C0のI2CAsync型のオブジェクト (一時オブジェクト不可)
+    // i2c1_async : I2C1のI2CAsync型のオブジェクト (一時オブジェクト不可)
+    I2CScheduler::I2CScheduler(I2CAsync& i2c0_async, I2CAsync& i2c1_async):
+        I2CScheduler(i2c0_async)
+    {
+        if (i2c0_async.i2c_id() == i2c1_async.i2c_id()) throw Error(__FILE__, __LINE__, "I2C0 and I2C1 must be different I2C");  // I2C0とI2C1は異なるI2Cである必要があります
+        _buses[i2c1_async.i2c_id()].async = &i2c1_async;
+    }
+
+    // 片方のI2Cだけを使う場合のセットアップ
+    // i2c_async : I2CAsync型のオブジェクト (一時オブジェクト不可)
+    I2CScheduler::I2CScheduler(I2CAsync& i2c_async)
+    {
+        for (Bus& bus : _buses)
+        {
+            bus.async = nullptr;
+            bus.planned_until_us = time_us_32();
+        }
+        _buses[i2c_async.i2c_id()].async = &i2c_async;
+        reset_statistics();
+    }
+
+    // 定期的な読み込みを登録
+    // i2c_id : I2C0かI2C1か
+    // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+    // memory_addr : 相手のデバイスの何番地のメモリーからデータを読み込むか
+    // input_data_bytes : 何バイト(文字)データを読み込むか (1以上I2CAsync::MaxDataBytes以下)
+    // input_data : 受信したデータを保存するための配列 (グローバル変数など，ずっと使用できるもの)
+    // period_us : 読み込みの周期 (μs)
+    // [deadline_us] : 読み込みの時刻になってから，通信を完了させるまでの締め切り (μs) (省略時:period_usと同じ)
+    // [priority] : 優先度  大きいほど先に通信する (省略時:0)
+    // [callback] : 読み込みが完了したときに呼び出す関数 (省略時:呼び出さない)
+    // [context] : callbackに渡すポインタ (省略時:nullptr)
+    // 戻り値 : 登録した読み込みの番号
+    std::size_t I2CScheduler::add_job(bool i2c_id, uint8_t slave_addr, uint8_t memory_addr, std::size_t input_data_bytes, uint8_t* input_data, uint32_t period_us, uint32_t deadline_us, uint8_t priority, Callback callback, void* context)
+    {
+        if (_jobs_num >= MaxJobs) throw Error(__FILE__, __LINE__, "Too many I2C scheduler jobs");  // I2Cのスケジューラに登録する読み込みが多すぎます
+        if (!_buses[i2c_id].async) throw Error(__FILE__, __LINE__, "The specified I2C is not managed by this scheduler");  // 指定されたI2Cはこのスケジューラで管理されていません
+        if (!input_data_bytes || input_data_bytes > I2CAsync::MaxDataBytes) throw Error(__FILE__, __LINE__, "Invalid number of bytes for an I2C scheduler job");  // I2Cのスケジューラに登録する読み込みのバイト数が不正です
+        if (!period_us) throw Error(__FILE__, __LINE__, "The period of an I2C scheduler job must not be 0");  // I2Cのスケジューラに登録する読み込みの周期は0にできません
+
+        Job& job = _jobs[_jobs_num];
+        job.scheduler = this;
+        job.i2c_id = i2c_id;
+        job.slave_addr = slave_addr;
+        job.memory_addr = memory_addr;
+        job.data_bytes = input_data_bytes;
+        job.input_data = input_data;
+        job.period_us = period_us;
+        job.deadline_us = (deadline_us ? deadline_us : period_us);
+        job.priority = priority;
+        job.callback = callback;
+        job.context = context;
+        job.next_release_us = time_us_32();  // 最初の読み込みはすぐに行う
+        job.release_us = job.next_release_us;
+        job.submit_us = job.next_release_us;
+        job.in_flight = false;
+        job.misses = 0;
+        return _jobs_num++;
+    }
+
+    // 読み込みの時刻になった通信と，予約済みの通信が終わるまでに読み込みの時刻になる通信を予約する
+    // メインループから，読み込みの周期より短い間隔で呼び出してください
+    // I2Cごとに，予約済みの通信が終わる時刻の見込みを次の通信の枠の始まりとし，その時刻までに読み込みの時刻になる通信を
+    // 優先度が高い順，優先度が同じなら締め切りが近い順に1つずつ枠に詰める  I2CAsyncの予約がいっぱいになるか，詰める通信がなくなったら終わる
+    void I2CScheduler::tick()
+    {
+        uint32_t now_us = time_us_32();
+        for (int i2c_id = 0; i2c_id < 2; ++i2c_id)
+        {
+            Bus& bus = _buses[i2c_id];
+            if (!bus.async)
+        continue;
+            I2CAsync& async = *bus.async;
+
+            // 予約した通信がすべて完了している場合や，見込みより早く進んでいる場合は今から通信できる
+            if (!async.pending() || static_cast<int32_t>(bus.planned_until_us - now_us) < 0) bus.planned_until_us = now_us;
+
+            while (!async.is_full())
+            {
+                // 枠の始まりまでに読み込みの時刻になる通信のうち，最も先に通信すべきものを選ぶ
+                Job* next = nullptr;
+                for (std::size_t i = 0; i < _jobs_num; ++i)
+                {
+                    Job& job = _jobs[i];
+                    if (job.i2c_id != static_cast<bool>(i2c_id) || job.in_flight || static_cast<int32_t>(bus.planned_until_us - job.next_release_us) < 0)
+                continue;
+                    if (!next || job.priority > next->priority || (job.priority == next->priority && static_cast<int32_t>((job.next_release_us + job.deadline_us) - (next->next_release_us + next->deadline_us)) < 0)) next = &job;
+                }
+                if (!next)
+            break;  // 次の読み込みの時刻まではバスが空くので，次回のtick()で予約する
+
+                Job& job = *next;
+                job.release_us = job.next_release_us;
+                job.in_flight = true;
+                job.submit_us = now_us;
+                async.read_mem(job.memory_addr, job.data_bytes, job.input_data, job.slave_addr, on_complete, &job);
+                bus.planned_until_us += async.read_mem_time_us(job.data_bytes, job.slave_addr);
+
+                // 次の読み込みの時刻を決める  周期を丸ごと飛ばしてしまった場合は，飛ばした回数を締め切りに間に合わなかった回数に加える
+                job.next_release_us += job.period_us;
+                if (static_cast<int32_t>(now_us - job.next_release_us) >= 0)
+                {
+                    uint32_t skipped = (now_us - job.next_release_us) / job.period_us + 1;
+                    job.misses = job.misses + skipped;
+                    job.next_release_us += skipped * job.period_us;
+                }
+            }
+        }
+    }
+
+    // I2Cが通信していた時間の割合 (0.0 ~ 1.0)
+    // i2c_id : I2C0かI2C1か
+    float I2CScheduler::utilization(bool i2c_id) const
+    {
+        return float(_buses[i2c_id].busy_us) / not0(float(time_us_32() - _statistics_start_us));
+    }
+
+    // 締め切りに間に合わなかった読み込みの回数 (すべての読み込みの合計)
+    uint32_t I2CScheduler::deadline_misses() const
+    {
+        uint32_t misses = 0;
+        for (std::size_t i = 0; i < _jobs_num; ++i) misses += _jobs[i].misses;
+        return misses;
+    }
+
+    // 締め切りに間に合わなかった読み込みの回数
+    // job : add_jobで返された番号
+    uint32_t I2CScheduler::deadline_misses(std::size_t job) const
+    {
+        if (job >= _jobs_num) throw Error(__FILE__, __LINE__, "The specified I2C scheduler job does not exist");  // 指定された読み込みは登録されていません
+        return _jobs[job].misses;
+    }
+
+    // 通信に失敗した読み込みの回数 (すべての読み込みの合計)
+    uint32_t I2CScheduler::failures() const
+    {
+        return _failures;
+    }
+
+    // 通信時間の割合，締め切りに間に合わなかった回数，失敗した回数を0に戻す
+    void I2CScheduler::reset_statistics()
+    {
+        _statistics_start_us = time_us_32();
+        for (Bus& bus : _buses)
+        {
+            bus.busy_us = 0;
+            bus.last_complete_us = _statistics_start_us;
+        }
+        for (std::size_t i = 0; i < _jobs_num; ++i) _jobs[i].misses = 0;
+        _failures = 0;
+    }
+
+    // 読み込みが完了したときに割り込み処理から呼び出される関数
+    void I2CScheduler::on_complete(bool success, void* context)
+    {
+        Job& job = *static_cast<Job*>(context);
+        I2CScheduler& scheduler = *job.scheduler;
+        Bus& bus = scheduler._buses[job.i2c_id];
+        uint32_t now_us = time_us_32();
+
+        // I2CAsyncは予約された順に通信するので，予約した時刻と直前の通信が完了した時刻の遅い方から通信が始まっている
+        uint32_t start_us = (static_cast<int32_t>(job.submit_us - bus.last_complete_us) > 0 ? job.submit_us : bus.last_complete_us);
+        bus.busy_us = bus.busy_us + (now_us - start_us);
+        bus.last_complete_us = now_us;
+
+        if (slack_us(job, now_us) < 0) job.misses = job.misses + 1;
+        if (!success) scheduler._failures = scheduler._failures + 1;
+        job.in_flight = false;
+
+        if (job.callback) job.callback(success, job.context);
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_I2C_SCHEDULER_HPP_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_I2C_SCHEDULER_HPP_
+
+#include "i2c_async.hpp"
+
+namespace sc
+{
+    // I2C0とI2C1につながったセンサからの定期的な読み込みをまとめて管理します
+    // メインループからtick()を呼び出すたびに，I2Cごとに予約済みの通信が終わる時刻を見積もり，その時刻までに読み込みの時刻になる通信を
+    // 優先度と締め切りの順にI2CAsyncの予約へ詰めます．前の通信が終わるとすぐに次の通信が始まるので，バスが空く時間を減らせます
+    // I2C0とI2C1の通信は同時に進みます
+    class I2CScheduler : Noncopyable
+    {
+    public:
+        static const std::size_t MaxJobs = 16;  // 登録できる読み込みの最大数
+
+        // 読み込みが完了したときに呼び出される関数
+        // success : 通信に成功したか
+        // context : 登録時に渡したポインタ
+        // !割り込み処理の中で呼び出されます!  時間のかかる処理は行わないでください
+        typedef I2CAsync::Callback Callback;
+
+        // I2C0とI2C1の両方を使う場合のセットアップ
+        // i2c0_async : I2C0のI2CAsync型のオブジェクト (一時オブジェクト不可)
+        // i2c1_async : I2C1のI2CAsync型のオブジェクト (一時オブジェクト不可)
+        I2CScheduler(I2CAsync& i2c0_async, I2CAsync& i2c1_async);
+
+        // 片方のI2Cだけを使う場合のセットアップ
+        // i2c_async : I2CAsync型のオブジェクト (一時オブジェクト不可)
+        I2CScheduler(I2CAsync& i2c_async);
+
+        // 定期的な読み込みを登録
+        // i2c_id : I2C0かI2C1か
+        // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+        // memory_addr : 相手のデバイスの何番地のメモリーからデータを読み込むか
+        // input_data_bytes : 何バイト(文字)データを読み込むか (1以上I2CAsync::MaxDataBytes以下)
+        // input_data : 受信したデータを保存するための配列 (グローバル変数など，ずっと使用できるもの)
+        // period_us : 読み込みの周期 (μs)
+        // [deadline_us] : 読み込みの時刻になってから，通信を完了させるまでの締め切り (μs) (省略時:period_usと同じ)
+        // [priority] : 優先度  大きいほど先に通信する (省略時:0)
+        // [callback] : 読み込みが完了したときに呼び出す関数 (省略時:呼び出さない)
+        // [context] : callbackに渡すポインタ (省略時:nullptr)
+        // 戻り値 : 登録した読み込みの番号
+        std::size_t add_job(bool i2c_id, uint8_t slave_addr, uint8_t memory_addr, std::size_t input_data_bytes, uint8_t* input_data, uint32_t period_us, uint32_t deadline_us = 0, uint8_t priority = 0, Callback callback = nullptr, void* context = nullptr);
+
+        // 読み込みの時刻になった通信と，予約済みの通信が終わるまでに読み込みの時刻になる通信を予約する
+        // メインループから，読み込みの周期より短い間隔で呼び出してください
+        void tick();
+
+        // I2Cが通信していた時間の割合 (0.0 ~ 1.0)
+        // i2c_id : I2C0かI2C1か
+        float utilization(bool i2c_id) const;
+
+        // 締め切りに間に合わなかった読み込みの回数 (すべての読み込みの合計)
+        uint32_t deadline_misses() const;
+
+        // 締め切りに間に合わなかった読み込みの回数
+        // job : add_jobで返された番号
+        uint32_t deadline_misses(std::size_t job) const;
+
+        // 通信に失敗した読み込みの回数 (すべての読み込みの合計)
+        uint32_t failures() const;
+
+        // 通信時間の割合，締め切りに間に合わなかった回数，失敗した回数を0に戻す
+        void reset_statistics();
+
+    private:
+        // 登録された読み込み
+        struct Job
+        {
+            I2CScheduler* scheduler;
+            bool i2c_id;
+            uint8_t slave_addr;
+            uint8_t memory_addr;
+            uint8_t data_bytes;
+            uint8_t* input_data;
+            uint32_t period_us;
+            uint32_t deadline_us;
+            uint8_t priority;
+            Callback callback;
+            void* context;
+
+            uint32_t next_release_us;  // 次の読み込みの時刻 (μs)
+            uint32_t release_us;  // 今回の読み込みの時刻 (μs)
+            uint32_t submit_us;  // 今回の読み込みを予約した時刻 (μs)
+            volatile bool in_flight;  // 予約した読み込みがまだ完了していないか
+            volatile uint32_t misses;  // 締め切りに間に合わなかった回数
+        };
+
+        // I2Cごとの状態
+        struct Bus
+        {
+            I2CAsync* async;
+            volatile uint32_t busy_us;  // 通信していた時間の合計 (μs)
+            volatile uint32_t last_complete_us;  // 最後に通信が完了した時刻 (μs)
+            uint32_t planned_until_us;  // 予約した通信がすべて完了する時刻の見込み (μs)
+        };
+
+        Job _jobs[MaxJobs];
+        std::size_t _jobs_num = 0;
+        Bus _buses[2];
+        uint32_t _statistics_start_us;  // 統計を取り始めた時刻 (μs)
+        volatile uint32_t _failures = 0;
+
+        // 締め切りまでの残り時間 (μs)  負の値のときは締め切りを過ぎている
+        static int32_t slack_us(const Job& job, uint32_t now_us) {return static_cast<int32_t>(job.release_us + job.deadline_us - now_us);}
+
+        // 読み込みが完了したときに割り込み処理から呼び出される関数
+        static void on_complete(bool success, void* context);
+    };
+}
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_I2C_SCHEDULER_HPP_
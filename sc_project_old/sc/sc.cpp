@@ -31,7 +31,7 @@ namespace sc
 
     // ログを記録し，標準出力に出力します
     // 末尾に改行が自動で追加されます
-    void inline log(const std::string& message) noexcept
+    void log(const std::string& message) noexcept
     {
         try
         {
@@ -86,7 +86,7 @@ namespace sc
     // temperature : 測定した気温
     // [pressure0] : 基準点の気圧  省略可
     // [altitude0] : 基準点の標高  省略可
-    Altitude to_altitude(const Pressure& pressure, const Temperature& temperature, const Pressure& pressure0 = AltitudePressure0, const Altitude& altitude0 = AltitudeAltitude0)
+    Altitude to_altitude(const Pressure& pressure, const Temperature& temperature, const Pressure& pressure0 = AltitudePressure0, const Altitude& altitude0 = AltitudeAltitude0) noexcept
     {
         if (is_error({pressure, temperature, pressure0, altitude0})) return Altitude(ErrorValue);
         return altitude0 + ((temperature + 273.15) / 0.0065) * (std::pow((pressure0 / pressure), (1.0 / 5.257)) - 1.0);
@@ -97,7 +97,7 @@ namespace sc
     // [pressure0] : 基準点の気圧  省略可
     // [temperature0] : 基準点の気温  省略可
     // [altitude0] : 基準点の標高  省略可
-    Altitude to_altitude(const Pressure& pressure, const Pressure& pressure0 = AltitudePressure0, const Temperature& temperature0 = AltitudeTemperature0, const Altitude& altitude0 = AltitudeAltitude0)
+    Altitude to_altitude(const Pressure& pressure, const Pressure& pressure0 = AltitudePressure0, const Temperature& temperature0 = AltitudeTemperature0, const Altitude& altitude0 = AltitudeAltitude0) noexcept
     {
         if (is_error({pressure, pressure0, temperature0, altitude0})) return Altitude(ErrorValue);
         return altitude0 + ((temperature0 + 273.15) / 0.0065) * (1.0 - pow((pressure / pressure0), (1.0 / 5.257)));
@@ -236,15 +236,17 @@ namespace sc
     }
 
     // 2点の座標から方位を計算
-    A_Angle to_angle(const A_Position& position, const A_Position& position0)
+    A_Angle to_angle(const A_Position& position, const A_Position& position0) noexcept
     {
         // 未実装
+        return A_Angle();  // 未実装の間は測定できなかったときと同じ値(ErrorValue)を返す
     }
 
     // 2つの方位から相対的な向きを計算
-    R_Angle to_r_angle(const A_Angle& angle, const A_Angle& angle0)
+    R_Angle to_r_angle(const A_Angle& angle, const A_Angle& angle0) noexcept
     {
         // 未実装
+        return R_Angle();  // 未実装の間は測定できなかったときと同じ値(ErrorValue)を返す
     }
 
     // 相対的な向きと基準の方位から方位を計算
@@ -397,7 +399,7 @@ namespace sc
     // 改行までデータを読み込む
     // input_data_bytes : 最大で何バイト(文字)データを読み込むか (省略した場合は，最大でinput_dataの長さだけ読み込む)
     // input_data : 受信したデータを保存するための配列
-    // select_device : I2Cではスレーブアドレス，UARTではCSピンのGPIO番号，UARTでは省略
+    // select_device : I2Cではスレーブアドレス，SPIではCSピンのGPIO番号，UARTでは省略
     void Communication::read_line(std::size_t input_data_bytes, uint8_t* input_data, uint8_t select_device) const
     {
         if (!input_data_bytes)
@@ -405,20 +407,140 @@ namespace sc
         do
         {
             read(1U, input_data, select_device);
-            if (*(++input_data) == static_cast<uint8_t>('\n'))
+            if (*(input_data++) == static_cast<uint8_t>('\n'))  // 受信した文字を確かめてから次の位置へ進む
     return;
         } while (--input_data_bytes);
     }
 
+    /***** class LineReader *****/
+
+    // data_bytesバイトの中からvalueを探す
+    // 4バイトずつまとめて比較する  (RP2040(Cortex-M0+)は境界の揃っていない4バイトを読めないので，先に境界を揃える)
+    // 戻り値 : 見つかった位置  見つからなかった場合はnullptr
+    static const uint8_t* find_byte(const uint8_t* data, std::size_t data_bytes, uint8_t value)
+    {
+        const uint8_t* end = data + data_bytes;
+        for (; data < end && (reinterpret_cast<uintptr_t>(data) & 3); ++data)
+            if (*data == value)
+    return data;
+
+        const uint32_t pattern = value * 0x01010101u;
+        for (; end - data >= 4; data += 4)
+        {
+            uint32_t word;
+            std::memcpy(&word, data, 4);  // 境界が揃っているので1命令で読み込まれる
+            word ^= pattern;  // valueと一致したバイトが0になる
+            uint32_t zero = (word - 0x01010101u) & ~word & 0x80808080u;  // 0のバイトがあれば最上位ビットが立つ (最初の0より前のバイトは誤検出しない)
+            if (!zero)
+    continue;
+            if (zero & 0x80u)
+    return data;  // リトルエンディアンなので下位のバイトが先
+            if (zero & 0x8000u)
+    return data + 1;
+            if (zero & 0x800000u)
+    return data + 2;
+            return data + 3;
+        }
+
+        for (; data < end; ++data)
+            if (*data == value)
+    return data;
+        return nullptr;
+    }
+
+    // 行の読み込みのセットアップ
+    // communication : 通信に使うオブジェクト (一時オブジェクト不可)
+    // buffer_bytes : バッファのバイト数  区切り文字も収まる必要があるので，1行の最大の長さはこれより1バイト短い (省略した場合はbufferの長さ)
+    // buffer : 受信したデータを保存するための配列  !LineReaderを使用している間は使用できる状態にしておいてください!
+    // [select_device] : I2Cではスレーブアドレス，SPIではCSピンのGPIO番号，UARTでは省略
+    // [delimiter] : 行の区切り文字 (省略時:'\n')  '\n'の場合は直前の'\r'も取り除く
+    LineReader::LineReader(const Communication& communication, std::size_t buffer_bytes, uint8_t* buffer, uint8_t select_device, uint8_t delimiter):
+        _communication(communication),
+        _buffer(buffer),
+        _buffer_bytes(buffer_bytes),
+        _select_device(select_device),
+        _delimiter(delimiter)
+    {
+        if (!buffer_bytes) throw Error(__FILE__, __LINE__, "The line buffer must be at least 1 byte");  // 行のバッファは1バイト以上必要です
+    }
+
+    // 1行取り出す  バッファに1行揃っていない場合は，すぐに読み込めるデータを1回だけまとめて受信する
+    // line : 取り出した行
+    // 戻り値 : 行を取り出せたか  行が揃っていない場合はfalse
+    // バッファより長い行は，バッファに収まる分をtruncatedとして返し，残りは次の区切り文字まで捨てる
+    bool LineReader::read_line(Line& line)
+    {
+        if (find_line(line))
+    return true;
+
+        // 取り出していないデータをバッファの先頭に移し，空いた所に続きを受信する  (前回返した行はここで上書きされる)
+        if (_begin)
+        {
+            std::memmove(_buffer, _buffer + _begin, _end - _begin);
+            _scanned -= _begin;
+            _end -= _begin;
+            _begin = 0;
+        }
+        _end += _communication.read_available(_buffer_bytes - _end, _buffer + _end, _select_device);
+        return find_line(line);
+    }
+
+    // バッファの中から1行取り出す
+    // 戻り値 : 行を取り出せたか
+    bool LineReader::find_line(Line& line)
+    {
+        const uint8_t* found;
+        while ((found = find_byte(_buffer + _scanned, _end - _scanned, _delimiter)) != nullptr)
+        {
+            std::size_t begin = _begin;
+            std::size_t end = found - _buffer;
+            _begin = _scanned = end + 1;
+            if (_discarding)  // バッファに収まらなかった行の残り
+            {
+                _discarding = false;
+    continue;
+            }
+            if (_delimiter == '\n' && end > begin && _buffer[end - 1] == '\r') --end;
+            line.data = _buffer + begin;
+            line.size = end - begin;
+            line.truncated = false;
+            ++_lines;
+            return true;
+        }
+        _scanned = _end;
+
+        if (_discarding)
+        {
+            _begin = _end;  // 区切り文字が来るまで捨て続ける
+        }
+        else if (_end - _begin == _buffer_bytes)  // 区切り文字が見つからないままバッファがいっぱいになった
+        {
+            line.data = _buffer + _begin;
+            line.size = _buffer_bytes;
+            line.truncated = true;
+            _begin = _end;
+            _discarding = true;
+            ++_lines;
+            ++_overflows;
+            return true;
+        }
+        return false;
+    }
+
     /***** class I2C *****/
 
+    bool I2C::AlreadyUseI2C0 = false;
+    bool I2C::AlreadyUseI2C1 = false;
+
     // I2Cのセットアップ  I2C0とI2C1を使う際にそれぞれ一回だけ呼び出す
     // i2c_id : I2C0かi2c1か
     // scl_pin : I2CのSCLのピン (ピン番号のみ指定したもの)
     // sda_pin : I2CのSDAのピン (ピン番号のみ指定したもの)
     // freq : I2Cの転送速度
     I2C::I2C(bool i2c_id, Pin scl_pin, Pin sda_pin, const uint32_t& freq):
-        _i2c_id(i2c_id)
+        _i2c_id(i2c_id),
+        _default_freq(freq),
+        _current_freq(freq)
     {
         if (_i2c_id)
         {
@@ -445,13 +567,16 @@ namespace sc
     // slave_addr : 通信先のデバイスのCSピンのGPIO番号
     void I2C::read(std::size_t input_data_bytes, uint8_t *input_data, uint8_t slave_addr) const
     {
+        wait_interval(slave_addr);  // 同じデバイスとの前回の通信から設定した時間が経つまで待つ
+        select_freq(slave_addr);  // 通信するデバイスに合わせて通信速度を切り替える
+
         if (_i2c_id) {
             i2c_read_blocking(i2c1, slave_addr, input_data, input_data_bytes, false);  // データを受信  3番目の引数は受信したデータを保存する配列の先頭へのポインタ  5番目の引数は，停止信号を送らず次の通信まで他のデバイスに割り込ませないか
         } else {
             i2c_read_blocking(i2c0, slave_addr, input_data, input_data_bytes, false);  // データを受信  3番目の引数は受信したデータを保存する配列の先頭へのポインタ  5番目の引数は，停止信号を送らず次の通信まで他のデバイスに割り込ませないか
         }
 
-        sleep_ms(10);  // 要検証
+        mark_complete(slave_addr);  // 通信が完了した時刻を記録
     }
 
     // I2Cで送信
@@ -460,17 +585,169 @@ namespace sc
     // slave_addr : 通信先のデバイスのスレーブアドレス (どのデバイスにデータを書き込むか) 通常は8~119の間を使用する  7bit
     void I2C::write(std::size_t output_data_bytes, uint8_t *output_data, uint8_t slave_addr) const
     {
+        wait_interval(slave_addr);  // 同じデバイスとの前回の通信から設定した時間が経つまで待つ
+        select_freq(slave_addr);  // 通信するデバイスに合わせて通信速度を切り替える
+
         if (_i2c_id) {
             i2c_write_blocking(i2c1, slave_addr, output_data, output_data_bytes, false);  // データを送信  3番目の引数は，送信するデータの配列の先頭へのポインタ  5番目の引数は，停止信号を送らず次の通信まで他のデバイスに割り込ませないか
         } else {
             i2c_write_blocking(i2c0, slave_addr, output_data, output_data_bytes, false);  // データを送信  3番目の引数は，送信するデータの配列の先頭へのポインタ  5番目の引数は，停止信号を送らず次の通信まで他のデバイスに割り込ませないか
         }
 
-        sleep_ms(10);  // 要検証
+        mark_complete(slave_addr);  // 通信が完了した時刻を記録
+    }
+
+    // メモリから読み込み
+    // memory_addr : 相手のデバイスの何番地のメモリーからデータを読み込むか
+    // input_data_bytes : 何バイト(文字)データを読み込むか (省略した場合は，input_dataの長さだけ読み込む)
+    // input_data : 受信したデータを保存するための配列
+    // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+    // メモリアドレスの送信とデータの受信の間に停止信号を送らず，再開始信号(リピーテッドスタート)で1回の通信として行います
+    // デバイスが応答しないなど，指定したバイト数を読み込めなかった場合は例外(Error)を投げます
+    void I2C::read_mem(uint8_t memory_addr, std::size_t input_data_bytes, uint8_t* input_data, uint8_t slave_addr) const
+    {
+        read_mem_burst({{memory_addr, input_data_bytes, input_data}}, slave_addr);
+    }
+
+    // 1つのデバイスのメモリの離れた複数の範囲をまとめて読み込む
+    // ranges : 読み込む範囲  {{メモリアドレス, バイト数, 配列}, {...}, ...}のように書く
+    // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+    // 最後の範囲を読み込むまで停止信号を送らないため，途中で他の通信に割り込まれません
+    // どれかの範囲を読み込めなかった場合は例外(Error)を投げます
+    void I2C::read_mem_burst(std::initializer_list<MemRange> ranges, uint8_t slave_addr) const
+    {
+        if (!ranges.size())
+    return;
+
+        wait_interval(slave_addr);  // 同じデバイスとの前回の通信から設定した時間が経つまで待つ
+        select_freq(slave_addr);  // 通信するデバイスに合わせて通信速度を切り替える
+
+        i2c_inst_t* i2c = (_i2c_id ? i2c1 : i2c0);
+        const MemRange* last_range = ranges.end() - 1;
+        for (const MemRange& range : ranges)
+        {
+            int written_bytes = i2c_write_blocking(i2c, slave_addr, &range.memory_addr, 1, true);  // メモリアドレスを送信  停止信号は送らない
+            int read_bytes = i2c_read_blocking(i2c, slave_addr, range.input_data, range.input_data_bytes, (&range != last_range));  // データを受信  最後の範囲のときだけ停止信号を送る
+            if (written_bytes != 1 || read_bytes != static_cast<int>(range.input_data_bytes))
+            {
+                mark_complete(slave_addr);
+                throw Error(__FILE__, __LINE__, "Failed to read memory via I2C");  // I2Cによるメモリの読み込みに失敗しました
+            }
+        }
+
+        mark_complete(slave_addr);  // 通信が完了した時刻を記録
+    }
+
+    // 同じデバイスとの通信の間に最低限空ける時間を設定
+    // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+    // min_interval_us : 前回の通信が完了してから次の通信を始めるまでに空ける時間 (μs)  0のときは待たない (初期値:0)
+    // 異なるデバイスとの通信は待たずにすぐに行います
+    void I2C::set_min_interval(uint8_t slave_addr, uint32_t min_interval_us)
+    {
+        if (slave_addr > 0x7f) throw Error(__FILE__, __LINE__, "I2C slave address must be 7 bits");  // I2Cのスレーブアドレスは7bitである必要があります
+        _min_interval_us[slave_addr] = min_interval_us;
+    }
+
+    // デバイスごとに通信速度の最大値を設定
+    // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+    // max_freq : そのデバイスと通信するときの通信速度 (Hz)  100kHz, 400kHz, 1MHz など  0のときはセットアップ時の通信速度を使う
+    // 通信速度は，前回と異なる速度のデバイスと通信するときだけ切り替えます
+    void I2C::set_max_freq(uint8_t slave_addr, uint32_t max_freq)
+    {
+        if (slave_addr > 0x7f) throw Error(__FILE__, __LINE__, "I2C slave address must be 7 bits");  // I2Cのスレーブアドレスは7bitである必要があります
+        if (max_freq > 1000000) throw Error(__FILE__, __LINE__, "I2C frequency must be 1MHz or less");  // I2Cの通信速度は1MHz以下である必要があります
+        _max_freq[slave_addr] = max_freq;
+    }
+
+    // 通信するデバイスに合わせて通信速度を切り替える  (速度が変わらない場合は何もしない)
+    // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+    // read, writeなどの中で自動で呼び出されるので，通常は呼び出す必要はありません
+    void I2C::select_freq(uint8_t slave_addr) const
+    {
+        uint32_t freq = this->freq(slave_addr);
+        if (freq == _current_freq)
+    return;  // 同じ速度のデバイスが続く間は切り替えない
+
+        uint32_t start_us = time_us_32();
+        i2c_set_baudrate((_i2c_id ? i2c1 : i2c0), freq);
+        _freq_change_time_us += time_us_32() - start_us;  // 切り替えにかかった時間を記録
+        ++_freq_changes;
+        _current_freq = freq;
+    }
+
+    // 前回の通信から設定した時間が経つまで待つ
+    // 通信が終わるたびに一定時間待つのではなく，同じデバイスとの次の通信の直前に，足りない時間だけ待つ
+    void I2C::wait_interval(uint8_t slave_addr) const
+    {
+        uint32_t min_interval_us = _min_interval_us[slave_addr & 0x7f];
+        if (!min_interval_us)
+    return;
+        uint32_t elapsed_us = time_us_32() - _last_complete_us[slave_addr & 0x7f];  // 符号なしの引き算なので，時刻がオーバーフローしても正しく計算できる
+        if (elapsed_us < min_interval_us)
+            sleep_us(min_interval_us - elapsed_us);
+    }
+
+    // 通信が完了した時刻を記録
+    void I2C::mark_complete(uint8_t slave_addr) const
+    {
+        _last_complete_us[slave_addr & 0x7f] = time_us_32();
+    }
+
+    // すべてのスレーブアドレスに短い通信を送り，接続されているデバイスを調べて記録する
+    // 起動時に，各センサをセットアップする前に一回だけ呼び出してください
+    // [timeout_us] : 1つのアドレスあたりの制限時間 (μs) (省略時:1000)
+    // 戻り値 : 見つかったデバイスの数
+    std::size_t I2C::scan(uint32_t timeout_us)
+    {
+        std::size_t found_num = 0;
+        for (uint32_t& bits : _present) bits = 0;
+        for (uint8_t slave_addr = 0x08; slave_addr < 0x78; ++slave_addr)  // 0x00~0x07と0x78~0x7fは予約されているアドレスなので調べない
+        {
+            uint8_t dummy;
+            if (i2c_read_timeout_us((_i2c_id ? i2c1 : i2c0), slave_addr, &dummy, 1, false, timeout_us) >= 0)  // 応答(ACK)があれば接続されている
+            {
+                _present[slave_addr >> 5] |= (1UL << (slave_addr & 31));
+                ++found_num;
+            }
+        }
+        _scanned = true;
+        return found_num;
+    }
+
+    // デバイスが接続されているか
+    // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+    // scanで記録した結果を返すので通信は行わない  scanを呼び出していない場合は常にtrue
+    bool I2C::is_present(uint8_t slave_addr) const
+    {
+        if (!_scanned)
+    return true;
+        return (_present[(slave_addr & 0x7f) >> 5] >> (slave_addr & 31)) & 1U;
+    }
+
+    // デバイスのID (チップIDなど) を読み込む
+    // id_memory_addr : IDが保存されているメモリアドレス
+    // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+    // 一度読み込んだIDは記録しておき，次からは通信せずに返す
+    uint8_t I2C::device_id(uint8_t id_memory_addr, uint8_t slave_addr) const
+    {
+        for (std::size_t i = 0; i < _device_ids_num; ++i)
+        {
+            if (_device_ids[i].slave_addr == slave_addr && _device_ids[i].id_memory_addr == id_memory_addr)
+    return _device_ids[i].id;
+        }
+
+        if (!is_present(slave_addr)) throw Error(__FILE__, __LINE__, "The I2C device was not found by the bus scan");  // I2Cのデバイスがスキャンで見つかりませんでした
+        uint8_t id;
+        read_mem(id_memory_addr, 1, &id, slave_addr);
+        if (_device_ids_num < MaxDeviceIds) _device_ids[_device_ids_num++] = {slave_addr, id_memory_addr, id};
+        return id;
     }
 
     /***** class SPI *****/
 
+    bool SPI::AlreadyUseSPI0 = false;
+    bool SPI::AlreadyUseSPI1 = false;
+
     // SPIのセットアップ  SPI0とSPI1を使う際にそれぞれ一回だけ呼び出す
     // spi_id : SPI0かSPI1か
     // sck_pin : SPIのSCKピン
@@ -479,7 +756,9 @@ namespace sc
     // cs_pins : SPIのCS(SS)ピン 使用するものすべて (波かっこ{}の中にカンマで区切って書く)
     // freq : SPIの転送速度
     SPI::SPI(bool spi_id, Pin sck_pin, Pin mosi_pin, Pin miso_pin, std::initializer_list<Pin> cs_pins, uint32_t freq):
-        _spi_id(spi_id)
+        _spi_id(spi_id),
+        _default_freq(freq),
+        _current{MODE_0, freq}  // spi_initはモード0とセットアップ時の転送速度に設定する
     {
         if (_spi_id)
         {
@@ -511,6 +790,7 @@ namespace sc
     // output_data : データを受信している間に送信するデータ(1バイト)  データを1バイト受信するごとに1回送信する
     void SPI::read(std::size_t input_data_bytes, uint8_t *input_data, uint8_t cs_gpio, uint8_t output_data) const
     {
+        select_profile(cs_gpio);  // 通信するデバイスに合わせて設定を切り替える
         gpio_put(cs_gpio, 0);  // CSピンを選択
         if (_spi_id) {
             spi_read_blocking(spi1, output_data, (uint8_t*)input_data, input_data_bytes);  // データを受信  2番目の引数はデータを受信している間に送信するデータ  3番目の引数は受信したデータを保存する配列の先頭へのポインタ
@@ -518,8 +798,6 @@ namespace sc
             spi_read_blocking(spi0, output_data, (uint8_t*)input_data, input_data_bytes);  // データを受信  2番目の引数はデータを受信している間に送信するデータ  3番目の引数は受信したデータを保存する配列の先頭へのポインタ
         }
         gpio_put(cs_gpio, 1);  // CSピンの選択を解除
-
-        sleep_ms(10);  // 要検証
     }
 
     // SPIで送信
@@ -528,6 +806,7 @@ namespace sc
     // cs_gpio : 通信先のデバイスに繋がるCSピンのGPIO番号
     void SPI::write(std::size_t output_data_bytes, uint8_t *output_data, uint8_t cs_gpio) const
     {
+        select_profile(cs_gpio);  // 通信するデバイスに合わせて設定を切り替える
         gpio_put(cs_gpio, 0);  // CSピンを選択
         if (_spi_id) {
             spi_write_blocking(spi1, (uint8_t*)output_data, output_data_bytes);  // データを送信
@@ -535,12 +814,99 @@ namespace sc
             spi_write_blocking(spi0, (uint8_t*)output_data, output_data_bytes);  // データを送信
         }
         gpio_put(cs_gpio, 1);  // CSピンの選択を解除
+    }
 
-        sleep_ms(10);  // 要検証
+    // メモリから読み込み
+    // memory_addr : 相手のデバイスの何番地のメモリーからデータを読み込むか
+    // input_data_bytes : 何バイト(文字)データを読み込むか (省略した場合は，input_dataの長さだけ読み込む)
+    // input_data : 受信したデータを保存するための配列
+    // cs_gpio : 通信先のデバイスに繋がるCSピンのGPIO番号
+    // メモリーアドレスの8ビット目を自動で1に置き換えます
+    // メモリアドレスの送信とデータの受信の間はCSピンを選択したままにし，1回の通信として行います
+    void SPI::read_mem(uint8_t memory_addr, std::size_t input_data_bytes, uint8_t* input_data, uint8_t cs_gpio) const
+    {
+        read_mem_burst({{memory_addr, input_data_bytes, input_data}}, cs_gpio);
+    }
+
+    // メモリに書き込み
+    // memory_addr : 相手のデバイスの何番地のメモリーにデータを書き込むか
+    // output_data_bytes : 何バイト(文字)データを書き込むか (省略した場合は，output_dataの長さだけ書き込む)
+    // output_data : 送信するデータの配列
+    // cs_gpio : 通信先のデバイスに繋がるCSピンのGPIO番号
+    // メモリーアドレスの8ビット目を自動で0に置き換えます
+    // メモリアドレスとデータの送信の間はCSピンを選択したままにし，1回の通信として行います
+    void SPI::write_mem(uint8_t memory_addr, std::size_t output_data_bytes, uint8_t* output_data, uint8_t cs_gpio) const
+    {
+        spi_inst_t* spi = (_spi_id ? spi1 : spi0);
+        memory_addr &= 0b01111111;  // 8ビット目が0のときは書き込み
+        select_profile(cs_gpio);  // 通信するデバイスに合わせて設定を切り替える
+
+        gpio_put(cs_gpio, 0);  // CSピンを選択
+        spi_write_blocking(spi, &memory_addr, 1);  // メモリアドレスを送信
+        spi_write_blocking(spi, output_data, output_data_bytes);  // 続けてデータを送信
+        gpio_put(cs_gpio, 1);  // CSピンの選択を解除
+    }
+
+    // 1つのデバイスのメモリの離れた複数の範囲をまとめて読み込む
+    // ranges : 読み込む範囲  {{メモリアドレス, バイト数, 配列}, {...}, ...}のように書く
+    // cs_gpio : 通信先のデバイスに繋がるCSピンのGPIO番号
+    // 範囲ごとにCSピンを選択し直し，間を空けずに続けて読み込みます
+    void SPI::read_mem_burst(std::initializer_list<MemRange> ranges, uint8_t cs_gpio) const
+    {
+        spi_inst_t* spi = (_spi_id ? spi1 : spi0);
+        select_profile(cs_gpio);  // 通信するデバイスに合わせて設定を切り替える
+        for (const MemRange& range : ranges)
+        {
+            uint8_t memory_addr = range.memory_addr | 0b10000000;  // 8ビット目が1のときは読み込み
+
+            gpio_put(cs_gpio, 0);  // CSピンを選択
+            spi_write_blocking(spi, &memory_addr, 1);  // メモリアドレスを送信
+            spi_read_blocking(spi, 0, range.input_data, range.input_data_bytes);  // 続けてデータを受信  (受信している間は0を送信)
+            gpio_put(cs_gpio, 1);  // CSピンの選択を解除
+        }
+    }
+
+    // CSピンごとに通信の設定をする
+    // cs_gpio : 通信先のデバイスに繋がるCSピンのGPIO番号
+    // mode : SPIのモード
+    // [freq] : そのデバイスと通信するときの転送速度 (省略時:セットアップ時の転送速度)
+    // [msb_first] : 上位ビットから送るか (省略時:true)  RP2040のSPIは上位ビットからの送信のみ対応しています
+    // 設定は，前回と異なる設定のデバイスと通信するときだけ変更します
+    void SPI::set_profile(uint8_t cs_gpio, Mode mode, uint32_t freq, bool msb_first)
+    {
+        if (cs_gpio >= GpioNum) throw Error(__FILE__, __LINE__, "Invalid CS pin GPIO number");  // CSピンのGPIO番号が不正です
+        if (!msb_first) throw Error(__FILE__, __LINE__, "RP2040 SPI supports MSB-first transfers only");  // RP2040のSPIは上位ビットからの送信のみ対応しています
+        _profiles[cs_gpio].mode = mode;
+        _profiles[cs_gpio].freq = freq;
+    }
+
+    // 通信するデバイスに合わせて設定を切り替える  (設定が変わらない場合は何もしない)
+    // cs_gpio : 通信先のデバイスに繋がるCSピンのGPIO番号
+    // read, writeなどの中で自動で呼び出されるので，通常は呼び出す必要はありません
+    void SPI::select_profile(uint8_t cs_gpio) const
+    {
+        if (cs_gpio >= GpioNum)
+    return;
+        Profile profile = _profiles[cs_gpio];
+        if (!profile.freq) profile.freq = _default_freq;  // 0はセットアップ時の転送速度を明示した場合と同じ設定とみなす
+        if (profile == _current)
+        {
+            ++_reconfigurations_avoided;  // 同じ設定のデバイスが続く間は切り替えない
+    return;
+        }
+
+        spi_inst_t* spi = (_spi_id ? spi1 : spi0);
+        if (profile.freq != _current.freq) spi_set_baudrate(spi, profile.freq);
+        if (profile.mode != _current.mode) spi_set_format(spi, 8, (profile.mode & 0b10 ? SPI_CPOL_1 : SPI_CPOL_0), (profile.mode & 0b01 ? SPI_CPHA_1 : SPI_CPHA_0), SPI_MSB_FIRST);
+        _current = profile;
+        ++_reconfigurations;
     }
 
     /***** class UART *****/
 
+    bool UART::AlreadyUseUART0 = false;
+    bool UART::AlreadyUseUART1 = false;
+
     // UARTのセットアップ  UART0とUART1を使う際にそれぞれ一回だけ呼び出す
     // uart_id : UART0かuart1か
     // tx_gpio : UARTのTXピン
@@ -579,12 +945,87 @@ namespace sc
         sleep_ms(10);  // 要検証
     }
 
+    // 割り込み処理で送信するデータを保存する送信バッファ (リングバッファ)
+    // メインループがheadだけを，割り込み処理がtailだけを進める
+    struct UartTxBuffer
+    {
+        uint8_t data[UART::TxBufferSize];
+        volatile std::size_t head = 0;  // これまでに保存したバイト数 (次に書き込む位置)  オーバーフローしてもかまわない
+        volatile std::size_t tail = 0;  // これまでにFIFOに移したバイト数 (次に送信する位置)  オーバーフローしてもかまわない
+        volatile uint32_t dropped = 0;  // 送信バッファがいっぱいで捨てたバイト数
+        std::size_t high_water = 0;  // 送信バッファにたまったバイト数の最大値
+        UART::TxFullPolicy policy = UART::TxFullPolicy::BLOCK;
+        bool enabled = false;  // set_tx_irqで送信バッファを使っているか
+    };
+    static_assert(!(UART::TxBufferSize & (UART::TxBufferSize - 1)), "UART TX buffer size must be a power of two");  // 送信バッファの大きさは2の累乗である必要があります
+    static UartTxBuffer UartTx[2];  // UART0とUART1の送信バッファ
+
+    // 送信バッファのデータを，FIFOが空いている分だけFIFOに移す  (割り込みを禁止した状態か，割り込み処理の中で呼び出す)
+    // データが残っている間だけ送信の割り込みを有効にする
+    static void uart_tx_fill(uart_inst_t* uart, UartTxBuffer& buffer)
+    {
+        uart_hw_t* hw = uart_get_hw(uart);
+        std::size_t head = buffer.head;
+        std::size_t tail = buffer.tail;
+        while (tail != head && uart_is_writable(uart))
+        {
+            uart_putc_raw(uart, buffer.data[tail & (UART::TxBufferSize - 1)]);  // 空きを確かめたので待たずに書き込まれる
+            ++tail;
+        }
+        buffer.tail = tail;
+        if (tail == head) hw_clear_bits(&hw->imsc, UART_UARTIMSC_TXIM_BITS);
+        else hw_set_bits(&hw->imsc, UART_UARTIMSC_TXIM_BITS);
+    }
+
     // UARTで送信
     // [output_data_bytes] : 何バイト(文字)書き込むか (省略時:output_dataの長さだけ書き込む)
     // output_data : 送信するデータの配列
     // 引数No_Useは，互換性維持のためにUARTでも付けていますが，UARTでは使用しません．
+    // set_tx_irqを呼び出した後は，送信バッファにコピーしてすぐに戻ります
+    // 割り込み処理の中や割り込みを禁止した状態では送信バッファが空かないので，BLOCKの場合も待たずにDROPと同じく捨てます
     void UART::write(std::size_t output_data_bytes, uint8_t *output_data, uint8_t No_Use) const
     {
+        UartTxBuffer& buffer = UartTx[_uart_id];
+        if (buffer.enabled)
+        {
+            if (output_data_bytes > TxBufferSize - (buffer.head - buffer.tail))
+            {
+                uint32_t status = save_and_disable_interrupts();
+                restore_interrupts(status);
+                bool can_wait = (buffer.policy == TxFullPolicy::BLOCK && !__get_current_exception() && !status);  // statusは割り込みを禁止していた場合に0以外
+                if (!can_wait)
+                {
+                    buffer.dropped = buffer.dropped + output_data_bytes;
+    return;
+                }
+            }
+
+            uart_inst_t* uart = (_uart_id ? uart1 : uart0);
+            while (output_data_bytes)
+            {
+                std::size_t space;
+                while (!(space = TxBufferSize - (buffer.head - buffer.tail))) tight_loop_contents();  // 割り込み処理が送信バッファを空けるまで待つ (BLOCKの場合のみ)
+
+                std::size_t head = buffer.head;
+                std::size_t copy_bytes = (output_data_bytes < space ? output_data_bytes : space);
+                std::size_t index = head & (TxBufferSize - 1);
+                std::size_t first_bytes = (copy_bytes < TxBufferSize - index ? copy_bytes : TxBufferSize - index);  // 送信バッファの終わりで折り返す
+                std::memcpy(buffer.data + index, output_data, first_bytes);
+                std::memcpy(buffer.data, output_data + first_bytes, copy_bytes - first_bytes);
+                __compiler_memory_barrier();  // データを書き込んでから位置を進める
+                buffer.head = head + copy_bytes;
+                if (buffer.head - buffer.tail > buffer.high_water) buffer.high_water = buffer.head - buffer.tail;
+                output_data += copy_bytes;
+                output_data_bytes -= copy_bytes;
+
+                // FIFOが空のまま割り込みを有効にしても割り込みは発生しない(FIFOの量が基準を下回ったときに発生する)ので，最初の分はここでFIFOに移す
+                uint32_t status = save_and_disable_interrupts();
+                uart_tx_fill(uart, buffer);
+                restore_interrupts(status);
+            }
+    return;
+        }
+
         if (_uart_id) {
             uart_write_blocking(uart1, (uint8_t*)output_data, output_data_bytes);  // データを送信
         } else {
@@ -594,72 +1035,294 @@ namespace sc
         sleep_ms(10);  // 要検証
     }
 
-    static std::deque<uint8_t> DefaultDeque(0);
-    // 割り込み処理で読み取ったデータを保存するための変数を返す関数
-    inline static std::deque<uint8_t>& uart0_data(std::deque<uint8_t>& dq = DefaultDeque)
+    // 割り込み処理で受信したデータを保存する受信バッファ (リングバッファ)
+    // 割り込み処理がheadだけを，メインループがtailだけを進めるので，割り込みを禁止せずに読み書きできる
+    struct UartRxBuffer
     {
-        static std::deque<uint8_t>& uart0_dq = dq;
-        return uart0_dq;
-    }
-    static std::size_t Uart0MaxLen = 100;  // 最大で何バイトまで保存するか
-    // 割り込み処理で実行する関数
-    void uart0_handler()
+        alignas(UART::RxBufferSize) uint8_t data[UART::RxBufferSize];  // DMAのリング(書き込み先の折り返し)を使うため，大きさの境界に配置する
+        volatile std::size_t head = 0;  // これまでに保存したバイト数 (次に書き込む位置)  オーバーフローしてもかまわない
+        volatile std::size_t tail = 0;  // これまでに読み取ったバイト数 (次に読み取る位置)  オーバーフローしてもかまわない
+        volatile uint32_t dropped = 0;  // 受信バッファがいっぱいで捨てたバイト数
+        bool enabled = false;  // set_irqかset_dmaで受信バッファを使っているか
+
+        // DMAで受信する場合に使う
+        int dma_channel = -1;  // DMAのチャンネル  -1のときは割り込み処理で受信する
+        std::size_t dma_base = 0;  // DMAを最後に開始したときのhead
+        UART::IdleCallback idle_callback = nullptr;  // 受信が途切れたときに呼び出す関数
+        std::size_t last_head = 0;  // 前回確認したときのhead
+        bool receiving = false;  // 前回確認してから受信したか
+        uint32_t idle_check_us = 1000;  // 受信が途切れたかを確認する間隔 (μs)
+        repeating_timer_t idle_timer;  // 受信が途切れたかを確認するタイマー  受信している間だけ動かす
+    };
+    static_assert(!(UART::RxBufferSize & (UART::RxBufferSize - 1)), "UART RX buffer size must be a power of two");  // 受信バッファの大きさは2の累乗である必要があります
+    static UartRxBuffer UartRx[2];  // UART0とUART1の受信バッファ
+
+    // 割り込み処理で実行する関数  FIFOにたまったデータをまとめて受信バッファに移す
+    static void uart_rx_handler(uart_inst_t* uart, UartRxBuffer& buffer)
     {
-        while (uart_is_readable(uart0))
+        std::size_t head = buffer.head;
+        while (uart_is_readable(uart))
         {
-            uart0_data().push_back(uart_getc(uart0));
-            uart0_data().pop_front();
+            uint8_t data = uart_getc(uart);  // 読み取るとFIFOから削除され，受信が途切れたときの割り込みも解除される  (読み取れることを確かめたので待たない)
+            if (head - buffer.tail < UART::RxBufferSize)
+            {
+                buffer.data[head & (UART::RxBufferSize - 1)] = data;
+                ++head;
+            } else {
+                buffer.dropped = buffer.dropped + 1;  // いっぱいの場合は新しいデータを捨てる
+            }
         }
-        if (uart0_data().size() != Uart0MaxLen)
+        __compiler_memory_barrier();  // データを書き込んでから位置を進める
+        buffer.head = head;
+    }
+
+    static void uart_dma_start_burst(uart_inst_t* uart, UartRxBuffer& buffer);
+
+    // UARTの割り込み処理  受信と送信で同じ割り込みを使う
+    static void uart_irq_handler(uart_inst_t* uart, UartRxBuffer& rx_buffer, UartTxBuffer& tx_buffer)
+    {
+        if (rx_buffer.enabled)
         {
-            uart0_data().resize(Uart0MaxLen, 0U);
+            if (rx_buffer.dma_channel < 0) uart_rx_handler(uart, rx_buffer);
+            else if ((uart_get_hw(uart)->imsc & UART_UARTIMSC_RXIM_BITS) && uart_is_readable(uart)) uart_dma_start_burst(uart, rx_buffer);  // DMAで受信している場合はFIFOから読み取らず，DMAに任せる
         }
+        if (tx_buffer.enabled) uart_tx_fill(uart, tx_buffer);
     }
+    void uart0_handler() {uart_irq_handler(uart0, UartRx[0], UartTx[0]);}
+    void uart1_handler() {uart_irq_handler(uart1, UartRx[1], UartTx[1]);}
 
-    // 割り込み処理で読み取ったデータを保存するための変数を返す関数
-    inline static std::deque<uint8_t>& uart1_data(std::deque<uint8_t>& dq = DefaultDeque)
+    // 割り込み処理で受信時に自動でデータを読み込み，受信バッファに保存
+    // FIFOを有効にし，FIFOが半分たまったときと，受信が途切れたとき(32bit分の時間)にだけ割り込みを発生させます
+    // 保存したデータは available, read_some で読み取ります
+    // 受信バッファ(RxBufferSizeバイト)がいっぱいの場合は，新しく受信したデータを捨てて dropped_bytes で数えます  (読み取っていない古いデータは残る)
+    // 同じオブジェクトに対し二回以上このメソッドを使った場合の動作は未定義です
+    void UART::set_irq() const
     {
-        static std::deque<uint8_t>& uart1_dq = dq;
-        return uart1_dq;
+        uart_inst_t* uart = (_uart_id ? uart1 : uart0);
+        UartRx[_uart_id].head = UartRx[_uart_id].tail = 0;
+        UartRx[_uart_id].enabled = true;
+
+        uart_set_hw_flow(uart, false, false);  // フロー制御(受信準備が終わるまで送信しないで待つ機能)を無効にします
+        uart_set_format(uart, 8, 1, UART_PARITY_NONE);  // UART通信の設定をします
+        uart_set_fifo_enabled(uart, true);  // FIFO(受信したデータを一時的に保管する機能)を有効にし，まとめて受信する
+
+        irq_set_exclusive_handler((_uart_id ? UART1_IRQ : UART0_IRQ), (_uart_id ? uart1_handler : uart0_handler));  // 割り込み処理で実行する関数をセット
+        uart_hw_t* hw = uart_get_hw(uart);
+        hw->ifls = (hw->ifls & ~UART_UARTIFLS_RXIFLSEL_BITS) | (0b010 << UART_UARTIFLS_RXIFLSEL_LSB);  // FIFO(32バイト)が半分たまったら割り込み
+        hw_set_bits(&hw->imsc, UART_UARTIMSC_RXIM_BITS | UART_UARTIMSC_RTIM_BITS);  // FIFOの量と，受信が途切れたとき(RXタイムアウト)に割り込み
+        irq_set_enabled((_uart_id ? UART1_IRQ : UART0_IRQ), true);  // 割り込み処理を有効にする
     }
-    static std::size_t Uart1MaxLen = 100;  // 最大で何バイトまで保存するか
-    // 割り込み処理で実行する関数
-    void uart1_handler()
+
+    static const uint32_t UartDmaTransferCount = 0xffffffff;  // DMAを1回開始したときに受信する最大のバイト数  (115200bpsで約4日分)
+    static const uint32_t UartDmaRearmCount = 0x80000000;  // DMAの残りの転送回数がこれより少なくなったら，DMAを開始し直す
+
+    // これまでに受信バッファに保存したバイト数  DMAで受信している場合はDMAの残りの転送回数から求める
+    static std::size_t uart_rx_head(const UartRxBuffer& buffer)
+    {
+        if (buffer.dma_channel < 0)
+    return buffer.head;
+        uint32_t status = save_and_disable_interrupts();  // DMAを開始し直している途中の値を読まないようにする
+        std::size_t head = buffer.dma_base + (UartDmaTransferCount - dma_channel_hw_addr(buffer.dma_channel)->transfer_count);
+        restore_interrupts(status);
+        return head;
+    }
+
+    // DMAの残りの転送回数が少なくなっていれば，続きの位置から開始し直す  (割り込み処理の中で呼び出す)
+    // 止めている間に届いたデータはFIFOに残り，開始し直した後に書き込まれるので失われない
+    static void uart_dma_rearm(UartRxBuffer& buffer)
+    {
+        if (dma_channel_hw_addr(buffer.dma_channel)->transfer_count >= UartDmaRearmCount)
+    return;
+        dma_channel_abort(buffer.dma_channel);
+        buffer.dma_base += UartDmaTransferCount - dma_channel_hw_addr(buffer.dma_channel)->transfer_count;
+        dma_channel_set_trans_count(buffer.dma_channel, UartDmaTransferCount, false);
+        dma_channel_set_write_addr(buffer.dma_channel, buffer.data + (buffer.dma_base & (UART::RxBufferSize - 1)), true);
+    }
+
+    // 受信を待っている間の設定にする  受信時のDMAを止め，FIFOにデータが届いたら割り込みを発生させる
+    // 届いたデータはDMAを再開するまでFIFO(32バイト)に残るので失われない
+    static void uart_dma_wait_burst(uart_inst_t* uart)
+    {
+        uart_hw_t* hw = uart_get_hw(uart);
+        hw_clear_bits(&hw->dmacr, UART_UARTDMACR_RXDMAE_BITS);
+        hw_set_bits(&hw->imsc, UART_UARTIMSC_RXIM_BITS | UART_UARTIMSC_RTIM_BITS);  // FIFOが1/8(4バイト)たまったときと，それより短いまま途切れたとき
+    }
+
+    // 受信が途切れたかを確認するタイマーの処理
+    // 前回の確認から受信していて，今回の確認までに受信していなければ途切れたとみなし，受信済みの位置を知らせる
+    // 途切れたらタイマーを止め，次に受信し始めるまでは割り込みを待つ
+    // DMAの転送回数を使い切って受信が止まらないよう，DMAの開始し直しもここで行う
+    static bool uart_idle_check(repeating_timer_t* timer)
     {
-        while (uart_is_readable(uart1))
+        UartRxBuffer& buffer = *static_cast<UartRxBuffer*>(timer->user_data);
+        uart_dma_rearm(buffer);
+        std::size_t head = uart_rx_head(buffer);
+        if (head != buffer.last_head)
         {
-            uart1_data().push_back(uart_getc(uart1));
-            uart1_data().pop_front();
+            buffer.last_head = head;
+            buffer.receiving = true;
+    return true;  // 確認を続ける
         }
-        if (uart1_data().size() != Uart1MaxLen)
+        uart_dma_wait_burst(&buffer == &UartRx[1] ? uart1 : uart0);
+        head = uart_rx_head(buffer);  // DMAを止める直前に移したデータも含める
+        if (buffer.receiving)
         {
-            uart1_data().resize(Uart1MaxLen, 0U);
+            buffer.receiving = false;
+            buffer.head = head;
+            if (buffer.idle_callback) buffer.idle_callback(head);
         }
+        return false;  // 確認をやめる
     }
 
-    // 割り込み処理で受信時に自動でデータを読み込み，dequeに保存
-    // max_data_bytes : dequeの大きさが最大で何バイトになるまで，読み取った値をdequeの末尾に追加するかを指定します．dequeの大きさがこの値を超えた場合，先頭のデータから削除されます
-    // InputData : !クローバル! 読み取った値を追加するdequeを指定します．このdequeは，グローバル変数である必要があります
-    // 同じオブジェクトに対し二回以上このメソッドを使った場合の動作は未定義です
-    void UART::set_irq(std::size_t max_data_bytes, std::deque<uint8_t>& InputData) const
+    // 受信し始めたときの割り込み処理  受信時のDMAを再開し，受信が途切れたかを確認するタイマーを開始する
+    // 受信していない間はタイマーを動かさないので，CPUは受信するたびに起きるだけでよい
+    static void uart_dma_start_burst(uart_inst_t* uart, UartRxBuffer& buffer)
     {
-        InputData.resize(max_data_bytes, 0U);
-        if (_uart_id)
+        uart_hw_t* hw = uart_get_hw(uart);
+        hw_clear_bits(&hw->imsc, UART_UARTIMSC_RXIM_BITS | UART_UARTIMSC_RTIM_BITS);
+        hw_set_bits(&hw->dmacr, UART_UARTDMACR_RXDMAE_BITS);  // FIFOに残っているデータからDMAで移す
+        buffer.receiving = true;  // 割り込みが発生したので，最初の確認の前から受信している
+        if (!add_repeating_timer_us(-static_cast<int64_t>(buffer.idle_check_us), uart_idle_check, &buffer, &buffer.idle_timer))
+            buffer.idle_callback = nullptr;  // タイマーを開始できなかった場合はDMAで受信し続けるが，途切れたことは知らせない
+    }
+
+    // DMAで受信バッファに書き込み続ける  (set_irqの代わりに使う)
+    // 1バイトごとの割り込みが発生しないため，GNSSやシリアルカメラなどの連続したデータの受信に向いています
+    // 保存したデータは set_irq と同様に available, read_some で読み取ります
+    // [idle_callback] : 受信が途切れたときに呼び出す関数 (省略時:呼び出さない)
+    // [idle_check_us] : 受信が途切れたかを確認する間隔 (μs)  この間に1バイトも受信しなければ途切れたとみなす (省略時:1000μs)
+    //                   確認するタイマーは受信し始めたときの割り込みで開始し，途切れたら止めるので，受信していない間はCPUを起こさない
+    // 同じオブジェクトに対し二回以上このメソッドを使った場合や，set_irqと併用した場合の動作は未定義です
+    void UART::set_dma(IdleCallback idle_callback, uint32_t idle_check_us) const
+    {
+        uart_inst_t* uart = (_uart_id ? uart1 : uart0);
+        UartRxBuffer& buffer = UartRx[_uart_id];
+        buffer.head = buffer.tail = buffer.last_head = buffer.dma_base = 0;
+        buffer.receiving = false;
+        buffer.idle_callback = idle_callback;
+        buffer.idle_check_us = idle_check_us;
+        buffer.enabled = true;
+
+        uart_set_hw_flow(uart, false, false);  // フロー制御(受信準備が終わるまで送信しないで待つ機能)を無効にします
+        uart_set_format(uart, 8, 1, UART_PARITY_NONE);  // UART通信の設定をします
+        uart_set_fifo_enabled(uart, true);  // FIFO(受信したデータを一時的に保管する機能)を有効にします
+
+        // 受信したデータを受信バッファに書き込み続けるDMA  書き込み先は受信バッファの終わりで先頭に戻る
+        buffer.dma_channel = dma_claim_unused_channel(true);
+        dma_channel_config config = dma_channel_get_default_config(buffer.dma_channel);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+        channel_config_set_read_increment(&config, false);
+        channel_config_set_write_increment(&config, true);
+        channel_config_set_ring(&config, true, __builtin_ctz(RxBufferSize));  // 書き込み先のアドレスの下位ビットだけを進める
+        channel_config_set_dreq(&config, uart_get_dreq(uart, false));
+        dma_channel_configure(buffer.dma_channel, &config, buffer.data, &uart_get_hw(uart)->dr, UartDmaTransferCount, true);  // 受信時のDMA(RXDMAE)を有効にするまでは転送しない
+
+        // 受信している間はDMAがFIFOを空にするため受信が途切れたときの割り込み(RXタイムアウト)は発生しない  代わりにタイマーで受信位置の変化を確認する
+        // 受信していない間はDMAを止め，最初に届いたデータの割り込みでDMAとタイマーを開始する
+        uart_dma_wait_burst(uart);
+        uart_hw_t* hw = uart_get_hw(uart);
+        hw->ifls = (hw->ifls & ~UART_UARTIFLS_RXIFLSEL_BITS) | (0b000 << UART_UARTIFLS_RXIFLSEL_LSB);  // FIFO(32バイト)が1/8たまったら割り込み
+        irq_set_exclusive_handler((_uart_id ? UART1_IRQ : UART0_IRQ), (_uart_id ? uart1_handler : uart0_handler));  // 割り込み処理で実行する関数をセット
+        irq_set_enabled((_uart_id ? UART1_IRQ : UART0_IRQ), true);  // 割り込み処理を有効にする
+    }
+
+    // 受信バッファに保存されている，読み取り可能なデータのバイト数  (set_irqかset_dmaを呼び出した後に使用)
+    std::size_t UART::available() const
+    {
+        const UartRxBuffer& buffer = UartRx[_uart_id];
+        std::size_t available_bytes = uart_rx_head(buffer) - buffer.tail;
+        return (available_bytes > RxBufferSize ? RxBufferSize : available_bytes);  // DMAで受信している場合は，上書きされた分を除く
+    }
+
+    // 受信バッファに保存されているデータを読み取る  待機せず，保存されている分だけ読み取る  (set_irqかset_dmaを呼び出した後に使用)
+    // [input_data_bytes] : 最大で何バイト(文字)読み込むか (省略時:input_dataの長さだけ読み取る)
+    // input_data : 受信したデータを保存するための配列
+    // 戻り値 : 読み取ったバイト数
+    std::size_t UART::read_some(std::size_t input_data_bytes, uint8_t* input_data) const
+    {
+        UartRxBuffer& buffer = UartRx[_uart_id];
+        std::size_t head = uart_rx_head(buffer);
+        std::size_t tail = buffer.tail;
+        if (head - tail > RxBufferSize)  // DMAで受信している場合に，読み取る前に上書きされた
         {
-            Uart1MaxLen = max_data_bytes;
-            uart_set_hw_flow(uart1, false, false);  // フロー制御(受信準備が終わるまで送信しないで待つ機能)を無効にします
-            uart_set_format(uart1, 8, 1, UART_PARITY_NONE);  // UART通信の設定をします
-            uart_set_fifo_enabled(uart1, false);  // FIFO(受信したデータを一時的に保管する機能)をオフにし，1文字ずつ受信する
-            irq_set_exclusive_handler(UART1_IRQ, uart1_handler);  // 割り込み処理で実行する関数をセット
-            irq_set_enabled(UART1_IRQ, true);  // 割り込み処理を有効にする
-        } else {
-            Uart0MaxLen = max_data_bytes;
-            uart_set_hw_flow(uart0, false, false);  // フロー制御(受信準備が終わるまで送信しないで待つ機能)を無効にします
-            uart_set_format(uart0, 8, 1, UART_PARITY_NONE);  // UART通信の設定をします
-            uart_set_fifo_enabled(uart0, false);  // FIFO(受信したデータを一時的に保管する機能)をオフにし，1文字ずつ受信する
-            irq_set_exclusive_handler(UART0_IRQ, uart0_handler);  // 割り込み処理で実行する関数をセット
-            irq_set_enabled(UART0_IRQ, true);  // 割り込み処理を有効にする
+            buffer.dropped = buffer.dropped + (head - tail - RxBufferSize);
+            tail = head - RxBufferSize;
         }
+        std::size_t read_bytes = head - tail;
+        __compiler_memory_barrier();  // 位置を読み取ってからデータを読み取る
+        if (read_bytes > input_data_bytes) read_bytes = input_data_bytes;
+        for (std::size_t i = 0; i < read_bytes; ++i) input_data[i] = buffer.data[(tail + i) & (RxBufferSize - 1)];
+        __compiler_memory_barrier();  // データを読み取ってから位置を進める
+        buffer.tail = tail + read_bytes;
+        return read_bytes;
+    }
+
+    // すぐに読み込めるデータをまとめて受信  待機しない
+    // set_irqかset_dmaを呼び出した後は受信バッファから，呼び出していない場合はFIFOから読み込む
+    // input_data_bytes : 最大で何バイト(文字)読み込むか
+    // input_data : 受信したデータを保存するための配列
+    // 引数No_Useは，互換性維持のためにUARTでも付けていますが，UARTでは使用しません．
+    // 戻り値 : 読み込んだバイト数
+    std::size_t UART::read_available(std::size_t input_data_bytes, uint8_t* input_data, uint8_t No_Use) const
+    {
+        if (UartRx[_uart_id].enabled)
+    return read_some(input_data_bytes, input_data);
+
+        uart_inst_t* uart = (_uart_id ? uart1 : uart0);
+        std::size_t read_bytes = 0;
+        while (read_bytes < input_data_bytes && uart_is_readable(uart)) input_data[read_bytes++] = uart_getc(uart);
+        return read_bytes;
+    }
+
+    // 受信バッファがいっぱいで捨てられたデータのバイト数
+    uint32_t UART::dropped_bytes() const
+    {
+        return UartRx[_uart_id].dropped;
+    }
+
+    // writeで送信データを送信バッファにコピーするだけですぐに戻り，割り込み処理で送信する
+    // FIFOに空きができたとき(半分以下になったとき)にだけ割り込みを発生させ，送信バッファからFIFOへまとめて移します
+    // [policy] : 送信バッファがいっぱいのときの動作 (省略時:BLOCK)  割り込み処理の中や割り込みを禁止した状態で呼び出したwriteは，BLOCKでも待たずに捨てる
+    // set_irq, set_dmaと併用できます
+    void UART::set_tx_irq(TxFullPolicy policy) const
+    {
+        uart_inst_t* uart = (_uart_id ? uart1 : uart0);
+        UartTxBuffer& buffer = UartTx[_uart_id];
+        buffer.head = buffer.tail = 0;
+        buffer.high_water = 0;
+        buffer.policy = policy;
+        buffer.enabled = true;
+
+        uart_set_fifo_enabled(uart, true);  // FIFO(送信するデータを一時的に保管する機能)を有効にし，まとめて送信する
+        irq_set_exclusive_handler((_uart_id ? UART1_IRQ : UART0_IRQ), (_uart_id ? uart1_handler : uart0_handler));  // 受信と同じ割り込み処理を使う
+        uart_hw_t* hw = uart_get_hw(uart);
+        hw->ifls = (hw->ifls & ~UART_UARTIFLS_TXIFLSEL_BITS) | (0b010 << UART_UARTIFLS_TXIFLSEL_LSB);  // FIFO(32バイト)が半分以下になったら割り込み
+        irq_set_enabled((_uart_id ? UART1_IRQ : UART0_IRQ), true);  // 割り込み処理を有効にする
+    }
+
+    // 送信バッファに残っている，まだFIFOに移していないデータのバイト数  (set_tx_irqを呼び出した後に使用)
+    std::size_t UART::tx_pending() const
+    {
+        return UartTx[_uart_id].head - UartTx[_uart_id].tail;
+    }
+
+    // 送信バッファにたまったデータのバイト数の最大値  送信バッファの大きさが足りているかの確認に使う
+    std::size_t UART::tx_high_water() const
+    {
+        return UartTx[_uart_id].high_water;
+    }
+
+    // 送信バッファがいっぱいで捨てられたデータのバイト数  (TxFullPolicy::DROPの場合と，BLOCKで待てなかった場合)
+    uint32_t UART::tx_dropped_bytes() const
+    {
+        return UartTx[_uart_id].dropped;
+    }
+
+    // 送信バッファとFIFOのデータをすべて送信し終えるまで待つ
+    void UART::flush() const
+    {
+        while (tx_pending()) tight_loop_contents();
+        uart_tx_wait_blocking(_uart_id ? uart1 : uart0);
     }
 
     /***** class PWM *****/
@@ -4,7 +4,7 @@
 #define _USE_MATH_DEFINES  // 円周率などの定数を使用する  math.hを読み込む前に定義する必要がある (math.hはcmathやiostreamに含まれる)
 #include <cfloat>
 #include <cmath>
-#include <deque>
+#include <cstring>
 #include <initializer_list>
 #include <iostream>
 #include <string>
@@ -14,6 +14,7 @@
 #include "hardware/i2c.h"
 #include "hardware/spi.h"
 #include "hardware/uart.h"
+#include "hardware/dma.h"
 #include "hardware/pwm.h"
 
 // Can Sat でよく使うセンサやモータードライバを簡単に使用するためのライブラリです．
@@ -374,10 +375,11 @@ namespace sc
     // 通信に関するクラスの親クラス
     class Communication : Noncopyable
     {
-    protected:
+    public:
         static const uint8_t DeviceNotSelected = 255;  // デバイス指定用の値を指定しなかった場合のデフォルト値
+        static const uint8_t BusI2C = 0x10;  // bus_id の通信の種類  I2C
+        static const uint8_t BusSPI = 0x20;  // bus_id の通信の種類  SPI
 
-    public:
         // 受信
         virtual void read(std::size_t input_data_bytes, uint8_t *input_data, uint8_t select_device = DeviceNotSelected) const = 0;
 
@@ -390,6 +392,7 @@ namespace sc
         // input_data : 受信したデータを保存するための配列
         // select_device : I2Cではスレーブアドレス，SPIではCSピンのGPIO番号，UARTでは省略
         // SPIの場合はメモリーアドレスの8ビット目を自動で0に置き換えます
+        // I2Cでは，デバイスが応答しないなど指定したバイト数を読み込めなかった場合に例外(Error)を投げます  (read, writeは結果を確認しません)
         virtual void read_mem(uint8_t memory_addr, std::size_t input_data_bytes, uint8_t* input_data, uint8_t select_device = DeviceNotSelected) const
         {
             this->write(1, &memory_addr, select_device);
@@ -422,6 +425,91 @@ namespace sc
         // select_device : I2Cではスレーブアドレス，SPIではCSピンのGPIO番号，UARTでは省略
         void read_line(std::size_t input_data_bytes, uint8_t* input_data, uint8_t select_device = DeviceNotSelected) const;
         template<typename T, std::size_t Size> void read_line(T (&input_data)[Size], uint8_t select_device = DeviceNotSelected) const {read_line(Size, (uint8_t*)input_data, select_device);}
+
+        // すぐに読み込めるデータをまとめて受信  (LineReaderが使用)
+        // input_data_bytes : 最大で何バイト(文字)読み込むか
+        // input_data : 受信したデータを保存するための配列
+        // select_device : I2Cではスレーブアドレス，SPIではCSピンのGPIO番号，UARTでは省略
+        // 戻り値 : 読み込んだバイト数
+        // I2C, SPIでは1回の通信でinput_data_bytesバイトを読み込み，UARTでは受信済みのデータだけを待機せずに読み込みます
+        virtual std::size_t read_available(std::size_t input_data_bytes, uint8_t* input_data, uint8_t select_device = DeviceNotSelected) const
+        {
+            this->read(input_data_bytes, input_data, select_device);
+            return input_data_bytes;
+        }
+
+        // デバイスが接続されているか
+        // select_device : I2Cではスレーブアドレス，SPIではCSピンのGPIO番号，UARTでは省略
+        // 接続を確認する手段がない場合は常にtrue
+        virtual bool is_present(uint8_t = DeviceNotSelected) const {return true;}
+
+        // デバイスのID (チップIDなど) を読み込む
+        // id_memory_addr : IDが保存されているメモリアドレス
+        // select_device : I2Cではスレーブアドレス，SPIではCSピンのGPIO番号，UARTでは省略
+        virtual uint8_t device_id(uint8_t id_memory_addr, uint8_t select_device = DeviceNotSelected) const
+        {
+            uint8_t id;
+            this->read_mem(id_memory_addr, 1, &id, select_device);
+            return id;
+        }
+
+        // 通信の種類とバスの番号  select_device が同じ別のデバイス(I2C0とI2C1の同じアドレスなど)を区別するために使う
+        // 戻り値 : I2CではBusI2C|I2Cの番号，SPIではBusSPI|SPIの番号，区別しない場合は0
+        virtual uint8_t bus_id() const {return 0;}
+    };
+
+    // 受信したデータを行ごとに取り出します
+    // まとめて受信したデータを自身のバッファに保存し，区切り文字を4バイトずつ探すため，1文字ずつ受信するread_lineより高速です
+    // 取り出した行はコピーせず，バッファの中の位置を返します
+    class LineReader : Noncopyable
+    {
+    public:
+        // 取り出した行  次にread_lineを呼び出すまで有効
+        struct Line
+        {
+            const uint8_t* data = nullptr;  // 行の先頭  区切り文字は含まない
+            std::size_t size = 0;  // 行のバイト数
+            bool truncated = false;  // バッファに収まらず，途中までしか取り出せなかったか
+        };
+
+        // 行の読み込みのセットアップ
+        // communication : 通信に使うオブジェクト (一時オブジェクト不可)
+        // buffer_bytes : バッファのバイト数  区切り文字も収まる必要があるので，1行の最大の長さはこれより1バイト短い (省略した場合はbufferの長さ)
+        // buffer : 受信したデータを保存するための配列  !LineReaderを使用している間は使用できる状態にしておいてください!
+        // [select_device] : I2Cではスレーブアドレス，SPIではCSピンのGPIO番号，UARTでは省略
+        // [delimiter] : 行の区切り文字 (省略時:'\n')  '\n'の場合は直前の'\r'も取り除く
+        LineReader(const Communication& communication, std::size_t buffer_bytes, uint8_t* buffer, uint8_t select_device = Communication::DeviceNotSelected, uint8_t delimiter = '\n');
+        template<typename T, std::size_t Size> LineReader(const Communication& communication, T (&buffer)[Size], uint8_t select_device = Communication::DeviceNotSelected, uint8_t delimiter = '\n'):
+            LineReader(communication, Size, (uint8_t*)buffer, select_device, delimiter) {}
+
+        // 1行取り出す  バッファに1行揃っていない場合は，すぐに読み込めるデータを1回だけまとめて受信する
+        // line : 取り出した行
+        // 戻り値 : 行を取り出せたか  行が揃っていない場合はfalse
+        // バッファより長い行は，バッファに収まる分をtruncatedとして返し，残りは次の区切り文字まで捨てる
+        bool read_line(Line& line);
+
+        // 取り出した行の数 (途中までしか取り出せなかった行も含む)
+        uint32_t lines() const {return _lines;}
+
+        // バッファに収まらなかった行の数
+        uint32_t overflows() const {return _overflows;}
+
+    private:
+        const Communication& _communication;
+        uint8_t* _buffer;
+        std::size_t _buffer_bytes;
+        uint8_t _select_device;
+        uint8_t _delimiter;
+        std::size_t _begin = 0;  // まだ取り出していないデータの先頭
+        std::size_t _scanned = 0;  // 区切り文字がないことを確認済みの位置
+        std::size_t _end = 0;  // 受信したデータの終わり
+        bool _discarding = false;  // バッファに収まらなかった行の残りを捨てている
+        uint32_t _lines = 0;
+        uint32_t _overflows = 0;
+
+        // バッファの中から1行取り出す
+        // 戻り値 : 行を取り出せたか
+        bool find_line(Line& line);
     };
 
     // I2C通信を行います
@@ -449,13 +537,115 @@ namespace sc
         void write(std::size_t output_data_bytes, uint8_t *output_data, uint8_t slave_addr) const;
         template<typename T, std::size_t Size> void write(T (&output_data)[Size], uint8_t slave_addr) const {write(Size, (uint8_t*)output_data, slave_addr);}
 
+        // メモリから読み込み
+        // memory_addr : 相手のデバイスの何番地のメモリーからデータを読み込むか
+        // input_data_bytes : 何バイト(文字)データを読み込むか (省略した場合は，input_dataの長さだけ読み込む)
+        // input_data : 受信したデータを保存するための配列
+        // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+        // メモリアドレスの送信とデータの受信の間に停止信号を送らず，再開始信号(リピーテッドスタート)で1回の通信として行います
+        // デバイスが応答しないなど，指定したバイト数を読み込めなかった場合は例外(Error)を投げます
+        void read_mem(uint8_t memory_addr, std::size_t input_data_bytes, uint8_t* input_data, uint8_t slave_addr) const;
+        using Communication::read_mem;
+
+        // 1つのデバイスのメモリの離れた複数の範囲を読み込む際の，それぞれの範囲
+        struct MemRange
+        {
+            uint8_t memory_addr;  // 相手のデバイスの何番地のメモリーからデータを読み込むか
+            std::size_t input_data_bytes;  // 何バイト(文字)データを読み込むか
+            uint8_t* input_data;  // 受信したデータを保存するための配列
+        };
+
+        // 1つのデバイスのメモリの離れた複数の範囲をまとめて読み込む
+        // ranges : 読み込む範囲  {{メモリアドレス, バイト数, 配列}, {...}, ...}のように書く
+        // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+        // 最後の範囲を読み込むまで停止信号を送らないため，途中で他の通信に割り込まれません
+        // どれかの範囲を読み込めなかった場合は例外(Error)を投げます
+        void read_mem_burst(std::initializer_list<MemRange> ranges, uint8_t slave_addr) const;
+
+        // 同じデバイスとの通信の間に最低限空ける時間を設定
+        // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+        // min_interval_us : 前回の通信が完了してから次の通信を始めるまでに空ける時間 (μs)  0のときは待たない (初期値:0)
+        // 異なるデバイスとの通信は待たずにすぐに行います
+        void set_min_interval(uint8_t slave_addr, uint32_t min_interval_us);
+
+        // デバイスごとに通信速度の最大値を設定
+        // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+        // max_freq : そのデバイスと通信するときの通信速度 (Hz)  100kHz, 400kHz, 1MHz など  0のときはセットアップ時の通信速度を使う
+        // 通信速度は，前回と異なる速度のデバイスと通信するときだけ切り替えます
+        void set_max_freq(uint8_t slave_addr, uint32_t max_freq);
+
+        // デバイスと通信するときの通信速度 (Hz)
+        // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+        uint32_t freq(uint8_t slave_addr) const {return _max_freq[slave_addr & 0x7f] ? _max_freq[slave_addr & 0x7f] : _default_freq;}
+
+        // 通信するデバイスに合わせて通信速度を切り替える  (速度が変わらない場合は何もしない)
+        // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+        // read, writeなどの中で自動で呼び出されるので，通常は呼び出す必要はありません
+        void select_freq(uint8_t slave_addr) const;
+
+        // これまでに通信速度を切り替えた回数
+        uint32_t freq_changes() const {return _freq_changes;}
+
+        // これまでに通信速度の切り替えにかかった時間の合計 (μs)
+        uint32_t freq_change_time_us() const {return _freq_change_time_us;}
+
+        // I2C0かI2C1か
+        bool i2c_id() const {return _i2c_id;}
+
+        // 通信の種類とバスの番号 (BusI2C|I2Cの番号)
+        uint8_t bus_id() const {return BusI2C | _i2c_id;}
+
+        // すべてのスレーブアドレスに短い通信を送り，接続されているデバイスを調べて記録する
+        // 起動時に，各センサをセットアップする前に一回だけ呼び出してください
+        // [timeout_us] : 1つのアドレスあたりの制限時間 (μs) (省略時:1000)
+        // 戻り値 : 見つかったデバイスの数
+        std::size_t scan(uint32_t timeout_us = 1000);
+
+        // デバイスが接続されているか
+        // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+        // scanで記録した結果を返すので通信は行わない  scanを呼び出していない場合は常にtrue
+        bool is_present(uint8_t slave_addr) const;
+
+        // デバイスのID (チップIDなど) を読み込む
+        // id_memory_addr : IDが保存されているメモリアドレス
+        // slave_addr : 通信先のデバイスのスレーブアドレス  7bit
+        // 一度読み込んだIDは記録しておき，次からは通信せずに返す
+        uint8_t device_id(uint8_t id_memory_addr, uint8_t slave_addr) const;
+
     private:
         static bool AlreadyUseI2C0;
         static bool AlreadyUseI2C1;
         bool _i2c_id;
+
+        bool _scanned = false;  // scanを呼び出したか
+        uint32_t _present[4] = {};  // スレーブアドレスごとに，デバイスが接続されているかを1ビットで記録
+
+        // 読み込んだデバイスのID
+        struct DeviceId
+        {
+            uint8_t slave_addr;
+            uint8_t id_memory_addr;
+            uint8_t id;
+        };
+        static const std::size_t MaxDeviceIds = 8;  // 記録するIDの最大数
+        mutable DeviceId _device_ids[MaxDeviceIds] = {};
+        mutable std::size_t _device_ids_num = 0;
+
+        uint32_t _min_interval_us[128] = {};  // スレーブアドレスごとの，通信と通信の間に空ける時間 (μs)
+        mutable uint32_t _last_complete_us[128] = {};  // スレーブアドレスごとの，前回の通信が完了した時刻 (μs)
+
+        uint32_t _default_freq;  // セットアップ時の通信速度 (Hz)
+        uint32_t _max_freq[128] = {};  // スレーブアドレスごとの通信速度 (Hz)  0のときは_default_freq
+        mutable uint32_t _current_freq;  // 現在の通信速度 (Hz)
+        mutable uint32_t _freq_changes = 0;  // 通信速度を切り替えた回数
+        mutable uint32_t _freq_change_time_us = 0;  // 通信速度の切り替えにかかった時間の合計 (μs)
+
+        // 前回の通信から設定した時間が経つまで待つ
+        void wait_interval(uint8_t slave_addr) const;
+
+        // 通信が完了した時刻を記録
+        void mark_complete(uint8_t slave_addr) const;
     };
-    bool I2C::AlreadyUseI2C0 = false;
-    bool I2C::AlreadyUseI2C1 = false;
 
     // SPI通信を行います
     class SPI : public Communication
@@ -495,35 +685,89 @@ namespace sc
         // memory_addr : 相手のデバイスの何番地のメモリーからデータを読み込むか
         // input_data_bytes : 何バイト(文字)データを読み込むか (省略した場合は，input_dataの長さだけ読み込む)
         // input_data : 受信したデータを保存するための配列
-        // select_device : I2Cではスレーブアドレス，SPIではCSピンのGPIO番号，UARTでは省略
-        // SPIの場合はメモリーアドレスの8ビット目を自動で0に置き換えます
-        void read_mem(uint8_t memory_addr, std::size_t input_data_bytes, uint8_t* input_data, uint8_t select_device = DeviceNotSelected) const
-        {
-            memory_addr |= 0b10000000;
-            this->write(1, &memory_addr, select_device);
-            this->read(input_data_bytes, input_data, select_device);
-        }
+        // cs_gpio : 通信先のデバイスに繋がるCSピンのGPIO番号
+        // メモリーアドレスの8ビット目を自動で1に置き換えます
+        // メモリアドレスの送信とデータの受信の間はCSピンを選択したままにし，1回の通信として行います
+        void read_mem(uint8_t memory_addr, std::size_t input_data_bytes, uint8_t* input_data, uint8_t cs_gpio) const;
+        using Communication::read_mem;
 
         // メモリに書き込み
         // memory_addr : 相手のデバイスの何番地のメモリーにデータを書き込むか
         // output_data_bytes : 何バイト(文字)データを書き込むか (省略した場合は，output_dataの長さだけ書き込む)
         // output_data : 送信するデータの配列
-        // select_device : I2Cではスレーブアドレス，SPIではCSピンのGPIO番号，UARTでは省略
-        // SPIの場合はメモリーアドレスの8ビット目を自動で1に置き換えます
-        void write_mem(uint8_t memory_addr, std::size_t output_data_bytes, uint8_t* output_data, uint8_t select_device = DeviceNotSelected) const
+        // cs_gpio : 通信先のデバイスに繋がるCSピンのGPIO番号
+        // メモリーアドレスの8ビット目を自動で0に置き換えます
+        // メモリアドレスとデータの送信の間はCSピンを選択したままにし，1回の通信として行います
+        void write_mem(uint8_t memory_addr, std::size_t output_data_bytes, uint8_t* output_data, uint8_t cs_gpio) const;
+        using Communication::write_mem;
+
+        // 1つのデバイスのメモリの離れた複数の範囲を読み込む際の，それぞれの範囲
+        struct MemRange
         {
-            memory_addr &= 0b01111111;
-            this->write(1, &memory_addr, select_device);
-            this->write(output_data_bytes, output_data, select_device);
-        }
+            uint8_t memory_addr;  // 相手のデバイスの何番地のメモリーからデータを読み込むか
+            std::size_t input_data_bytes;  // 何バイト(文字)データを読み込むか
+            uint8_t* input_data;  // 受信したデータを保存するための配列
+        };
+
+        // 1つのデバイスのメモリの離れた複数の範囲をまとめて読み込む
+        // ranges : 読み込む範囲  {{メモリアドレス, バイト数, 配列}, {...}, ...}のように書く
+        // cs_gpio : 通信先のデバイスに繋がるCSピンのGPIO番号
+        // 範囲ごとにCSピンを選択し直し，間を空けずに続けて読み込みます
+        void read_mem_burst(std::initializer_list<MemRange> ranges, uint8_t cs_gpio) const;
+
+        // SPIのモード  クロックの極性(CPOL)と位相(CPHA)の組み合わせ
+        enum Mode : uint8_t
+        {
+            MODE_0 = 0,  // CPOL=0, CPHA=0
+            MODE_1 = 1,  // CPOL=0, CPHA=1
+            MODE_2 = 2,  // CPOL=1, CPHA=0
+            MODE_3 = 3   // CPOL=1, CPHA=1
+        };
+
+        // CSピンごとに通信の設定をする
+        // cs_gpio : 通信先のデバイスに繋がるCSピンのGPIO番号
+        // mode : SPIのモード
+        // [freq] : そのデバイスと通信するときの転送速度 (省略時:セットアップ時の転送速度)
+        // [msb_first] : 上位ビットから送るか (省略時:true)  RP2040のSPIは上位ビットからの送信のみ対応しています
+        // 設定は，前回と異なる設定のデバイスと通信するときだけ変更します
+        void set_profile(uint8_t cs_gpio, Mode mode, uint32_t freq = 0, bool msb_first = true);
+
+        // 通信するデバイスに合わせて設定を切り替える  (設定が変わらない場合は何もしない)
+        // cs_gpio : 通信先のデバイスに繋がるCSピンのGPIO番号
+        // read, writeなどの中で自動で呼び出されるので，通常は呼び出す必要はありません
+        void select_profile(uint8_t cs_gpio) const;
+
+        // これまでに設定を切り替えた回数
+        uint32_t reconfigurations() const {return _reconfigurations;}
+
+        // 設定が同じだったため，切り替えずに済んだ回数
+        uint32_t reconfigurations_avoided() const {return _reconfigurations_avoided;}
+
+        // SPI0かSPI1か
+        bool spi_id() const {return _spi_id;}
+
+        // 通信の種類とバスの番号 (BusSPI|SPIの番号)
+        uint8_t bus_id() const {return BusSPI | _spi_id;}
 
     private:
         static bool AlreadyUseSPI0;
         static bool AlreadyUseSPI1;
         bool _spi_id;
+
+        // CSピンごとの通信の設定
+        struct Profile
+        {
+            Mode mode;
+            uint32_t freq;  // 転送速度 (Hz)  0のときはセットアップ時の転送速度
+            bool operator==(const Profile& other) const {return mode == other.mode && freq == other.freq;}
+        };
+        static const std::size_t GpioNum = 30;  // GPIOの数
+        Profile _profiles[GpioNum] = {};  // CSピンのGPIO番号ごとの設定
+        uint32_t _default_freq;  // セットアップ時の転送速度 (Hz)
+        mutable Profile _current;  // 現在の設定  転送速度は0ではなく実際の値
+        mutable uint32_t _reconfigurations = 0;  // 設定を切り替えた回数
+        mutable uint32_t _reconfigurations_avoided = 0;  // 切り替えずに済んだ回数
     };
-    bool SPI::AlreadyUseSPI0 = false;
-    bool SPI::AlreadyUseSPI1 = false;
 
     // UART通信を行います
     class UART : public Communication
@@ -550,19 +794,82 @@ namespace sc
         void write(std::size_t output_data_bytes, uint8_t *output_data, uint8_t No_Use = DeviceNotSelected) const;
         template<typename T, std::size_t Size> void write(T (&output_data)[Size], uint8_t No_Use = DeviceNotSelected) const {write(Size, (uint8_t*)output_data, No_Use);}
 
-        // 割り込み処理で受信時に自動でデータを読み込み，dequeに保存
-        // max_data_bytes : dequeの大きさが最大で何バイトになるまで，読み取った値をdequeの末尾に追加するかを指定します．dequeの大きさがこの値を超えた場合，先頭のデータから削除されます
-        // InputData : !クローバル! 読み取った値を追加するdequeを指定します．このdequeは，グローバル変数である必要があります
+        // 割り込み処理で受信時に自動でデータを読み込み，受信バッファに保存
+        // FIFOを有効にし，FIFOが半分たまったときと，受信が途切れたとき(32bit分の時間)にだけ割り込みを発生させます
+        // 保存したデータは available, read_some で読み取ります
+        // 受信バッファ(RxBufferSizeバイト)がいっぱいの場合は，新しく受信したデータを捨てて dropped_bytes で数えます  (読み取っていない古いデータは残る)
         // 同じオブジェクトに対し二回以上このメソッドを使った場合の動作は未定義です
-        void set_irq(std::size_t max_data_bytes, std::deque<uint8_t>& InputData) const;
+        void set_irq() const;
+
+        // 受信バッファに保存されている，読み取り可能なデータのバイト数  (set_irqかset_dmaを呼び出した後に使用)
+        std::size_t available() const;
+
+        // 受信バッファに保存されているデータを読み取る  待機せず，保存されている分だけ読み取る  (set_irqかset_dmaを呼び出した後に使用)
+        // input_data_bytes : 最大で何バイト(文字)読み込むか (省略した場合はinput_dataの長さだけ読み取る)
+        // input_data : 受信したデータを保存するための配列
+        // 戻り値 : 読み取ったバイト数
+        std::size_t read_some(std::size_t input_data_bytes, uint8_t* input_data) const;
+        template<typename T, std::size_t Size> std::size_t read_some(T (&input_data)[Size]) const {return read_some(Size, (uint8_t*)input_data);}
+
+        // すぐに読み込めるデータをまとめて受信  待機しない
+        // set_irqかset_dmaを呼び出した後は受信バッファから，呼び出していない場合はFIFOから読み込む
+        // input_data_bytes : 最大で何バイト(文字)読み込むか
+        // input_data : 受信したデータを保存するための配列
+        // 引数No_Useは，互換性維持のためにUARTでも付けていますが，UARTでは使用しません．
+        // 戻り値 : 読み込んだバイト数
+        std::size_t read_available(std::size_t input_data_bytes, uint8_t* input_data, uint8_t No_Use = DeviceNotSelected) const;
+
+        // 受信が途切れたときに呼び出される関数
+        // received_bytes : これまでに受信したデータのバイト数の合計 (受信バッファのこの位置までデータが届いている)
+        // !割り込み処理の中で呼び出されます!  時間のかかる処理は行わないでください
+        typedef void (*IdleCallback)(std::size_t received_bytes);
+
+        // DMAで受信バッファに書き込み続ける  (set_irqの代わりに使う)
+        // 1バイトごとの割り込みが発生しないため，GNSSやシリアルカメラなどの連続したデータの受信に向いています
+        // 保存したデータは set_irq と同様に available, read_some で読み取ります
+        // [idle_callback] : 受信が途切れたときに呼び出す関数 (省略時:呼び出さない)
+        // [idle_check_us] : 受信が途切れたかを確認する間隔 (μs)  この間に1バイトも受信しなければ途切れたとみなす (省略時:1000μs)
+        //                   確認するタイマーは受信し始めたときの割り込みで開始し，途切れたら止めるので，受信していない間はCPUを起こさない
+        // 同じオブジェクトに対し二回以上このメソッドを使った場合や，set_irqと併用した場合の動作は未定義です
+        void set_dma(IdleCallback idle_callback = nullptr, uint32_t idle_check_us = 1000) const;
+
+        // 受信バッファがいっぱいで捨てられたデータのバイト数
+        // DMAで受信している場合は，読み取る前に上書きされたデータのバイト数
+        uint32_t dropped_bytes() const;
+
+        // 送信バッファがいっぱいのときの動作
+        enum class TxFullPolicy : uint8_t
+        {
+            BLOCK,  // 空くまで待つ
+            DROP  // 書き込むデータをまとめて捨てる (一部だけ送信して文が壊れることはない)
+        };
+
+        // writeで送信データを送信バッファにコピーするだけですぐに戻り，割り込み処理で送信する
+        // FIFOに空きができたとき(半分以下になったとき)にだけ割り込みを発生させ，送信バッファからFIFOへまとめて移します
+        // [policy] : 送信バッファがいっぱいのときの動作 (省略時:BLOCK)  割り込み処理の中や割り込みを禁止した状態で呼び出したwriteは，BLOCKでも待たずに捨てる
+        // set_irq, set_dmaと併用できます
+        void set_tx_irq(TxFullPolicy policy = TxFullPolicy::BLOCK) const;
+
+        // 送信バッファに残っている，まだFIFOに移していないデータのバイト数  (set_tx_irqを呼び出した後に使用)
+        std::size_t tx_pending() const;
+
+        // 送信バッファにたまったデータのバイト数の最大値  送信バッファの大きさが足りているかの確認に使う
+        std::size_t tx_high_water() const;
+
+        // 送信バッファがいっぱいで捨てられたデータのバイト数  (TxFullPolicy::DROPの場合と，BLOCKで待てなかった場合)
+        uint32_t tx_dropped_bytes() const;
+
+        // 送信バッファとFIFOのデータをすべて送信し終えるまで待つ
+        void flush() const;
+
+        static const std::size_t RxBufferSize = 1024;  // 受信バッファの大きさ (2の累乗)  DMAで受信する場合はこの大きさの境界に配置される
+        static const std::size_t TxBufferSize = 1024;  // 送信バッファの大きさ (2の累乗)
 
     private:
         static bool AlreadyUseUART0;
         static bool AlreadyUseUART1;
         bool _uart_id;
     };
-    bool UART::AlreadyUseUART0 = false;
-    bool UART::AlreadyUseUART1 = false;
 
     // PWM(パルス幅変調)を行います
     class PWM : Noncopyable
@@ -0,0 +1,185 @@
+#include "spi_async.hpp"
+
+namespace sc
+{
+    SPIAsync* SPIAsync::Instance[2] = {nullptr, nullptr};
+
+    // SPIの非同期通信のセットアップ  SPI0とSPI1でそれぞれ一回だけ呼び出す
+    // spi : セットアップ済みのSPI型のオブジェクト (一時オブジェクト不可)
+    SPIAsync::SPIAsync(const SPI& spi):
+        _spi_master(spi),
+        _spi(spi.spi_id() ? spi1 : spi0)
+    {
+        if (Instance[spi.spi_id()]) throw Error(__FILE__, __LINE__, "SPIAsync cannot be initialized twice for the same SPI");  // 同じSPIに対してSPIAsyncを二回初期化することはできません
+        Instance[spi.spi_id()] = this;
+
+        _tx_dma = dma_claim_unused_channel(true);  // 空いているDMAのチャンネルを確保
+        _rx_dma = dma_claim_unused_channel(true);
+
+        // 受信が終わったときに割り込みを発生させる (送信は受信より先に終わる)
+        dma_channel_set_irq0_enabled(_rx_dma, true);
+        if (!Instance[!spi.spi_id()])  // DMAの割り込みは二つのSPIで共有するので，最初の一回だけ登録する
+        {
+            irq_add_shared_handler(DMA_IRQ_0, dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+            irq_set_enabled(DMA_IRQ_0, true);
+        }
+    }
+
+    SPIAsync::~SPIAsync()
+    {
+        bool spi_id = (_spi == spi1);
+        dma_channel_set_irq0_enabled(_rx_dma, false);
+        if (!Instance[!spi_id]) irq_remove_handler(DMA_IRQ_0, dma_irq_handler);
+
+        dma_channel_abort(_tx_dma);
+        dma_channel_abort(_rx_dma);
+        dma_channel_unclaim(_tx_dma);
+        dma_channel_unclaim(_rx_dma);
+
+        Instance[spi_id] = nullptr;
+    }
+
+    // 送受信を予約  すべての区間をCSピンを選択したまま続けて通信する
+    // segments : 通信する区間  {{送信データ, 受信データ, バイト数}, ...} のように書く  !通信が完了するまで配列を使用できる状態にしておいてください!
+    // cs_gpio : 通信先のデバイスに繋がるCSピンのGPIO番号
+    // [callback] : 通信が完了したときに呼び出す関数 (省略時:呼び出さない)
+    // [context] : callbackに渡すポインタ (省略時:nullptr)
+    // 戻り値 : 予約した通信を識別する番号
+    SPIAsync::Handle SPIAsync::transfer(std::initializer_list<Segment> segments, uint8_t cs_gpio, Callback callback, void* context)
+    {
+        if (!segments.size()) throw Error(__FILE__, __LINE__, "At least one segment is required");  // 1つ以上の区間が必要です
+        if (segments.size() > MaxSegments) throw Error(__FILE__, __LINE__, "Too many segments for one asynchronous SPI transfer");  // 1回の非同期SPI通信の区間が多すぎます
+        for (const Segment& segment : segments)
+            if (!segment.data_bytes) throw Error(__FILE__, __LINE__, "Each segment must transfer at least one byte");  // 各区間で1バイト以上通信する必要があります
+
+        uint32_t status = save_and_disable_interrupts();  // 割り込み処理と同時に予約を書き換えないように，割り込みを禁止する
+        if (is_full())
+        {
+            restore_interrupts(status);
+            throw Error(__FILE__, __LINE__, "The asynchronous SPI queue is full");  // 非同期SPI通信の予約がいっぱいです
+        }
+
+        Handle handle = _submitted;
+        Request& request = _queue[handle % QueueSize];
+        request.handle = handle;
+        request.cs_gpio = cs_gpio;
+        request.segments_num = 0;
+        for (const Segment& segment : segments) request.segments[request.segments_num++] = segment;
+        request.callback = callback;
+        request.context = context;
+        request.success = false;
+        _submitted = handle + 1;
+
+        if (!_running) start_next();
+        restore_interrupts(status);
+        return handle;
+    }
+
+    // 予約した通信が完了したか
+    // handle : 予約時に返された番号
+    bool SPIAsync::is_done(Handle handle) const
+    {
+        return static_cast<int32_t>(_completed - handle) > 0;  // 符号なしの引き算なので，番号がオーバーフローしても正しく比較できる
+    }
+
+    // 予約した通信が成功したか
+    // handle : 予約時に返された番号
+    // 完了していない場合や，その後にQueueSize個以上の通信を予約して結果が上書きされた場合はfalse
+    bool SPIAsync::is_succeeded(Handle handle) const
+    {
+        const Request& request = _queue[handle % QueueSize];
+        return is_done(handle) && request.handle == handle && request.success;
+    }
+
+    // 予約した通信が完了するまで待つ
+    // handle : 予約時に返された番号
+    // 戻り値 : 通信が成功したか
+    bool SPIAsync::wait(Handle handle) const
+    {
+        while (!is_done(handle)) tight_loop_contents();
+        return is_succeeded(handle);
+    }
+
+    // 完了していない通信の数
+    std::size_t SPIAsync::pending() const
+    {
+        return _submitted - _completed;
+    }
+
+    // 次の通信を開始  (割り込みを禁止した状態か，割り込み処理の中で呼び出す)
+    void SPIAsync::start_next()
+    {
+        if (_completed == _submitted)
+        {
+            _running = false;  // 予約された通信がもうない
+    return;
+        }
+        _running = true;
+        _segment = 0;
+
+        uint8_t cs_gpio = _queue[_completed % QueueSize].cs_gpio;
+        _spi_master.select_profile(cs_gpio);  // 通信するデバイスに合わせて設定を切り替える (設定が変わらない場合は何もしない)
+        gpio_put(cs_gpio, 0);  // CSピンを選択  すべての区間が終わるまで選択したままにする
+        start_segment();
+    }
+
+    // 通信中の区間の送受信を開始
+    void SPIAsync::start_segment()
+    {
+        const Segment& segment = _queue[_completed % QueueSize].segments[_segment];
+        volatile void* data_register = &spi_get_hw(_spi)->dr;
+
+        // 受信したデータを配列に移すDMA  (受信データを捨てるときは同じ場所に書き続ける)
+        dma_channel_config rx_config = dma_channel_get_default_config(_rx_dma);
+        channel_config_set_transfer_data_size(&rx_config, DMA_SIZE_8);
+        channel_config_set_read_increment(&rx_config, false);
+        channel_config_set_write_increment(&rx_config, segment.input_data != nullptr);
+        channel_config_set_dreq(&rx_config, spi_get_dreq(_spi, false));
+        dma_channel_configure(_rx_dma, &rx_config, (segment.input_data ? segment.input_data : &_dummy_rx), data_register, segment.data_bytes, false);
+
+        // データをSPIに送るDMA  (送信データがないときは0を送り続ける)
+        dma_channel_config tx_config = dma_channel_get_default_config(_tx_dma);
+        channel_config_set_transfer_data_size(&tx_config, DMA_SIZE_8);
+        channel_config_set_read_increment(&tx_config, segment.output_data != nullptr);
+        channel_config_set_write_increment(&tx_config, false);
+        channel_config_set_dreq(&tx_config, spi_get_dreq(_spi, true));
+        dma_channel_configure(_tx_dma, &tx_config, data_register, (segment.output_data ? segment.output_data : &_dummy_tx), segment.data_bytes, false);
+
+        dma_start_channel_mask((1u << _rx_dma) | (1u << _tx_dma));  // 送信と受信を同時に開始
+    }
+
+    // DMAの割り込み処理
+    // 受信が終わったら次の区間を開始し，すべての区間が終わったら通信を完了とする
+    void SPIAsync::on_dma_irq()
+    {
+        if (!dma_channel_get_irq0_status(_rx_dma))
+    return;  // ほかのDMAのチャンネルによる割り込み
+        dma_channel_acknowledge_irq0(_rx_dma);
+        if (!_running)
+    return;
+
+        Request& request = _queue[_completed % QueueSize];
+        if (++_segment < request.segments_num)
+        {
+            start_segment();  // CSピンを選択したまま次の区間へ
+    return;
+        }
+
+        gpio_put(request.cs_gpio, 1);  // CSピンの選択を解除  (受信が終わっているので，送信もすべて終わっている)
+        request.success = true;
+
+        // 次の通信を先に開始してから，コールバック関数を呼び出す
+        Callback callback = request.callback;
+        void* context = request.context;
+        _completed = _completed + 1;
+        start_next();
+
+        if (callback) callback(true, context);
+    }
+
+    void SPIAsync::dma_irq_handler()
+    {
+        for (SPIAsync* instance : Instance)
+            if (instance) instance->on_dma_irq();
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_SPI_ASYNC_HPP_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_SPI_ASYNC_HPP_
+
+#include "sc.hpp"
+
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+namespace sc
+{
+    // SPIの通信を，DMAと割り込み処理によって裏で行います
+    // 送信と受信を同時に行い(全二重)，複数の区間(Segment)をCSピンを選択したまま続けて通信できます
+    // 通信を予約するとすぐに戻るため，通信している間にほかの処理を行えます
+    // 通信の完了はコールバック関数か，予約時に返される番号(Handle)で確認できます
+    // 通信中に同じSPIで SPI::read などの待機する通信を行った場合の動作は未定義です
+    class SPIAsync : Noncopyable
+    {
+    public:
+        static const std::size_t QueueSize = 8;  // 同時に予約できる通信の数 (2の累乗)
+        static const std::size_t MaxSegments = 4;  // 1回の通信に含められる区間の最大数
+
+        // 予約した通信を識別する番号
+        typedef uint32_t Handle;
+
+        // 通信が完了したときに呼び出される関数
+        // success : 通信に成功したか
+        // context : 予約時に渡したポインタ
+        // !割り込み処理の中で呼び出されます!  時間のかかる処理は行わないでください
+        typedef void (*Callback)(bool success, void* context);
+
+        // 1回の通信の中の区間  output_dataを送信しながら，同じバイト数をinput_dataに受信する
+        struct Segment
+        {
+            const uint8_t* output_data;  // 送信するデータの配列  nullptrのときは0を送信する
+            uint8_t* input_data;  // 受信したデータを保存するための配列  nullptrのときは受信したデータを捨てる
+            std::size_t data_bytes;  // 何バイト(文字)送受信するか (1以上)
+        };
+
+        // SPIの非同期通信のセットアップ  SPI0とSPI1でそれぞれ一回だけ呼び出す
+        // spi : セットアップ済みのSPI型のオブジェクト (一時オブジェクト不可)
+        SPIAsync(const SPI& spi);
+
+        ~SPIAsync();
+
+        // 送受信を予約  すべての区間をCSピンを選択したまま続けて通信する
+        // segments : 通信する区間  {{送信データ, 受信データ, バイト数}, ...} のように書く  !通信が完了するまで配列を使用できる状態にしておいてください!
+        // cs_gpio : 通信先のデバイスに繋がるCSピンのGPIO番号
+        // [callback] : 通信が完了したときに呼び出す関数 (省略時:呼び出さない)
+        // [context] : callbackに渡すポインタ (省略時:nullptr)
+        // 戻り値 : 予約した通信を識別する番号
+        Handle transfer(std::initializer_list<Segment> segments, uint8_t cs_gpio, Callback callback = nullptr, void* context = nullptr);
+
+        // 予約した通信が完了したか
+        // handle : 予約時に返された番号
+        bool is_done(Handle handle) const;
+
+        // 予約した通信が成功したか
+        // handle : 予約時に返された番号
+        // 完了していない場合や，その後にQueueSize個以上の通信を予約して結果が上書きされた場合はfalse
+        bool is_succeeded(Handle handle) const;
+
+        // 予約した通信が完了するまで待つ
+        // handle : 予約時に返された番号
+        // 戻り値 : 通信が成功したか
+        bool wait(Handle handle) const;
+
+        // 完了していない通信の数
+        std::size_t pending() const;
+
+        // これ以上通信を予約できないか
+        bool is_full() const {return pending() >= QueueSize;}
+
+        // SPI0かSPI1か
+        bool spi_id() const {return _spi == spi1;}
+
+    private:
+        // 予約された通信
+        struct Request
+        {
+            Handle handle;
+            uint8_t cs_gpio;
+            uint8_t segments_num;
+            Segment segments[MaxSegments];
+            Callback callback;
+            void* context;
+            volatile bool success;
+        };
+
+        static SPIAsync* Instance[2];  // 割り込み処理から呼び出すためのオブジェクト
+
+        const SPI& _spi_master;  // CSピンごとの設定の切り替えに使う
+        spi_inst_t* _spi;
+        uint _tx_dma;  // SPIへデータを送るDMAのチャンネル
+        uint _rx_dma;  // SPIから受信したデータを受け取るDMAのチャンネル
+
+        Request _queue[QueueSize];  // 予約された通信 (リングバッファ)
+        volatile Handle _submitted = 0;  // これまでに予約された通信の数 (次に予約される通信の番号)
+        volatile Handle _completed = 0;  // これまでに完了した通信の数 (次に実行する通信の番号)
+        volatile bool _running = false;  // 通信中か
+        std::size_t _segment = 0;  // 通信中の区間の番号
+
+        uint8_t _dummy_tx = 0;  // 送信データがないときに送る値
+        uint8_t _dummy_rx;  // 受信データを捨てるときの書き込み先
+
+        // 次の通信を開始  (割り込みを禁止した状態か，割り込み処理の中で呼び出す)
+        void start_next();
+
+        // 通信中の区間の送受信を開始
+        void start_segment();
+
+        // DMAの割り込み処理
+        void on_dma_irq();
+        static void dma_irq_handler();
+    };
+    // このクラスの作成にあたり以下の資料を参考にしました
+    // https://datasheets.raspberrypi.com/rp2040/rp2040-datasheet.pdf  (4.4. SPI, 2.5. DMA)
+}
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_SPI_ASYNC_HPP_
@@ -0,0 +1,433 @@
+#include "telemetry.hpp"
+#include "crc.hpp"
+
+#include <cmath>
+
+namespace sc
+{
+    // 記録の種類ごとの値の数と，固定小数点にするときの倍率
+    struct TelemetryFormat
+    {
+        uint8_t values_num;  // 0のときは存在しない種類
+        double scale;
+    };
+
+    // 記録の種類に対応する形式を返す
+    static TelemetryFormat telemetry_format(TelemetryType type)
+    {
+        switch (type)
+        {
+            case TelemetryType::TEMPERATURE: return {1, 1e2};
+            case TelemetryType::PRESSURE: return {1, 1e2};
+            case TelemetryType::HUMIDITY: return {1, 1e2};
+            case TelemetryType::ALTITUDE: return {1, 1e3};
+            case TelemetryType::LATITUDE: return {1, 1e7};
+            case TelemetryType::LONGITUDE: return {1, 1e7};
+            case TelemetryType::A_POSITION: return {3, 1e3};
+            case TelemetryType::ACCELERATION: return {3, 1e3};
+            case TelemetryType::GYRO: return {3, 1e3};
+            case TelemetryType::MAGNETISM: return {3, 1e6};
+            case TelemetryType::A_DIRECTION: return {1, 1e2};
+            default: return {0, 1};
+        }
+    }
+
+    // 符号なし整数を可変長整数(LEB128)で書き込む
+    // 戻り値 : 書き込んだバイト数 (1〜5)
+    static std::size_t write_uvarint(uint32_t value, uint8_t* output)
+    {
+        std::size_t bytes = 0;
+        while (value >= 0x80)
+        {
+            output[bytes++] = (value & 0x7f) | 0x80;  // 最上位ビットが1のときは続きがある
+            value >>= 7;
+        }
+        output[bytes++] = value;
+        return bytes;
+    }
+
+    // 符号付き整数を，絶対値が小さいほど短くなる可変長整数(ZigZag + LEB128)で書き込む
+    // 戻り値 : 書き込んだバイト数 (1〜5)
+    static std::size_t write_varint(int32_t value, uint8_t* output)
+    {
+        return write_uvarint((static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31), output);  // 0, -1, 1, -2, ... を 0, 1, 2, 3, ... にする
+    }
+
+    // 符号なしの可変長整数を読む
+    // data : 読み込む位置  読み込んだ分だけ進める
+    // end : データの終わり
+    // 戻り値 : 読み込めたか
+    static bool read_uvarint(const uint8_t*& data, const uint8_t* end, uint32_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            if (data == end)
+    return false;
+            uint8_t c = *(data++);
+            value |= static_cast<uint32_t>(c & 0x7f) << shift;
+            if (!(c & 0x80))
+    return true;
+        }
+        return false;  // 5バイトを超える
+    }
+
+    // 符号付きの可変長整数を読む
+    // data : 読み込む位置  読み込んだ分だけ進める
+    // end : データの終わり
+    // 戻り値 : 読み込めたか
+    static bool read_varint(const uint8_t*& data, const uint8_t* end, int32_t& value)
+    {
+        uint32_t zigzag;
+        if (!read_uvarint(data, end, zigzag))
+    return false;
+        value = static_cast<int32_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+        return true;
+    }
+
+    // 2つの値の差  符号なしで引き算し，オーバーフローしても受信側で元に戻せるようにする
+    static int32_t difference(int32_t value, int32_t base)
+    {
+        return static_cast<int32_t>(static_cast<uint32_t>(value) - static_cast<uint32_t>(base));
+    }
+
+    // differenceで求めた差から値を戻す
+    static int32_t undo_difference(int32_t delta, int32_t base)
+    {
+        return static_cast<int32_t>(static_cast<uint32_t>(base) + static_cast<uint32_t>(delta));
+    }
+
+    // COBSで符号化する  符号化したデータには0x00が含まれない
+    // 戻り値 : 符号化したデータのバイト数 (data_bytes+1  ただし254バイトを超える場合は254バイトごとに1バイト増える)
+    static std::size_t cobs_encode(const uint8_t* data, std::size_t data_bytes, uint8_t* output)
+    {
+        std::size_t code_index = 0;  // 次の0x00までの距離を書き込む位置
+        std::size_t output_bytes = 1;
+        uint8_t code = 1;
+        for (std::size_t i = 0; i < data_bytes; ++i)
+        {
+            if (data[i])
+            {
+                output[output_bytes++] = data[i];
+                if (++code != 0xff)
+    continue;
+            }
+            output[code_index] = code;  // 0x00の代わりに，次の0x00までの距離を書く
+            code_index = output_bytes++;
+            code = 1;
+        }
+        output[code_index] = code;
+        return output_bytes;
+    }
+
+    // COBSで符号化されたデータを復号する  復号したデータは元のデータより短いので，同じ配列に上書きできる
+    // 戻り値 : 復号したデータのバイト数  正しく符号化されていない場合は0
+    static std::size_t cobs_decode(const uint8_t* data, std::size_t data_bytes, uint8_t* output)
+    {
+        std::size_t i = 0, output_bytes = 0;
+        while (i < data_bytes)
+        {
+            uint8_t code = data[i++];
+            if (!code || i + code - 1 > data_bytes)
+    return 0;
+            for (uint8_t j = 1; j < code; ++j) output[output_bytes++] = data[i++];
+            if (code != 0xff && i < data_bytes) output[output_bytes++] = 0;  // 最後の区間の後には0x00はない
+        }
+        return output_bytes;
+    }
+
+    /***** struct TelemetryRecord *****/
+
+    // index番目の値を元の単位で返す
+    double TelemetryRecord::value(std::size_t index) const
+    {
+        return values[index] / telemetry_format(type).scale;
+    }
+
+    /***** class TelemetryEncoder *****/
+
+    // 新しいフレームを作り始める  作成中のフレームは捨てる
+    // time_ms : 送信側の時刻 (ms)
+    void TelemetryEncoder::begin(uint32_t time_ms)
+    {
+        _payload[0] = _sequence & 0xff;
+        _payload[1] = _sequence >> 8;
+        _size = 2;
+        _size += write_uvarint(time_ms, _payload + _size);  // 時刻は符号なしなので，ZigZagを使わずにそのまま書く
+        _time_ms = time_ms;
+        _records_num = 0;
+        for (bool& has_last : _has_last) has_last = false;
+    }
+
+    // 1つの値を持つ記録を追加
+    // type : 記録の種類
+    // value : 値 (元の単位)
+    // 戻り値 : 追加できたか  beginを呼んでいない場合，フレームに入りきらない場合(TelemetryFrame::MaxRecords個を超える場合も含む)や，値の数が違う種類の場合はfalse
+    bool TelemetryEncoder::add(TelemetryType type, double value)
+    {
+        return add(type, 1, &value);
+    }
+
+    // 3つの値を持つ記録を追加
+    // type : 記録の種類
+    // x, y, z : 値 (元の単位)
+    // 戻り値 : 追加できたか  beginを呼んでいない場合，フレームに入りきらない場合(TelemetryFrame::MaxRecords個を超える場合も含む)や，値の数が違う種類の場合はfalse
+    bool TelemetryEncoder::add(TelemetryType type, double x, double y, double z)
+    {
+        const double values[3] = {x, y, z};
+        return add(type, 3, values);
+    }
+
+    // 記録を追加
+    // キーフレームの形式で書き込み，差分フレームを作るために値も残しておく
+    bool TelemetryEncoder::add(TelemetryType type, std::size_t values_num, const double* values)
+    {
+        TelemetryFormat format = telemetry_format(type);
+        if (!_size || format.values_num != values_num || _records_num >= TelemetryFrame::MaxRecords)
+    return false;
+
+        uint8_t type_index = static_cast<uint8_t>(type);
+        TelemetryRecord& added = _records[_records_num];
+        added.type = type;
+        added.values_num = values_num;
+        for (std::size_t i = 0; i < values_num; ++i)
+        {
+            double fixed = std::round(values[i] * format.scale);
+            if (fixed > INT32_MAX) fixed = INT32_MAX;  // 範囲外の値は端に揃える
+            if (fixed < INT32_MIN) fixed = INT32_MIN;
+            added.values[i] = static_cast<int32_t>(fixed);
+        }
+
+        // 値をそのまま書いた場合と，前の記録との差を書いた場合の短い方を使う
+        uint8_t record[1 + 5 * 3];
+        std::size_t record_bytes = 1;
+        record[0] = type_index;
+        for (std::size_t i = 0; i < values_num; ++i) record_bytes += write_varint(added.values[i], record + record_bytes);
+        if (_has_last[type_index])
+        {
+            uint8_t delta_record[1 + 5 * 3];
+            std::size_t delta_record_bytes = 1;
+            delta_record[0] = type_index | DeltaFlag;
+            for (std::size_t i = 0; i < values_num; ++i)
+                delta_record_bytes += write_varint(difference(added.values[i], _last[type_index][i]), delta_record + delta_record_bytes);
+            if (delta_record_bytes < record_bytes)
+            {
+                for (std::size_t i = 0; i < delta_record_bytes; ++i) record[i] = delta_record[i];
+                record_bytes = delta_record_bytes;
+            }
+        }
+        if (_size + record_bytes > MaxPayloadBytes)
+    return false;  // キーフレームに入りきらない  (差分フレームにできない場合に送れなくなるので，差分フレームの大きさでは判断しない)
+
+        for (std::size_t i = 0; i < record_bytes; ++i) _payload[_size++] = record[i];
+        for (std::size_t i = 0; i < values_num; ++i) _last[type_index][i] = added.values[i];
+        _has_last[type_index] = true;
+        ++_records_num;
+        return true;
+    }
+
+    // フレームを完成させて符号化する  最後のキーフレームと記録の種類と順番が同じで，短くなる場合は差分フレームにする
+    // frame : 符号化したフレームを保存するための配列  MaxFrameBytesバイト以上必要  (末尾に区切りの0x00を含む)
+    // 戻り値 : 符号化したフレームのバイト数  beginを呼んでいない場合は0
+    std::size_t TelemetryEncoder::end(uint8_t* frame)
+    {
+        if (!_size)
+    return 0;
+
+        uint8_t* payload = _payload;
+        std::size_t payload_bytes = _size;
+        std::size_t delta_bytes = (_frames_to_keyframe ? encode_delta() : 0);
+        if (delta_bytes)
+        {
+            payload = _delta_payload;
+            payload_bytes = delta_bytes;
+            --_frames_to_keyframe;
+        }
+        else _frames_to_keyframe = _keyframe_interval - 1;
+
+        uint16_t crc = crc16(payload, payload_bytes);
+        payload[payload_bytes] = crc & 0xff;
+        payload[payload_bytes + 1] = crc >> 8;
+        std::size_t frame_bytes = cobs_encode(payload, payload_bytes + 2, frame);
+        frame[frame_bytes++] = 0;  // フレームの区切り
+
+        // キーフレームは次からの差分フレームの元にする
+        if (!delta_bytes)
+        {
+            _has_keyframe = true;
+            _keyframe_sequence = _sequence;
+            _keyframe_time_ms = _time_ms;
+            _keyframe_records_num = _records_num;
+            for (std::size_t i = 0; i < _records_num; ++i) _keyframe_records[i] = _records[i];
+        }
+        _sequence = (_sequence + 1) & SequenceMask;
+        _size = 0;
+        return frame_bytes;
+    }
+
+    // 作成中のフレームを差分フレームの形式にする
+    // 戻り値 : 差分フレームのバイト数 (CRCを除く)  最後のキーフレームと記録の種類と順番が違う場合や，キーフレームの形式より短くならない場合は0
+    std::size_t TelemetryEncoder::encode_delta()
+    {
+        if (!_has_keyframe || _records_num != _keyframe_records_num)
+    return 0;
+        for (std::size_t i = 0; i < _records_num; ++i)
+            if (_records[i].type != _keyframe_records[i].type)
+    return 0;
+
+        uint16_t header = _sequence | DeltaFrameFlag;
+        _delta_payload[0] = header & 0xff;
+        _delta_payload[1] = header >> 8;
+        std::size_t size = 2;
+        size += write_uvarint((_sequence - _keyframe_sequence) & SequenceMask, _delta_payload + size);  // 受信側が元のキーフレームを確かめられるように，番号の差を書く
+        size += write_uvarint(_time_ms - _keyframe_time_ms, _delta_payload + size);  // 時刻が戻った場合も，符号なしの引き算なので受信側で元に戻せる
+        for (std::size_t i = 0; i < _records_num; ++i)
+        {
+            if (size >= _size || size + 5 * 3 > MaxPayloadBytes)
+    return 0;  // キーフレームより短くならない  (値の差が大きいときは，そのまま書いた方が短い場合がある)
+            for (std::size_t j = 0; j < _records[i].values_num; ++j)
+                size += write_varint(difference(_records[i].values[j], _keyframe_records[i].values[j]), _delta_payload + size);
+        }
+        return (size < _size ? size : 0);
+    }
+
+    /***** class TelemetryDecoder *****/
+
+    // 1バイト読み込む
+    // c : 受信したバイト
+    // 戻り値 : 正しいフレームを読み終えたか  読み終えたフレームは frame で取得する
+    bool TelemetryDecoder::feed(uint8_t c)
+    {
+        if (c)
+        {
+            if (_size < sizeof(_buffer)) _buffer[_size++] = c;
+            else _overflow = true;  // 区切りが来るまで捨てる
+    return false;
+        }
+
+        // 区切りを受信した
+        if (!_size && !_overflow)
+    return false;  // 区切りが続いている
+        bool decoded = false;
+        bool success = !_overflow && decode(decoded);
+        if (!success) ++_errors;
+        _size = 0;
+        _overflow = false;
+        return success && decoded;
+    }
+
+    // 区切りまでに受信したデータを復号し，フレームとして解釈する
+    // decoded : フレームの内容を読み込めたか  差分フレームの元になるキーフレームがない場合はfalse
+    // 戻り値 : 正しいフレームだったか
+    bool TelemetryDecoder::decode(bool& decoded)
+    {
+        std::size_t payload_bytes = cobs_decode(_buffer, _size, _buffer);
+        if (payload_bytes < 2 + 1 + 2)
+    return false;  // 番号, 時刻, CRC の分もない
+        payload_bytes -= 2;
+        if (crc16(_buffer, payload_bytes) != (_buffer[payload_bytes] | (_buffer[payload_bytes + 1] << 8)))
+    return false;
+
+        TelemetryFrame frame;
+        uint16_t header = _buffer[0] | (_buffer[1] << 8);
+        frame.sequence = header & TelemetryEncoder::SequenceMask;
+        frame.delta = header & TelemetryEncoder::DeltaFrameFlag;
+        const uint8_t* data = _buffer + 2;
+        const uint8_t* end = _buffer + payload_bytes;
+
+        if (frame.delta)
+        {
+            uint32_t keyframe_distance;
+            if (!read_uvarint(data, end, keyframe_distance))
+    return false;
+            if (!_has_keyframe || ((frame.sequence - keyframe_distance) & TelemetryEncoder::SequenceMask) != _keyframe.sequence)
+            {
+                // 元になるキーフレームを読み込めていないので，次のキーフレームまで読み込めない
+                count_sequence(frame.sequence);
+                ++_skipped_frames;
+    return true;
+            }
+
+            // 記録の種類と順番はキーフレームと同じ
+            uint32_t time_delta;
+            if (!read_uvarint(data, end, time_delta))
+    return false;
+            frame.time_ms = _keyframe.time_ms + time_delta;
+            frame.records_num = _keyframe.records_num;
+            for (std::size_t i = 0; i < frame.records_num; ++i)
+            {
+                TelemetryRecord& record = frame.records[i];
+                record.type = _keyframe.records[i].type;
+                record.values_num = _keyframe.records[i].values_num;
+                for (std::size_t j = 0; j < record.values_num; ++j)
+                {
+                    if (!read_varint(data, end, record.values[j]))
+    return false;
+                    record.values[j] = undo_difference(record.values[j], _keyframe.records[i].values[j]);
+                }
+            }
+            if (data != end)
+    return false;  // キーフレームと記録の数が合わない
+        }
+        else
+        {
+            if (!read_uvarint(data, end, frame.time_ms))
+    return false;
+
+            while (data != end)
+            {
+                if (frame.records_num >= TelemetryFrame::MaxRecords)
+    return false;
+                TelemetryRecord& record = frame.records[frame.records_num++];
+                bool delta = *data & TelemetryEncoder::DeltaFlag;
+                record.type = static_cast<TelemetryType>(*(data++) & ~TelemetryEncoder::DeltaFlag);
+                record.values_num = telemetry_format(record.type).values_num;
+                if (!record.values_num)
+    return false;  // 知らない種類の記録は，値の長さが分からないので読み進められない
+
+                const TelemetryRecord* last = nullptr;  // 差の元になる，同じ種類の前の記録
+                if (delta)
+                {
+                    for (std::size_t i = frame.records_num - 1; i-- > 0;)
+                        if (frame.records[i].type == record.type)
+                        {
+                            last = &frame.records[i];
+                            break;
+                        }
+                    if (!last)
+    return false;
+                }
+                for (std::size_t i = 0; i < record.values_num; ++i)
+                {
+                    if (!read_varint(data, end, record.values[i]))
+    return false;
+                    if (last) record.values[i] = undo_difference(record.values[i], last->values[i]);
+                }
+            }
+        }
+
+        count_sequence(frame.sequence);
+        if (!frame.delta)
+        {
+            _has_keyframe = true;
+            _keyframe = frame;
+        }
+        _frame = frame;
+        ++_frames;
+        decoded = true;
+        return true;
+    }
+
+    // 受信したフレームの番号から，失われたフレームを数える
+    void TelemetryDecoder::count_sequence(uint16_t sequence)
+    {
+        if (_has_sequence)
+        {
+            uint16_t gap = (sequence - _last_sequence - 1) & TelemetryEncoder::SequenceMask;  // 番号が一周しても正しく数えられる  戻った場合は大きな値になる
+            if (gap <= MaxSequenceGap) _lost_frames += gap;
+            else ++_resyncs;  // 送信側の再起動などで番号が続いていないので，失われたフレームとしては数えずに，このフレームから数え直す
+        }
+        _has_sequence = true;
+        _last_sequence = sequence;
+    }
+}
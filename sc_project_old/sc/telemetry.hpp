@@ -0,0 +1,190 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TELEMETRY_HPP_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TELEMETRY_HPP_
+
+// 地上局のパソコン(Linuxなど)でも同じファイルを使って受信できるように，pico-sdkやsc.hppは読み込まない
+// 例: g++ -std=c++11 -c telemetry.cpp crc.cpp
+#include <cstddef>
+#include <cstdint>
+
+namespace sc
+{
+    // テレメトリの記録の種類  値は固定小数点の整数で送る
+    // 種類を追加する場合は，受信側と合わせるため末尾に追加してください
+    enum class TelemetryType : uint8_t
+    {
+        TEMPERATURE = 1,  // 気温 (℃)  0.01℃単位
+        PRESSURE = 2,  // 気圧 (hPa)  0.01hPa(1Pa)単位
+        HUMIDITY = 3,  // 湿度 (%)  0.01%単位
+        ALTITUDE = 4,  // 標高 (m)  1mm単位
+        LATITUDE = 5,  // 緯度 (°)  10^-7°単位
+        LONGITUDE = 6,  // 経度 (°)  10^-7°単位
+        A_POSITION = 7,  // 絶対直交座標上の位置 (x, y, z) (m)  1mm単位
+        ACCELERATION = 8,  // 加速度 (x, y, z) (m/s/s)  0.001m/s/s単位
+        GYRO = 9,  // 角速度 (x, y, z) (rad/s)  0.001rad/s単位
+        MAGNETISM = 10,  // 磁気 (x, y, z) (mT)  10^-6mT(1nT)単位
+        A_DIRECTION = 11  // 絶対的な方角 (°)  0.01°単位
+    };
+
+    // テレメトリの1つの記録
+    struct TelemetryRecord
+    {
+        TelemetryType type;
+        uint8_t values_num;  // 値の数 (1か3)
+        int32_t values[3];  // 固定小数点の値
+
+        // index番目の値を元の単位で返す
+        double value(std::size_t index = 0) const;
+    };
+
+    // テレメトリの1つのフレーム (1回の送信分)
+    struct TelemetryFrame
+    {
+        static const std::size_t MaxRecords = 64;  // 1つのフレームに含められる記録の最大数
+
+        uint16_t sequence = 0;  // 送信するたびに1増える番号 (15ビット)  受信側で失われたフレームを数えるために使う
+        bool delta = false;  // キーフレームとの差だけで送られたフレーム(差分フレーム)だったか
+        uint32_t time_ms = 0;  // 送信側の時刻 (ms)
+        std::size_t records_num = 0;
+        TelemetryRecord records[MaxRecords];
+    };
+
+    // テレメトリのフレームを作成します
+    // 記録は 種類(1バイト)+値(可変長整数) で表すため，値が小さいほど短くなります
+    // 同じフレームに同じ種類の記録を複数入れる場合は，短くなるときは前の記録との差を送ります (種類の最上位ビットが1)
+    //
+    // set_keyframe_intervalで指定した間隔ごとに，他のフレームを使わないフレーム(キーフレーム)を送ります
+    // その間のフレームは，最後のキーフレームと記録の種類と順番が同じ場合は，種類を省き，時刻と値をキーフレームとの差だけで送ります(差分フレーム)
+    // 差分フレームはキーフレームだけを元にするため，他の差分フレームが失われても読み込めます  (読み込めなくなるのはキーフレームが失われた場合だけ)
+    // フレームはCRC-16を付けてCOBSで符号化し，0x00で区切るため，受信側は途中から受信しても次のキーフレームから読み込めます
+    //
+    // フレームの形式 (COBSで符号化する前)
+    // キーフレーム : [番号(2バイト)][時刻(可変長)][種類][値]...[種類][値][CRC-16(2バイト)]
+    // 差分フレーム : [番号|0x8000(2バイト)][キーフレームからの番号の差(可変長)][時刻の差(可変長)][値の差]...[値の差][CRC-16(2バイト)]
+    class TelemetryEncoder
+    {
+    public:
+        static const std::size_t MaxPayloadBytes = 250;  // CRCを除いたフレームの最大のバイト数  (CRCを含めて254バイト以下なので，COBSで増えるのは1バイトだけ)
+        static const std::size_t MaxFrameBytes = MaxPayloadBytes + 2 + 2;  // 符号化したフレームの最大のバイト数 (CRC, COBS, 区切り)
+        static const uint8_t DeltaFlag = 0x80;  // 種類に付けると，同じフレームの前の同じ種類の記録との差を表す
+        static const uint16_t DeltaFrameFlag = 0x8000;  // 番号に付けると，差分フレームであることを表す
+        static const uint16_t SequenceMask = 0x7fff;  // 番号として使うビット
+        static const std::size_t MaxType = 11;  // 記録の種類の最大値
+
+        // 新しいフレームを作り始める  作成中のフレームは捨てる
+        // time_ms : 送信側の時刻 (ms)
+        void begin(uint32_t time_ms);
+
+        // 1つの値を持つ記録を追加
+        // type : 記録の種類
+        // value : 値 (元の単位)
+        // 戻り値 : 追加できたか  beginを呼んでいない場合，フレームに入りきらない場合(TelemetryFrame::MaxRecords個を超える場合も含む)や，値の数が違う種類の場合はfalse
+        bool add(TelemetryType type, double value);
+
+        // 3つの値を持つ記録を追加
+        // type : 記録の種類
+        // x, y, z : 値 (元の単位)
+        // 戻り値 : 追加できたか  beginを呼んでいない場合，フレームに入りきらない場合(TelemetryFrame::MaxRecords個を超える場合も含む)や，値の数が違う種類の場合はfalse
+        bool add(TelemetryType type, double x, double y, double z);
+
+        // フレームを完成させて符号化する  最後のキーフレームと記録の種類と順番が同じで，短くなる場合は差分フレームにする
+        // frame : 符号化したフレームを保存するための配列  MaxFrameBytesバイト以上必要  (末尾に区切りの0x00を含む)
+        // 戻り値 : 符号化したフレームのバイト数  beginを呼んでいない場合は0
+        std::size_t end(uint8_t* frame);
+
+        // キーフレームを送る間隔を設定する  受信側は，キーフレームが失われてから最大でこの数のフレームを読み込めない
+        // interval : 何フレームに1回キーフレームを送るか  1の場合は差分フレームを使わない (初期値:10)
+        void set_keyframe_interval(uint16_t interval) {_keyframe_interval = (interval ? interval : 1);}
+
+        // 次のフレームをキーフレームにする  受信側が途中から受信し始めたことが分かっている場合など
+        void request_keyframe() {_frames_to_keyframe = 0;}
+
+        // 作成中のフレームをキーフレームとして送る場合のバイト数 (CRCと符号化を除く)  差分フレームの場合はこれより短くなる
+        std::size_t size() const {return _size;}
+
+    private:
+        uint8_t _payload[MaxPayloadBytes + 2];  // 作成中のフレーム(キーフレームの形式)  CRCの分だけ大きくしておく
+        uint8_t _delta_payload[MaxPayloadBytes + 2];  // 作成中のフレームを差分フレームの形式にしたもの
+        std::size_t _size = 0;  // 0のときはフレームを作成中でない
+        uint16_t _sequence = 0;
+        uint32_t _time_ms = 0;
+        bool _has_last[MaxType + 1] = {};  // 作成中のフレームに，その種類の記録があるか
+        int32_t _last[MaxType + 1][3];  // 作成中のフレームの，その種類の最後の記録の値
+        std::size_t _records_num = 0;
+        TelemetryRecord _records[TelemetryFrame::MaxRecords];  // 作成中のフレームの記録  (差分フレームを作るために使う)
+        bool _has_keyframe = false;  // キーフレームを送ったか
+        uint16_t _keyframe_sequence = 0;
+        uint32_t _keyframe_time_ms = 0;
+        std::size_t _keyframe_records_num = 0;
+        TelemetryRecord _keyframe_records[TelemetryFrame::MaxRecords];  // 最後に送ったキーフレームの記録  (差分フレームの元にする)
+        uint16_t _keyframe_interval = 10;
+        uint16_t _frames_to_keyframe = 0;  // 次のキーフレームまでに送る差分フレームの数
+
+        // 記録を追加
+        bool add(TelemetryType type, std::size_t values_num, const double* values);
+
+        // 作成中のフレームを差分フレームの形式にする
+        // 戻り値 : 差分フレームのバイト数 (CRCを除く)  最後のキーフレームと記録の種類と順番が違う場合や，キーフレームの形式より短くならない場合は0
+        std::size_t encode_delta();
+    };
+
+    // テレメトリのフレームを1バイトずつ読み込みます
+    // 壊れたデータや途中から受信したデータは，次の区切り(0x00)まで読み飛ばします
+    // 差分フレームは，元になるキーフレームを読み込めている場合だけ読み込み，そうでない場合は次のキーフレームまで読み飛ばします
+    class TelemetryDecoder
+    {
+    public:
+        static const uint16_t MaxSequenceGap = 1024;  // 失われたとみなす番号の飛びの最大  これより大きく飛んだ場合や戻った場合は，送信側が再起動したとみなす
+
+        // 1バイト読み込む
+        // c : 受信したバイト
+        // 戻り値 : 正しいフレームを読み終えたか  読み終えたフレームは frame で取得する
+        bool feed(uint8_t c);
+
+        // 最後に読み終えたフレーム
+        const TelemetryFrame& frame() const {return _frame;}
+
+        // 正しく読み込めたフレームの数
+        uint32_t frames() const {return _frames;}
+
+        // CRCが一致しなかったか，形式が正しくなかったフレームの数
+        uint32_t errors() const {return _errors;}
+
+        // 番号が飛んでいたことから分かる，受信できなかったフレームの数 (壊れていたフレームも含む)
+        // 番号がMaxSequenceGapより大きく飛んだ場合や，戻った場合(送信側の再起動，同じフレームの重複，順番の入れ替わり)は数えない
+        uint32_t lost_frames() const {return _lost_frames;}
+
+        // 番号が大きく飛んだか戻ったため，数え直した回数
+        uint32_t resyncs() const {return _resyncs;}
+
+        // 正しく受信できたが，元になるキーフレームがないため読み込めなかった差分フレームの数
+        uint32_t skipped_frames() const {return _skipped_frames;}
+
+    private:
+        uint8_t _buffer[TelemetryEncoder::MaxFrameBytes];  // 区切りまでに受信したデータ
+        std::size_t _size = 0;
+        bool _overflow = false;  // 区切りが来ないままバッファがいっぱいになった
+        bool _has_sequence = false;  // 前のフレームの番号を受信したか
+        uint16_t _last_sequence = 0;
+        TelemetryFrame _frame;  // 最後に読み込んだフレーム
+        bool _has_keyframe = false;  // _keyframeを読み込んだか  (差分フレームの元にできるか)
+        TelemetryFrame _keyframe;  // 最後に読み込んだキーフレーム
+        uint32_t _frames = 0;
+        uint32_t _errors = 0;
+        uint32_t _lost_frames = 0;
+        uint32_t _resyncs = 0;
+        uint32_t _skipped_frames = 0;
+
+        // 区切りまでに受信したデータを復号し，フレームとして解釈する
+        // decoded : フレームの内容を読み込めたか  差分フレームの元になるキーフレームがない場合はfalse
+        // 戻り値 : 正しいフレームだったか
+        bool decode(bool& decoded);
+
+        // 受信したフレームの番号から，失われたフレームを数える
+        void count_sequence(uint16_t sequence);
+    };
+    // このクラスの作成にあたり以下の資料を参考にしました
+    // http://www.stuartcheshire.org/papers/COBSforToN.pdf  (Consistent Overhead Byte Stuffing)
+    // https://developers.google.com/protocol-buffers/docs/encoding  (Varints, ZigZag encoding)
+}
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TELEMETRY_HPP_
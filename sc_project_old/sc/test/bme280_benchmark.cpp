@@ -0,0 +1,166 @@
+// BME280の補正の計算の処理速度の測定
+// 以前のBME280::convert_XX (データシートの32ビットの計算と，doubleへの割り算)，データシートの64ビットの計算，
+// BME280Calibrationの計算(1回ずつ, bme280_compensateでまとめて)を，同じ生データで比べる
+// 時刻はパソコンの実際の時刻で，パソコンには浮動小数点数の計算回路があるため，doubleの割り算はRP2040よりずっと速い  (RP2040での処理時間は実機で測る必要がある)
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "bme280_compensation.hpp"
+#include "bme280_reference.hpp"
+#include "check.hpp"
+
+namespace
+{
+    const std::size_t Count = 1 << 20;  // 生データの数
+    const int Repeats = 5;  // 測定を繰り返す回数  最も速かった回を結果とする
+
+    // 以前のBME280::convert_temperature, convert_pressure, convert_humidity と同じ計算
+    struct Baseline
+    {
+        double temperature, pressure, humidity;
+    };
+
+    Baseline baseline(const reference::Calibration& c, const sc::BME280Raw& raw)
+    {
+        Baseline result;
+        int32_t t_fine = (((((raw.temperature >> 3) - ((int32_t) c.dig_T1 << 1))) * ((int32_t) c.dig_T2)) >> 11) + ((((((raw.temperature >> 4) - ((int32_t) c.dig_T1)) * ((raw.temperature >> 4) - ((int32_t) c.dig_T1))) >> 12) * ((int32_t) c.dig_T3)) >> 14);
+        result.temperature = ((t_fine * 5 + 128) >> 8) / 100.0;
+
+        int32_t var1, var2;
+        uint32_t p;
+        var1 = (((int32_t) t_fine) >> 1) - (int32_t) 64000;
+        var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * ((int32_t) c.dig_P6);
+        var2 = var2 + ((var1 * ((int32_t) c.dig_P5)) * 2);
+        var2 = (var2 >> 2) + (((int32_t) c.dig_P4) * 65536);
+        var1 = (((c.dig_P3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) + ((((int32_t) c.dig_P2) * var1) >> 1)) >> 18;
+        var1 = ((((32768 + var1)) * ((int32_t) c.dig_P1)) >> 15);
+        if (var1 == 0)
+            result.pressure = 0;
+        else
+        {
+            p = (((uint32_t) (((int32_t) 1048576) - raw.pressure) - (var2 >> 12))) * 3125;
+            if (p < 0x80000000)
+                p = (p << 1) / ((uint32_t) var1);
+            else
+                p = (p / (uint32_t) var1) * 2;
+            var1 = (((int32_t) c.dig_P9) * ((int32_t) (((p >> 3) * (p >> 3)) >> 13))) >> 12;
+            var2 = (((int32_t) (p >> 2)) * ((int32_t) c.dig_P8)) >> 13;
+            p = (uint32_t) ((int32_t) p + ((var1 + var2 + c.dig_P7) >> 4));
+            result.pressure = p / 100.0;
+        }
+
+        result.humidity = reference::bme280_compensate_H_int32(c, raw.humidity, t_fine) / 1024.0;
+        return result;
+    }
+
+    // 計算をRepeats回行い，最も速かった回の時間(ns)を返す
+    template<typename Function> double measure(Function function)
+    {
+        double best = 1e30;
+        for (int repeat = 0; repeat < Repeats; ++repeat)
+        {
+            auto start = std::chrono::steady_clock::now();
+            function();
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            if (ns < best) best = ns;
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    // データシート(BMP280)の計算例の補正用データ
+    // 実際と同じく実行するまで値が分からないようにvolatileから読み込み，データシートの計算の係数が定数として畳み込まれないようにする
+    static volatile uint8_t Registers[sc::BME280Calibration::TemperaturePressureBytes + sc::BME280Calibration::HumidityBytes] = {
+        0x70, 0x6b, 0x43, 0x67, 0x18, 0xfc, 0x7d, 0x8e, 0x43, 0xd6, 0xd0, 0x0b, 0x27, 0x0b, 0x8c, 0x00,
+        0xf9, 0xff, 0x8c, 0x3c, 0xf8, 0xc6, 0x70, 0x17, 0x00, 0x4b,
+        0x6a, 0x01, 0x00, 0x13, 0x29, 0x03, 0x1e};
+    uint8_t registers[sizeof(Registers)];
+    for (std::size_t i = 0; i < sizeof(Registers); ++i) registers[i] = Registers[i];
+    const uint8_t* temperature_pressure = registers;
+    const uint8_t* humidity = registers + sc::BME280Calibration::TemperaturePressureBytes;
+    reference::Calibration reference_calibration(temperature_pressure, humidity);
+    sc::BME280Calibration calibration;
+    calibration.load(temperature_pressure, humidity);
+
+    // 室内から上空までの気温・気圧・湿度にあたる生データ
+    std::vector<uint8_t> frames(Count * sc::BME280Raw::FrameBytes);
+    uint32_t random = 1;
+    for (std::size_t i = 0; i < Count; ++i)
+    {
+        random = random * 1103515245 + 12345;
+        uint32_t raw_pressure = 250000 + (random >> 8) % 200000;
+        uint32_t raw_temperature = 480000 + (random >> 12) % 80000;
+        uint32_t raw_humidity = 20000 + (random >> 16) % 20000;
+        uint8_t* frame = &frames[i * sc::BME280Raw::FrameBytes];
+        frame[0] = raw_pressure >> 12;
+        frame[1] = raw_pressure >> 4;
+        frame[2] = (raw_pressure & 0x0f) << 4;
+        frame[3] = raw_temperature >> 12;
+        frame[4] = raw_temperature >> 4;
+        frame[5] = (raw_temperature & 0x0f) << 4;
+        frame[6] = raw_humidity >> 8;
+        frame[7] = raw_humidity & 0xff;
+    }
+
+    std::vector<int32_t> temperature(Count);
+    std::vector<uint32_t> pressure(Count), humidity_out(Count);
+    double baseline_sum = 0;
+    uint64_t reference_sum = 0, kernel_sum = 0;
+
+    double baseline_ns = measure([&]
+    {
+        double sum = 0;
+        for (std::size_t i = 0; i < Count; ++i)
+        {
+            Baseline b = baseline(reference_calibration, sc::BME280Raw::from_frame(&frames[i * sc::BME280Raw::FrameBytes]));
+            sum += b.temperature + b.pressure + b.humidity;
+        }
+        baseline_sum = sum;
+    });
+
+    double reference_ns = measure([&]
+    {
+        uint64_t sum = 0;
+        for (std::size_t i = 0; i < Count; ++i)
+        {
+            sc::BME280Raw raw = sc::BME280Raw::from_frame(&frames[i * sc::BME280Raw::FrameBytes]);
+            int32_t t_fine;
+            sum += static_cast<uint32_t>(reference::BME280_compensate_T_int32(reference_calibration, raw.temperature, t_fine));
+            sum += reference::BME280_compensate_P_int64(reference_calibration, raw.pressure, t_fine);
+            sum += reference::bme280_compensate_H_int32(reference_calibration, raw.humidity, t_fine);
+        }
+        reference_sum = sum;
+    });
+
+    double kernel_ns = measure([&]
+    {
+        uint64_t sum = 0;
+        for (std::size_t i = 0; i < Count; ++i)
+        {
+            sc::BME280Data data = calibration.compensate(sc::BME280Raw::from_frame(&frames[i * sc::BME280Raw::FrameBytes]));
+            sum += static_cast<uint32_t>(data.temperature) + data.pressure + data.humidity;
+        }
+        kernel_sum = sum;
+    });
+
+    double batch_ns = measure([&]
+    {
+        sc::bme280_compensate(calibration, Count, frames.data(), temperature.data(), pressure.data(), humidity_out.data());
+    });
+    uint64_t batch_sum = 0;
+    for (std::size_t i = 0; i < Count; ++i) batch_sum += static_cast<uint32_t>(temperature[i]) + pressure[i] + humidity_out[i];
+
+    std::printf("compensating %u samples (host CPU time, best of %d)\n", static_cast<unsigned>(Count), Repeats);
+    std::printf("  old convert_XX (32-bit pressure, double division)  %6.2f ns/sample  (checksum %.1f)\n", baseline_ns / Count, baseline_sum);
+    std::printf("  datasheet reference (64-bit pressure)              %6.2f ns/sample\n", reference_ns / Count);
+    std::printf("  BME280Calibration::compensate                      %6.2f ns/sample  %.2fx vs reference\n", kernel_ns / Count, reference_ns / kernel_ns);
+    std::printf("  bme280_compensate (blocks of 256)                  %6.2f ns/sample  %.2fx vs reference\n", batch_ns / Count, reference_ns / batch_ns);
+
+    // 同じ生データからは同じ結果になる
+    CHECK_EQUAL(kernel_sum, reference_sum);
+    CHECK_EQUAL(batch_sum, reference_sum);
+    return check::result();
+}
@@ -0,0 +1,211 @@
+// BME280Calibrationの補正の計算が，データシートの計算(bme280_reference.hpp)と1ビットも違わないことを確認する
+// データシートの例の値と，実際のセンサにありうる範囲で作った補正用データ・生データを使う
+#include <cstdio>
+#include <vector>
+
+#include "bme280_compensation.hpp"
+#include "bme280_reference.hpp"
+#include "check.hpp"
+
+namespace
+{
+    // 補正用データのレジスタの内容 (0x88〜0xA1, 0xE1〜0xE7)
+    struct CalibrationRegisters
+    {
+        uint8_t temperature_pressure[sc::BME280Calibration::TemperaturePressureBytes];
+        uint8_t humidity[sc::BME280Calibration::HumidityBytes];
+    };
+
+    // dig_XXの値からレジスタの内容を作る
+    CalibrationRegisters registers(uint16_t t1, int16_t t2, int16_t t3, uint16_t p1, const int16_t (&p)[8], uint8_t h1, int16_t h2, uint8_t h3, int16_t h4, int16_t h5, int8_t h6)
+    {
+        CalibrationRegisters r = {};
+        auto put16 = [&r](std::size_t index, int value)
+        {
+            r.temperature_pressure[index] = static_cast<uint8_t>(value & 0xff);
+            r.temperature_pressure[index + 1] = static_cast<uint8_t>((value >> 8) & 0xff);
+        };
+        put16(0, t1);
+        put16(2, t2);
+        put16(4, t3);
+        put16(6, p1);
+        for (int i = 0; i < 8; ++i) put16(8 + 2 * i, p[i]);
+        r.temperature_pressure[25] = h1;
+        r.humidity[0] = static_cast<uint8_t>(h2 & 0xff);
+        r.humidity[1] = static_cast<uint8_t>((h2 >> 8) & 0xff);
+        r.humidity[2] = h3;
+        r.humidity[3] = static_cast<uint8_t>((h4 >> 4) & 0xff);  // 0xE4 : dig_H4の上位8ビット
+        r.humidity[4] = static_cast<uint8_t>((h4 & 0x0f) | ((h5 & 0x0f) << 4));  // 0xE5 : dig_H4の下位4ビットとdig_H5の下位4ビット
+        r.humidity[5] = static_cast<uint8_t>((h5 >> 4) & 0xff);  // 0xE6 : dig_H5の上位8ビット
+        r.humidity[6] = static_cast<uint8_t>(h6);
+        return r;
+    }
+
+    // データシート(BMP280)の計算例の補正用データ  湿度はよくある値
+    CalibrationRegisters datasheet_example()
+    {
+        const int16_t p[8] = {-10685, 3024, 2855, 140, -7, 15500, -14600, 6000};
+        return registers(27504, 26435, -1000, 36477, p, 75, 362, 0, 313, 50, 30);
+    }
+
+    // 決まった順番で出てくる乱数
+    uint32_t next(uint32_t& random)
+    {
+        random = random * 1103515245 + 12345;
+        return random >> 8;
+    }
+
+    // centerを中心に±spreadの範囲の乱数
+    int around(uint32_t& random, int center, int spread)
+    {
+        return center - spread + static_cast<int>(next(random) % (2 * spread + 1));
+    }
+
+    // 実際のセンサにありうる範囲の補正用データを作る
+    CalibrationRegisters random_calibration(uint32_t& random)
+    {
+        const int16_t p[8] = {
+            static_cast<int16_t>(around(random, -10550, 200)), static_cast<int16_t>(around(random, 3024, 100)),
+            static_cast<int16_t>(around(random, 5500, 3500)), static_cast<int16_t>(around(random, 0, 300)),
+            static_cast<int16_t>(around(random, -7, 3)), static_cast<int16_t>(around(random, 12700, 2800)),
+            static_cast<int16_t>(around(random, -12400, 2200)), static_cast<int16_t>(around(random, 5100, 900))};
+        return registers(static_cast<uint16_t>(around(random, 27900, 900)), static_cast<int16_t>(around(random, 26500, 500)), static_cast<int16_t>(around(random, 0, 1000)),
+                         static_cast<uint16_t>(around(random, 37200, 1300)), p,
+                         static_cast<uint8_t>(around(random, 75, 10)), static_cast<int16_t>(around(random, 360, 20)), static_cast<uint8_t>(around(random, 0, 0)),
+                         static_cast<int16_t>(around(random, 320, 30)), static_cast<int16_t>(around(random, 0, 100)), static_cast<int8_t>(around(random, 30, 5)));
+    }
+
+    // 生データを0xF7〜0xFEの8バイトにする
+    void put_frame(int32_t raw_pressure, int32_t raw_temperature, int32_t raw_humidity, uint8_t* frame)
+    {
+        frame[0] = static_cast<uint8_t>(raw_pressure >> 12);
+        frame[1] = static_cast<uint8_t>(raw_pressure >> 4);
+        frame[2] = static_cast<uint8_t>((raw_pressure & 0x0f) << 4);
+        frame[3] = static_cast<uint8_t>(raw_temperature >> 12);
+        frame[4] = static_cast<uint8_t>(raw_temperature >> 4);
+        frame[5] = static_cast<uint8_t>((raw_temperature & 0x0f) << 4);
+        frame[6] = static_cast<uint8_t>(raw_humidity >> 8);
+        frame[7] = static_cast<uint8_t>(raw_humidity);
+    }
+
+    // センサの動作範囲(-40〜85℃)に入る気温の生データを作る
+    int32_t random_raw_temperature(uint32_t& random, const reference::Calibration& c)
+    {
+        for (;;)
+        {
+            int32_t raw = static_cast<int32_t>(next(random) & 0xfffff);
+            int32_t t_fine;
+            int32_t temperature = reference::BME280_compensate_T_int32(c, raw, t_fine);
+            if (temperature >= -4000 && temperature <= 8500)
+        return raw;
+        }
+    }
+}
+
+int main()
+{
+    // データシートの計算例  adc_T=519888 で 25.08℃, adc_P=415148 で 100653.27Pa  (計算例は浮動小数点数での値なので，気圧は0.05Paまでの差を認める)
+    {
+        CalibrationRegisters r = datasheet_example();
+        reference::Calibration expected(r.temperature_pressure, r.humidity);
+        sc::BME280Calibration calibration;
+        calibration.load(r.temperature_pressure, r.humidity);
+
+        int32_t t_fine;
+        CHECK_EQUAL(reference::BME280_compensate_T_int32(expected, 519888, t_fine), 2508);
+        CHECK_EQUAL(t_fine, 128422);
+        uint32_t pressure = reference::BME280_compensate_P_int64(expected, 415148, t_fine);
+        CHECK(pressure / 256.0 > 100653.22 && pressure / 256.0 < 100653.32);
+        CHECK_EQUAL(calibration.t_fine(519888), 128422);
+        CHECK_EQUAL(sc::BME280Calibration::temperature(128422), 2508);
+        CHECK_EQUAL(calibration.pressure(415148, 128422), pressure);
+        CHECK_EQUAL(calibration.humidity(30000, 128422), reference::bme280_compensate_H_int32(expected, 30000, 128422));
+
+        // 気温の生データはすべての値を試す  (この補正用データでは，どの値でもt_fineの計算は32ビットに収まる)
+        std::size_t mismatches = 0;
+        for (int32_t raw = 0; raw <= 0xfffff; ++raw)
+        {
+            int32_t temperature = reference::BME280_compensate_T_int32(expected, raw, t_fine);
+            mismatches += (calibration.t_fine(raw) != t_fine || sc::BME280Calibration::temperature(calibration.t_fine(raw)) != temperature);
+        }
+        CHECK_EQUAL(mismatches, 0);
+    }
+
+    // ありうる範囲の補正用データと生データを組み合わせて比べる
+    {
+        const int Calibrations = 100;
+        const int Samples = 20000;
+        uint32_t random = 2024;
+        std::size_t mismatches = 0, compared = 0;
+        for (int i = 0; i < Calibrations; ++i)
+        {
+            CalibrationRegisters r = random_calibration(random);
+            reference::Calibration expected(r.temperature_pressure, r.humidity);
+            sc::BME280Calibration calibration;
+            calibration.load(r.temperature_pressure, r.humidity);
+
+            for (int j = 0; j < Samples; ++j)
+            {
+                int32_t raw_temperature = random_raw_temperature(random, expected);
+                int32_t raw_pressure = static_cast<int32_t>(next(random) & 0xfffff);
+                int32_t raw_humidity = static_cast<int32_t>(next(random) & 0xffff);
+                if (j == 0) raw_pressure = 0x80000, raw_humidity = 0x8000;  // 測定しない設定のときに読み込まれる値
+                uint8_t frame[sc::BME280Raw::FrameBytes];
+                put_frame(raw_pressure, raw_temperature, raw_humidity, frame);
+
+                int32_t t_fine;
+                int32_t temperature = reference::BME280_compensate_T_int32(expected, raw_temperature, t_fine);
+                uint32_t pressure = reference::BME280_compensate_P_int64(expected, raw_pressure, t_fine);
+                uint32_t humidity = reference::bme280_compensate_H_int32(expected, raw_humidity, t_fine);
+                sc::BME280Data data = calibration.compensate(sc::BME280Raw::from_frame(frame));
+                mismatches += (data.temperature != temperature || data.pressure != pressure || data.humidity != humidity);
+                ++compared;
+            }
+        }
+        std::printf("%u calibrations x %u samples: %u mismatches\n", static_cast<unsigned>(Calibrations), static_cast<unsigned>(Samples), static_cast<unsigned>(mismatches));
+        CHECK_EQUAL(compared, Calibrations * Samples);
+        CHECK_EQUAL(mismatches, 0);
+    }
+
+    // まとめて補正した結果も同じになる  (BME280BlockSizeの倍数でない数，気圧と湿度を省略した場合も含む)
+    {
+        uint32_t random = 7;
+        CalibrationRegisters r = random_calibration(random);
+        reference::Calibration expected(r.temperature_pressure, r.humidity);
+        sc::BME280Calibration calibration;
+        calibration.load(r.temperature_pressure, r.humidity);
+
+        const std::size_t Count = 10007;
+        std::vector<uint8_t> frames(Count * sc::BME280Raw::FrameBytes);
+        for (std::size_t i = 0; i < Count; ++i)
+            put_frame(static_cast<int32_t>(next(random) & 0xfffff), random_raw_temperature(random, expected), static_cast<int32_t>(next(random) & 0xffff), &frames[i * sc::BME280Raw::FrameBytes]);
+
+        std::vector<int32_t> temperature(Count), temperature_only(Count);
+        std::vector<uint32_t> pressure(Count), humidity(Count);
+        sc::bme280_compensate(calibration, Count, frames.data(), temperature.data(), pressure.data(), humidity.data());
+        sc::bme280_compensate(calibration, Count, frames.data(), temperature_only.data());
+
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i < Count; ++i)
+        {
+            sc::BME280Raw raw = sc::BME280Raw::from_frame(&frames[i * sc::BME280Raw::FrameBytes]);
+            int32_t t_fine;
+            int32_t t = reference::BME280_compensate_T_int32(expected, raw.temperature, t_fine);
+            mismatches += (temperature[i] != t || temperature_only[i] != t);
+            mismatches += (pressure[i] != reference::BME280_compensate_P_int64(expected, raw.pressure, t_fine));
+            mismatches += (humidity[i] != reference::bme280_compensate_H_int32(expected, raw.humidity, t_fine));
+        }
+        CHECK_EQUAL(mismatches, 0);
+    }
+
+    // dig_P1が0の場合は0で割らずに0を返す
+    {
+        const int16_t p[8] = {-10685, 3024, 2855, 140, -7, 15500, -14600, 6000};
+        CalibrationRegisters r = registers(27504, 26435, -1000, 0, p, 75, 362, 0, 313, 50, 30);
+        sc::BME280Calibration calibration;
+        calibration.load(r.temperature_pressure, r.humidity);
+        CHECK_EQUAL(calibration.pressure(415148, 128422), 0);
+    }
+
+    return check::result();
+}
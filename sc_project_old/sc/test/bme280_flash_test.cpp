@@ -0,0 +1,153 @@
+// BME280の補正用データをフラッシュに保存する動作のテスト  シミュレーション上のI2C(400kHz)に接続したBME280を使う
+// 初めての起動や照合で一致しなかった場合も，セットアップや measure の中ではフラッシュを消去・書き込みせず，store_pending_calibration で保存することを確認する
+#include <cstring>
+
+#include "bme280.hpp"
+#include "check.hpp"
+#include "fake_sdk.hpp"
+
+namespace
+{
+    const uint8_t BME280Addr = 0x76;
+    const int MaxVerifyMeasures = 10;  // 照合が終わるまでに measure を呼び出す回数の上限
+
+    // データシート(BMP280)の計算例の補正用データ  湿度はよくある値
+    const uint8_t TemperaturePressure[sc::BME280Calibration::TemperaturePressureBytes] = {
+        0x70, 0x6b, 0x43, 0x67, 0x18, 0xfc, 0x7d, 0x8e, 0x43, 0xd6, 0xd0, 0x0b, 0x27, 0x0b, 0x8c, 0x00,
+        0xf9, 0xff, 0x8c, 0x3c, 0xf8, 0xc6, 0x70, 0x17, 0x00, 0x4b};
+    const uint8_t Humidity[sc::BME280Calibration::HumidityBytes] = {0x6a, 0x01, 0x00, 0x13, 0x29, 0x03, 0x1e};
+
+    // シミュレーション上のBME280のレジスタに，チップID・補正用データ・生データを書き込む
+    uint8_t* connect_bme280(i2c_inst_t* i2c, uint8_t addr)
+    {
+        uint8_t* memory = fake::i2c_device(i2c, addr);
+        memory[0xd0] = 0x60;
+        std::memcpy(memory + 0x88, TemperaturePressure, sizeof(TemperaturePressure));
+        std::memcpy(memory + 0xe1, Humidity, sizeof(Humidity));
+        const uint8_t frame[sc::BME280Raw::FrameBytes] = {0x65, 0x5a, 0xc0, 0x7e, 0xed, 0x00, 0x75, 0x30};  // adc_P=415148, adc_T=519888, adc_H=30000
+        std::memcpy(memory + 0xf7, frame, sizeof(frame));
+        return memory;
+    }
+
+    // センサのレジスタの補正用データから補正した結果
+    sc::BME280Data expected_data(const uint8_t* memory)
+    {
+        sc::BME280Calibration calibration;
+        calibration.load(memory + 0x88, memory + 0xe1);
+        return calibration.compensate(sc::BME280Raw::from_frame(memory + 0xf7));
+    }
+
+    // 照合が終わるか，保存し直す必要が出るまで measure を呼び出す
+    void measure_until_verified(sc::BME280& bme280)
+    {
+        for (int i = 0; i < MaxVerifyMeasures && !bme280.calibration_verified() && !bme280.calibration_store_pending(); ++i) bme280.measure();
+    }
+}
+
+int main()
+{
+    sc::I2C i2c(false, sc::Pin(4), sc::Pin(5), 400000);
+    uint8_t* memory = connect_bme280(i2c0, BME280Addr);
+
+    // 初めての起動では，センサから読み込む  セットアップの中では書き込まず，store_pending_calibration で1ページ書き込む
+    {
+        sc::BME280 bme280(i2c, BME280Addr);
+        CHECK_EQUAL(fake::flash_programs(), 0);
+        CHECK(bme280.calibration_verified());
+        CHECK(bme280.calibration_store_pending());
+        bme280.measure();
+        CHECK_EQUAL(fake::flash_programs(), 0);
+        CHECK(bme280.store_pending_calibration());
+        CHECK_EQUAL(fake::flash_programs(), 1);
+        CHECK_EQUAL(fake::flash_erases(), 0);
+        CHECK(!bme280.calibration_store_pending());
+    }
+
+    // 同じセンサで起動し直すと，フラッシュから読み込み，measure のたびに照合して一致する  書き込みはしない
+    {
+        sc::BME280 bme280(i2c, BME280Addr);
+        CHECK(!bme280.calibration_verified());
+        measure_until_verified(bme280);
+        CHECK(bme280.calibration_verified());
+        CHECK(!bme280.calibration_store_pending());
+        CHECK_EQUAL(fake::flash_programs(), 1);
+        CHECK_EQUAL(bme280.data().temperature, expected_data(memory).temperature);
+    }
+
+    // センサを交換した(補正用データが変わった)場合は，measure の中では読み込み直すだけで，フラッシュには触れない
+    memory[0x88] ^= 0x10;
+    {
+        sc::BME280 bme280(i2c, BME280Addr);
+        measure_until_verified(bme280);
+        CHECK(bme280.calibration_store_pending());
+        CHECK_EQUAL(fake::flash_programs(), 1);
+        CHECK_EQUAL(fake::flash_erases(), 0);
+        bme280.measure();
+        sc::BME280Data expected = expected_data(memory);
+        CHECK_EQUAL(bme280.data().temperature, expected.temperature);
+        CHECK_EQUAL(bme280.data().pressure, expected.pressure);
+
+        // もう一方のコアを止められなかった場合は書き込まず，後で呼び出し直せる
+        fake::set_flash_safe_execute_result(PICO_ERROR_TIMEOUT);
+        CHECK(!bme280.store_pending_calibration());
+        CHECK(bme280.calibration_store_pending());
+        CHECK_EQUAL(fake::flash_programs(), 1);
+        fake::set_flash_safe_execute_result(PICO_OK);
+
+        CHECK(bme280.store_pending_calibration());
+        CHECK(!bme280.calibration_store_pending());
+        CHECK_EQUAL(fake::flash_programs(), 2);
+        CHECK(bme280.store_pending_calibration());  // 必要がなければ何もしない
+        CHECK_EQUAL(fake::flash_programs(), 2);
+    }
+
+    // 保存し直した補正用データで起動すると一致する
+    {
+        sc::BME280 bme280(i2c, BME280Addr);
+        measure_until_verified(bme280);
+        CHECK(bme280.calibration_verified());
+        CHECK(!bme280.calibration_store_pending());
+        CHECK_EQUAL(fake::flash_programs(), 2);
+    }
+
+    // セクタが一杯になると，store_pending_calibration の中で消去してから書き込む
+    for (uint32_t i = 2; i <= FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE; ++i)
+    {
+        memory[0x89] = static_cast<uint8_t>(i);
+        sc::BME280 bme280(i2c, BME280Addr);
+        measure_until_verified(bme280);
+        CHECK(bme280.calibration_store_pending());
+        CHECK(bme280.store_pending_calibration());
+    }
+    CHECK_EQUAL(fake::flash_erases(), 1);
+    CHECK_EQUAL(fake::flash_programs(), FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE + 1);
+
+    // I2C0とI2C1の同じアドレスに補正用データの違うセンサを接続しても，互いの記録を読み込まない
+    // 2回目の起動からはどちらもフラッシュの記録と一致し，書き込みも消去もしない
+    {
+        sc::I2C i2c1_master(true, sc::Pin(3), sc::Pin(2), 400000);
+        uint8_t* other = connect_bme280(i2c1, BME280Addr);
+        other[0x8a] ^= 0x20;
+        sc::BME280 first0(i2c, BME280Addr);
+        sc::BME280 first1(i2c1_master, BME280Addr);
+        CHECK(first1.calibration_verified());  // I2C0の記録を読み込まず，センサから読み込む
+        CHECK(first1.calibration_store_pending());
+        CHECK(first1.store_pending_calibration());
+        uint32_t programs = fake::flash_programs();
+        uint32_t erases = fake::flash_erases();
+        for (int boot = 0; boot < 3; ++boot)
+        {
+            sc::BME280 bme280_0(i2c, BME280Addr);
+            sc::BME280 bme280_1(i2c1_master, BME280Addr);
+            measure_until_verified(bme280_0);
+            measure_until_verified(bme280_1);
+            CHECK(bme280_0.calibration_verified() && !bme280_0.calibration_store_pending());
+            CHECK(bme280_1.calibration_verified() && !bme280_1.calibration_store_pending());
+            CHECK_EQUAL(bme280_1.data().temperature, expected_data(other).temperature);
+        }
+        CHECK_EQUAL(fake::flash_programs(), programs);
+        CHECK_EQUAL(fake::flash_erases(), erases);
+    }
+
+    return check::result();
+}
@@ -0,0 +1,107 @@
+// bme280_compensate_parallelのスレッド数による処理速度の変化の測定
+// 1回の飛行の記録より十分大きいログ(4M個の生データ)を，スレッド数を変えて補正し，1スレッドの場合からの速さの比を求める
+// 結果がbme280_compensateと1ビットも違わないことも確認する  (スレッドの分担の境目を含む)
+// 速さの比は実行するパソコンのCPUの数で決まる  CPUが1つの場合はスレッドを増やしても速くならない
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "bme280_compensation.hpp"
+#include "check.hpp"
+
+namespace
+{
+    const std::size_t Count = 4 << 20;  // 生データの数
+    const int Repeats = 3;  // 測定を繰り返す回数  最も速かった回を結果とする
+
+    // 補正した結果
+    struct Output
+    {
+        std::vector<int32_t> temperature;
+        std::vector<uint32_t> pressure, humidity;
+
+        explicit Output(std::size_t count): temperature(count), pressure(count), humidity(count) {}
+
+        bool operator==(const Output& other) const
+        {
+            return temperature == other.temperature && pressure == other.pressure && humidity == other.humidity;
+        }
+    };
+
+    // threads個のスレッドで補正し，かかった時間(ms)を返す
+    double measure(const sc::BME280Calibration& calibration, const std::vector<uint8_t>& frames, std::size_t count, unsigned threads, Output& output)
+    {
+        double best = 1e30;
+        for (int repeat = 0; repeat < Repeats; ++repeat)
+        {
+            auto start = std::chrono::steady_clock::now();
+            sc::bme280_compensate_parallel(calibration, count, frames.data(), output.temperature.data(), output.pressure.data(), output.humidity.data(), threads);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (ms < best) best = ms;
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    // データシート(BMP280)の計算例の補正用データ
+    const uint8_t temperature_pressure[sc::BME280Calibration::TemperaturePressureBytes] = {
+        0x70, 0x6b, 0x43, 0x67, 0x18, 0xfc, 0x7d, 0x8e, 0x43, 0xd6, 0xd0, 0x0b, 0x27, 0x0b, 0x8c, 0x00,
+        0xf9, 0xff, 0x8c, 0x3c, 0xf8, 0xc6, 0x70, 0x17, 0x00, 0x4b};
+    const uint8_t humidity[sc::BME280Calibration::HumidityBytes] = {0x6a, 0x01, 0x00, 0x13, 0x29, 0x03, 0x1e};
+    sc::BME280Calibration calibration;
+    calibration.load(temperature_pressure, humidity);
+
+    std::vector<uint8_t> frames(Count * sc::BME280Raw::FrameBytes);
+    uint32_t random = 1;
+    for (std::size_t i = 0; i < Count; ++i)
+    {
+        random = random * 1103515245 + 12345;
+        uint32_t raw_pressure = 250000 + (random >> 8) % 200000;
+        uint32_t raw_temperature = 480000 + (random >> 12) % 80000;
+        uint32_t raw_humidity = 20000 + (random >> 16) % 20000;
+        uint8_t* frame = &frames[i * sc::BME280Raw::FrameBytes];
+        frame[0] = raw_pressure >> 12;
+        frame[1] = raw_pressure >> 4;
+        frame[2] = (raw_pressure & 0x0f) << 4;
+        frame[3] = raw_temperature >> 12;
+        frame[4] = raw_temperature >> 4;
+        frame[5] = (raw_temperature & 0x0f) << 4;
+        frame[6] = raw_humidity >> 8;
+        frame[7] = raw_humidity & 0xff;
+    }
+
+    // 1スレッドでの結果を基準にする
+    Output expected(Count);
+    sc::bme280_compensate(calibration, Count, frames.data(), expected.temperature.data(), expected.pressure.data(), expected.humidity.data());
+
+    unsigned cpus = std::thread::hardware_concurrency();
+    std::printf("compensating %u samples with bme280_compensate_parallel (%u hardware threads, best of %d)\n", static_cast<unsigned>(Count), cpus, Repeats);
+    double single_ms = 0;
+    const unsigned Threads[] = {1, 2, 4, 8, 0};
+    for (unsigned threads : Threads)
+    {
+        Output output(Count);
+        double ms = measure(calibration, frames, Count, threads, output);
+        if (threads == 1) single_ms = ms;
+        std::printf("  threads %u%-7s %8.2f ms  %6.2f ns/sample  %.2fx vs 1 thread\n",
+                    threads, threads ? "" : " (auto)", ms, ms * 1e6 / Count, single_ms / ms);
+        CHECK(output == expected);
+    }
+    if (cpus <= 1) std::printf("  only one hardware thread is available, so no speed-up is expected here\n");
+
+    // スレッドの分担の境目(16ブロック=4096個ごと)の前後の数でも，結果は同じ
+    const std::size_t Counts[] = {1, 255, 256, 4095, 4096, 4097, 3 * 4096 + 17};
+    for (std::size_t count : Counts)
+    {
+        Output output(count);
+        sc::bme280_compensate_parallel(calibration, count, frames.data(), output.temperature.data(), output.pressure.data(), output.humidity.data(), 3);
+        Output single(count);
+        sc::bme280_compensate(calibration, count, frames.data(), single.temperature.data(), single.pressure.data(), single.humidity.data());
+        CHECK(output == single);
+    }
+
+    return check::result();
+}
@@ -0,0 +1,104 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_BME280_REFERENCE_HPP_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_BME280_REFERENCE_HPP_
+
+// BME280のデータシートに載っている補正の計算 (4.2.3 Compensation formulas, 8.2 Pressure compensation in 64 bit format)
+// sc::BME280Calibrationの計算と結果が1ビットも違わないことを確かめるための基準として，データシートのコードをそのまま使う
+#include <cstdint>
+
+namespace reference
+{
+    typedef int32_t BME280_S32_t;
+    typedef uint32_t BME280_U32_t;
+    typedef int64_t BME280_S64_t;
+
+    // データシートの補正用データ  (Table 16, 0xE4〜0xE6の並びはBosch社のドライバ(BME280_driver)と同じ読み方)
+    struct Calibration
+    {
+        uint16_t dig_T1;
+        int16_t dig_T2, dig_T3;
+        uint16_t dig_P1;
+        int16_t dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;
+        uint8_t dig_H1;
+        int16_t dig_H2;
+        uint8_t dig_H3;
+        int16_t dig_H4, dig_H5;
+        int8_t dig_H6;
+
+        // 0x88〜0xA1 の26バイトと 0xE1〜0xE7 の7バイトから読み込む
+        Calibration(const uint8_t* tp, const uint8_t* h)
+        {
+            dig_T1 = static_cast<uint16_t>(tp[0] | tp[1] << 8);
+            dig_T2 = static_cast<int16_t>(tp[2] | tp[3] << 8);
+            dig_T3 = static_cast<int16_t>(tp[4] | tp[5] << 8);
+            dig_P1 = static_cast<uint16_t>(tp[6] | tp[7] << 8);
+            dig_P2 = static_cast<int16_t>(tp[8] | tp[9] << 8);
+            dig_P3 = static_cast<int16_t>(tp[10] | tp[11] << 8);
+            dig_P4 = static_cast<int16_t>(tp[12] | tp[13] << 8);
+            dig_P5 = static_cast<int16_t>(tp[14] | tp[15] << 8);
+            dig_P6 = static_cast<int16_t>(tp[16] | tp[17] << 8);
+            dig_P7 = static_cast<int16_t>(tp[18] | tp[19] << 8);
+            dig_P8 = static_cast<int16_t>(tp[20] | tp[21] << 8);
+            dig_P9 = static_cast<int16_t>(tp[22] | tp[23] << 8);
+            dig_H1 = tp[25];
+            dig_H2 = static_cast<int16_t>(h[0] | h[1] << 8);
+            dig_H3 = h[2];
+            dig_H4 = static_cast<int16_t>(static_cast<int16_t>(static_cast<int8_t>(h[3])) * 16 | (h[4] & 0x0f));
+            dig_H5 = static_cast<int16_t>(static_cast<int16_t>(static_cast<int8_t>(h[5])) * 16 | (h[4] >> 4));
+            dig_H6 = static_cast<int8_t>(h[6]);
+        }
+    };
+
+    // Returns temperature in DegC, resolution is 0.01 DegC. Output value of "5123" equals 51.23 DegC.
+    // t_fine carries fine temperature as global value
+    inline BME280_S32_t BME280_compensate_T_int32(const Calibration& c, BME280_S32_t adc_T, BME280_S32_t& t_fine)
+    {
+        BME280_S32_t var1, var2, T;
+        var1 = ((((adc_T>>3) - ((BME280_S32_t)c.dig_T1<<1))) * ((BME280_S32_t)c.dig_T2)) >> 11;
+        var2 = (((((adc_T>>4) - ((BME280_S32_t)c.dig_T1)) * ((adc_T>>4) - ((BME280_S32_t)c.dig_T1))) >> 12) *
+            ((BME280_S32_t)c.dig_T3)) >> 14;
+        t_fine = var1 + var2;
+        T = (t_fine * 5 + 128) >> 8;
+        return T;
+    }
+
+    // Returns pressure in Pa as unsigned 32 bit integer in Q24.8 format (24 integer bits and 8 fractional bits).
+    // Output value of "24674867" represents 24674867/256 = 96386.2 Pa = 963.862 hPa
+    inline BME280_U32_t BME280_compensate_P_int64(const Calibration& c, BME280_S32_t adc_P, BME280_S32_t t_fine)
+    {
+        BME280_S64_t var1, var2, p;
+        var1 = ((BME280_S64_t)t_fine) - 128000;
+        var2 = var1 * var1 * (BME280_S64_t)c.dig_P6;
+        var2 = var2 + ((var1*(BME280_S64_t)c.dig_P5)<<17);
+        var2 = var2 + (((BME280_S64_t)c.dig_P4)<<35);
+        var1 = ((var1 * var1 * (BME280_S64_t)c.dig_P3)>>8) + ((var1 * (BME280_S64_t)c.dig_P2)<<12);
+        var1 = (((((BME280_S64_t)1)<<47)+var1))*((BME280_S64_t)c.dig_P1)>>33;
+        if (var1 == 0)
+        {
+            return 0; // avoid exception caused by division by zero
+        }
+        p = 1048576-adc_P;
+        p = (((p<<31)-var2)*3125)/var1;
+        var1 = (((BME280_S64_t)c.dig_P9) * (p>>13) * (p>>13)) >> 25;
+        var2 = (((BME280_S64_t)c.dig_P8) * p) >> 19;
+        p = ((p + var1 + var2) >> 8) + (((BME280_S64_t)c.dig_P7)<<4);
+        return (BME280_U32_t)p;
+    }
+
+    // Returns humidity in %RH as unsigned 32 bit integer in Q22.10 format (22 integer and 10 fractional bits).
+    // Output value of "47445" represents 47445/1024 = 46.333 %RH
+    inline BME280_U32_t bme280_compensate_H_int32(const Calibration& c, BME280_S32_t adc_H, BME280_S32_t t_fine)
+    {
+        BME280_S32_t v_x1_u32r;
+        v_x1_u32r = (t_fine - ((BME280_S32_t)76800));
+        v_x1_u32r = (((((adc_H << 14) - (((BME280_S32_t)c.dig_H4) << 20) - (((BME280_S32_t)c.dig_H5) * v_x1_u32r)) +
+            ((BME280_S32_t)16384)) >> 15) * (((((((v_x1_u32r * ((BME280_S32_t)c.dig_H6)) >> 10) * (((v_x1_u32r *
+            ((BME280_S32_t)c.dig_H3)) >> 11) + ((BME280_S32_t)32768))) >> 10) + ((BME280_S32_t)2097152)) *
+            ((BME280_S32_t)c.dig_H2) + 8192) >> 14));
+        v_x1_u32r = (v_x1_u32r - (((((v_x1_u32r >> 15) * (v_x1_u32r >> 15)) >> 7) * ((BME280_S32_t)c.dig_H1)) >> 4));
+        v_x1_u32r = (v_x1_u32r < 0 ? 0 : v_x1_u32r);
+        v_x1_u32r = (v_x1_u32r > 419430400 ? 419430400 : v_x1_u32r);
+        return (BME280_U32_t)(v_x1_u32r>>12);
+    }
+}
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_BME280_REFERENCE_HPP_
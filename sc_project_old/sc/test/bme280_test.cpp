@@ -0,0 +1,175 @@
+// BME280の測定のテスト  シミュレーション上のI2C(400kHz)に接続したBME280を使う
+// 強制モードで start_measurement → is_ready → measure と呼び出したときに，余分な通信や待機をしないことを確認する
+#include <cstring>
+
+#include "bme280.hpp"
+#include "check.hpp"
+#include "fake_sdk.hpp"
+
+namespace
+{
+    const uint8_t BME280Addr = 0x76;
+
+    // データシート(BMP280)の計算例の補正用データ  湿度はよくある値
+    const uint8_t TemperaturePressure[sc::BME280Calibration::TemperaturePressureBytes] = {
+        0x70, 0x6b, 0x43, 0x67, 0x18, 0xfc, 0x7d, 0x8e, 0x43, 0xd6, 0xd0, 0x0b, 0x27, 0x0b, 0x8c, 0x00,
+        0xf9, 0xff, 0x8c, 0x3c, 0xf8, 0xc6, 0x70, 0x17, 0x00, 0x4b};
+    const uint8_t Humidity[sc::BME280Calibration::HumidityBytes] = {0x6a, 0x01, 0x00, 0x13, 0x29, 0x03, 0x1e};
+
+    // シミュレーション上のBME280のレジスタに，チップID・補正用データ・生データを書き込む
+    uint8_t* connect_bme280(i2c_inst_t* i2c, uint8_t addr)
+    {
+        uint8_t* memory = fake::i2c_device(i2c, addr);
+        memory[0xd0] = 0x60;
+        std::memcpy(memory + 0x88, TemperaturePressure, sizeof(TemperaturePressure));
+        std::memcpy(memory + 0xe1, Humidity, sizeof(Humidity));
+        const uint8_t frame[sc::BME280Raw::FrameBytes] = {0x65, 0x5a, 0xc0, 0x7e, 0xed, 0x00, 0x75, 0x30};  // adc_P=415148, adc_T=519888, adc_H=30000
+        std::memcpy(memory + 0xf7, frame, sizeof(frame));
+        return memory;
+    }
+
+    // 前回呼び出してから増えた通信の数
+    uint32_t new_transactions()
+    {
+        static uint32_t last = 0;
+        uint32_t transactions = fake::i2c_transactions(i2c0);
+        uint32_t added = transactions - last;
+        last = transactions;
+        return added;
+    }
+}
+
+int main()
+{
+    sc::I2C i2c(false, sc::Pin(4), sc::Pin(5), 400000);
+    uint8_t* memory = connect_bme280(i2c0, BME280Addr);
+    sc::BME280 bme280(i2c, BME280Addr);
+    bme280.set_forced_mode(sc::BME280::OSRS_x16, sc::BME280::OSRS_x16, sc::BME280::OSRS_x16);
+    const uint32_t conversion_us = bme280.conversion_time_us();
+    CHECK_EQUAL(conversion_us, 1250 + 3 * 2300 * 16 + 2 * 575);
+
+    // 変換を開始し，終わるまで is_ready で待ってから読み込む  measure では0xF4を書き込み直さず，読み込みの1回だけ通信する
+    for (int repeat = 0; repeat < 3; ++repeat)
+    {
+        new_transactions();
+        bme280.start_measurement();
+        CHECK_EQUAL(new_transactions(), 2);  // 0xF4の書き込み (I2Cの write_byte_mem はアドレスとデータを別々に送る)
+        bme280.start_measurement();  // 変換中は何もしない
+        CHECK(!bme280.is_ready());  // 変換にかかる最大の時間が経つまでは通信しない
+        CHECK_EQUAL(new_transactions(), 0);
+
+        fake::run_for_us(conversion_us);
+        uint32_t polls = bme280.status_polls();
+        CHECK(bme280.is_ready());
+        CHECK_EQUAL(bme280.status_polls(), polls + 1);
+        CHECK(bme280.is_ready());  // 読み込むまでは通信せずにtrue
+        bme280.start_measurement();  // 読み込んでいない結果があるときは何もしない
+        CHECK_EQUAL(new_transactions(), 1);  // 0xF3の読み込み
+
+        uint64_t start_ns = fake::now_ns();
+        bme280.measure();
+        CHECK_EQUAL(new_transactions(), 1);  // 0xF7〜0xFEの読み込みだけ
+        CHECK(fake::now_ns() - start_ns < 1000000);  // 変換を待たない (8バイトの読み込みは約0.3ms)
+        CHECK(bme280.temperature() > 25.07 && bme280.temperature() < 25.09);
+        CHECK(!bme280.is_ready());  // 読み込んだら次の変換を開始するまではfalse
+        CHECK_EQUAL(new_transactions(), 0);
+    }
+
+    // start_measurement を呼び出さずに measure を呼び出すと，変換を開始して最大の時間だけ待ってから読み込む
+    {
+        new_transactions();
+        uint64_t start_ns = fake::now_ns();
+        bme280.measure();
+        uint64_t elapsed_us = (fake::now_ns() - start_ns) / 1000;
+        CHECK(elapsed_us >= conversion_us && elapsed_us < conversion_us + 2000);
+        CHECK_EQUAL(new_transactions(), 4);  // 0xF4の書き込み(2回)，0xF3の読み込み，0xF7〜0xFEの読み込み
+        CHECK(bme280.temperature() > 25.07 && bme280.temperature() < 25.09);
+    }
+
+    // 状態レジスタの変換中のビットが消えなくても，measure は変換にかかる最大の時間の2倍ほどで諦めて戻る
+    {
+        memory[0xf3] = 0x08;
+        uint64_t start_ns = fake::now_ns();
+        bme280.measure();
+        uint64_t elapsed_us = (fake::now_ns() - start_ns) / 1000;
+        CHECK(elapsed_us >= 2 * conversion_us && elapsed_us < 2 * conversion_us + 2000);
+        CHECK(bme280.temperature() == sc::ErrorValue);  // 測定できなかった
+        CHECK(!bme280.is_ready());
+
+        // ビットが消えれば，次の measure では変換を開始し直して読み込める
+        memory[0xf3] = 0x00;
+        new_transactions();
+        bme280.measure();
+        CHECK_EQUAL(new_transactions(), 4);
+        CHECK(bme280.temperature() > 25.07 && bme280.temperature() < 25.09);
+    }
+
+    // 設定をテンプレート引数で固定した BME280Fixed も，強制モードでは BME280 と同じように待機せずに読み込める
+    // 測定しない湿度は読み込まず，0xF7〜0xFCの6バイトだけを読み込む
+    {
+        typedef sc::BME280Config<sc::BME280::MODE_FORCED, sc::BME280::OSRS_x2, sc::BME280::OSRS_x4, sc::BME280::OSRS_SKIPPED> Config;
+        static_assert(Config::ReadAddress == 0xf7 && Config::ReadBytes == 6, "read temperature and pressure only");
+        sc::BME280Fixed<Config> fixed(i2c, BME280Addr);
+        for (int i = 0; i < 10 && !fixed.calibration_verified(); ++i) fixed.measure();  // フラッシュの補正用データとの照合を済ませておく
+        CHECK(fixed.calibration_verified());
+        CHECK_EQUAL(fixed.conversion_time_us(), 1250 + 2300 * 2 + 2300 * 4 + 575);
+
+        new_transactions();
+        fixed.start_measurement();
+        fake::run_for_us(Config::ConversionTimeUs);
+        CHECK(fixed.is_ready());
+        CHECK_EQUAL(new_transactions(), 3);  // 0xF4の書き込み(2回)，0xF3の読み込み
+        uint64_t start_ns = fake::now_ns();
+        fixed.measure();
+        CHECK_EQUAL(new_transactions(), 1);
+        CHECK(fake::now_ns() - start_ns < 1000000);
+        CHECK(fixed.temperature() > 25.07 && fixed.temperature() < 25.09);
+        CHECK(fixed.pressure() > 1000.0 && fixed.pressure() < 1020.0);
+        CHECK(fixed.humidity() == sc::ErrorValue);
+
+        // 状態レジスタの変換中のビットが消えなくても戻る
+        memory[0xf3] = 0x08;
+        start_ns = fake::now_ns();
+        fixed.measure();
+        uint64_t elapsed_us = (fake::now_ns() - start_ns) / 1000;
+        CHECK(elapsed_us >= 2 * Config::ConversionTimeUs && elapsed_us < 2 * Config::ConversionTimeUs + 2000);
+        CHECK(fixed.temperature() == sc::ErrorValue);
+        memory[0xf3] = 0x00;
+    }
+
+    // ノーマルモードでは変換を待たずに読み込むだけ  測定しない気圧は読み込まず，0xFA〜0xFEの5バイトだけを読み込む
+    {
+        typedef sc::BME280Config<sc::BME280::MODE_NORMAL, sc::BME280::OSRS_x1, sc::BME280::OSRS_SKIPPED, sc::BME280::OSRS_x1> Config;
+        static_assert(Config::ReadAddress == 0xfa && Config::ReadBytes == 5, "read temperature and humidity only");
+        sc::BME280Fixed<Config> fixed(i2c, BME280Addr);
+        for (int i = 0; i < 10 && !fixed.calibration_verified(); ++i) fixed.measure();
+        CHECK(fixed.calibration_verified());
+
+        new_transactions();
+        uint64_t start_ns = fake::now_ns();
+        fixed.measure();
+        CHECK_EQUAL(new_transactions(), 1);
+        CHECK(fake::now_ns() - start_ns < 1000000);
+        CHECK(fixed.temperature() > 25.07 && fixed.temperature() < 25.09);
+        CHECK(fixed.pressure() == sc::ErrorValue);
+        CHECK(fixed.humidity() > 0.0 && fixed.humidity() < 100.0);
+    }
+
+    // センサが接続されていない場合も，セットアップで例外を投げず，measure は測定できなかったことを返す
+    {
+        bool thrown = false;
+        try
+        {
+            sc::BME280 absent(i2c, BME280Addr + 1);
+            absent.measure();
+            CHECK(absent.temperature() == sc::ErrorValue);
+        }
+        catch(const std::exception&)
+        {
+            thrown = true;
+        }
+        CHECK(!thrown);
+    }
+
+    return check::result();
+}
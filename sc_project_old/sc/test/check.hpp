@@ -0,0 +1,55 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_CHECK_HPP_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_CHECK_HPP_
+
+// テストで使う確認用のマクロ
+// 失敗しても止めずに数え，最後に check::result() の戻り値をmainから返す
+#include <cstdio>
+
+namespace check
+{
+    inline int& failures()
+    {
+        static int failures = 0;
+        return failures;
+    }
+
+    inline bool expect(bool ok, const char* expression, const char* file, int line)
+    {
+        if (!ok)
+        {
+            std::printf("FAILED  %s:%d  %s\n", file, line, expression);
+            ++failures();
+        }
+        return ok;
+    }
+
+    inline bool expect_equal(long long actual, long long expected, const char* expression, const char* file, int line)
+    {
+        if (actual != expected)
+        {
+            std::printf("FAILED  %s:%d  %s  (actual: %lld, expected: %lld)\n", file, line, expression, actual, expected);
+            ++failures();
+        }
+        return actual == expected;
+    }
+
+    // 戻り値 : mainから返す終了コード
+    inline int result()
+    {
+        if (failures())
+        {
+            std::printf("%d check(s) failed\n", failures());
+    return 1;
+        }
+        std::printf("all checks passed\n");
+        return 0;
+    }
+}
+
+// 条件が成り立つかを確認する
+#define CHECK(expression) check::expect((expression), #expression, __FILE__, __LINE__)
+
+// 整数の値が一致するかを確認する  (一致しない場合は両方の値を表示する)
+#define CHECK_EQUAL(actual, expected) check::expect_equal(static_cast<long long>(actual), static_cast<long long>(expected), #actual " == " #expected, __FILE__, __LINE__)
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_CHECK_HPP_
@@ -0,0 +1,1272 @@
+#include "fake_sdk.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include "hardware/irq.h"
+
+// RP2040の周辺機能のシミュレーション  使い方と実機との違いは fake_sdk.hpp を参照
+namespace
+{
+    /**************************************************/
+    /*********************時刻と予定*********************/
+    /**************************************************/
+
+    uint64_t Now = 0;  // シミュレーション上の時刻 (ns)
+    uint64_t TimeLimit = 600000000000ULL;  // これを超えたら止まったとみなす (ns)
+    std::multimap<uint64_t, std::function<void()>> Events;  // 時刻ごとの予定  同じ時刻の予定は追加した順に実行する
+
+    [[noreturn]] void fail(const char* message)
+    {
+        std::fprintf(stderr, "fake_sdk: %s (t=%lluus)\n", message, static_cast<unsigned long long>(Now / 1000));
+        std::abort();
+    }
+
+    void schedule(uint64_t time, std::function<void()> action)
+    {
+        Events.emplace(time, std::move(action));
+    }
+
+    /**************************************************/
+    /***********************割り込み**********************/
+    /**************************************************/
+
+    const uint IrqNum = 32;
+
+    struct Irq
+    {
+        bool enabled = false;
+        std::vector<irq_handler_t> handlers;
+        uint32_t count = 0;
+    };
+    Irq Irqs[IrqNum];
+    bool InterruptsEnabled = true;
+    int IrqDepth = 0;  // 実行中の割り込み処理の深さ
+    uint CurrentException = 0;  // 実行中の割り込み処理の例外の番号 (16+割り込みの番号)
+
+    struct DueTimer
+    {
+        repeating_timer_t* timer;
+        uint32_t generation;
+        uint64_t time;  // 予定していた時刻
+    };
+    std::deque<DueTimer> DueTimers;  // 時刻になったが，まだコールバック関数を呼び出していないタイマー
+    uint32_t TimerGeneration = 0;
+
+    bool irq_level(uint num);
+    void irq_enter(uint num, uint32_t& seen_flags);
+    void irq_leave(uint num, uint32_t seen_flags);
+
+    // 割り込みが許可されていれば，条件を満たしている割り込み処理をすべて実行する
+    void dispatch_irqs()
+    {
+        if (!InterruptsEnabled || IrqDepth)
+    return;
+        uint64_t storm_time = Now;
+        uint32_t storm_count = 0;
+        for (;;)
+        {
+            if (Now != storm_time) storm_time = Now, storm_count = 0;
+            if (++storm_count > 100000) fail("interrupt storm: a handler does not clear its interrupt");
+
+            if (!DueTimers.empty())
+            {
+                DueTimer due = DueTimers.front();
+                DueTimers.pop_front();
+                if (due.timer->generation != due.generation)
+        continue;  // 取り消されたタイマー
+                ++IrqDepth;
+                InterruptsEnabled = false;
+                CurrentException = 16 + TIMER_IRQ_0;
+                ++Irqs[TIMER_IRQ_0].count;
+                bool again = due.timer->callback(due.timer);
+                CurrentException = 0;
+                InterruptsEnabled = true;
+                --IrqDepth;
+                if (again && due.timer->generation == due.generation)
+                {
+                    int64_t delay_us = due.timer->delay_us;
+                    uint64_t next = (delay_us < 0 ? due.time + static_cast<uint64_t>(-delay_us) * 1000 : Now + static_cast<uint64_t>(delay_us) * 1000);
+                    if (next <= Now) next = Now + 1;
+                    repeating_timer_t* timer = due.timer;
+                    uint32_t generation = due.generation;
+                    schedule(next, [timer, generation, next] {DueTimers.push_back({timer, generation, next});});
+                }
+        continue;
+            }
+
+            uint num = 0;
+            while (num < IrqNum && !(Irqs[num].enabled && !Irqs[num].handlers.empty() && irq_level(num))) ++num;
+            if (num == IrqNum)
+    return;
+
+            uint32_t seen_flags = 0;
+            ++IrqDepth;
+            InterruptsEnabled = false;
+            CurrentException = 16 + num;
+            ++Irqs[num].count;
+            irq_enter(num, seen_flags);
+            std::vector<irq_handler_t> handlers = Irqs[num].handlers;  // 割り込み処理の中で登録を変えてもよいように写す
+            for (irq_handler_t handler : handlers) handler();
+            irq_leave(num, seen_flags);
+            CurrentException = 0;
+            InterruptsEnabled = true;
+            --IrqDepth;
+        }
+    }
+
+    // 予定を実行しながら，時刻をtargetまで進める
+    void advance_to(uint64_t target)
+    {
+        for (;;)
+        {
+            dispatch_irqs();
+            auto it = Events.begin();
+            if (it == Events.end() || it->first > target)
+        break;
+            uint64_t time = it->first;
+            std::function<void()> action = std::move(it->second);
+            Events.erase(it);
+            if (time > Now) Now = time;
+            if (Now > TimeLimit) fail("time limit exceeded: something is waiting forever");
+            action();
+        }
+        if (target > Now) Now = target;
+        if (Now > TimeLimit) fail("time limit exceeded: something is waiting forever");
+        dispatch_irqs();
+    }
+
+    void advance(uint64_t ns)
+    {
+        advance_to(Now + ns);
+    }
+
+    /**************************************************/
+    /*************************DMA************************/
+    /**************************************************/
+
+    struct Channel
+    {
+        bool claimed = false;
+        dma_channel_config config;
+        dma_channel_hw_t hw = {};
+        bool busy = false;
+        uint32_t generation = 0;  // 開始・中止・完了のたびに増やし，古い予定を無視するために使う
+    };
+    Channel Channels[NUM_DMA_CHANNELS];
+    uint32_t DmaInte0 = 0;  // DMA_IRQ_0を発生させるチャンネル
+    uint32_t DmaInts0 = 0;  // DMA_IRQ_0が発生しているチャンネル
+
+    void dma_start(uint channel);
+
+    Channel& dma_channel(uint channel)
+    {
+        if (channel >= NUM_DMA_CHANNELS) fail("invalid DMA channel");
+        return Channels[channel];
+    }
+
+    uint element_bytes(const Channel& c)
+    {
+        return 1u << c.config.size;
+    }
+
+    // リング(下位ビットだけを進める)を考慮してアドレスを進める
+    uintptr_t step_addr(uintptr_t addr, uint bytes, bool ring, uint ring_size_bits)
+    {
+        if (!ring || !ring_size_bits)
+    return addr + bytes;
+        uintptr_t mask = (static_cast<uintptr_t>(1) << ring_size_bits) - 1;
+        return (addr & ~mask) | ((addr + bytes) & mask);
+    }
+
+    void dma_finish(uint channel)
+    {
+        Channel& c = Channels[channel];
+        c.busy = false;
+        ++c.generation;
+        if (DmaInte0 & (1u << channel)) DmaInts0 |= (1u << channel);
+        if (c.config.chain_to != channel) dma_start(c.config.chain_to);
+    }
+
+    // 転送回数を1回減らし，0になったら完了とする
+    void dma_count(uint channel)
+    {
+        Channel& c = Channels[channel];
+        c.hw.transfer_count = c.hw.transfer_count - 1;
+        if (!c.hw.transfer_count) dma_finish(channel);
+    }
+
+    // 読み込み元から1要素読み込む  (転送回数は減らさない)
+    uint32_t dma_read_element(uint channel)
+    {
+        Channel& c = Channels[channel];
+        uintptr_t addr = c.hw.read_addr;
+        uint32_t value = 0;
+        switch (element_bytes(c))
+        {
+            case 1: value = *reinterpret_cast<const uint8_t*>(addr); break;
+            case 2: value = *reinterpret_cast<const uint16_t*>(addr); break;
+            default: value = *reinterpret_cast<const uint32_t*>(addr); break;
+        }
+        if (c.config.read_increment) c.hw.read_addr = step_addr(addr, element_bytes(c), !c.config.ring_write, c.config.ring_size_bits);
+        return value;
+    }
+
+    // 書き込み先に1要素書き込む  (転送回数は減らさない)
+    void dma_write_element(uint channel, uint32_t value)
+    {
+        Channel& c = Channels[channel];
+        uintptr_t addr = c.hw.write_addr;
+        switch (element_bytes(c))
+        {
+            case 1: *reinterpret_cast<uint8_t*>(addr) = static_cast<uint8_t>(value); break;
+            case 2: *reinterpret_cast<uint16_t*>(addr) = static_cast<uint16_t>(value); break;
+            default: *reinterpret_cast<uint32_t*>(addr) = value; break;
+        }
+        if (c.config.write_increment) c.hw.write_addr = step_addr(addr, element_bytes(c), c.config.ring_write, c.config.ring_size_bits);
+    }
+
+    int active_channel(uint dreq)
+    {
+        for (uint i = 0; i < NUM_DMA_CHANNELS; ++i)
+            if (Channels[i].claimed && Channels[i].busy && Channels[i].config.dreq == dreq)
+    return i;
+        return -1;
+    }
+
+    /**************************************************/
+    /*************************I2C************************/
+    /**************************************************/
+
+    struct I2CDevice
+    {
+        uint8_t memory[256] = {};
+        uint8_t pointer = 0;  // 次に読み書きするメモリの位置
+    };
+
+    struct I2CBus
+    {
+        i2c_hw_t hw = {};
+        uint baudrate = 100000;
+        std::map<uint8_t, I2CDevice> devices;
+        I2CDevice* device = nullptr;  // 通信中のデバイス  (開始信号の後，停止信号まで)
+        bool first_write = false;  // 開始信号の後，まだ1バイトも書き込んでいない
+        bool executing = false;  // DMAから受け取ったコマンドを実行中
+        std::deque<uint8_t> rx_fifo;  // 受信したが，DMAが受け取っていないデータ
+        uint32_t stolen = 0;
+        uint32_t transactions = 0;
+        uint64_t busy_ns = 0;
+
+        uint64_t bit_ns() const {return 1000000000ULL / baudrate;}
+    };
+    I2CBus I2CBuses[2];
+
+    uint i2c_index(i2c_inst_t* i2c)
+    {
+        return i2c == i2c1 ? 1 : 0;
+    }
+
+    // 受信したデータを，動いているDMAに移す
+    void i2c_drain_rx(uint index)
+    {
+        I2CBus& bus = I2CBuses[index];
+        int channel = active_channel(DREQ_I2C0_RX + 2 * index);
+        while (channel >= 0 && Channels[channel].busy && !bus.rx_fifo.empty())
+        {
+            dma_write_element(channel, bus.rx_fifo.front());
+            bus.rx_fifo.pop_front();
+            dma_count(channel);
+        }
+    }
+
+    void i2c_kick(uint index);
+
+    // DMAから受け取ったコマンド(data_cmdに書き込まれた値)を1つ実行する
+    void i2c_execute(uint index, uint32_t command)
+    {
+        I2CBus& bus = I2CBuses[index];
+        bus.executing = false;
+        if (!bus.device || (command & I2C_IC_DATA_CMD_RESTART_BITS))
+        {
+            auto it = bus.devices.find(bus.hw.tar & 0x7f);
+            if (it == bus.devices.end())
+            {
+                // アドレスに応答がない  エラーの後に停止信号を送り，残りのコマンドは捨てる
+                bus.device = nullptr;
+                bus.hw.tx_abrt_source = 1;
+                bus.hw.raw_intr_stat |= I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS | I2C_IC_RAW_INTR_STAT_STOP_DET_BITS;
+                ++bus.transactions;
+    return;
+            }
+            bus.device = &it->second;
+            bus.first_write = true;
+        }
+
+        if (command & I2C_IC_DATA_CMD_CMD_BITS)
+        {
+            bus.rx_fifo.push_back(bus.device->memory[bus.device->pointer++]);
+            i2c_drain_rx(index);
+        } else if (bus.first_write) {
+            bus.device->pointer = static_cast<uint8_t>(command);
+            bus.first_write = false;
+        } else {
+            bus.device->memory[bus.device->pointer++] = static_cast<uint8_t>(command);
+        }
+
+        if (command & I2C_IC_DATA_CMD_STOP_BITS)
+        {
+            bus.device = nullptr;
+            bus.hw.raw_intr_stat |= I2C_IC_RAW_INTR_STAT_STOP_DET_BITS;
+            ++bus.transactions;
+        }
+        i2c_kick(index);
+    }
+
+    // DMAが送ってくるコマンドがあれば，1つ受け取って実行を予定する
+    void i2c_kick(uint index)
+    {
+        I2CBus& bus = I2CBuses[index];
+        if (bus.executing || (bus.hw.raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS))
+    return;  // エラーのフラグが消えるまでは送信しない
+        int channel = active_channel(DREQ_I2C0_TX + 2 * index);
+        if (channel < 0)
+    return;
+
+        uint32_t command = dma_read_element(channel);
+        dma_count(channel);
+
+        uint64_t bits = 9;
+        if (!bus.device || (command & I2C_IC_DATA_CMD_RESTART_BITS)) bits += 10;  // 開始信号とアドレス
+        if (command & I2C_IC_DATA_CMD_STOP_BITS) bits += 1;
+        uint64_t cost = bits * bus.bit_ns();
+        bus.busy_ns += cost;
+        bus.executing = true;
+        schedule(Now + cost, [index, command] {i2c_execute(index, command);});
+    }
+
+    // 待機する通信  pico-sdkの i2c_write_blocking_internal, i2c_read_blocking_internal と同じく，
+    // 停止信号を送る場合は，停止信号のフラグが立つのを待ってから自分で消す
+    int i2c_blocking(i2c_inst_t* i2c, uint8_t addr, bool read, uint8_t* data, std::size_t len, bool nostop, uint64_t until_ns)
+    {
+        uint index = i2c_index(i2c);
+        I2CBus& bus = I2CBuses[index];
+        if (bus.executing || active_channel(DREQ_I2C0_TX + 2 * index) >= 0) fail("blocking I2C transfer while a DMA transfer is running on the same bus");
+        if (!len) fail("blocking I2C transfer of zero bytes");
+
+        bus.hw.tar = addr;
+        uint64_t cost = (10 + 9 * len + (nostop ? 0 : 1)) * bus.bit_ns();
+        bool timeout = (until_ns && Now + cost > until_ns);
+        auto it = bus.devices.find(addr & 0x7f);
+        if (it == bus.devices.end() || timeout)
+        {
+            uint64_t wait = (timeout ? (until_ns > Now ? until_ns - Now : 0) : 10 * bus.bit_ns());
+            bus.busy_ns += wait;
+            advance(wait);
+            bus.device = nullptr;
+            if (timeout)
+    return PICO_ERROR_TIMEOUT;
+            bus.hw.tx_abrt_source = 1;
+            bus.hw.raw_intr_stat |= I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS | I2C_IC_RAW_INTR_STAT_STOP_DET_BITS;
+            ++bus.transactions;
+            advance(0);  // この間に割り込み処理がフラグを消すと，実機ではNACKを見逃す
+            if ((bus.hw.raw_intr_stat & (I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS | I2C_IC_RAW_INTR_STAT_STOP_DET_BITS)) != (I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS | I2C_IC_RAW_INTR_STAT_STOP_DET_BITS)) ++bus.stolen;
+            bus.hw.raw_intr_stat &= ~(I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS | I2C_IC_RAW_INTR_STAT_STOP_DET_BITS);
+    return PICO_ERROR_GENERIC;
+        }
+
+        I2CDevice& device = it->second;
+        for (std::size_t i = 0; i < len; ++i)
+        {
+            if (read) data[i] = device.memory[device.pointer++];
+            else if (i == 0) device.pointer = data[i];  // 開始信号(再開始信号)の後の最初のバイトは読み書きの位置
+            else device.memory[device.pointer++] = data[i];
+        }
+        bus.busy_ns += cost;
+        advance(cost);
+        if (nostop)
+        {
+            bus.device = &device;
+    return static_cast<int>(len);
+        }
+
+        bus.device = nullptr;
+        bus.hw.raw_intr_stat |= I2C_IC_RAW_INTR_STAT_STOP_DET_BITS;
+        ++bus.transactions;
+        advance(0);  // この間に割り込み処理がフラグを消すと，実機では停止信号を待ち続ける
+        if (!(bus.hw.raw_intr_stat & I2C_IC_RAW_INTR_STAT_STOP_DET_BITS))
+        {
+            ++bus.stolen;
+    return PICO_ERROR_GENERIC;
+        }
+        bus.hw.raw_intr_stat &= ~I2C_IC_RAW_INTR_STAT_STOP_DET_BITS;
+        return static_cast<int>(len);
+    }
+
+    /**************************************************/
+    /*************************SPI************************/
+    /**************************************************/
+
+    struct SPIBus
+    {
+        spi_hw_t hw = {};
+        uint baudrate = 1000000;
+        uint mode = 0;  // CPOLとCPHAから決まるSPIのモード (0〜3)
+        uint32_t setting_writes = 0;  // spi_set_baudrate, spi_set_format を呼び出した回数
+        fake::SPIDevice device = nullptr;
+        void* context = nullptr;
+        bool transferring = false;
+        uint64_t bytes = 0;
+
+        uint8_t exchange(uint8_t output)
+        {
+            ++bytes;
+            return device ? device(output, context) : output;
+        }
+        uint64_t byte_ns() const {return 8000000000ULL / baudrate;}
+    };
+    SPIBus SPIBuses[2];
+
+    uint spi_index(const spi_inst_t* spi)
+    {
+        return spi == spi1 ? 1 : 0;
+    }
+
+    // 送信と受信のDMAが両方動いていれば，転送を予定する
+    void spi_kick(uint index)
+    {
+        SPIBus& bus = SPIBuses[index];
+        if (bus.transferring)
+    return;
+        int tx = active_channel(DREQ_SPI0_TX + 2 * index);
+        int rx = active_channel(DREQ_SPI0_RX + 2 * index);
+        if (tx < 0 || rx < 0)
+    return;
+
+        uint32_t n = Channels[tx].hw.transfer_count;
+        if (Channels[rx].hw.transfer_count < n) n = Channels[rx].hw.transfer_count;
+        uint32_t tx_generation = Channels[tx].generation;
+        uint32_t rx_generation = Channels[rx].generation;
+        bus.transferring = true;
+        schedule(Now + n * bus.byte_ns(), [index, tx, rx, n, tx_generation, rx_generation] {
+            SPIBus& bus = SPIBuses[index];
+            bus.transferring = false;
+            if (Channels[tx].generation != tx_generation || Channels[rx].generation != rx_generation)
+        return;  // 途中で中止された
+            for (uint32_t i = 0; i < n; ++i)
+            {
+                uint8_t input = bus.exchange(static_cast<uint8_t>(dma_read_element(tx)));
+                dma_write_element(rx, input);
+            }
+            for (uint32_t i = 0; i < n; ++i) dma_count(tx);  // 送信が先に終わる
+            for (uint32_t i = 0; i < n; ++i) dma_count(rx);
+            spi_kick(index);
+        });
+    }
+
+    /**************************************************/
+    /************************UART************************/
+    /**************************************************/
+
+    const std::size_t UartFifoSize = 32;
+
+    struct UARTBus
+    {
+        uart_hw_t hw = {};
+        uint baudrate = 115200;
+        std::deque<uint8_t> fifo;  // 受信したが，まだ読み取られていないデータ
+        // uart_receiveで流したが，まだ届いていないデータ
+        struct LineByte
+        {
+            uint8_t data;
+            uint64_t gap_ns;  // 前のバイトが届いてから，このバイトを送り始めるまでに空ける時間
+        };
+        std::deque<LineByte> line;
+        uint64_t next_arrival = 0;  // lineの先頭のバイトが届く時刻
+        uint64_t line_gap_ns = 0;  // lineの2バイト目以降のgap_nsの合計
+        bool arriving = false;  // 届く予定を入れている
+        uint64_t last_arrival = 0;  // 最後にバイトが届いた時刻  受信が途切れたときの割り込み(RXタイムアウト)に使う
+        uint32_t overruns = 0;
+        std::deque<uint8_t> tx_fifo;  // 送信するためにFIFOに書き込んだが，まだ送り始めていないデータ
+        bool sending = false;  // 1バイトを送っている途中
+        std::vector<uint8_t> sent;  // 送信し終えたデータ
+
+        uint64_t byte_ns() const {return 10000000000ULL / baudrate;}
+    };
+    UARTBus UARTBuses[2];
+
+    uint uart_index(uart_inst_t* uart)
+    {
+        return uart == uart1 ? 1 : 0;
+    }
+
+    // FIFOのデータを，動いているDMAに移す  受信時のDMA(RXDMAE)が無効の場合は移さない
+    void uart_drain(uint index)
+    {
+        UARTBus& bus = UARTBuses[index];
+        if (!(bus.hw.dmacr & UART_UARTDMACR_RXDMAE_BITS))
+    return;
+        int channel = active_channel(DREQ_UART0_RX + 2 * index);
+        while (channel >= 0 && Channels[channel].busy && !bus.fifo.empty())
+        {
+            dma_write_element(channel, bus.fifo.front());
+            bus.fifo.pop_front();
+            dma_count(channel);
+        }
+    }
+
+    void uart_arrive(uint index)
+    {
+        UARTBus& bus = UARTBuses[index];
+        bus.arriving = false;
+        if (bus.line.empty())
+    return;
+        if (bus.fifo.size() < UartFifoSize) bus.fifo.push_back(bus.line.front().data);
+        else ++bus.overruns;
+        bus.line.pop_front();
+        bus.last_arrival = Now;
+        schedule(Now + bus.byte_ns() * 32 / 10, [] {});  // 32bit分の時間が経ったら，RXタイムアウトの割り込みの条件を確かめ直す
+        uart_drain(index);
+
+        if (!bus.line.empty())
+        {
+            bus.line_gap_ns -= bus.line.front().gap_ns;
+            bus.next_arrival += bus.line.front().gap_ns + bus.byte_ns();
+            bus.arriving = true;
+            schedule(bus.next_arrival, [index] {uart_arrive(index);});
+        }
+    }
+
+    // 送信のFIFOの先頭のバイトを送り始める  1バイト分の時間が経ったら送信し終え，続きを送る
+    void uart_send_next(uint index)
+    {
+        UARTBus& bus = UARTBuses[index];
+        if (bus.sending || bus.tx_fifo.empty())
+    return;
+        bus.sending = true;
+        uint8_t data = bus.tx_fifo.front();
+        bus.tx_fifo.pop_front();
+        schedule(Now + bus.byte_ns(), [index, data] {
+            UARTBuses[index].sending = false;
+            UARTBuses[index].sent.push_back(data);
+            uart_send_next(index);
+        });
+    }
+
+    // UARTの割り込みの条件
+    // 受信はFIFOが基準の量までたまったとき(RXIM)と，データが残ったまま32bit分の時間受信しなかったとき(RTIM)
+    // 送信はFIFOが基準の量以下になったとき(TXIM)
+    bool uart_irq_level(uint index)
+    {
+        static const std::size_t Levels[] = {4, 8, 16, 24, 28};  // IFLSELごとの基準の量 (1/8〜7/8)
+        const UARTBus& bus = UARTBuses[index];
+        uint32_t tx_select = (bus.hw.ifls & UART_UARTIFLS_TXIFLSEL_BITS) >> UART_UARTIFLS_TXIFLSEL_LSB;
+        if ((bus.hw.imsc & UART_UARTIMSC_TXIM_BITS) && bus.tx_fifo.size() <= Levels[tx_select < 4 ? tx_select : 4])
+    return true;
+        if (bus.fifo.empty())
+    return false;
+        uint32_t rx_select = (bus.hw.ifls & UART_UARTIFLS_RXIFLSEL_BITS) >> UART_UARTIFLS_RXIFLSEL_LSB;
+        bool level = bus.fifo.size() >= Levels[rx_select < 4 ? rx_select : 4];
+        bool timeout = Now >= bus.last_arrival + bus.byte_ns() * 32 / 10;
+        return (level && (bus.hw.imsc & UART_UARTIMSC_RXIM_BITS)) || (timeout && (bus.hw.imsc & UART_UARTIMSC_RTIM_BITS));
+    }
+
+    /**************************************************/
+    /*************************GPIO***********************/
+    /**************************************************/
+
+    const uint GpioNum = 30;
+    bool GpioOut[GpioNum];
+    bool GpioLevel[GpioNum];
+    bool GpioPullUp[GpioNum];
+    bool GpioPullDown[GpioNum];
+
+    uint gpio_index(uint gpio)
+    {
+        if (gpio >= GpioNum) fail("invalid GPIO number");
+        return gpio;
+    }
+
+    /**************************************************/
+    /***********************フラッシュ********************/
+    /**************************************************/
+
+    uint32_t FlashErases = 0;
+    uint32_t FlashPrograms = 0;
+    int FlashSafeExecuteResult = PICO_OK;  // flash_safe_execute の結果
+
+    struct FlashInit
+    {
+        FlashInit() {std::memset(fake_flash_memory, 0xff, sizeof(fake_flash_memory));}
+    };
+
+    /**************************************************/
+    /*********************割り込みの条件*******************/
+    /**************************************************/
+
+    bool irq_level(uint num)
+    {
+        switch (num)
+        {
+            case I2C0_IRQ: return I2CBuses[0].hw.raw_intr_stat & I2CBuses[0].hw.intr_mask;
+            case I2C1_IRQ: return I2CBuses[1].hw.raw_intr_stat & I2CBuses[1].hw.intr_mask;
+            case DMA_IRQ_0: return DmaInts0 & DmaInte0;
+            case UART0_IRQ: return uart_irq_level(0);
+            case UART1_IRQ: return uart_irq_level(1);
+            default: return false;
+        }
+    }
+
+    void irq_enter(uint num, uint32_t& seen_flags)
+    {
+        if (num == I2C0_IRQ || num == I2C1_IRQ)
+        {
+            I2CBus& bus = I2CBuses[num == I2C1_IRQ];
+            seen_flags = bus.hw.raw_intr_stat & bus.hw.intr_mask;
+            bus.hw.intr_stat = seen_flags;
+        }
+    }
+
+    // I2Cのclr_*は読み取りを検出できないので，割り込み処理が見たフラグを処理の後に消す
+    void irq_leave(uint num, uint32_t seen_flags)
+    {
+        if (num == I2C0_IRQ || num == I2C1_IRQ)
+        {
+            uint index = (num == I2C1_IRQ);
+            I2CBus& bus = I2CBuses[index];
+            bus.hw.raw_intr_stat &= ~seen_flags;
+            bus.hw.intr_stat = 0;
+            if (seen_flags & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) i2c_kick(index);
+        }
+        if (num == UART0_IRQ || num == UART1_IRQ) uart_drain(num == UART1_IRQ);  // 割り込み処理の中で受信時のDMAを有効にした場合は，FIFOに残っているデータから移す
+    }
+
+    void dma_start(uint channel)
+    {
+        Channel& c = dma_channel(channel);
+        if (!c.config.enable)
+    return;
+        ++c.generation;
+        c.busy = true;
+        if (!c.hw.transfer_count)
+        {
+            dma_finish(channel);
+    return;
+        }
+
+        uint dreq = c.config.dreq;
+        if (dreq == DREQ_FORCE)
+        {
+            while (c.busy)
+            {
+                dma_write_element(channel, dma_read_element(channel));
+                dma_count(channel);
+            }
+        }
+        else if (dreq == DREQ_I2C0_TX || dreq == DREQ_I2C1_TX) i2c_kick(dreq == DREQ_I2C1_TX);
+        else if (dreq == DREQ_I2C0_RX || dreq == DREQ_I2C1_RX) i2c_drain_rx(dreq == DREQ_I2C1_RX);
+        else if (dreq >= DREQ_SPI0_TX && dreq <= DREQ_SPI1_RX) spi_kick((dreq - DREQ_SPI0_TX) / 2);
+        else if (dreq == DREQ_UART0_RX || dreq == DREQ_UART1_RX) uart_drain(dreq == DREQ_UART1_RX);
+        else if (dreq == DREQ_UART0_TX || dreq == DREQ_UART1_TX)
+        {
+            while (c.busy)
+            {
+                (void)dma_read_element(channel);
+                dma_count(channel);
+            }
+        }
+        else fail("unsupported DREQ");
+    }
+}
+
+uint8_t fake_flash_memory[PICO_FLASH_SIZE_BYTES];
+static FlashInit FlashInitializer;
+
+/**************************************************/
+/*************************時刻************************/
+/**************************************************/
+
+uint64_t time_us_64() {return Now / 1000;}
+uint32_t time_us_32() {return static_cast<uint32_t>(Now / 1000);}
+absolute_time_t get_absolute_time() {return time_us_64();}
+absolute_time_t make_timeout_time_us(uint64_t us) {return time_us_64() + us;}
+absolute_time_t make_timeout_time_ms(uint32_t ms) {return time_us_64() + ms * 1000ULL;}
+absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) {return t + us;}
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {return static_cast<int64_t>(to - from);}
+uint64_t to_us_since_boot(absolute_time_t t) {return t;}
+
+void sleep_us(uint64_t us) {advance(us * 1000);}
+void sleep_ms(uint32_t ms) {advance(ms * 1000000ULL);}
+void busy_wait_us_32(uint32_t us) {advance(us * 1000ULL);}
+void tight_loop_contents() {advance(1000);}
+void stdio_init_all() {}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void* user_data, repeating_timer_t* out)
+{
+    if (!delay_us || !callback || !out)
+return false;
+    out->delay_us = delay_us;
+    out->callback = callback;
+    out->user_data = user_data;
+    out->generation = ++TimerGeneration;
+    uint64_t next = Now + static_cast<uint64_t>(delay_us < 0 ? -delay_us : delay_us) * 1000;
+    uint32_t generation = out->generation;
+    schedule(next, [out, generation, next] {DueTimers.push_back({out, generation, next});});
+    return true;
+}
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void* user_data, repeating_timer_t* out)
+{
+    return add_repeating_timer_us(delay_ms * 1000LL, callback, user_data, out);
+}
+
+bool cancel_repeating_timer(repeating_timer_t* timer)
+{
+    timer->generation = ++TimerGeneration;
+    return true;
+}
+
+/**************************************************/
+/***********************割り込み**********************/
+/**************************************************/
+
+uint32_t save_and_disable_interrupts()
+{
+    uint32_t status = !InterruptsEnabled;  // 実機のPRIMASKと同じく，禁止していれば1
+    InterruptsEnabled = false;
+    return status;
+}
+
+void restore_interrupts(uint32_t status)
+{
+    InterruptsEnabled = !status;
+    dispatch_irqs();
+}
+
+uint __get_current_exception()
+{
+    return CurrentException;
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler)
+{
+    if (num >= IrqNum) fail("invalid IRQ number");
+    if (!Irqs[num].handlers.empty() && Irqs[num].handlers[0] != handler) fail("irq_set_exclusive_handler: another handler is already set");
+    Irqs[num].handlers.assign(1, handler);
+}
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t)
+{
+    if (num >= IrqNum) fail("invalid IRQ number");
+    Irqs[num].handlers.push_back(handler);
+}
+
+void irq_remove_handler(uint num, irq_handler_t handler)
+{
+    std::vector<irq_handler_t>& handlers = Irqs[num].handlers;
+    for (auto it = handlers.begin(); it != handlers.end(); ++it)
+    {
+        if (*it == handler)
+        {
+            handlers.erase(it);
+    return;
+        }
+    }
+}
+
+void irq_set_enabled(uint num, bool enabled)
+{
+    if (num >= IrqNum) fail("invalid IRQ number");
+    Irqs[num].enabled = enabled;
+    dispatch_irqs();
+}
+
+bool irq_is_enabled(uint num)
+{
+    return num < IrqNum && Irqs[num].enabled;
+}
+
+/**************************************************/
+/*************************GPIO************************/
+/**************************************************/
+
+void gpio_init(uint gpio) {gpio = gpio_index(gpio); GpioOut[gpio] = false; GpioLevel[gpio] = false;}
+void gpio_set_function(uint gpio, enum gpio_function) {gpio_index(gpio);}
+void gpio_set_dir(uint gpio, bool out) {GpioOut[gpio_index(gpio)] = out;}
+bool gpio_get_dir(uint gpio) {return GpioOut[gpio_index(gpio)];}
+void gpio_put(uint gpio, bool value) {GpioLevel[gpio_index(gpio)] = value;}
+bool gpio_get(uint gpio) {gpio = gpio_index(gpio); return GpioOut[gpio] ? GpioLevel[gpio] : GpioPullUp[gpio];}
+void gpio_pull_up(uint gpio) {gpio = gpio_index(gpio); GpioPullUp[gpio] = true; GpioPullDown[gpio] = false;}
+void gpio_pull_down(uint gpio) {gpio = gpio_index(gpio); GpioPullUp[gpio] = false; GpioPullDown[gpio] = true;}
+void gpio_disable_pulls(uint gpio) {gpio = gpio_index(gpio); GpioPullUp[gpio] = GpioPullDown[gpio] = false;}
+bool gpio_is_pulled_up(uint gpio) {return GpioPullUp[gpio_index(gpio)];}
+bool gpio_is_pulled_down(uint gpio) {return GpioPullDown[gpio_index(gpio)];}
+
+/**************************************************/
+/*************************DMA*************************/
+/**************************************************/
+
+int dma_claim_unused_channel(bool required)
+{
+    for (uint i = 0; i < NUM_DMA_CHANNELS; ++i)
+    {
+        if (!Channels[i].claimed)
+        {
+            Channels[i].claimed = true;
+    return i;
+        }
+    }
+    if (required) fail("no DMA channel left");
+    return -1;
+}
+
+void dma_channel_claim(uint channel)
+{
+    if (dma_channel(channel).claimed) fail("DMA channel is already claimed");
+    Channels[channel].claimed = true;
+}
+
+void dma_channel_unclaim(uint channel)
+{
+    dma_channel(channel).claimed = false;
+}
+
+bool dma_channel_is_claimed(uint channel)
+{
+    return dma_channel(channel).claimed;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+    dma_channel_config config;
+    config.size = DMA_SIZE_32;
+    config.read_increment = true;
+    config.write_increment = false;
+    config.dreq = DREQ_FORCE;
+    config.chain_to = channel;
+    config.ring_write = false;
+    config.ring_size_bits = 0;
+    config.enable = true;
+    return config;
+}
+
+dma_channel_hw_t* dma_channel_hw_addr(uint channel)
+{
+    return &dma_channel(channel).hw;
+}
+
+void dma_channel_set_config(uint channel, const dma_channel_config* config, bool trigger)
+{
+    dma_channel(channel).config = *config;
+    if (trigger) dma_start(channel);
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void* read_addr, bool trigger)
+{
+    dma_channel(channel).hw.read_addr = reinterpret_cast<uintptr_t>(read_addr);
+    if (trigger) dma_start(channel);
+}
+
+void dma_channel_set_write_addr(uint channel, volatile void* write_addr, bool trigger)
+{
+    dma_channel(channel).hw.write_addr = reinterpret_cast<uintptr_t>(write_addr);
+    if (trigger) dma_start(channel);
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger)
+{
+    dma_channel(channel).hw.transfer_count = trans_count;
+    if (trigger) dma_start(channel);
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config* config, volatile void* write_addr, const volatile void* read_addr, uint transfer_count, bool trigger)
+{
+    Channel& c = dma_channel(channel);
+    if (c.busy) fail("dma_channel_configure on a busy channel");
+    c.config = *config;
+    c.hw.write_addr = reinterpret_cast<uintptr_t>(write_addr);
+    c.hw.read_addr = reinterpret_cast<uintptr_t>(read_addr);
+    c.hw.transfer_count = transfer_count;
+    if (trigger) dma_start(channel);
+}
+
+void dma_channel_start(uint channel)
+{
+    dma_start(channel);
+}
+
+void dma_start_channel_mask(uint32_t chan_mask)
+{
+    for (uint i = 0; i < NUM_DMA_CHANNELS; ++i)
+        if (chan_mask & (1u << i)) dma_start(i);
+}
+
+void dma_channel_abort(uint channel)
+{
+    Channel& c = dma_channel(channel);
+    c.busy = false;
+    ++c.generation;
+    DmaInts0 &= ~(1u << channel);
+}
+
+bool dma_channel_is_busy(uint channel)
+{
+    return dma_channel(channel).busy;
+}
+
+void dma_channel_wait_for_finish_blocking(uint channel)
+{
+    while (dma_channel(channel).busy) advance(100);
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled)
+{
+    if (enabled) DmaInte0 |= (1u << channel);
+    else DmaInte0 &= ~(1u << channel);
+    dispatch_irqs();
+}
+
+bool dma_channel_get_irq0_status(uint channel)
+{
+    return DmaInts0 & (1u << channel);
+}
+
+void dma_channel_acknowledge_irq0(uint channel)
+{
+    DmaInts0 &= ~(1u << channel);
+}
+
+/**************************************************/
+/*************************I2C*************************/
+/**************************************************/
+
+i2c_inst_t i2c0_inst = {&I2CBuses[0].hw, false};
+i2c_inst_t i2c1_inst = {&I2CBuses[1].hw, false};
+
+uint i2c_init(i2c_inst_t* i2c, uint baudrate)
+{
+    I2CBus& bus = I2CBuses[i2c_index(i2c)];
+    bus.hw = i2c_hw_t();
+    bus.hw.enable = I2C_IC_ENABLE_ENABLE_BITS;
+    bus.baudrate = baudrate;
+    return baudrate;
+}
+
+void i2c_deinit(i2c_inst_t* i2c)
+{
+    I2CBuses[i2c_index(i2c)].hw.enable = 0;
+}
+
+uint i2c_set_baudrate(i2c_inst_t* i2c, uint baudrate)
+{
+    if (!baudrate) fail("I2C baudrate must not be zero");
+    I2CBuses[i2c_index(i2c)].baudrate = baudrate;
+    advance(1000);  // 分周比の計算とレジスタの書き込みに1μsかかるとする
+    return baudrate;
+}
+
+uint i2c_get_dreq(i2c_inst_t* i2c, bool is_tx)
+{
+    return DREQ_I2C0_TX + 2 * i2c_index(i2c) + (is_tx ? 0 : 1);
+}
+
+int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop)
+{
+    return i2c_blocking(i2c, addr, false, const_cast<uint8_t*>(src), len, nostop, 0);
+}
+
+int i2c_read_blocking(i2c_inst_t* i2c, uint8_t addr, uint8_t* dst, size_t len, bool nostop)
+{
+    return i2c_blocking(i2c, addr, true, dst, len, nostop, 0);
+}
+
+int i2c_write_blocking_until(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop, absolute_time_t until)
+{
+    return i2c_blocking(i2c, addr, false, const_cast<uint8_t*>(src), len, nostop, until * 1000);
+}
+
+int i2c_read_blocking_until(i2c_inst_t* i2c, uint8_t addr, uint8_t* dst, size_t len, bool nostop, absolute_time_t until)
+{
+    return i2c_blocking(i2c, addr, true, dst, len, nostop, until * 1000);
+}
+
+int i2c_write_timeout_us(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop, uint timeout_us)
+{
+    return i2c_write_blocking_until(i2c, addr, src, len, nostop, make_timeout_time_us(timeout_us));
+}
+
+int i2c_read_timeout_us(i2c_inst_t* i2c, uint8_t addr, uint8_t* dst, size_t len, bool nostop, uint timeout_us)
+{
+    return i2c_read_blocking_until(i2c, addr, dst, len, nostop, make_timeout_time_us(timeout_us));
+}
+
+/**************************************************/
+/*************************SPI*************************/
+/**************************************************/
+
+spi_inst_t spi0_inst = {&SPIBuses[0].hw};
+spi_inst_t spi1_inst = {&SPIBuses[1].hw};
+
+uint spi_init(spi_inst_t* spi, uint baudrate)
+{
+    SPIBuses[spi_index(spi)].baudrate = baudrate;
+    SPIBuses[spi_index(spi)].mode = 0;  // 実機の spi_init もモード0に設定する
+    return baudrate;
+}
+
+void spi_deinit(spi_inst_t*) {}
+
+uint spi_set_baudrate(spi_inst_t* spi, uint baudrate)
+{
+    if (!baudrate) fail("SPI baudrate must not be zero");
+    SPIBuses[spi_index(spi)].baudrate = baudrate;
+    ++SPIBuses[spi_index(spi)].setting_writes;
+    return baudrate;
+}
+
+uint spi_get_baudrate(const spi_inst_t* spi)
+{
+    return SPIBuses[spi_index(spi)].baudrate;
+}
+
+void spi_set_format(spi_inst_t* spi, uint, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t)
+{
+    SPIBuses[spi_index(spi)].mode = (cpol == SPI_CPOL_1 ? 0b10 : 0) | (cpha == SPI_CPHA_1 ? 0b01 : 0);
+    ++SPIBuses[spi_index(spi)].setting_writes;
+}
+
+uint spi_get_dreq(spi_inst_t* spi, bool is_tx)
+{
+    return DREQ_SPI0_TX + 2 * spi_index(spi) + (is_tx ? 0 : 1);
+}
+
+bool spi_is_busy(const spi_inst_t* spi)
+{
+    return SPIBuses[spi_index(spi)].transferring;
+}
+
+int spi_write_read_blocking(spi_inst_t* spi, const uint8_t* src, uint8_t* dst, size_t len)
+{
+    SPIBus& bus = SPIBuses[spi_index(spi)];
+    if (bus.transferring) fail("blocking SPI transfer while a DMA transfer is running on the same bus");
+    for (std::size_t i = 0; i < len; ++i) dst[i] = bus.exchange(src[i]);
+    advance(len * bus.byte_ns());
+    return static_cast<int>(len);
+}
+
+int spi_write_blocking(spi_inst_t* spi, const uint8_t* src, size_t len)
+{
+    SPIBus& bus = SPIBuses[spi_index(spi)];
+    if (bus.transferring) fail("blocking SPI transfer while a DMA transfer is running on the same bus");
+    for (std::size_t i = 0; i < len; ++i) bus.exchange(src[i]);
+    advance(len * bus.byte_ns());
+    return static_cast<int>(len);
+}
+
+int spi_read_blocking(spi_inst_t* spi, uint8_t repeated_tx_data, uint8_t* dst, size_t len)
+{
+    SPIBus& bus = SPIBuses[spi_index(spi)];
+    if (bus.transferring) fail("blocking SPI transfer while a DMA transfer is running on the same bus");
+    for (std::size_t i = 0; i < len; ++i) dst[i] = bus.exchange(repeated_tx_data);
+    advance(len * bus.byte_ns());
+    return static_cast<int>(len);
+}
+
+/**************************************************/
+/************************UART*************************/
+/**************************************************/
+
+uart_inst_t uart0_inst = {&UARTBuses[0].hw};
+uart_inst_t uart1_inst = {&UARTBuses[1].hw};
+
+uint uart_init(uart_inst_t* uart, uint baudrate)
+{
+    UARTBuses[uart_index(uart)].baudrate = baudrate;
+    return baudrate;
+}
+
+void uart_deinit(uart_inst_t*) {}
+
+uint uart_set_baudrate(uart_inst_t* uart, uint baudrate)
+{
+    if (!baudrate) fail("UART baudrate must not be zero");
+    UARTBuses[uart_index(uart)].baudrate = baudrate;
+    return baudrate;
+}
+
+void uart_set_hw_flow(uart_inst_t*, bool, bool) {}
+void uart_set_format(uart_inst_t*, uint, uint, uart_parity_t) {}
+void uart_set_fifo_enabled(uart_inst_t*, bool) {}
+void uart_set_irq_enables(uart_inst_t*, bool, bool) {}
+
+uint uart_get_dreq(uart_inst_t* uart, bool is_tx)
+{
+    return DREQ_UART0_TX + 2 * uart_index(uart) + (is_tx ? 0 : 1);
+}
+
+bool uart_is_readable(uart_inst_t* uart)
+{
+    return !UARTBuses[uart_index(uart)].fifo.empty();
+}
+
+bool uart_is_writable(uart_inst_t* uart)
+{
+    return UARTBuses[uart_index(uart)].tx_fifo.size() < UartFifoSize;
+}
+
+char uart_getc(uart_inst_t* uart)
+{
+    UARTBus& bus = UARTBuses[uart_index(uart)];
+    while (bus.fifo.empty()) tight_loop_contents();
+    char c = static_cast<char>(bus.fifo.front());
+    bus.fifo.pop_front();
+    return c;
+}
+
+void uart_putc_raw(uart_inst_t* uart, char c)
+{
+    while (!uart_is_writable(uart)) tight_loop_contents();
+    UARTBuses[uart_index(uart)].tx_fifo.push_back(static_cast<uint8_t>(c));
+    uart_send_next(uart_index(uart));
+}
+
+void uart_read_blocking(uart_inst_t* uart, uint8_t* dst, size_t len)
+{
+    for (std::size_t i = 0; i < len; ++i) dst[i] = static_cast<uint8_t>(uart_getc(uart));
+}
+
+void uart_write_blocking(uart_inst_t* uart, const uint8_t* src, size_t len)
+{
+    for (std::size_t i = 0; i < len; ++i) uart_putc_raw(uart, static_cast<char>(src[i]));
+}
+
+void uart_tx_wait_blocking(uart_inst_t* uart)
+{
+    const UARTBus& bus = UARTBuses[uart_index(uart)];
+    while (bus.sending || !bus.tx_fifo.empty()) tight_loop_contents();
+}
+
+/**************************************************/
+/***********************フラッシュ**********************/
+/**************************************************/
+
+void flash_range_erase(uint32_t flash_offs, size_t count)
+{
+    if (InterruptsEnabled && !IrqDepth) fail("flash_range_erase called with interrupts enabled");
+    if (flash_offs % FLASH_SECTOR_SIZE || count % FLASH_SECTOR_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES) fail("flash_range_erase: unaligned range");
+    std::memset(fake_flash_memory + flash_offs, 0xff, count);
+    FlashErases += count / FLASH_SECTOR_SIZE;
+    advance(45000000ULL * (count / FLASH_SECTOR_SIZE));  // セクタの消去には約45msかかる (W25Q16JVの標準値)  その間も周辺機能は動き続ける
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count)
+{
+    if (InterruptsEnabled && !IrqDepth) fail("flash_range_program called with interrupts enabled");
+    if (flash_offs % FLASH_PAGE_SIZE || count % FLASH_PAGE_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES) fail("flash_range_program: unaligned range");
+    for (std::size_t i = 0; i < count; ++i) fake_flash_memory[flash_offs + i] &= data[i];  // 消去せずに書き込むと0のビットしか変わらない
+    FlashPrograms += count / FLASH_PAGE_SIZE;
+    advance(400000ULL * (count / FLASH_PAGE_SIZE));  // ページの書き込みには約0.4msかかる
+}
+
+int flash_safe_execute(void (*func)(void*), void* param, uint32_t)
+{
+    if (FlashSafeExecuteResult != PICO_OK)
+return FlashSafeExecuteResult;
+    uint32_t status = save_and_disable_interrupts();
+    func(param);
+    restore_interrupts(status);
+    return PICO_OK;
+}
+
+bool flash_safe_execute_core_init()
+{
+    return true;
+}
+
+/**************************************************/
+/******************シミュレーションの操作*****************/
+/**************************************************/
+
+namespace fake
+{
+    uint64_t now_ns() {return Now;}
+    void run_for_us(uint64_t us) {advance(us * 1000);}
+    void set_time_limit_us(uint64_t limit_us) {TimeLimit = limit_us * 1000;}
+    bool interrupts_enabled() {return InterruptsEnabled;}
+    uint32_t irq_count(uint num) {return num < IrqNum ? Irqs[num].count : 0;}
+
+    uint8_t* i2c_device(i2c_inst_t* i2c, uint8_t slave_addr)
+    {
+        return I2CBuses[i2c_index(i2c)].devices[slave_addr & 0x7f].memory;
+    }
+
+    void i2c_remove_device(i2c_inst_t* i2c, uint8_t slave_addr)
+    {
+        I2CBus& bus = I2CBuses[i2c_index(i2c)];
+        auto it = bus.devices.find(slave_addr & 0x7f);
+        if (it == bus.devices.end())
+    return;
+        if (bus.device == &it->second) bus.device = nullptr;
+        bus.devices.erase(it);
+    }
+
+    uint32_t i2c_stolen_flags(i2c_inst_t* i2c) {return I2CBuses[i2c_index(i2c)].stolen;}
+    uint32_t i2c_transactions(i2c_inst_t* i2c) {return I2CBuses[i2c_index(i2c)].transactions;}
+    uint64_t i2c_busy_ns(i2c_inst_t* i2c) {return I2CBuses[i2c_index(i2c)].busy_ns;}
+    uint i2c_baudrate(i2c_inst_t* i2c) {return I2CBuses[i2c_index(i2c)].baudrate;}
+
+    void set_spi_device(spi_inst_t* spi, SPIDevice device, void* context)
+    {
+        SPIBuses[spi_index(spi)].device = device;
+        SPIBuses[spi_index(spi)].context = context;
+    }
+
+    uint64_t spi_bytes(spi_inst_t* spi) {return SPIBuses[spi_index(spi)].bytes;}
+    uint spi_mode(spi_inst_t* spi) {return SPIBuses[spi_index(spi)].mode;}
+    uint32_t spi_setting_writes(spi_inst_t* spi) {return SPIBuses[spi_index(spi)].setting_writes;}
+
+    void uart_receive(uart_inst_t* uart, const uint8_t* data, std::size_t data_bytes, uint64_t gap_us)
+    {
+        uint index = uart_index(uart);
+        UARTBus& bus = UARTBuses[index];
+        if (!data_bytes)
+    return;
+        if (bus.line.empty())
+        {
+            bus.next_arrival = (bus.next_arrival > Now ? bus.next_arrival : Now) + gap_us * 1000 + bus.byte_ns();
+            if (!bus.arriving)
+            {
+                bus.arriving = true;
+                schedule(bus.next_arrival, [index] {uart_arrive(index);});
+            }
+            bus.line.push_back(UARTBus::LineByte{data[0], 0});
+        } else {
+            bus.line.push_back(UARTBus::LineByte{data[0], gap_us * 1000});  // 前に流したデータが届き終えてから空ける
+            bus.line_gap_ns += gap_us * 1000;
+        }
+        for (std::size_t i = 1; i < data_bytes; ++i) bus.line.push_back(UARTBus::LineByte{data[i], 0});
+    }
+
+    uint64_t uart_receive_end_ns(uart_inst_t* uart)
+    {
+        const UARTBus& bus = UARTBuses[uart_index(uart)];
+        return bus.line.empty() ? bus.next_arrival : bus.next_arrival + (bus.line.size() - 1) * bus.byte_ns() + bus.line_gap_ns;
+    }
+
+    uint32_t uart_overruns(uart_inst_t* uart) {return UARTBuses[uart_index(uart)].overruns;}
+
+    const std::vector<uint8_t>& uart_sent(uart_inst_t* uart) {return UARTBuses[uart_index(uart)].sent;}
+
+    int dma_active_channel(uint dreq) {return active_channel(dreq);}
+
+    uint32_t flash_erases() {return FlashErases;}
+    uint32_t flash_programs() {return FlashPrograms;}
+    void set_flash_safe_execute_result(int result) {FlashSafeExecuteResult = result;}
+}
@@ -0,0 +1,124 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_FAKE_SDK_HPP_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_FAKE_SDK_HPP_
+
+// パソコン上でscのライブラリを試すための，RP2040の周辺機能のシミュレーション
+//
+// 時刻はシミュレーション上の時刻(ns単位)で，sleep_us や tight_loop_contents など待機する関数を呼び出したときにだけ進む
+// 時刻が進む間に，DMAやI2C/SPI/UARTの転送，タイマーなどの予定(イベント)を時刻の順に実行し，
+// 割り込みが許可されていれば，条件を満たした割り込み処理をすぐに呼び出す
+// そのため，処理そのものにかかる時間は0とみなし，通信や待機にかかる時間だけを測れる
+//
+// 実機との主な違い
+// ・I2Cの clr_stop_det などは読み取ってもフラグが消えない  代わりに，割り込み処理を呼び出した時点で立っていたフラグを，処理の後に消す
+// ・UARTの受信はDMAか uart_getc で行う  (dr を直接読む受信の割り込み処理は再現しない)
+// ・UARTの割り込みは，受信のFIFOの量(RXIM)と受信が途切れたとき(RTIM)，送信のFIFOの量(TXIM)の条件だけを再現する  受信時のDMA(RXDMAE)を無効にするとFIFOにたまる
+// ・UARTの送信は uart_putc_raw などで行う  (dr に直接書き込んだデータは送信しない)
+// ・I2Cのデバイスは256バイトのメモリで，最初に書き込んだバイトを読み書きの位置とする (BME280などのレジスタと同じ)
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "hardware/uart.h"
+
+namespace fake
+{
+    /***** 時刻と割り込み *****/
+
+    // シミュレーション上の時刻 (ns)
+    uint64_t now_ns();
+
+    // 時刻を進め，その間のイベントと割り込み処理を実行する
+    // us : 進める時間 (μs)
+    void run_for_us(uint64_t us);
+
+    // 時刻の上限を設定  超えた場合は，終わらない待機とみなしてメッセージを出して異常終了する (初期値:600秒)
+    // limit_us : 時刻の上限 (μs)
+    void set_time_limit_us(uint64_t limit_us);
+
+    // 割り込みが許可されているか  (割り込み処理の中ではfalse)
+    bool interrupts_enabled();
+
+    // 割り込み処理を呼び出した回数
+    // num : 割り込みの番号 (I2C0_IRQなど)
+    uint32_t irq_count(uint num);
+
+    /***** I2C *****/
+
+    // I2Cのバスにデバイスを接続する  既に接続していれば何もしない
+    // i2c : i2c0かi2c1
+    // slave_addr : デバイスのスレーブアドレス  7bit
+    // 戻り値 : デバイスのメモリ (256バイト)  テストから直接読み書きしてよい
+    uint8_t* i2c_device(i2c_inst_t* i2c, uint8_t slave_addr);
+
+    // I2Cのバスからデバイスを外す  以降の通信はアドレスに応答しない(NACK)
+    void i2c_remove_device(i2c_inst_t* i2c, uint8_t slave_addr);
+
+    // 待機する通信(i2c_*_blocking)が待っていた停止信号やエラーのフラグを，割り込み処理に先に消された回数
+    // 実機ではこのとき待機する通信が止まるか，NACKを見逃して成功したとみなす  シミュレーションでは失敗として返す
+    uint32_t i2c_stolen_flags(i2c_inst_t* i2c);
+
+    // 停止信号まで終えた通信の数 (待機する通信とDMAによる通信の合計)
+    uint32_t i2c_transactions(i2c_inst_t* i2c);
+
+    // バスが通信に使われていた時間の合計 (ns)
+    uint64_t i2c_busy_ns(i2c_inst_t* i2c);
+
+    // 現在の通信速度 (Hz)  i2c_set_baudrate は1μsかかるものとする
+    uint i2c_baudrate(i2c_inst_t* i2c);
+
+    /***** SPI *****/
+
+    // SPIのデバイス  送信された1バイトを受け取り，同時に返す1バイトを返す
+    typedef uint8_t (*SPIDevice)(uint8_t output, void* context);
+
+    // SPIのバスにデバイスを接続する  (初期値:送信した値をそのまま返すループバック)
+    void set_spi_device(spi_inst_t* spi, SPIDevice device, void* context);
+
+    // 送受信したバイト数の合計
+    uint64_t spi_bytes(spi_inst_t* spi);
+
+    // 現在のSPIのモード (0〜3)  転送速度は spi_get_baudrate で確認できる
+    uint spi_mode(spi_inst_t* spi);
+
+    // 設定を書き込んだ回数 (spi_set_baudrate と spi_set_format の呼び出しの合計)
+    uint32_t spi_setting_writes(spi_inst_t* spi);
+
+    /***** UART *****/
+
+    // UARTの受信線にデータを流す  通信速度に合わせて1バイト(10bit)ずつ届き，前に流したデータの後に続く
+    // uart : uart0かuart1
+    // data : 受信させるデータ
+    // data_bytes : バイト数
+    // [gap_us] : 前に流したデータが届き終えてから(既に届き終えている場合は今から)，このデータを流し始めるまでに空ける時間 (μs) (省略時:0)
+    void uart_receive(uart_inst_t* uart, const uint8_t* data, std::size_t data_bytes, uint64_t gap_us = 0);
+
+    // uart_receiveで流したデータがすべて届く時刻 (ns)
+    uint64_t uart_receive_end_ns(uart_inst_t* uart);
+
+    // FIFO(32バイト)があふれて失われたバイト数
+    uint32_t uart_overruns(uart_inst_t* uart);
+
+    // 送信線に送り終えたデータ  1バイト(10bit)ずつ通信速度に合わせて送る
+    const std::vector<uint8_t>& uart_sent(uart_inst_t* uart);
+
+    /***** DMA *****/
+
+    // そのDREQで転送しているチャンネル  ない場合は-1
+    int dma_active_channel(uint dreq);
+
+    /***** フラッシュ *****/
+
+    // セクタを消去した回数
+    uint32_t flash_erases();
+
+    // ページに書き込んだ回数
+    uint32_t flash_programs();
+
+    // flash_safe_execute が返す結果を設定  PICO_OK以外にすると，もう一方のコアを止められなかったものとして書き込まずに返す
+    void set_flash_safe_execute_result(int result);
+}
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_FAKE_SDK_HPP_
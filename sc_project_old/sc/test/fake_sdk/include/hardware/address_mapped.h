@@ -0,0 +1,14 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_ADDRESS_MAPPED_H_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_ADDRESS_MAPPED_H_
+
+#include <cstdint>
+
+typedef volatile uint32_t io_rw_32;
+typedef const volatile uint32_t io_ro_32;
+
+// レジスタの一部のビットだけを書き換える  (実機ではアトミックな別名アドレスを使う)
+static inline void hw_set_bits(io_rw_32* addr, uint32_t mask) {*addr = *addr | mask;}
+static inline void hw_clear_bits(io_rw_32* addr, uint32_t mask) {*addr = *addr & ~mask;}
+static inline void hw_write_masked(io_rw_32* addr, uint32_t values, uint32_t write_mask) {*addr = (*addr & ~write_mask) | (values & write_mask);}
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_ADDRESS_MAPPED_H_
@@ -0,0 +1,88 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_DMA_H_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_DMA_H_
+
+#include <cstdint>
+
+#include "pico/stdlib.h"
+#include "hardware/address_mapped.h"
+
+#define NUM_DMA_CHANNELS 12
+
+// DMAの転送を開始するきっかけ (RP2040と同じ番号)
+enum dreq_num
+{
+    DREQ_SPI0_TX = 16,
+    DREQ_SPI0_RX = 17,
+    DREQ_SPI1_TX = 18,
+    DREQ_SPI1_RX = 19,
+    DREQ_UART0_TX = 20,
+    DREQ_UART0_RX = 21,
+    DREQ_UART1_TX = 22,
+    DREQ_UART1_RX = 23,
+    DREQ_I2C0_TX = 32,
+    DREQ_I2C0_RX = 33,
+    DREQ_I2C1_TX = 34,
+    DREQ_I2C1_RX = 35,
+    DREQ_FORCE = 63
+};
+
+enum dma_channel_transfer_size
+{
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2
+};
+
+// チャンネルの設定  実機では制御レジスタの値だが，ここでは項目ごとに持つ
+typedef struct
+{
+    enum dma_channel_transfer_size size;
+    bool read_increment;
+    bool write_increment;
+    uint dreq;
+    uint chain_to;
+    bool ring_write;
+    uint ring_size_bits;
+    bool enable;
+} dma_channel_config;
+
+// チャンネルのレジスタ  アドレスはパソコンのポインタを入れるため，実機より大きい
+typedef struct
+{
+    volatile uintptr_t read_addr;
+    volatile uintptr_t write_addr;
+    volatile uint32_t transfer_count;  // 残りの転送回数  転送するたびにシミュレーションが減らす
+    io_rw_32 ctrl_trig;
+} dma_channel_hw_t;
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_claim(uint channel);
+void dma_channel_unclaim(uint channel);
+bool dma_channel_is_claimed(uint channel);
+
+dma_channel_config dma_channel_get_default_config(uint channel);
+static inline void channel_config_set_transfer_data_size(dma_channel_config* c, enum dma_channel_transfer_size size) {c->size = size;}
+static inline void channel_config_set_read_increment(dma_channel_config* c, bool incr) {c->read_increment = incr;}
+static inline void channel_config_set_write_increment(dma_channel_config* c, bool incr) {c->write_increment = incr;}
+static inline void channel_config_set_dreq(dma_channel_config* c, uint dreq) {c->dreq = dreq;}
+static inline void channel_config_set_chain_to(dma_channel_config* c, uint chain_to) {c->chain_to = chain_to;}
+static inline void channel_config_set_ring(dma_channel_config* c, bool write, uint size_bits) {c->ring_write = write; c->ring_size_bits = size_bits;}
+static inline void channel_config_set_enable(dma_channel_config* c, bool enable) {c->enable = enable;}
+
+dma_channel_hw_t* dma_channel_hw_addr(uint channel);
+void dma_channel_set_config(uint channel, const dma_channel_config* config, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void* read_addr, bool trigger);
+void dma_channel_set_write_addr(uint channel, volatile void* write_addr, bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+void dma_channel_configure(uint channel, const dma_channel_config* config, volatile void* write_addr, const volatile void* read_addr, uint transfer_count, bool trigger);
+void dma_channel_start(uint channel);
+void dma_start_channel_mask(uint32_t chan_mask);
+void dma_channel_abort(uint channel);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_wait_for_finish_blocking(uint channel);
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+bool dma_channel_get_irq0_status(uint channel);
+void dma_channel_acknowledge_irq0(uint channel);
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_DMA_H_
@@ -0,0 +1,24 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_FLASH_H_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_FLASH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pico/stdlib.h"
+
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+#define FLASH_BLOCK_SIZE (1u << 16)
+#ifndef PICO_FLASH_SIZE_BYTES
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+#endif
+
+// フラッシュの内容は配列に保存する  XIP_BASEからのアドレスで読み込める
+extern uint8_t fake_flash_memory[PICO_FLASH_SIZE_BYTES];
+#define XIP_BASE (reinterpret_cast<uintptr_t>(fake_flash_memory))
+
+// 消去と書き込みは，実機と同じく割り込みを禁止した状態で呼び出す必要がある  (許可したまま呼び出すと異常終了する)
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count);
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_FLASH_H_
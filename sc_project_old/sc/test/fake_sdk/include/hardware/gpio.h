@@ -0,0 +1,39 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_GPIO_H_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_GPIO_H_
+
+#include <cstdint>
+
+typedef unsigned int uint;
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+enum gpio_function
+{
+    GPIO_FUNC_XIP = 0,
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PIO0 = 6,
+    GPIO_FUNC_PIO1 = 7,
+    GPIO_FUNC_GPCK = 8,
+    GPIO_FUNC_USB = 9,
+    GPIO_FUNC_NULL = 0x1f
+};
+
+// ピンの状態は配列に保存するだけで，どこにも繋がっていない  (出力した値がそのまま読める)
+void gpio_init(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_set_dir(uint gpio, bool out);
+bool gpio_get_dir(uint gpio);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_pull_up(uint gpio);
+void gpio_pull_down(uint gpio);
+void gpio_disable_pulls(uint gpio);
+bool gpio_is_pulled_up(uint gpio);
+bool gpio_is_pulled_down(uint gpio);
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_GPIO_H_
@@ -0,0 +1,72 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_I2C_H_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_I2C_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pico/stdlib.h"
+#include "hardware/address_mapped.h"
+
+// I2Cのレジスタ  使うものだけを並べているので，実機とはアドレスの並びが異なる
+typedef struct
+{
+    io_rw_32 con;
+    io_rw_32 tar;
+    io_rw_32 data_cmd;  // DMAでの書き込み先  書き込んだ値はシミュレーションのI2Cが読み取る
+    io_rw_32 intr_stat;  // raw_intr_stat & intr_mask  割り込み処理を呼び出す直前に更新する
+    io_rw_32 intr_mask;
+    io_rw_32 raw_intr_stat;
+    io_rw_32 clr_intr;
+    io_rw_32 clr_tx_abrt;  // 読み取ってもフラグは消えない  (割り込み処理の後に，処理の時点で立っていたフラグを消す)
+    io_rw_32 clr_stop_det;
+    io_rw_32 enable;
+    io_rw_32 status;
+    io_rw_32 txflr;
+    io_rw_32 rxflr;
+    io_rw_32 tx_abrt_source;
+    io_rw_32 dma_cr;
+} i2c_hw_t;
+
+typedef struct i2c_inst
+{
+    i2c_hw_t* hw;
+    bool restart_on_next;
+} i2c_inst_t;
+
+extern i2c_inst_t i2c0_inst;
+extern i2c_inst_t i2c1_inst;
+#define i2c0 (&i2c0_inst)
+#define i2c1 (&i2c1_inst)
+
+#define I2C_IC_DATA_CMD_RESTART_BITS 0x00000400u
+#define I2C_IC_DATA_CMD_STOP_BITS 0x00000200u
+#define I2C_IC_DATA_CMD_CMD_BITS 0x00000100u
+#define I2C_IC_DATA_CMD_DAT_BITS 0x000000ffu
+#define I2C_IC_INTR_MASK_M_RX_FULL_BITS 0x00000004u
+#define I2C_IC_INTR_MASK_M_TX_EMPTY_BITS 0x00000010u
+#define I2C_IC_INTR_MASK_M_TX_ABRT_BITS 0x00000040u
+#define I2C_IC_INTR_MASK_M_STOP_DET_BITS 0x00000200u
+#define I2C_IC_INTR_STAT_R_TX_ABRT_BITS 0x00000040u
+#define I2C_IC_INTR_STAT_R_STOP_DET_BITS 0x00000200u
+#define I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS 0x00000040u
+#define I2C_IC_RAW_INTR_STAT_STOP_DET_BITS 0x00000200u
+#define I2C_IC_ENABLE_ENABLE_BITS 0x00000001u
+#define I2C_IC_DMA_CR_TDMAE_BITS 0x00000002u
+#define I2C_IC_DMA_CR_RDMAE_BITS 0x00000001u
+
+uint i2c_init(i2c_inst_t* i2c, uint baudrate);
+void i2c_deinit(i2c_inst_t* i2c);
+uint i2c_set_baudrate(i2c_inst_t* i2c, uint baudrate);
+static inline uint i2c_hw_index(i2c_inst_t* i2c) {return i2c == i2c1 ? 1 : 0;}
+static inline i2c_hw_t* i2c_get_hw(i2c_inst_t* i2c) {return i2c->hw;}
+uint i2c_get_dreq(i2c_inst_t* i2c, bool is_tx);
+
+// 待機する通信  通信にかかる時間だけシミュレーション上の時刻を進める
+int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t* i2c, uint8_t addr, uint8_t* dst, size_t len, bool nostop);
+int i2c_write_blocking_until(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop, absolute_time_t until);
+int i2c_read_blocking_until(i2c_inst_t* i2c, uint8_t addr, uint8_t* dst, size_t len, bool nostop, absolute_time_t until);
+int i2c_write_timeout_us(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop, uint timeout_us);
+int i2c_read_timeout_us(i2c_inst_t* i2c, uint8_t addr, uint8_t* dst, size_t len, bool nostop, uint timeout_us);
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_I2C_H_
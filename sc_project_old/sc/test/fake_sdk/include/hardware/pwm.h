@@ -0,0 +1,24 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_PWM_H_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_PWM_H_
+
+#include <cstdint>
+
+#include "pico/stdlib.h"
+
+enum
+{
+    PWM_CHAN_A = 0,
+    PWM_CHAN_B = 1
+};
+
+// PWMは設定を受け取るだけで何もしない
+static inline uint pwm_gpio_to_slice_num(uint gpio) {return (gpio >> 1u) & 7u;}
+static inline uint pwm_gpio_to_channel(uint gpio) {return gpio & 1u;}
+static inline void pwm_set_phase_correct(uint, bool) {}
+static inline void pwm_set_output_polarity(uint, bool, bool) {}
+static inline void pwm_set_enabled(uint, bool) {}
+static inline void pwm_set_wrap(uint, uint16_t) {}
+static inline void pwm_set_clkdiv(uint, float) {}
+static inline void pwm_set_chan_level(uint, uint, uint16_t) {}
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_PWM_H_
@@ -0,0 +1,54 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_SPI_H_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_SPI_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pico/stdlib.h"
+#include "hardware/address_mapped.h"
+
+// SPIのレジスタ  DMAの読み書き先として dr のアドレスだけを使う
+typedef struct
+{
+    io_rw_32 cr0;
+    io_rw_32 cr1;
+    io_rw_32 dr;
+    io_ro_32 sr;
+    io_rw_32 cpsr;
+    io_rw_32 imsc;
+    io_ro_32 ris;
+    io_ro_32 mis;
+    io_rw_32 icr;
+    io_rw_32 dmacr;
+} spi_hw_t;
+
+typedef struct spi_inst
+{
+    spi_hw_t* hw;
+} spi_inst_t;
+
+extern spi_inst_t spi0_inst;
+extern spi_inst_t spi1_inst;
+#define spi0 (&spi0_inst)
+#define spi1 (&spi1_inst)
+
+typedef enum {SPI_CPHA_0 = 0, SPI_CPHA_1 = 1} spi_cpha_t;
+typedef enum {SPI_CPOL_0 = 0, SPI_CPOL_1 = 1} spi_cpol_t;
+typedef enum {SPI_LSB_FIRST = 0, SPI_MSB_FIRST = 1} spi_order_t;
+
+uint spi_init(spi_inst_t* spi, uint baudrate);
+void spi_deinit(spi_inst_t* spi);
+uint spi_set_baudrate(spi_inst_t* spi, uint baudrate);
+uint spi_get_baudrate(const spi_inst_t* spi);
+void spi_set_format(spi_inst_t* spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order);
+static inline uint spi_get_index(const spi_inst_t* spi) {return spi == spi1 ? 1 : 0;}
+static inline spi_hw_t* spi_get_hw(spi_inst_t* spi) {return spi->hw;}
+uint spi_get_dreq(spi_inst_t* spi, bool is_tx);
+bool spi_is_busy(const spi_inst_t* spi);
+
+// 待機する通信  通信にかかる時間だけシミュレーション上の時刻を進める
+int spi_write_read_blocking(spi_inst_t* spi, const uint8_t* src, uint8_t* dst, size_t len);
+int spi_write_blocking(spi_inst_t* spi, const uint8_t* src, size_t len);
+int spi_read_blocking(spi_inst_t* spi, uint8_t repeated_tx_data, uint8_t* dst, size_t len);
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_SPI_H_
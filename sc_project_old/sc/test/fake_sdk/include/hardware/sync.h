@@ -0,0 +1,18 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_SYNC_H_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_SYNC_H_
+
+#include <atomic>
+#include <cstdint>
+
+// 割り込みの禁止  禁止している間に発生した割り込みは，restore_interruptsで許可したときに実行する
+// save_and_disable_interrupts は実機のPRIMASKと同じく，既に禁止していた場合に1を返す
+uint32_t save_and_disable_interrupts();
+void restore_interrupts(uint32_t status);
+
+static inline void __compiler_memory_barrier() {std::atomic_signal_fence(std::memory_order_seq_cst);}
+static inline void __dmb() {std::atomic_thread_fence(std::memory_order_seq_cst);}
+static inline void __sev() {}
+static inline void __wfe() {}
+static inline void __wfi() {}
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_SYNC_H_
@@ -0,0 +1,79 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_UART_H_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_UART_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pico/stdlib.h"
+#include "hardware/address_mapped.h"
+
+// UARTのレジスタ  受信はDMAか uart_getc で行う (drを直接読んでもFIFOからは取り出されない)
+typedef struct
+{
+    io_rw_32 dr;
+    io_rw_32 rsr;
+    uint32_t _pad0[4];
+    io_ro_32 fr;
+    uint32_t _pad1;
+    io_rw_32 ilpr;
+    io_rw_32 ibrd;
+    io_rw_32 fbrd;
+    io_rw_32 lcr_h;
+    io_rw_32 cr;
+    io_rw_32 ifls;
+    io_rw_32 imsc;
+    io_ro_32 ris;
+    io_ro_32 mis;
+    io_rw_32 icr;
+    io_rw_32 dmacr;
+} uart_hw_t;
+
+typedef struct uart_inst
+{
+    uart_hw_t* hw;
+} uart_inst_t;
+
+extern uart_inst_t uart0_inst;
+extern uart_inst_t uart1_inst;
+#define uart0 (&uart0_inst)
+#define uart1 (&uart1_inst)
+
+typedef enum
+{
+    UART_PARITY_NONE,
+    UART_PARITY_EVEN,
+    UART_PARITY_ODD
+} uart_parity_t;
+
+#define UART_UARTFR_RXFE_BITS 0x00000010u
+#define UART_UARTIMSC_RXIM_BITS 0x00000010u
+#define UART_UARTIMSC_TXIM_BITS 0x00000020u
+#define UART_UARTIMSC_RTIM_BITS 0x00000040u
+#define UART_UARTIFLS_RXIFLSEL_BITS 0x00000038u
+#define UART_UARTIFLS_RXIFLSEL_LSB 3
+#define UART_UARTIFLS_TXIFLSEL_BITS 0x00000007u
+#define UART_UARTIFLS_TXIFLSEL_LSB 0
+#define UART_UARTDMACR_RXDMAE_BITS 0x00000001u
+#define UART_UARTDMACR_TXDMAE_BITS 0x00000002u
+#define UART_UARTICR_RTIC_BITS 0x00000040u
+
+uint uart_init(uart_inst_t* uart, uint baudrate);
+void uart_deinit(uart_inst_t* uart);
+uint uart_set_baudrate(uart_inst_t* uart, uint baudrate);
+void uart_set_hw_flow(uart_inst_t* uart, bool cts, bool rts);
+void uart_set_format(uart_inst_t* uart, uint data_bits, uint stop_bits, uart_parity_t parity);
+void uart_set_fifo_enabled(uart_inst_t* uart, bool enabled);
+void uart_set_irq_enables(uart_inst_t* uart, bool rx_has_data, bool tx_needs_data);
+static inline uint uart_get_index(uart_inst_t* uart) {return uart == uart1 ? 1 : 0;}
+static inline uart_hw_t* uart_get_hw(uart_inst_t* uart) {return uart->hw;}
+uint uart_get_dreq(uart_inst_t* uart, bool is_tx);
+
+bool uart_is_readable(uart_inst_t* uart);
+bool uart_is_writable(uart_inst_t* uart);
+char uart_getc(uart_inst_t* uart);
+void uart_putc_raw(uart_inst_t* uart, char c);
+void uart_read_blocking(uart_inst_t* uart, uint8_t* dst, size_t len);
+void uart_write_blocking(uart_inst_t* uart, const uint8_t* src, size_t len);
+void uart_tx_wait_blocking(uart_inst_t* uart);
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_HARDWARE_UART_H_
@@ -0,0 +1,13 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_PICO_FLASH_H_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_PICO_FLASH_H_
+
+#include <cstdint>
+
+#include "pico/stdlib.h"
+
+// 割り込みを禁止し，もう一方のコアを止めた状態でfuncを呼び出す  シミュレーションではもう一方のコアはないので，割り込みの禁止だけを行う
+// fake::set_flash_safe_execute_result で，もう一方のコアを止められなかった場合の結果を返すようにできる  (そのときはfuncを呼び出さない)
+int flash_safe_execute(void (*func)(void*), void* param, uint32_t enter_exit_timeout_ms);
+bool flash_safe_execute_core_init();
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_PICO_FLASH_H_
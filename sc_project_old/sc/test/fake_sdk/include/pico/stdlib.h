@@ -0,0 +1,62 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_PICO_STDLIB_H_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_PICO_STDLIB_H_
+
+// パソコン上でscのライブラリを動かすための，pico-sdkの代わりのヘッダ
+// 時刻は実時間ではなくシミュレーション上の時刻で，待機する関数を呼び出したときにだけ進む (fake_sdk.hpp を参照)
+// 使う関数と定数だけを，pico-sdkと同じ名前と引数で宣言している
+#include <cstddef>
+#include <cstdint>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;  // pico-sdkでは構造体の場合もあるが，ここでは起動からの時間 (μs)
+
+enum
+{
+    PICO_OK = 0,
+    PICO_ERROR_NONE = 0,
+    PICO_ERROR_GENERIC = -1,
+    PICO_ERROR_TIMEOUT = -2
+};
+
+#define __not_in_flash_func(func_name) func_name
+
+#include "hardware/sync.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+// 時刻
+uint64_t time_us_64();
+uint32_t time_us_32();
+absolute_time_t get_absolute_time();
+absolute_time_t make_timeout_time_us(uint64_t us);
+absolute_time_t make_timeout_time_ms(uint32_t ms);
+absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us);
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to);
+uint64_t to_us_since_boot(absolute_time_t t);
+
+// 待機  シミュレーション上の時刻を進め，その間に起きる割り込みを実行する
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void busy_wait_us_32(uint32_t us);
+void tight_loop_contents();  // 1μs進める
+
+// 繰り返しタイマー  コールバック関数は割り込みとして実行する
+struct repeating_timer;
+typedef bool (*repeating_timer_callback_t)(struct repeating_timer* rt);
+typedef struct repeating_timer
+{
+    int64_t delay_us;
+    repeating_timer_callback_t callback;
+    void* user_data;
+    uint32_t generation;  // 取り消したタイマーの予定を無視するために使う
+} repeating_timer_t;
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void* user_data, repeating_timer_t* out);
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void* user_data, repeating_timer_t* out);
+bool cancel_repeating_timer(repeating_timer_t* timer);
+
+// 実行中の例外の番号  割り込み処理の中では16+割り込みの番号，割り込み処理の外では0
+uint __get_current_exception();
+
+void stdio_init_all();
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_FAKE_SDK_PICO_STDLIB_H_
@@ -0,0 +1,223 @@
+// GNSSの読み込みのテスト  NAV-PVTとNMEAの文から取り出した値を確かめる
+// 南緯・西経を含む値の符号と単位，シミュレーション上のUART(115200bps, DMA)でNMEAとUBXが混ざって届いたときの振り分け，
+// set_ubx が送る設定のメッセージ(CFG-MSG, CFG-RATE)のバイト列を確認する
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "gnss.hpp"
+#include "serial_capture.hpp"
+
+namespace
+{
+    // NAV-PVTに書き込む値
+    struct Pvt
+    {
+        uint8_t hour, minute, second;
+        int32_t nano;  // 秒の端数 (ns)
+        uint8_t fix_type;  // 0:測位なし, 2:2D, 3:3D
+        bool fix_ok;
+        uint8_t satellites;
+        int32_t longitude_e7, latitude_e7;
+        int32_t height_mm;  // 楕円体からの高さ
+        int32_t altitude_mm;  // 海水面(ジオイド)からの高さ (hMSL)
+        int32_t speed_mm_s;  // gSpeed
+        int32_t course_e5;  // headMot
+    };
+
+    void put_i32(uint8_t* data, int32_t value)
+    {
+        for (int i = 0; i < 4; ++i) data[i] = static_cast<uint8_t>(static_cast<uint32_t>(value) >> (8 * i));
+    }
+
+    // u-blox M8のプロトコルの仕様どおりの位置に値を書き込んだNAV-PVTのメッセージ
+    // [text] : 使わない領域(+68〜)に書き込む文字列  NMEAの文と紛らわしいバイトを含める場合に使う (省略時:なし)
+    std::string nav_pvt(const Pvt& pvt, const char* text = "")
+    {
+        uint8_t payload[sc::UBXParser::NavPvtLength] = {};
+        payload[8] = pvt.hour;
+        payload[9] = pvt.minute;
+        payload[10] = pvt.second;
+        put_i32(payload + 16, pvt.nano);
+        payload[20] = pvt.fix_type;
+        payload[21] = (pvt.fix_ok ? 0x01 : 0x00);
+        payload[23] = pvt.satellites;
+        put_i32(payload + 24, pvt.longitude_e7);
+        put_i32(payload + 28, pvt.latitude_e7);
+        put_i32(payload + 32, pvt.height_mm);
+        put_i32(payload + 36, pvt.altitude_mm);
+        put_i32(payload + 60, pvt.speed_mm_s);
+        put_i32(payload + 64, pvt.course_e5);
+        std::memcpy(payload + 68, text, std::strlen(text));
+        uint8_t frame[sizeof(payload) + sc::UBXParser::FrameOverhead];
+        std::size_t frame_bytes = sc::UBXParser::build_frame(0x01, 0x07, sizeof(payload), payload, frame);
+        return std::string(reinterpret_cast<const char*>(frame), frame_bytes);
+    }
+
+    // サンパウロ付近 (南緯・西経)  hMSLと楕円体高は別の値にして，読み込む位置を確かめる
+    const Pvt SouthWest = {23, 59, 59, 250000000, 3, true, 9, -466333090, -235505200, 755000, 760123, 12345, 27012345};
+
+    // 読み込んだ値の数
+    std::size_t feed(sc::UBXParser& parser, const std::string& data, sc::GNSSFix& fix)
+    {
+        std::size_t fixes = 0;
+        for (char c : data) fixes += parser.feed(static_cast<uint8_t>(c), fix);
+        return fixes;
+    }
+    std::size_t feed(sc::NMEAParser& parser, const std::string& data, sc::GNSSFix& fix)
+    {
+        std::size_t fixes = 0;
+        for (char c : data) fixes += parser.feed(c, fix);
+        return fixes;
+    }
+
+    // シミュレーション上のUARTの受信線にdataを流し，届き終わるまで待つ
+    void receive(const std::string& data)
+    {
+        fake::uart_receive(uart0, reinterpret_cast<const uint8_t*>(data.data()), data.size());
+        fake::run_for_us((fake::uart_receive_end_ns(uart0) - fake::now_ns()) / 1000 + 2000);
+    }
+}
+
+int main()
+{
+    // NAV-PVTの値を符号と単位を変えずに取り出す
+    {
+        sc::UBXParser parser;
+        sc::GNSSFix fix;
+        CHECK_EQUAL(feed(parser, nav_pvt(SouthWest), fix), 1);
+        CHECK(fix.valid && fix.has_altitude);
+        CHECK_EQUAL(fix.latitude_e7, -235505200);
+        CHECK_EQUAL(fix.longitude_e7, -466333090);
+        CHECK_EQUAL(fix.altitude_mm, 760123);  // 楕円体高(755000)ではなくhMSL
+        CHECK_EQUAL(fix.speed_mm_s, 12345);
+        CHECK_EQUAL(fix.course_e5, 27012345);
+        CHECK_EQUAL(fix.time_ms, 86399250);  // 23:59:59.250
+        CHECK_EQUAL(fix.satellites, 9);
+
+        // 秒の端数が負の場合は，切り上げられた秒から引く  12:00:00 - 1ms = 11:59:59.999
+        Pvt rounded = SouthWest;
+        rounded.hour = 12;
+        rounded.minute = 0;
+        rounded.second = 0;
+        rounded.nano = -1000000;
+        CHECK_EQUAL(feed(parser, nav_pvt(rounded), fix), 1);
+        CHECK_EQUAL(fix.time_ms, 43199999);
+
+        // 2D測位では標高がなく，gnssFixOKが立っていなければ測位できていない
+        Pvt fix_2d = SouthWest;
+        fix_2d.fix_type = 2;
+        feed(parser, nav_pvt(fix_2d), fix);
+        CHECK(fix.valid && !fix.has_altitude);
+        Pvt not_ok = SouthWest;
+        not_ok.fix_ok = false;
+        feed(parser, nav_pvt(not_ok), fix);
+        CHECK(!fix.valid && !fix.has_altitude);
+
+        // チェックサムが一致しないメッセージは値を変えない
+        std::string broken = nav_pvt(rounded);
+        broken[6 + 28] ^= 0x01;
+        CHECK_EQUAL(feed(parser, broken, fix), 0);
+        CHECK(!fix.valid);
+        CHECK_EQUAL(parser.errors(), 1);
+    }
+
+    // NMEAの文の南緯・西経と，標高・速度・進行方向・時刻
+    {
+        sc::NMEAParser parser;
+        sc::GNSSFix fix;
+        std::string sentences = capture::nmea_sentence("GNRMC,235959.25,A,3330.12300,S,07045.06000,W,10.000,270.50,160426,,,A")
+                              + capture::nmea_sentence("GNGGA,235959.25,3330.12300,S,07045.06000,W,1,09,0.9,-12.3,M,20.1,M,,");
+        CHECK_EQUAL(feed(parser, sentences, fix), 2);
+        CHECK(fix.valid && fix.has_altitude);
+        CHECK_EQUAL(fix.latitude_e7, -335020500);  // 33°30.123' = 33.50205°
+        CHECK_EQUAL(fix.longitude_e7, -707510000);  // 70°45.060' = 70.751°
+        CHECK_EQUAL(fix.altitude_mm, -12300);
+        CHECK_EQUAL(fix.speed_mm_s, 5144);  // 10ノット = 5.144m/s
+        CHECK_EQUAL(fix.course_e5, 27050000);
+        CHECK_EQUAL(fix.time_ms, 86399250);
+        CHECK_EQUAL(fix.satellites, 9);
+
+        CHECK_EQUAL(feed(parser, capture::nmea_sentence("GNVTG,90.25,T,,M,,N,36.000,K,A"), fix), 1);
+        CHECK_EQUAL(fix.speed_mm_s, 10000);  // 36km/h = 10m/s
+        CHECK_EQUAL(fix.course_e5, 9025000);
+        CHECK_EQUAL(fix.latitude_e7, -335020500);  // 文に含まれない値はそのまま
+    }
+
+    sc::UART uart(false, sc::Pin(0), sc::Pin(1), 115200);
+    sc::GNSS gnss(uart);
+
+    // set_ubx はNAV-PVTを出力し，NMEAの6種類の文を止め，測位の間隔を設定するメッセージを送る
+    // チェックサムはu-bloxの仕様書の計算方法で手計算したもの
+    {
+        gnss.set_ubx(200);
+        fake::run_for_us(20000);
+        const uint8_t expected[] = {
+            0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0x01, 0x07, 0x01, 0x13, 0x51,  // CFG-MSG NAV-PVT 1回ごと
+            0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x00, 0x00, 0xFA, 0x0F,  // CFG-MSG GGA 止める
+            0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x01, 0x00, 0xFB, 0x11,  // GLL
+            0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x02, 0x00, 0xFC, 0x13,  // GSA
+            0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x03, 0x00, 0xFD, 0x15,  // GSV
+            0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x04, 0x00, 0xFE, 0x17,  // RMC
+            0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0xF0, 0x05, 0x00, 0xFF, 0x19,  // VTG
+            0xB5, 0x62, 0x06, 0x08, 0x06, 0x00, 0xC8, 0x00, 0x01, 0x00, 0x01, 0x00, 0xDE, 0x6A};  // CFG-RATE 200ms, 1回ごと, GPS時刻
+        CHECK(fake::uart_sent(uart0) == std::vector<uint8_t>(expected, expected + sizeof(expected)));
+
+        bool thrown = false;
+        try {gnss.set_ubx(0);} catch (const sc::Error&) {thrown = true;}
+        CHECK(thrown);
+        CHECK_EQUAL(fake::uart_sent(uart0).size(), sizeof(expected));  // 何も送らない
+    }
+
+    // 受信機が切り替わる間はNMEAとUBXが混ざって届く  どちらも読み込み，UBXのペイロードの中の'$'はNMEAとして読まない
+    {
+        const uint8_t ack[] = {0x06, 0x01};
+        uint8_t ack_frame[2 + sc::UBXParser::FrameOverhead];
+        std::string ack_ack(reinterpret_cast<const char*>(ack_frame), sc::UBXParser::build_frame(0x05, 0x01, sizeof(ack), ack, ack_frame));
+
+        receive(capture::nmea_sentence("GNRMC,120000.00,A,3330.12300,S,07045.06000,W,10.000,270.50,160426,,,A")
+                + ack_ack
+                + nav_pvt(SouthWest, "$GNGGA,000000.00,0000.00000,N,00000.00000,E,1,")
+                + capture::nmea_sentence("GNGGA,120000.50,3330.12300,S,07045.06000,W,1,07,0.9,-12.3,M,20.1,M,,"));
+        gnss.measure();
+        CHECK_EQUAL(gnss.nmea().sentences(), 2);
+        CHECK_EQUAL(gnss.nmea().errors(), 0);  // ペイロードの'$'から始まる文を読みかけていれば，次の'$'で捨てたことになる
+        CHECK_EQUAL(gnss.ubx().frames(), 2);
+        CHECK_EQUAL(gnss.ubx().acks(), 1);
+
+        // 最後に届いたGGAの値  GGAに含まれない速度と進行方向はNAV-PVTの値のまま
+        const sc::GNSSFix& fix = gnss.fix();
+        CHECK_EQUAL(fix.latitude_e7, -335020500);
+        CHECK_EQUAL(fix.longitude_e7, -707510000);
+        CHECK_EQUAL(fix.altitude_mm, -12300);
+        CHECK_EQUAL(fix.time_ms, 43200500);
+        CHECK_EQUAL(fix.satellites, 7);
+        CHECK_EQUAL(fix.speed_mm_s, 12345);
+        CHECK_EQUAL(fix.course_e5, 27012345);
+        CHECK(gnss.latitude() > -33.50206 && gnss.latitude() < -33.50204);
+        CHECK(gnss.longitude() > -70.75101 && gnss.longitude() < -70.75099);
+        CHECK(gnss.altitude() > -12.31 && gnss.altitude() < -12.29);
+        CHECK(gnss.speed() > 12.344 && gnss.speed() < 12.346);
+        CHECK(gnss.course() > 270.12344 && gnss.course() < 270.12346);
+    }
+
+    // 読み込みの途中でメッセージが途切れても，続きを受信した後の measure で読み込む
+    {
+        Pvt next = SouthWest;
+        next.latitude_e7 = -235505300;
+        std::string frame = nav_pvt(next, "$");
+        receive(frame.substr(0, 50));
+        gnss.measure();
+        CHECK_EQUAL(gnss.fix().latitude_e7, -335020500);
+        receive(frame.substr(50));
+        gnss.measure();
+        CHECK_EQUAL(gnss.fix().latitude_e7, -235505300);
+        CHECK_EQUAL(gnss.fix().altitude_mm, 760123);
+        CHECK_EQUAL(gnss.ubx().frames(), 3);
+        CHECK_EQUAL(gnss.nmea().errors(), 0);
+        CHECK(gnss.check_connection());
+    }
+
+    return check::result();
+}
@@ -0,0 +1,179 @@
+// I2CAsyncのテスト  シミュレーション上のI2CとDMAで，予約した通信の結果と，待機する通信と交互に使えることを確認する
+#include <cstdio>
+
+#include "check.hpp"
+#include "fake_sdk.hpp"
+#include "i2c_async.hpp"
+
+namespace
+{
+    const uint8_t BME280Addr = 0x76;
+    const uint8_t MissingAddr = 0x50;  // 接続していないデバイス
+
+    struct Completion
+    {
+        int calls = 0;
+        bool success = false;
+        uint64_t time_ns = 0;
+    };
+
+    void on_complete(bool success, void* context)
+    {
+        Completion& completion = *static_cast<Completion*>(context);
+        ++completion.calls;
+        completion.success = success;
+        completion.time_ns = fake::now_ns();
+    }
+}
+
+int main()
+{
+    sc::I2C i2c(false, sc::Pin(4), sc::Pin(5), 400000);
+    sc::I2CAsync async(i2c);
+    uint8_t* memory = fake::i2c_device(i2c0, BME280Addr);
+    for (int i = 0; i < 256; ++i) memory[i] = static_cast<uint8_t>(i ^ 0x5a);
+
+    // 読み込み  コールバック関数と番号の両方で完了を確認できる
+    {
+        uint8_t data[8] = {};
+        Completion completion;
+        uint64_t start_ns = fake::now_ns();
+        sc::I2CAsync::Handle handle = async.read_mem(0xf7, data, BME280Addr, on_complete, &completion);
+        CHECK(!async.is_done(handle));
+        CHECK(fake::now_ns() == start_ns);  // 予約はすぐに戻る
+        CHECK(async.wait(handle));
+        CHECK_EQUAL(completion.calls, 1);
+        CHECK(completion.success);
+        for (int i = 0; i < 8; ++i) CHECK_EQUAL(data[i], (0xf7 + i) ^ 0x5a);
+        std::printf("8-byte read_mem at 400kHz: %.1f us\n", (completion.time_ns - start_ns) / 1e3);
+    }
+
+    // 書き込み
+    {
+        const uint8_t output[3] = {0x11, 0x22, 0x33};
+        CHECK(async.wait(async.write_mem(0xf2, output, BME280Addr)));
+        CHECK_EQUAL(memory[0xf2], 0x11);
+        CHECK_EQUAL(memory[0xf3], 0x22);
+        CHECK_EQUAL(memory[0xf4], 0x33);
+    }
+
+    // 予約をいっぱいにして，順番に完了することと，待っている間に処理を進められることを確認
+    {
+        uint8_t data[sc::I2CAsync::QueueSize][8];
+        sc::I2CAsync::Handle handles[sc::I2CAsync::QueueSize];
+        for (std::size_t i = 0; i < sc::I2CAsync::QueueSize; ++i) handles[i] = async.read_mem(static_cast<uint8_t>(0x80 + 8 * i), data[i], BME280Addr);
+        CHECK(async.is_full());
+
+        // 予約がいっぱいのときは例外を投げ，割り込みは許可したまま戻る
+        uint8_t extra[8];
+        bool thrown = false;
+        try {async.read_mem(0x00, extra, BME280Addr);} catch (const sc::Error&) {thrown = true;}
+        CHECK(thrown);
+        CHECK(fake::interrupts_enabled());
+
+        std::size_t work = 0;  // 通信している間にメインループで進められた処理 (1μsごとに1回)
+        while (async.pending())
+        {
+            tight_loop_contents();
+            ++work;
+        }
+        for (std::size_t i = 0; i < sc::I2CAsync::QueueSize; ++i)
+        {
+            CHECK(async.is_succeeded(handles[i]));
+            CHECK_EQUAL(data[i][7], (0x80 + 8 * i + 7) ^ 0x5a);
+        }
+        CHECK(work > 1000);  // 8回の通信(約2ms)の間，CPUは待たずに済む
+    }
+
+    // 大きすぎる通信は例外を投げ，割り込みは許可したまま戻る
+    {
+        uint8_t data[sc::I2CAsync::MaxDataBytes + 1];
+        bool thrown = false;
+        try {async.read_mem(0x00, data, BME280Addr);} catch (const sc::Error&) {thrown = true;}
+        CHECK(thrown);
+        CHECK(fake::interrupts_enabled());
+        CHECK_EQUAL(async.pending(), 0);
+    }
+
+    // 応答しないデバイスとの通信は失敗とし，次の予約は続けて実行する
+    {
+        uint8_t missing[2];
+        uint8_t data[2];
+        Completion completion;
+        sc::I2CAsync::Handle failed = async.read_mem(0x00, missing, MissingAddr, on_complete, &completion);
+        sc::I2CAsync::Handle next = async.read_mem(0x10, data, BME280Addr);
+        CHECK(!async.wait(failed));
+        CHECK_EQUAL(completion.calls, 1);
+        CHECK(!completion.success);
+        CHECK(async.wait(next));
+        CHECK_EQUAL(data[1], 0x11 ^ 0x5a);
+    }
+
+    // 予約した通信がすべて完了した後は，待機する通信が停止信号やエラーのフラグを受け取れる
+    {
+        uint8_t data[4];
+        i2c.read_mem(0x20, 4, data, BME280Addr);
+        CHECK_EQUAL(data[3], 0x23 ^ 0x5a);
+        bool thrown = false;
+        try {i2c.read_mem(0x00, 1, data, MissingAddr);} catch (const sc::Error&) {thrown = true;}
+        CHECK(thrown);  // NACKを見逃さない
+        CHECK_EQUAL(fake::i2c_stolen_flags(i2c0), 0);
+
+        // 待機する通信の後も，予約した通信を続けて使える
+        CHECK(async.wait(async.read_mem(0x30, data, BME280Addr)));
+        CHECK_EQUAL(data[0], 0x30 ^ 0x5a);
+        i2c.read_mem(0x40, 4, data, BME280Addr);
+        CHECK_EQUAL(data[0], 0x40 ^ 0x5a);
+        CHECK_EQUAL(fake::i2c_stolen_flags(i2c0), 0);
+    }
+
+    // デバイスごとの通信速度は，前回と異なる速度のデバイスと通信するときだけ切り替える
+    // 待機する通信でも，割り込み処理の中で始める予約した通信でも同じ
+    {
+        const uint8_t SlowAddr = 0x68;  // 100kHzまでのデバイス
+        uint8_t* slow_memory = fake::i2c_device(i2c0, SlowAddr);
+        for (int i = 0; i < 256; ++i) slow_memory[i] = static_cast<uint8_t>(i ^ 0xa5);
+        i2c.set_max_freq(SlowAddr, 100000);
+        CHECK_EQUAL(i2c.freq(SlowAddr), 100000);
+        CHECK_EQUAL(i2c.freq(BME280Addr), 400000);  // 設定していないデバイスはセットアップ時の速度
+        CHECK_EQUAL(i2c.freq_changes(), 0);  // ここまでの通信はすべてセットアップ時の速度
+
+        uint8_t data[4];
+        for (int i = 0; i < 3; ++i) i2c.read_mem(0x00, 4, data, SlowAddr);
+        CHECK_EQUAL(i2c.freq_changes(), 1);  // 最初の1回だけ切り替える
+        CHECK_EQUAL(fake::i2c_baudrate(i2c0), 100000);
+        CHECK_EQUAL(data[3], 0x03 ^ 0xa5);
+        i2c.read_mem(0x00, 4, data, BME280Addr);
+        i2c.read_mem(0x00, 4, data, BME280Addr);
+        CHECK_EQUAL(i2c.freq_changes(), 2);
+        CHECK_EQUAL(fake::i2c_baudrate(i2c0), 400000);
+
+        // 予約した通信  遅いデバイス，遅いデバイス，速いデバイス，速いデバイス，遅いデバイスの順で3回切り替える
+        const uint8_t order[] = {SlowAddr, SlowAddr, BME280Addr, BME280Addr, SlowAddr};
+        uint8_t results[sizeof(order)][4];
+        sc::I2CAsync::Handle handles[sizeof(order)];
+        for (std::size_t i = 0; i < sizeof(order); ++i) handles[i] = async.read_mem(0x10, results[i], order[i]);
+        bool succeeded = true;
+        for (std::size_t i = 0; i < sizeof(order); ++i) succeeded &= async.wait(handles[i]);
+        CHECK(succeeded);
+        CHECK_EQUAL(i2c.freq_changes(), 5);
+        CHECK_EQUAL(results[1][0], 0x10 ^ 0xa5);
+        CHECK_EQUAL(results[2][0], 0x10 ^ 0x5a);
+        CHECK_EQUAL(fake::i2c_baudrate(i2c0), 100000);
+
+        // 切り替えた速度で通信している  同じ通信でも100kHzのデバイスは400kHzのデバイスの4倍かかる
+        uint64_t busy_ns = fake::i2c_busy_ns(i2c0);
+        CHECK(async.wait(async.read_mem(0x10, data, SlowAddr)));
+        uint64_t slow_ns = fake::i2c_busy_ns(i2c0) - busy_ns;
+        busy_ns = fake::i2c_busy_ns(i2c0);
+        CHECK(async.wait(async.read_mem(0x10, data, BME280Addr)));
+        uint64_t fast_ns = fake::i2c_busy_ns(i2c0) - busy_ns;
+        CHECK(slow_ns > 3 * fast_ns && slow_ns < 5 * fast_ns);
+        CHECK_EQUAL(i2c.freq_changes(), 6);
+
+        // 切り替えにかかった時間を合計する  シミュレーションでは1回あたり1μs
+        CHECK_EQUAL(i2c.freq_change_time_us(), 6);
+    }
+
+    return check::result();
+}
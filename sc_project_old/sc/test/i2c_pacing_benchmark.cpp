@@ -0,0 +1,88 @@
+// I2Cの通信の間隔の空け方による，1秒あたりの通信回数の比較
+// 以前の実装(メモリアドレスの書き込みと読み込みの後にそれぞれ10ms待つ)と，デバイスごとに最低限の間隔だけを空ける実装(I2C::set_min_interval)を，
+// シミュレーション上のI2C(400kHz)で比べる  時刻はシミュレーション上の時刻なので，結果は実行するパソコンによらない
+#include <cstdio>
+
+#include "check.hpp"
+#include "fake_sdk.hpp"
+#include "sc.hpp"
+
+namespace
+{
+    const uint8_t BME280Addr = 0x76;  // 気圧センサ
+    const uint8_t IMUAddr = 0x68;  // 加速度センサ
+    const std::size_t Transactions = 1000;  // 1つの場合に行う通信の回数
+
+    // 通信をTransactions回行い，1秒あたりの通信回数を返す
+    // transaction : i番目の通信を行う関数
+    template<typename Transaction> double measure(Transaction transaction)
+    {
+        uint64_t start_ns = fake::now_ns();
+        for (std::size_t i = 0; i < Transactions; ++i) transaction(i);
+        return Transactions / ((fake::now_ns() - start_ns) / 1e9);
+    }
+
+    void print(const char* name, double transactions_per_second)
+    {
+        std::printf("  %-52s %10.0f transactions/s\n", name, transactions_per_second);
+    }
+}
+
+int main()
+{
+    sc::I2C i2c(false, sc::Pin(4), sc::Pin(5), 400000);
+    fake::i2c_device(i2c0, BME280Addr)[0xd0] = 0x60;
+    fake::i2c_device(i2c0, IMUAddr)[0x75] = 0x68;
+    uint8_t data[8];
+
+    std::printf("I2C 400kHz, 8-byte register reads (simulated bus)\n");
+
+    // 以前の実装  read_mem はメモリアドレスの書き込み(停止信号あり)と読み込みの2回の通信で，それぞれの後に10ms待つ
+    double fixed_sleep = measure([&](std::size_t i) {
+        uint8_t slave_addr = (i & 1) ? IMUAddr : BME280Addr;
+        uint8_t memory_addr = 0xf7;
+        i2c_write_blocking(i2c0, slave_addr, &memory_addr, 1, false);
+        sleep_ms(10);
+        i2c_read_blocking(i2c0, slave_addr, data, 8, false);
+        sleep_ms(10);
+    });
+    print("before: write, sleep_ms(10), read, sleep_ms(10)", fixed_sleep);
+
+    // 間隔を設定しない場合は続けて通信する
+    double unpaced = measure([&](std::size_t i) {
+        i2c.read_mem(0xf7, 8, data, (i & 1) ? IMUAddr : BME280Addr);
+    });
+    print("after: no minimum interval", unpaced);
+
+    // 気圧センサだけに2msの間隔を設定  加速度センサとの通信はその間に行える
+    const uint32_t MinIntervalUs = 2000;
+    i2c.set_min_interval(BME280Addr, MinIntervalUs);
+    uint64_t last_bme280_ns = 0;
+    uint64_t min_gap_ns = UINT64_MAX;  // 気圧センサとの通信が完了した時刻の間隔の最小値
+    double paced = measure([&](std::size_t i) {
+        if (i % 4 == 0)
+        {
+            i2c.read_mem(0xf7, 8, data, BME280Addr);
+            uint64_t complete_ns = fake::now_ns();
+            if (last_bme280_ns && complete_ns - last_bme280_ns < min_gap_ns) min_gap_ns = complete_ns - last_bme280_ns;
+            last_bme280_ns = complete_ns;
+        } else {
+            i2c.read_mem(0x3b, 6, data, IMUAddr);
+        }
+    });
+    print("after: BME280 every 2ms, IMU in between", paced);
+
+    // 同じデバイスとの通信だけなら，設定した間隔ごとにしか通信しない
+    double paced_single = measure([&](std::size_t) {
+        i2c.read_mem(0xf7, 8, data, BME280Addr);
+    });
+    print("after: BME280 only, 2ms minimum interval", paced_single);
+
+    CHECK(unpaced > fixed_sleep * 10);  // 待たなければ10倍以上通信できる
+    CHECK(paced > fixed_sleep * 10);  // 間隔を設定したデバイスがあっても，ほかのデバイスとの通信は待たない
+    CHECK(min_gap_ns >= MinIntervalUs * 1000ULL);  // 設定した間隔は守られる
+    CHECK(paced_single <= 1e6 / MinIntervalUs);
+    CHECK(paced_single > 0.8e6 / MinIntervalUs);  // 間隔より長くは待たない (通信そのものの時間は約0.25ms)
+    CHECK(fake::i2c_stolen_flags(i2c0) == 0);
+    return check::result();
+}
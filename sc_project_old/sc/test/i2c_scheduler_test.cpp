@@ -0,0 +1,121 @@
+// I2CSchedulerのテスト  シミュレーション上のI2C(400kHz)で，通信を枠に詰める動作，I2C0とI2C1の並行動作，通信時間の割合を確認する
+#include <cstdio>
+
+#include "check.hpp"
+#include "fake_sdk.hpp"
+#include "i2c_scheduler.hpp"
+
+namespace
+{
+    const uint8_t IMUAddr = 0x68;
+    const uint8_t BME280Addr = 0x76;
+    const uint8_t MagAddr = 0x1e;
+
+    // 読み込みが完了した時刻
+    struct Completion
+    {
+        uint32_t calls = 0;
+        uint64_t time_ns = 0;
+    };
+
+    void on_complete(bool, void* context)
+    {
+        Completion& completion = *static_cast<Completion*>(context);
+        ++completion.calls;
+        completion.time_ns = fake::now_ns();
+    }
+}
+
+int main()
+{
+    sc::I2C i2c0_master(false, sc::Pin(4), sc::Pin(5), 400000);
+    sc::I2C i2c1_master(true, sc::Pin(3), sc::Pin(2), 400000);
+    sc::I2CAsync i2c0_async(i2c0_master);
+    sc::I2CAsync i2c1_async(i2c1_master);
+    for (uint8_t addr : {IMUAddr, BME280Addr, MagAddr})
+    {
+        fake::i2c_device(i2c0, addr);
+        fake::i2c_device(i2c1, addr);
+    }
+
+    // 通信時間の見込みはシミュレーション上の通信時間と一致する (クロックストレッチがないため)
+    {
+        Completion completion;
+        uint8_t data[8];
+        uint64_t start_ns = fake::now_ns();
+        i2c0_async.wait(i2c0_async.read_mem(0xf7, data, BME280Addr, on_complete, &completion));
+        CHECK_EQUAL((completion.time_ns - start_ns) / 1000, i2c0_async.read_mem_time_us(8, BME280Addr));
+    }
+
+    // 予約済みの通信が終わるまでに読み込みの時刻になる通信は，同じtick()で続けて予約される
+    {
+        sc::I2CScheduler scheduler(i2c0_async);
+        const uint32_t PeriodUs = 4000;
+        uint8_t long_data[32], b_data[8], c_data[8];
+        Completion long_done, b_done, c_done;
+
+        // 読み込みの時刻を 0μs, 500μs, 1000μs ずらして登録する  (登録した時点で最初の読み込みの時刻になる)
+        uint64_t origin_ns = fake::now_ns();
+        scheduler.add_job(false, MagAddr, 0x00, sizeof(long_data), long_data, PeriodUs, 0, 0, on_complete, &long_done);
+        scheduler.tick();
+        fake::run_for_us(500);
+        scheduler.add_job(false, BME280Addr, 0xf7, sizeof(b_data), b_data, PeriodUs, 0, 0, on_complete, &b_done);
+        scheduler.tick();
+        fake::run_for_us(500);
+        scheduler.add_job(false, IMUAddr, 0x3b, sizeof(c_data), c_data, PeriodUs, 0, 0, on_complete, &c_done);
+        scheduler.tick();
+
+        // 2周期目は，最初の読み込みの時刻に1回だけtick()を呼び出す
+        fake::run_for_us(origin_ns / 1000 + PeriodUs - fake::now_ns() / 1000);
+        uint64_t tick_ns = fake::now_ns();
+        uint64_t busy_start_ns = fake::i2c_busy_ns(i2c0);
+        scheduler.tick();
+        CHECK_EQUAL(i2c0_async.pending(), 3);  // 長い通信の間に残りの2つが読み込みの時刻になるので，まとめて予約する
+        fake::run_for_us(PeriodUs / 2);
+
+        CHECK_EQUAL(long_done.calls, 2);
+        CHECK_EQUAL(b_done.calls, 2);
+        CHECK_EQUAL(c_done.calls, 2);
+        uint64_t b_start_ns = b_done.time_ns - i2c0_async.read_mem_time_us(8, BME280Addr) * 1000ULL;
+        uint64_t c_start_ns = c_done.time_ns - i2c0_async.read_mem_time_us(8, IMUAddr) * 1000ULL;
+        CHECK(b_start_ns >= tick_ns + 500000);  // 読み込みの時刻より前には通信しない
+        CHECK(c_start_ns >= tick_ns + 1000000);
+        CHECK_EQUAL(b_start_ns, long_done.time_ns);  // 前の通信が終わるとすぐに次の通信が始まる
+        CHECK_EQUAL(c_start_ns, b_done.time_ns);
+        CHECK_EQUAL(fake::i2c_busy_ns(i2c0) - busy_start_ns, c_done.time_ns - tick_ns);  // tick()を呼び出してから最後の通信が終わるまで，バスは空かない
+        CHECK_EQUAL(scheduler.deadline_misses(), 0);
+    }
+
+    // I2C0とI2C1の通信は同時に進む  それぞれ約69%の通信を，1秒間，100μsごとのtick()で行う
+    {
+        sc::I2CScheduler scheduler(i2c0_async, i2c1_async);
+        uint8_t data[4][12];
+        scheduler.add_job(false, IMUAddr, 0x3b, 12, data[0], 1000, 600, 2);
+        scheduler.add_job(false, MagAddr, 0x03, 12, data[1], 1000, 0, 1);
+        scheduler.add_job(true, IMUAddr, 0x3b, 12, data[2], 1000, 600, 2);
+        scheduler.add_job(true, MagAddr, 0x03, 12, data[3], 1000, 0, 1);
+
+        uint64_t start_ns = fake::now_ns();
+        uint64_t busy_start_ns[2] = {fake::i2c_busy_ns(i2c0), fake::i2c_busy_ns(i2c1)};
+        while (fake::now_ns() - start_ns < 1000000000ULL)
+        {
+            scheduler.tick();
+            sleep_us(100);
+        }
+        double elapsed_ns = static_cast<double>(fake::now_ns() - start_ns);
+        double actual[2] = {(fake::i2c_busy_ns(i2c0) - busy_start_ns[0]) / elapsed_ns, (fake::i2c_busy_ns(i2c1) - busy_start_ns[1]) / elapsed_ns};
+        std::printf("utilization I2C0: %.3f (simulated %.3f), I2C1: %.3f (simulated %.3f), deadline misses: %u\n",
+                    scheduler.utilization(false), actual[0], scheduler.utilization(true), actual[1], static_cast<unsigned>(scheduler.deadline_misses()));
+
+        CHECK(actual[0] + actual[1] > 1.0);  // 1本のI2Cでは運べない量の通信
+        for (int i = 0; i < 2; ++i)
+        {
+            CHECK(actual[i] > 0.68);
+            CHECK(scheduler.utilization(i) > actual[i] - 0.01 && scheduler.utilization(i) < actual[i] + 0.01);
+        }
+        CHECK_EQUAL(scheduler.deadline_misses(), 0);
+        CHECK_EQUAL(scheduler.failures(), 0);
+    }
+
+    return check::result();
+}
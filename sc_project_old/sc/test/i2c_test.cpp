@@ -0,0 +1,141 @@
+// I2C(待機する通信)のテスト  シミュレーション上のI2C(400kHz)を使う
+// read_mem と read_mem_burst が再開始信号で1回の通信になることと，読み込めなかった場合に例外を投げることを確認する
+// scan で記録した結果を is_present が返すことと，device_id が読み込んだIDを8個まで記録して通信せずに返すことも確認する
+#include "check.hpp"
+#include "fake_sdk.hpp"
+#include "sc.hpp"
+
+namespace
+{
+    const uint8_t DeviceAddr = 0x76;
+    const uint8_t AbsentAddr = 0x77;
+
+    // 前回呼び出してから増えた通信(停止信号まで)の数
+    uint32_t new_transactions()
+    {
+        static uint32_t last = 0;
+        uint32_t transactions = fake::i2c_transactions(i2c0);
+        uint32_t added = transactions - last;
+        last = transactions;
+        return added;
+    }
+}
+
+int main()
+{
+    sc::I2C i2c(false, sc::Pin(4), sc::Pin(5), 400000);
+    uint8_t* memory = fake::i2c_device(i2c0, DeviceAddr);
+    for (int i = 0; i < 256; ++i) memory[i] = static_cast<uint8_t>(i ^ 0x5a);
+
+    // メモリアドレスの送信と受信の間に停止信号を送らないので，1回の通信になる
+    {
+        new_transactions();
+        uint8_t data[8] = {};
+        i2c.read_mem(0xf7, data, DeviceAddr);
+        CHECK_EQUAL(new_transactions(), 1);
+        bool matched = true;
+        for (int i = 0; i < 8; ++i) matched &= (data[i] == ((0xf7 + i) ^ 0x5a));
+        CHECK(matched);
+    }
+
+    // 離れた複数の範囲も，最後の範囲まで停止信号を送らずに1回の通信で読み込む
+    {
+        new_transactions();
+        uint8_t a[2] = {}, b[4] = {}, c[1] = {};
+        i2c.read_mem_burst({{0x10, sizeof(a), a}, {0x80, sizeof(b), b}, {0xf0, sizeof(c), c}}, DeviceAddr);
+        CHECK_EQUAL(new_transactions(), 1);
+        CHECK_EQUAL(a[0], 0x10 ^ 0x5a);
+        CHECK_EQUAL(a[1], 0x11 ^ 0x5a);
+        CHECK_EQUAL(b[0], 0x80 ^ 0x5a);
+        CHECK_EQUAL(b[3], 0x83 ^ 0x5a);
+        CHECK_EQUAL(c[0], 0xf0 ^ 0x5a);
+
+        i2c.read_mem_burst({}, DeviceAddr);  // 範囲がなければ通信しない
+        CHECK_EQUAL(new_transactions(), 0);
+    }
+
+    // 応答しないデバイスからは読み込めないので例外を投げる  その後も他のデバイスとは通信できる
+    {
+        bool thrown = false;
+        uint8_t data[2];
+        try
+        {
+            i2c.read_mem(0x00, data, AbsentAddr);
+        }
+        catch(const std::exception&)
+        {
+            thrown = true;
+        }
+        CHECK(thrown);
+
+        thrown = false;
+        try
+        {
+            i2c.read_mem_burst({{0x10, 1, data}, {0x20, 1, data + 1}}, AbsentAddr);
+        }
+        catch(const std::exception&)
+        {
+            thrown = true;
+        }
+        CHECK(thrown);
+
+        i2c.read_mem(0x20, 1, data, DeviceAddr);
+        CHECK_EQUAL(data[0], 0x20 ^ 0x5a);
+    }
+
+    // scanを呼び出すまでは，接続を確かめる手段がないので常にtrue
+    // scanの後は通信せずに記録を返す  予約されているアドレス(0x00~0x07, 0x78~0x7f)は調べない
+    {
+        const sc::Communication& communication = i2c;
+        CHECK(i2c.is_present(AbsentAddr));
+        fake::i2c_device(i2c0, 0x08);
+        fake::i2c_device(i2c0, 0x77 + 1);
+        CHECK_EQUAL(i2c.scan(), 2);  // DeviceAddrと0x08
+        CHECK(i2c.is_present(DeviceAddr));
+        CHECK(i2c.is_present(0x08));
+        CHECK(!i2c.is_present(0x78));
+        CHECK(!i2c.is_present(AbsentAddr));
+        CHECK(!communication.is_present(AbsentAddr));  // Communicationとして呼び出しても同じ
+        new_transactions();
+        CHECK(i2c.is_present(DeviceAddr));
+        CHECK_EQUAL(new_transactions(), 0);
+
+        fake::i2c_remove_device(i2c0, 0x08);
+        CHECK_EQUAL(i2c.scan(), 1);  // 前回の記録は消してから調べ直す
+        CHECK(!i2c.is_present(0x08));
+    }
+
+    // device_id は一度読み込んだIDを記録し，次からは通信せずに返す
+    {
+        new_transactions();
+        CHECK_EQUAL(i2c.device_id(0xd0, DeviceAddr), 0xd0 ^ 0x5a);
+        CHECK_EQUAL(new_transactions(), 1);
+        memory[0xd0] = 0x60;  // 記録したIDを返すので，レジスタが変わっても読み込み直さない
+        CHECK_EQUAL(i2c.device_id(0xd0, DeviceAddr), 0xd0 ^ 0x5a);
+        CHECK_EQUAL(new_transactions(), 0);
+
+        // スキャンで見つからなかったデバイスは，通信せずに例外を投げる
+        bool thrown = false;
+        try
+        {
+            i2c.device_id(0xd0, AbsentAddr);
+        }
+        catch(const std::exception&)
+        {
+            thrown = true;
+        }
+        CHECK(thrown);
+        CHECK_EQUAL(new_transactions(), 0);
+
+        // 記録できるのは8個まで  それより後のIDは毎回読み込む
+        for (uint8_t addr = 0x01; addr < 0x08; ++addr) i2c.device_id(addr, DeviceAddr);
+        CHECK_EQUAL(new_transactions(), 7);
+        for (uint8_t addr = 0x01; addr < 0x08; ++addr) i2c.device_id(addr, DeviceAddr);
+        CHECK_EQUAL(new_transactions(), 0);
+        CHECK_EQUAL(i2c.device_id(0x08, DeviceAddr), 0x08 ^ 0x5a);
+        CHECK_EQUAL(i2c.device_id(0x08, DeviceAddr), 0x08 ^ 0x5a);
+        CHECK_EQUAL(new_transactions(), 2);
+    }
+
+    return check::result();
+}
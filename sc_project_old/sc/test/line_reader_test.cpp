@@ -0,0 +1,162 @@
+// LineReaderとCommunication::read_lineのテスト  用意したデータを決まった大きさずつ返す通信を使う
+// 区切り文字をどの位置・境界からでも見つけることと，バッファに収まらない行の扱い，'\r'の取り除きを確認する
+#include <cstring>
+#include <string>
+
+#include "check.hpp"
+#include "fake_sdk.hpp"
+#include "sc.hpp"
+
+namespace
+{
+    // 用意したデータを先頭から返す通信  read_available は1回に最大 chunk_bytes バイトだけ返す
+    class ScriptedInput : public sc::Communication
+    {
+    public:
+        std::string data;
+        mutable std::size_t position = 0;  // 次に返すデータの位置
+        std::size_t chunk_bytes = 1024;
+        mutable uint32_t reads = 0;  // read_available を呼び出した回数
+
+        void read(std::size_t input_data_bytes, uint8_t* input_data, uint8_t = DeviceNotSelected) const
+        {
+            for (std::size_t i = 0; i < input_data_bytes; ++i) input_data[i] = (position < data.size() ? static_cast<uint8_t>(data[position++]) : 0);
+        }
+
+        void write(std::size_t, uint8_t*, uint8_t = DeviceNotSelected) const {}
+
+        std::size_t read_available(std::size_t input_data_bytes, uint8_t* input_data, uint8_t = DeviceNotSelected) const
+        {
+            ++reads;
+            std::size_t bytes = data.size() - position;
+            if (bytes > input_data_bytes) bytes = input_data_bytes;
+            if (bytes > chunk_bytes) bytes = chunk_bytes;
+            std::memcpy(input_data, data.data() + position, bytes);
+            position += bytes;
+            return bytes;
+        }
+    };
+
+    bool line_equals(const sc::LineReader::Line& line, const std::string& expected)
+    {
+        return line.size == expected.size() && !std::memcmp(line.data, expected.data(), line.size);
+    }
+
+    // 区切り文字('\n' = 0x0a)と紛らわしいバイトを並べる  最上位ビットだけ違う0x8aや，1だけ違う0x09, 0x0bも含める
+    std::string filler(std::size_t bytes)
+    {
+        static const char Pattern[] = {'x', '\x8a', '\x0b', '\x09', '\x00', '\xff', '\x2a', 'y'};
+        std::string text;
+        for (std::size_t i = 0; i < bytes; ++i) text += Pattern[i % sizeof(Pattern)];
+        return text;
+    }
+}
+
+int main()
+{
+    // 区切り文字がどの位置にあっても，4バイトの境界からどれだけずれていても見つける
+    // 前の行の長さで行の先頭の境界を，受信する大きさで続きを探し始める位置を変える
+    {
+        bool all_found = true;
+        for (std::size_t prefix = 0; prefix < 4; ++prefix)
+        {
+            for (std::size_t length = 0; length < 40; ++length)
+            {
+                for (std::size_t chunk = 1; chunk <= 9; chunk += 4)
+                {
+                    ScriptedInput input;
+                    input.data = filler(prefix) + '\n' + filler(length) + '\n';
+                    input.chunk_bytes = chunk;
+                    alignas(4) uint8_t buffer[64];
+                    sc::LineReader reader(input, buffer);
+                    sc::LineReader::Line line;
+                    int found = 0;
+                    for (int i = 0; i < 100 && found < 2; ++i)
+                    {
+                        if (reader.read_line(line))
+                        {
+                            all_found &= !line.truncated && line_equals(line, found ? filler(length) : filler(prefix));
+                            ++found;
+                        }
+                    }
+                    all_found &= (found == 2) && !reader.read_line(line);
+                }
+            }
+        }
+        CHECK(all_found);
+    }
+
+    // 区切り文字を除いて buffer_bytes-1 バイトの行までは，そのまま取り出せる
+    // buffer_bytes バイトの行は区切り文字がバッファに収まらないので，全体を取り出せていてもtruncatedになる
+    {
+        ScriptedInput input;
+        input.data = std::string(15, 'a') + '\n' + std::string(16, 'b') + '\n' + "next\n";
+        uint8_t buffer[16];
+        sc::LineReader reader(input, buffer);
+        sc::LineReader::Line line;
+        CHECK(reader.read_line(line));
+        CHECK(!line.truncated && line_equals(line, std::string(15, 'a')));
+        CHECK(reader.read_line(line));
+        CHECK(line.truncated && line_equals(line, std::string(16, 'b')));
+        CHECK(reader.read_line(line));  // 残りの区切り文字だけを捨て，次の行を取り出す
+        CHECK(!line.truncated && line_equals(line, "next"));
+        CHECK_EQUAL(reader.lines(), 3);
+        CHECK_EQUAL(reader.overflows(), 1);
+    }
+
+    // バッファに収まらない行の残りを捨てた後，同じ受信で届いた次の行を取り出す
+    {
+        ScriptedInput input;
+        input.data = std::string(20, 'a') + "\nok\r\n";
+        uint8_t buffer[16];
+        sc::LineReader reader(input, buffer);
+        sc::LineReader::Line line;
+        CHECK(reader.read_line(line));
+        CHECK(line.truncated && line_equals(line, std::string(16, 'a')));
+        CHECK_EQUAL(input.reads, 1);
+        CHECK(reader.read_line(line));
+        CHECK(!line.truncated && line_equals(line, "ok"));
+        CHECK_EQUAL(input.reads, 2);  // 残りの4バイトと次の行を1回で受信した
+        CHECK(!reader.read_line(line));
+        CHECK_EQUAL(reader.lines(), 2);
+        CHECK_EQUAL(reader.overflows(), 1);
+    }
+
+    // '\n'の直前の'\r'だけを取り除く  区切り文字が'\n'以外の場合は取り除かない
+    {
+        ScriptedInput input;
+        input.data = "a\r\n\r\na\rb\n";
+        uint8_t buffer[16];
+        sc::LineReader reader(input, buffer);
+        sc::LineReader::Line line;
+        CHECK(reader.read_line(line) && line_equals(line, "a"));
+        CHECK(reader.read_line(line) && line_equals(line, ""));
+        CHECK(reader.read_line(line) && line_equals(line, "a\rb"));
+
+        ScriptedInput other;
+        other.data = "a\r;b;";
+        sc::LineReader semicolon(other, buffer, sc::Communication::DeviceNotSelected, ';');
+        CHECK(semicolon.read_line(line) && line_equals(line, "a\r"));
+        CHECK(semicolon.read_line(line) && line_equals(line, "b"));
+    }
+
+    // Communication::read_line は改行まで(改行を含めて)読み込み，その後ろには書き込まない
+    {
+        ScriptedInput input;
+        input.data = "ab\ncdefgh\n";
+        char text[8];
+        std::memset(text, '-', sizeof(text));
+        input.read_line(text);
+        CHECK(!std::memcmp(text, "ab\n-----", sizeof(text)));
+        CHECK_EQUAL(input.position, 3);
+        input.read_line(text);
+        CHECK(!std::memcmp(text, "cdefgh\n-", sizeof(text)));
+
+        input.data = "0123456789\n";  // 改行が来なくても，指定したバイト数で止める
+        input.position = 0;
+        input.read_line(4, reinterpret_cast<uint8_t*>(text));
+        CHECK_EQUAL(input.position, 4);
+    }
+
+    return check::result();
+}
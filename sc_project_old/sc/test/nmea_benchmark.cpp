@@ -0,0 +1,114 @@
+// NMEAParserとUBXParserの処理速度の測定
+// 合成の10Hzの受信機のキャプチャ(1時間分)をパソコン上で読み込み，1バイトあたりの処理時間を測る
+// 時刻はパソコンの実際の時刻なので，結果は実行するパソコンによって変わる  (RP2040での処理時間は実機で測る必要がある)
+// 読み込みの間にメモリを確保しないことと，壊れた文を捨てて次の文から読み直せることも確認する
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "check.hpp"
+#include "gnss.hpp"
+#include "serial_capture.hpp"
+
+namespace
+{
+    std::size_t Allocations = 0;  // operator newを呼び出した回数
+
+    const uint64_t EpochUs = 100000;  // 10Hz
+    const std::size_t Epochs = 36000;  // 1時間分
+    const int Repeats = 5;  // 測定を繰り返す回数  最も速かった回を結果とする
+
+    struct Result
+    {
+        double ns_per_byte;
+        std::size_t fixes;
+        std::size_t allocations;
+    };
+
+    // dataをすべて読み込むのにかかった時間を測る
+    template<typename Parser> Result measure(const std::string& data)
+    {
+        Result best = {1e30, 0, 0};
+        for (int repeat = 0; repeat < Repeats; ++repeat)
+        {
+            Parser parser;
+            sc::GNSSFix fix;
+            std::size_t fixes = 0;
+            std::size_t allocations = Allocations;
+            auto start = std::chrono::steady_clock::now();
+            for (char c : data) fixes += parser.feed(c, fix);
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            if (ns / data.size() < best.ns_per_byte) best = {ns / data.size(), fixes, Allocations - allocations};
+        }
+        return best;
+    }
+
+    void print(const char* name, const std::string& data, const Result& result)
+    {
+        double bytes_per_second = data.size() / (Epochs * EpochUs / 1e6);  // 10Hzで受信機が送ってくるバイト数 (1秒あたり)
+        std::printf("  %-34s %8.2f ns/byte %8.1f MB/s  %7.0f bytes/s at 10Hz -> %.4f%% of one host core\n",
+                    name, result.ns_per_byte, 1e3 / result.ns_per_byte, bytes_per_second, bytes_per_second * result.ns_per_byte / 1e7);
+    }
+}
+
+// 読み込みの間にメモリを確保していないかを数えるため，operator newを置き換える
+void* operator new(std::size_t size)
+{
+    ++Allocations;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept {std::free(p);}
+void operator delete(void* p, std::size_t) noexcept {std::free(p);}
+
+int main()
+{
+    std::string nmea = capture::synthetic_gnss(Epochs, EpochUs).joined();
+    std::string ubx = capture::synthetic_gnss(Epochs, EpochUs, true).joined();
+    std::printf("parsing one hour of 10Hz receiver output (host CPU time, best of %d)\n", Repeats);
+
+    Result nmea_result = measure<sc::NMEAParser>(nmea);
+    print("NMEA (RMC,VTG,GGA,GSA,GSVx3,GLL)", nmea, nmea_result);
+    CHECK_EQUAL(nmea_result.fixes, 3 * Epochs);  // RMC, VTG, GGA
+    CHECK_EQUAL(nmea_result.allocations, 0);
+
+    Result ubx_result = measure<sc::UBXParser>(ubx);
+    print("UBX NAV-PVT", ubx, ubx_result);
+    CHECK_EQUAL(ubx_result.fixes, Epochs);
+    CHECK_EQUAL(ubx_result.allocations, 0);
+
+    // 10文に1文の割合で1文字壊す  壊れた文だけを捨て，ほかの文は読み込める
+    {
+        capture::SerialCapture source = capture::synthetic_gnss(1000, EpochUs);
+        std::string corrupted;
+        std::size_t sentences = 0, broken = 0, broken_fixes = 0;
+        for (const capture::Burst& burst : source.bursts())
+        {
+            std::size_t begin = 0;
+            while (begin < burst.data.size())
+            {
+                std::size_t end = burst.data.find('\n', begin) + 1;
+                std::string sentence = burst.data.substr(begin, end - begin);
+                if (++sentences % 10 == 0)
+                {
+                    sentence[sentence.size() / 2] ^= 0x01;
+                    ++broken;
+                    if (sentence.compare(3, 3, "RMC") == 0 || sentence.compare(3, 3, "VTG") == 0 || sentence.compare(3, 3, "GGA") == 0) ++broken_fixes;
+                }
+                corrupted += sentence;
+                begin = end;
+            }
+        }
+        sc::NMEAParser parser;
+        sc::GNSSFix fix;
+        std::size_t fixes = 0;
+        for (char c : corrupted) fixes += parser.feed(c, fix);
+        std::printf("  corrupted capture: %u of %u sentences broken, %u checksum errors\n", static_cast<unsigned>(broken), static_cast<unsigned>(sentences), static_cast<unsigned>(parser.errors()));
+        CHECK_EQUAL(parser.errors(), broken);
+        CHECK_EQUAL(fixes, 3 * 1000 - broken_fixes);
+    }
+
+    return check::result();
+}
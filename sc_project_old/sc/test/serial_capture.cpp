@@ -0,0 +1,175 @@
+#include "serial_capture.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include "gnss.hpp"
+
+namespace capture
+{
+    namespace
+    {
+        // 緯度・経度を NMEA の ddmm.mmmmm (経度は dddmm.mmmmm) の形式にする
+        std::string format_coordinate(int32_t value_e7, int degree_digits, char positive, char negative, std::string& hemisphere)
+        {
+            hemisphere = std::string(1, value_e7 < 0 ? negative : positive);
+            int64_t magnitude = std::llabs(static_cast<int64_t>(value_e7));
+            int64_t degrees = magnitude / 10000000;
+            int64_t minutes_e5 = (magnitude % 10000000) * 60 / 100;  // 分×10^5
+            char text[24];
+            std::snprintf(text, sizeof(text), "%0*lld%02lld.%05lld", degree_digits, static_cast<long long>(degrees), static_cast<long long>(minutes_e5 / 100000), static_cast<long long>(minutes_e5 % 100000));
+            return text;
+        }
+
+        std::string format_time(uint32_t time_ms)
+        {
+            char text[16];
+            std::snprintf(text, sizeof(text), "%02u%02u%02u.%02u", time_ms / 3600000, time_ms / 60000 % 60, time_ms / 1000 % 60, time_ms % 1000 / 10);
+            return text;
+        }
+
+        void put_i32(uint8_t* p, int32_t value)
+        {
+            uint32_t u = static_cast<uint32_t>(value);
+            for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(u >> (8 * i));
+        }
+
+        const int32_t SpeedMmS = 5144;  // 合成の測位の対地速度 (10ノット)
+        const int32_t CourseE5 = 4500000;  // 合成の測位の進行方向 (45°)
+    }
+
+    // NMEAの文を改行で区切って記録したログ(受信機の出力をそのまま保存したもの)を読み込む
+    // 時刻は記録されていないため，epoch_sentence の文が現れるたびに新しいバーストとし，epoch_usずつずらす
+    bool SerialCapture::load_nmea_log(const char* path, uint64_t epoch_us, const char* epoch_sentence)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+    return false;
+        std::string line;
+        std::string burst;
+        uint64_t time_us = 0;
+        while (std::getline(file, line))
+        {
+            if (line.size() > 6 && line[0] == '$' && line.compare(3, 3, epoch_sentence) == 0 && !burst.empty())
+            {
+                add(time_us, burst);
+                burst.clear();
+                time_us += epoch_us;
+            }
+            if (!line.empty() && line.back() != '\r') line += '\r';  // 改行だけで記録されたログもCRLFに戻す
+            burst += line + '\n';
+        }
+        if (!burst.empty()) add(time_us, burst);
+        return true;
+    }
+
+    // シミュレーション上のUARTの受信線に，今の時刻を始まりとしてすべてのバーストを流す
+    void SerialCapture::play(uart_inst_t* uart) const
+    {
+        uint64_t start_ns = fake::now_ns();
+        if (fake::uart_receive_end_ns(uart) > start_ns) start_ns = fake::uart_receive_end_ns(uart);
+        for (const Burst& burst : _bursts)
+        {
+            uint64_t burst_ns = start_ns + burst.time_us * 1000;
+            uint64_t end_ns = fake::uart_receive_end_ns(uart);
+            if (end_ns < fake::now_ns()) end_ns = fake::now_ns();
+            uint64_t gap_us = (burst_ns > end_ns ? (burst_ns - end_ns) / 1000 : 0);
+            fake::uart_receive(uart, reinterpret_cast<const uint8_t*>(burst.data.data()), burst.data.size(), gap_us);
+        }
+    }
+
+    // すべてのバーストのバイト数の合計
+    std::size_t SerialCapture::bytes() const
+    {
+        std::size_t bytes = 0;
+        for (const Burst& burst : _bursts) bytes += burst.data.size();
+        return bytes;
+    }
+
+    // すべてのバイトを1つにつなげたもの
+    std::string SerialCapture::joined() const
+    {
+        std::string data;
+        for (const Burst& burst : _bursts) data += burst.data;
+        return data;
+    }
+
+    // NMEAの文を作る  $と*の間の内容にチェックサムと改行を付ける
+    std::string nmea_sentence(const std::string& body)
+    {
+        uint8_t checksum = 0;
+        for (char c : body) checksum ^= static_cast<uint8_t>(c);
+        char tail[8];
+        std::snprintf(tail, sizeof(tail), "*%02X\r\n", checksum);
+        return "$" + body + tail;
+    }
+
+    // 測位の内容から，u-blox受信機の標準の出力と同じ種類と順番の文(RMC, VTG, GGA, GSA, GSV×3, GLL)を作る
+    std::string nmea_epoch(const Epoch& epoch)
+    {
+        std::string ns, ew;
+        std::string latitude = format_coordinate(epoch.latitude_e7, 2, 'N', 'S', ns);
+        std::string longitude = format_coordinate(epoch.longitude_e7, 3, 'E', 'W', ew);
+        std::string time = format_time(epoch.time_ms);
+        char altitude[16];
+        std::snprintf(altitude, sizeof(altitude), "%.1f", epoch.altitude_mm / 1000.0);
+
+        std::string sentences;
+        sentences += nmea_sentence("GNRMC," + time + ",A," + latitude + "," + ns + "," + longitude + "," + ew + ",10.000,45.00,160426,,,A");
+        sentences += nmea_sentence("GNVTG,45.00,T,,M,10.000,N,18.520,K,A");
+        sentences += nmea_sentence("GNGGA," + time + "," + latitude + "," + ns + "," + longitude + "," + ew + ",1,12,0.78," + altitude + ",M,39.4,M,,");
+        sentences += nmea_sentence("GNGSA,A,3,02,05,07,09,13,15,20,30,,,,,1.30,0.78,1.04");
+        sentences += nmea_sentence("GPGSV,3,1,12,02,45,120,40,05,60,045,42,07,30,300,38,09,15,200,35");
+        sentences += nmea_sentence("GPGSV,3,2,12,13,70,010,44,15,25,250,37,20,50,090,41,30,10,330,30");
+        sentences += nmea_sentence("GPGSV,3,3,12,04,05,180,,11,08,020,,18,03,270,,24,02,140,");
+        sentences += nmea_sentence("GNGLL," + latitude + "," + ns + "," + longitude + "," + ew + "," + time + ",A,A");
+        return sentences;
+    }
+
+    // 測位の内容から，UBXのNAV-PVTメッセージを作る
+    std::string ubx_nav_pvt(const Epoch& epoch)
+    {
+        uint8_t payload[sc::UBXParser::NavPvtLength] = {};
+        payload[8] = static_cast<uint8_t>(epoch.time_ms / 3600000);
+        payload[9] = static_cast<uint8_t>(epoch.time_ms / 60000 % 60);
+        payload[10] = static_cast<uint8_t>(epoch.time_ms / 1000 % 60);
+        put_i32(payload + 16, static_cast<int32_t>(epoch.time_ms % 1000) * 1000000);
+        payload[20] = 3;  // 3D
+        payload[21] = 0x01;  // gnssFixOK
+        payload[23] = 12;
+        put_i32(payload + 24, epoch.longitude_e7);
+        put_i32(payload + 28, epoch.latitude_e7);
+        put_i32(payload + 32, epoch.altitude_mm + 39400);
+        put_i32(payload + 36, epoch.altitude_mm);
+        put_i32(payload + 60, SpeedMmS);
+        put_i32(payload + 64, CourseE5);
+        uint8_t frame[sizeof(payload) + sc::UBXParser::FrameOverhead];
+        std::size_t frame_bytes = sc::UBXParser::build_frame(0x01, 0x07, sizeof(payload), payload, frame);
+        return std::string(reinterpret_cast<const char*>(frame), frame_bytes);
+    }
+
+    // 北東へ進み続ける合成の測位を作る
+    Epoch synthetic_epoch(std::size_t i, uint64_t epoch_us)
+    {
+        Epoch epoch;
+        int32_t step_e7 = static_cast<int32_t>(SpeedMmS * 0.7071 * (epoch_us / 1e6) / 11.132);  // 1回の測位の間に北と東へ進む角度 (°×10^7)  1°≒111.32km
+        epoch.latitude_e7 = 356812345 + static_cast<int32_t>(i) * step_e7;
+        epoch.longitude_e7 = 1397671234 + static_cast<int32_t>(i) * step_e7;
+        epoch.altitude_mm = 40000 + static_cast<int32_t>(i % 100) * 100;
+        epoch.time_ms = static_cast<uint32_t>((12 * 3600000ULL + i * epoch_us / 1000) % 86400000);
+        return epoch;
+    }
+
+    // 合成の測位をepochs回，epoch_usごとに送る受信機のキャプチャを作る
+    SerialCapture synthetic_gnss(std::size_t epochs, uint64_t epoch_us, bool ubx)
+    {
+        SerialCapture capture;
+        for (std::size_t i = 0; i < epochs; ++i)
+        {
+            Epoch epoch = synthetic_epoch(i, epoch_us);
+            capture.add(i * epoch_us, ubx ? ubx_nav_pvt(epoch) : nmea_epoch(epoch));
+        }
+        return capture;
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_SERIAL_CAPTURE_HPP_
+#define SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_SERIAL_CAPTURE_HPP_
+
+// シリアル通信で受信したデータの記録(キャプチャ)を，実際の受信と同じ時間の間隔でシミュレーション上のUARTに流すための道具
+// GNSS受信機のように，測位のたびにまとめて(バースト)送ってくる機器を想定し，バーストごとに送り始める時刻を持つ
+// バーストの中のバイトは，通信速度どおり(1バイトあたり10bit)に続けて届く
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "fake_sdk.hpp"
+
+namespace capture
+{
+    // 送り始める時刻と，続けて届くデータ
+    struct Burst
+    {
+        uint64_t time_us;  // キャプチャの始まりからの時刻 (μs)
+        std::string data;
+    };
+
+    // 1回の測位で送られてくる内容
+    struct Epoch
+    {
+        int32_t latitude_e7;  // 緯度 (°)×10^7
+        int32_t longitude_e7;  // 経度 (°)×10^7
+        int32_t altitude_mm;  // 標高 (mm)
+        uint32_t time_ms;  // 時刻 (UTC)  0時からの経過時間 (ms)
+    };
+
+    class SerialCapture
+    {
+    public:
+        // バーストを追加する  時刻の順に追加すること
+        void add(uint64_t time_us, const std::string& data) {_bursts.push_back(Burst{time_us, data});}
+
+        // NMEAの文を改行で区切って記録したログ(受信機の出力をそのまま保存したもの)を読み込む
+        // 時刻は記録されていないため，epoch_sentence の文が現れるたびに新しいバーストとし，epoch_usずつずらす
+        // path : ログのファイル
+        // [epoch_us] : 測位の間隔 (μs) (省略時:100000 (10Hz))
+        // [epoch_sentence] : 測位ごとに最初に送られる文の種類 (省略時:"RMC")
+        // 戻り値 : 読み込めたか
+        bool load_nmea_log(const char* path, uint64_t epoch_us = 100000, const char* epoch_sentence = "RMC");
+
+        // シミュレーション上のUARTの受信線に，今の時刻を始まりとしてすべてのバーストを流す
+        // バーストが前のバーストの終わりに間に合わない場合は，続けて流す
+        void play(uart_inst_t* uart) const;
+
+        const std::vector<Burst>& bursts() const {return _bursts;}
+
+        // すべてのバーストのバイト数の合計
+        std::size_t bytes() const;
+
+        // すべてのバイトを1つにつなげたもの
+        std::string joined() const;
+
+    private:
+        std::vector<Burst> _bursts;
+    };
+
+    // NMEAの文を作る  $と*の間の内容にチェックサムと改行を付ける
+    std::string nmea_sentence(const std::string& body);
+
+    // 測位の内容から，u-blox受信機の標準の出力と同じ種類と順番の文(RMC, VTG, GGA, GSA, GSV×3, GLL)を作る
+    std::string nmea_epoch(const Epoch& epoch);
+
+    // 測位の内容から，UBXのNAV-PVTメッセージを作る
+    std::string ubx_nav_pvt(const Epoch& epoch);
+
+    // 北東へ進み続ける合成の測位を作る
+    // i : 何回目の測位か
+    // epoch_us : 測位の間隔 (μs)
+    Epoch synthetic_epoch(std::size_t i, uint64_t epoch_us);
+
+    // 合成の測位をepochs回，epoch_usごとに送る受信機のキャプチャを作る
+    // [ubx] : NMEAの代わりにUBXのNAV-PVTを送るか (省略時:false)
+    SerialCapture synthetic_gnss(std::size_t epochs, uint64_t epoch_us, bool ubx = false);
+}
+
+#endif  // SC_PROJECT_RP_PICO_PICO_SDK_SC_TEST_SERIAL_CAPTURE_HPP_
@@ -0,0 +1,127 @@
+// SPIAsyncのテストと転送速度の測定
+// シミュレーション上のSPI(10MHz)とDMAで，複数の区間をCSピンを選択したまま続けて通信できることを確認し，
+// 待機する通信(SPI::read_mem)と比べて，バスの転送速度と，通信している間にCPUが使える時間を測る
+#include <cstdio>
+
+#include "check.hpp"
+#include "fake_sdk.hpp"
+#include "spi_async.hpp"
+
+namespace
+{
+    const uint8_t CSGpio = 17;
+    const uint32_t Freq = 10000000;
+    const std::size_t BurstBytes = 14;  // 加速度と角速度をまとめて読み込む場合のバイト数
+    const std::size_t Transfers = 1000;
+
+    // メモリアドレス(1バイト)の後にBurstBytesバイトを返すデバイス  アドレスは続けて読むと1ずつ進む
+    struct Sensor
+    {
+        uint8_t memory[256];
+        std::size_t index = 0;  // 通信の中の何バイト目か
+        uint8_t addr = 0;
+        uint32_t deselected_bytes = 0;  // CSピンを選択していない間に送受信したバイト数
+    };
+
+    uint8_t sensor_exchange(uint8_t output, void* context)
+    {
+        Sensor& sensor = *static_cast<Sensor*>(context);
+        if (gpio_get(CSGpio)) ++sensor.deselected_bytes;
+        uint8_t input = 0;
+        if (sensor.index == 0) sensor.addr = output & 0x7f;
+        else input = sensor.memory[static_cast<uint8_t>(sensor.addr + sensor.index - 1)];
+        sensor.index = (sensor.index + 1) % (BurstBytes + 1);
+        return input;
+    }
+
+    void print(const char* name, double transfers_per_second, double cpu_free)
+    {
+        std::printf("  %-44s %9.0f transfers/s %6.2f MB/s  CPU free %5.1f%%\n", name, transfers_per_second, transfers_per_second * BurstBytes / 1e6, cpu_free * 100);
+    }
+}
+
+int main()
+{
+    sc::SPI spi(false, sc::Pin(18), sc::Pin(19), sc::Pin(16), {sc::Pin(CSGpio)}, Freq);
+    sc::SPIAsync async(spi);
+    Sensor sensor;
+    for (int i = 0; i < 256; ++i) sensor.memory[i] = static_cast<uint8_t>(i * 7 + 1);
+    fake::set_spi_device(spi0, sensor_exchange, &sensor);
+    const uint8_t command = 0x3b | 0x80;
+
+    // 複数の区間に分けて受信しても，CSピンを選択したままの1回の通信になる
+    {
+        uint8_t accel[6], gyro[8];
+        CHECK(async.wait(async.transfer({{&command, nullptr, 1}, {nullptr, accel, sizeof(accel)}, {nullptr, gyro, sizeof(gyro)}}, CSGpio)));
+        for (int i = 0; i < 6; ++i) CHECK_EQUAL(accel[i], sensor.memory[0x3b + i]);
+        for (int i = 0; i < 8; ++i) CHECK_EQUAL(gyro[i], sensor.memory[0x3b + 6 + i]);
+        CHECK_EQUAL(sensor.deselected_bytes, 0);
+        CHECK(gpio_get(CSGpio));  // 通信が終わるとCSピンの選択を解除する
+    }
+
+    // 送信と受信を同時に行う
+    {
+        uint8_t output[1 + BurstBytes] = {command};
+        uint8_t input[1 + BurstBytes];
+        CHECK(async.wait(async.transfer({{output, input, sizeof(output)}}, CSGpio)));
+        CHECK_EQUAL(input[1], sensor.memory[0x3b]);
+        CHECK_EQUAL(input[BurstBytes], sensor.memory[0x3b + BurstBytes - 1]);
+    }
+
+    std::printf("SPI 10MHz, %u-byte register bursts (simulated bus)\n", static_cast<unsigned>(BurstBytes));
+    const double wire_per_second = Freq / 8.0 / (1 + BurstBytes);  // バスを休まず使った場合の通信回数
+
+    // 以前の実装  通信のたびに10ms待つ
+    uint8_t data[BurstBytes];
+    {
+        uint64_t start_ns = fake::now_ns();
+        for (std::size_t i = 0; i < 100; ++i)
+        {
+            spi.read_mem(0x3b, BurstBytes, data, CSGpio);
+            sleep_ms(10);
+        }
+        print("before: read_mem + sleep_ms(10)", 100 / ((fake::now_ns() - start_ns) / 1e9), 0);
+    }
+
+    // 待機する通信  バスは休まず使えるが，通信している間CPUは待つだけになる
+    double blocking_per_second;
+    {
+        uint64_t start_ns = fake::now_ns();
+        for (std::size_t i = 0; i < Transfers; ++i) spi.read_mem(0x3b, BurstBytes, data, CSGpio);
+        blocking_per_second = Transfers / ((fake::now_ns() - start_ns) / 1e9);
+        print("blocking: SPI::read_mem", blocking_per_second, 0);
+        CHECK_EQUAL(data[BurstBytes - 1], sensor.memory[0x3b + BurstBytes - 1]);
+    }
+
+    // DMAによる通信  予約をいっぱいに保ち，空いている時間はメインループの処理(1μsごとに1回)に使う
+    {
+        static uint8_t buffers[sc::SPIAsync::QueueSize][BurstBytes];
+        uint64_t start_ns = fake::now_ns();
+        uint64_t bytes_start = fake::spi_bytes(spi0);
+        std::size_t submitted = 0;
+        uint64_t work = 0;
+        while (submitted < Transfers || async.pending())
+        {
+            while (submitted < Transfers && !async.is_full())
+            {
+                async.transfer({{&command, nullptr, 1}, {nullptr, buffers[submitted % sc::SPIAsync::QueueSize], BurstBytes}}, CSGpio);
+                ++submitted;
+            }
+            tight_loop_contents();
+            ++work;
+        }
+        uint64_t elapsed_ns = fake::now_ns() - start_ns;
+        double async_per_second = Transfers / (elapsed_ns / 1e9);
+        double cpu_free = work * 1000.0 / elapsed_ns;
+        print("DMA: SPIAsync::transfer, queue kept full", async_per_second, cpu_free);
+
+        CHECK_EQUAL(fake::spi_bytes(spi0) - bytes_start, Transfers * (1 + BurstBytes));
+        CHECK(async_per_second > 0.95 * wire_per_second);  // バスの速度に近い速さで通信できる
+        CHECK(async_per_second > 0.95 * blocking_per_second);
+        CHECK(cpu_free > 0.9);  // 通信している間もCPUはほかの処理に使える
+        CHECK_EQUAL(buffers[0][BurstBytes - 1], sensor.memory[0x3b + BurstBytes - 1]);
+        CHECK_EQUAL(sensor.deselected_bytes, 0);
+    }
+
+    return check::result();
+}
@@ -0,0 +1,80 @@
+// SPI(待機する通信)のCSピンごとの設定のテスト  シミュレーション上のSPI(1MHz)を使う
+// 設定は前回と異なる設定のデバイスと通信するときだけ書き込み，転送速度を省略した設定はセットアップ時の転送速度と同じとみなすことを確認する
+#include "check.hpp"
+#include "fake_sdk.hpp"
+#include "sc.hpp"
+
+namespace
+{
+    const uint32_t Freq = 1000000;
+    const uint8_t DefaultGpio = 17;  // 設定しないデバイス
+    const uint8_t ExplicitGpio = 20;  // セットアップ時の転送速度を明示したデバイス
+    const uint8_t OmittedGpio = 21;  // 転送速度を省略したデバイス
+    const uint8_t FastGpio = 22;  // 別の転送速度とモードのデバイス
+
+    // 前回呼び出してから増えた設定の書き込みの数
+    uint32_t new_setting_writes()
+    {
+        static uint32_t last = 0;
+        uint32_t writes = fake::spi_setting_writes(spi0);
+        uint32_t added = writes - last;
+        last = writes;
+        return added;
+    }
+}
+
+int main()
+{
+    sc::SPI spi(false, sc::Pin(18), sc::Pin(19), sc::Pin(16), {sc::Pin(DefaultGpio), sc::Pin(ExplicitGpio), sc::Pin(OmittedGpio), sc::Pin(FastGpio)}, Freq);
+    spi.set_profile(ExplicitGpio, sc::SPI::MODE_0, Freq);
+    spi.set_profile(OmittedGpio, sc::SPI::MODE_0);
+    spi.set_profile(FastGpio, sc::SPI::MODE_3, 8 * Freq);
+    uint8_t data[4];
+    new_setting_writes();
+
+    // セットアップ時と同じ設定のデバイスは，転送速度を明示しても省略しても，最初の通信から書き込まない
+    {
+        spi.read(data, DefaultGpio);
+        spi.read(data, ExplicitGpio);
+        spi.read(data, OmittedGpio);
+        spi.read_mem(0x00, 4, data, ExplicitGpio);
+        CHECK_EQUAL(new_setting_writes(), 0);
+        CHECK_EQUAL(spi.reconfigurations(), 0);
+        CHECK_EQUAL(spi.reconfigurations_avoided(), 4);
+    }
+
+    // 設定の異なるデバイスに切り替えるときだけ，変わる項目(転送速度とモード)を書き込む
+    {
+        spi.read(data, FastGpio);
+        CHECK_EQUAL(new_setting_writes(), 2);
+        CHECK_EQUAL(spi_get_baudrate(spi0), 8 * Freq);
+        CHECK_EQUAL(fake::spi_mode(spi0), 3);
+        spi.read(data, FastGpio);
+        spi.write(data, FastGpio);
+        CHECK_EQUAL(new_setting_writes(), 0);  // 同じデバイスが続く間は書き込まない
+
+        spi.read(data, ExplicitGpio);
+        CHECK_EQUAL(new_setting_writes(), 2);
+        CHECK_EQUAL(spi_get_baudrate(spi0), Freq);
+        CHECK_EQUAL(fake::spi_mode(spi0), 0);
+        spi.read(data, OmittedGpio);  // 省略した転送速度も同じ設定とみなす
+        spi.read(data, DefaultGpio);
+        CHECK_EQUAL(new_setting_writes(), 0);
+        CHECK_EQUAL(spi.reconfigurations(), 2);
+        CHECK_EQUAL(spi.reconfigurations_avoided(), 4 + 4);
+    }
+
+    // 転送速度だけが違うデバイスへは，転送速度だけを書き込む
+    {
+        spi.set_profile(FastGpio, sc::SPI::MODE_0, 8 * Freq);
+        spi.read(data, FastGpio);
+        CHECK_EQUAL(new_setting_writes(), 1);
+        CHECK_EQUAL(spi_get_baudrate(spi0), 8 * Freq);
+        spi.read(data, OmittedGpio);
+        CHECK_EQUAL(new_setting_writes(), 1);
+        CHECK_EQUAL(spi_get_baudrate(spi0), Freq);
+        CHECK_EQUAL(spi.reconfigurations(), 4);
+    }
+
+    return check::result();
+}
@@ -0,0 +1,196 @@
+// TelemetryEncoderで作ったフレームの大きさと，同じ値をCSVの文字列で送った場合の大きさの比較
+// 合成の降下中のデータ(10Hz, 1回の測定ごとに1フレーム)を使い，キーフレームの間隔ごとに1フレームあたりのバイト数を測る
+// CSVは，sc::Errorのようにstd::to_stringと+で作った文字列(to_string)と，値の分解能に合わせた桁数で書いた文字列(compact)の2通り
+// 同じ精度で比べるためcompactに対する小ささを確かめる  (to_stringは桁を埋めるため大きく，4倍を超えるのは全部の値を送る場合のto_stringに対してだけ)
+// 差分フレームはキーフレームとの差なので，無線でフレームが失われても，読み込めなくなるのはキーフレームが失われた場合だけ
+// 符号化と復号の時間も測るが，パソコンの実際の時刻なので，結果は実行するパソコンによって変わる
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "telemetry.hpp"
+
+namespace
+{
+    const std::size_t Samples = 36000;  // 10Hzで1時間分
+    const double RequiredRatio = 3.0;  // CSV(compact)に対して必要な小ささ
+    const double MaxSkippedRatio = 0.1;  // 10%のフレームが失われたときに，受信できたが読み込めなかったフレームの割合の上限
+
+    // 1回の測定の値
+    struct Sample
+    {
+        uint32_t time_ms;
+        double temperature, pressure, humidity, altitude, latitude, longitude;
+        double acceleration[3], gyro[3], magnetism[3];
+        double direction;
+    };
+
+    // 測定の値の組
+    enum class SampleSet
+    {
+        ENVIRONMENT,  // BME280とGNSS (気温, 気圧, 湿度, 標高, 緯度, 経度)
+        ALL  // ENVIRONMENTに加えて9軸センサと方角
+    };
+
+    // 決まった順番で出てくる乱数  -1〜1
+    double noise(uint32_t& random)
+    {
+        random = random * 1103515245 + 12345;
+        return static_cast<int32_t>(random >> 8 & 0xffff) / 32768.0 - 1.0;
+    }
+
+    // 高度300mからパラシュートで降下する間の測定を作る  (5m/s で降下し，風で北東へ2m/s 流される)
+    std::vector<Sample> descent()
+    {
+        std::vector<Sample> samples(Samples);
+        uint32_t random = 1;
+        for (std::size_t i = 0; i < Samples; ++i)
+        {
+            Sample& s = samples[i];
+            double t = i * 0.1;
+            double altitude = 300.0 - std::fmod(5.0 * t, 300.0);
+            s.time_ms = static_cast<uint32_t>(i * 100);
+            s.altitude = altitude + noise(random) * 0.3;
+            s.pressure = 1013.25 - altitude * 0.12 + noise(random) * 0.02;
+            s.temperature = 20.0 - altitude * 0.0065 + noise(random) * 0.02;
+            s.humidity = 45.0 + noise(random) * 0.05;
+            s.latitude = 35.6812345 + t * 1.3e-5 + noise(random) * 2e-7;
+            s.longitude = 139.7671234 + t * 1.6e-5 + noise(random) * 2e-7;
+            double swing = std::sin(t * 2.0);  // パラシュートの揺れ
+            s.acceleration[0] = swing * 0.3 + noise(random) * 0.05;
+            s.acceleration[1] = swing * 0.2 + noise(random) * 0.05;
+            s.acceleration[2] = 9.81 + noise(random) * 0.05;
+            s.gyro[0] = std::cos(t * 2.0) * 0.2 + noise(random) * 0.01;
+            s.gyro[1] = noise(random) * 0.01;
+            s.gyro[2] = 0.17 + noise(random) * 0.01;  // 約10°/s で回る
+            double heading = std::fmod(t * 10.0, 360.0);
+            s.magnetism[0] = 0.03 * std::cos(heading * 3.14159265 / 180) + noise(random) * 2e-4;
+            s.magnetism[1] = 0.03 * std::sin(heading * 3.14159265 / 180) + noise(random) * 2e-4;
+            s.magnetism[2] = -0.035 + noise(random) * 2e-4;
+            s.direction = heading;
+        }
+        return samples;
+    }
+
+    // 1回の測定を1フレームにする
+    std::size_t encode(sc::TelemetryEncoder& encoder, const Sample& s, SampleSet set, uint8_t* frame)
+    {
+        encoder.begin(s.time_ms);
+        encoder.add(sc::TelemetryType::TEMPERATURE, s.temperature);
+        encoder.add(sc::TelemetryType::PRESSURE, s.pressure);
+        encoder.add(sc::TelemetryType::HUMIDITY, s.humidity);
+        encoder.add(sc::TelemetryType::ALTITUDE, s.altitude);
+        encoder.add(sc::TelemetryType::LATITUDE, s.latitude);
+        encoder.add(sc::TelemetryType::LONGITUDE, s.longitude);
+        if (set == SampleSet::ALL)
+        {
+            encoder.add(sc::TelemetryType::ACCELERATION, s.acceleration[0], s.acceleration[1], s.acceleration[2]);
+            encoder.add(sc::TelemetryType::GYRO, s.gyro[0], s.gyro[1], s.gyro[2]);
+            encoder.add(sc::TelemetryType::MAGNETISM, s.magnetism[0], s.magnetism[1], s.magnetism[2]);
+            encoder.add(sc::TelemetryType::A_DIRECTION, s.direction);
+        }
+        return encoder.end(frame);
+    }
+
+    // sc::Errorと同じように，std::to_stringと+で1行のCSVを作る
+    std::string csv_to_string(const Sample& s, SampleSet set)
+    {
+        std::string line = std::to_string(s.time_ms) + "," + std::to_string(s.temperature) + "," + std::to_string(s.pressure) + "," + std::to_string(s.humidity)
+                         + "," + std::to_string(s.altitude) + "," + std::to_string(s.latitude) + "," + std::to_string(s.longitude);
+        if (set == SampleSet::ALL)
+        {
+            for (double v : s.acceleration) line += "," + std::to_string(v);
+            for (double v : s.gyro) line += "," + std::to_string(v);
+            for (double v : s.magnetism) line += "," + std::to_string(v);
+            line += "," + std::to_string(s.direction);
+        }
+        return line + "\n";
+    }
+
+    // 値の分解能(テレメトリの固定小数点と同じ)に合わせた桁数で，1行のCSVを作る
+    std::string csv_compact(const Sample& s, SampleSet set)
+    {
+        char line[256];
+        int n = std::snprintf(line, sizeof(line), "%u,%.2f,%.2f,%.2f,%.3f,%.7f,%.7f", s.time_ms, s.temperature, s.pressure, s.humidity, s.altitude, s.latitude, s.longitude);
+        if (set == SampleSet::ALL)
+            n += std::snprintf(line + n, sizeof(line) - n, ",%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.6f,%.6f,%.6f,%.2f",
+                               s.acceleration[0], s.acceleration[1], s.acceleration[2], s.gyro[0], s.gyro[1], s.gyro[2],
+                               s.magnetism[0], s.magnetism[1], s.magnetism[2], s.direction);
+        return std::string(line, n) + "\n";
+    }
+
+    // 測定の値の組ごとに，キーフレームの間隔を変えて大きさを比べる
+    // 戻り値 : 初期値の間隔(10)のときの，CSV(compact)に対する小ささ
+    double compare(const std::vector<Sample>& samples, SampleSet set, const char* name)
+    {
+        std::size_t to_string_bytes = 0, compact_bytes = 0;
+        for (const Sample& s : samples)
+        {
+            to_string_bytes += csv_to_string(s, set).size();
+            compact_bytes += csv_compact(s, set).size();
+        }
+        std::printf("%s: CSV to_string %.1f bytes/sample, compact %.1f bytes/sample\n", name, double(to_string_bytes) / samples.size(), double(compact_bytes) / samples.size());
+
+        double default_ratio = 0;
+        const uint16_t Intervals[] = {1, 10, 50};
+        for (uint16_t interval : Intervals)
+        {
+            sc::TelemetryEncoder encoder;
+            sc::TelemetryDecoder decoder;
+            encoder.set_keyframe_interval(interval);
+            std::vector<uint8_t> stream;
+            uint8_t frame[sc::TelemetryEncoder::MaxFrameBytes];
+            auto start = std::chrono::steady_clock::now();
+            for (const Sample& s : samples)
+            {
+                std::size_t frame_bytes = encode(encoder, s, set, frame);
+                stream.insert(stream.end(), frame, frame + frame_bytes);
+            }
+            double encode_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+            for (uint8_t c : stream) decoder.feed(c);
+            double decode_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            CHECK_EQUAL(decoder.frames(), samples.size());
+            CHECK_EQUAL(decoder.errors(), 0);
+
+            // 無作為に10%のフレームが失われた場合に，受信できたが読み込めなくなるフレームの割合
+            sc::TelemetryEncoder lossy_encoder;
+            sc::TelemetryDecoder lossy_decoder;
+            lossy_encoder.set_keyframe_interval(interval);
+            uint32_t random = 7;
+            for (std::size_t i = 0; i < samples.size(); ++i)
+            {
+                std::size_t frame_bytes = encode(lossy_encoder, samples[i], set, frame);
+                random = random * 1103515245 + 12345;
+                if ((random >> 16) % 10 == 0)
+            continue;
+                for (std::size_t j = 0; j < frame_bytes; ++j) lossy_decoder.feed(frame[j]);
+            }
+
+            double bytes = double(stream.size()) / samples.size();
+            double ratio = compact_bytes / double(stream.size());
+            double skipped = double(lossy_decoder.skipped_frames()) / samples.size();
+            std::printf("  keyframe every %2u: %5.1f bytes/frame  %4.2fx smaller than to_string, %4.2fx smaller than compact  encode %5.0f ns, decode %5.0f ns per frame  (10%% loss -> %4.1f%% skipped)\n",
+                        interval, bytes, to_string_bytes / double(stream.size()), ratio, encode_ns / samples.size(), decode_ns / samples.size(), 100.0 * skipped);
+            if (interval == 10)
+            {
+                default_ratio = ratio;
+                CHECK(skipped <= MaxSkippedRatio);
+            }
+        }
+        return default_ratio;
+    }
+}
+
+int main()
+{
+    std::vector<Sample> samples = descent();
+    std::printf("one telemetry frame per 10Hz sample, %u samples\n", static_cast<unsigned>(samples.size()));
+    CHECK(compare(samples, SampleSet::ENVIRONMENT, "temperature, pressure, humidity, altitude, latitude, longitude") >= RequiredRatio);
+    CHECK(compare(samples, SampleSet::ALL, "with acceleration, gyro, magnetism, direction") >= RequiredRatio);
+    return check::result();
+}
@@ -0,0 +1,263 @@
+// TelemetryEncoderとTelemetryDecoderのテスト
+// 途中から受信した場合や壊れたデータを読み飛ばして次のキーフレームから読み込めることと，失われたフレームを正しく数えること，
+// 差分フレームを含めて，送った値がそのまま受信できることを確認する
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "check.hpp"
+#include "telemetry.hpp"
+
+namespace
+{
+    // 符号化した1つのフレーム
+    typedef std::vector<uint8_t> Frame;
+
+    // 気温と気圧を1回分ずつ入れたフレームを作る
+    Frame encode(sc::TelemetryEncoder& encoder, uint32_t time_ms)
+    {
+        uint8_t frame[sc::TelemetryEncoder::MaxFrameBytes];
+        encoder.begin(time_ms);
+        encoder.add(sc::TelemetryType::TEMPERATURE, 20.0 + time_ms / 1000.0);
+        encoder.add(sc::TelemetryType::PRESSURE, 1013.25);
+        return Frame(frame, frame + encoder.end(frame));
+    }
+
+    // フレームを受信させ，正しく読み終えたフレームの数を返す
+    std::size_t feed(sc::TelemetryDecoder& decoder, const Frame& frame)
+    {
+        std::size_t frames = 0;
+        for (uint8_t c : frame) frames += decoder.feed(c);
+        return frames;
+    }
+}
+
+int main()
+{
+    // 途中から受信した場合  最初のフレームは壊れたデータとして捨て，続く差分フレームも読み飛ばして，次のキーフレームから読み込む
+    {
+        sc::TelemetryEncoder encoder;
+        sc::TelemetryDecoder decoder;
+        Frame first = encode(encoder, 1000);
+        feed(decoder, Frame(first.begin() + 3, first.end()));
+        CHECK_EQUAL(decoder.errors(), 1);
+        for (uint32_t i = 1; i < 10; ++i) CHECK_EQUAL(feed(decoder, encode(encoder, 1000 + i * 100)), 0);
+        CHECK_EQUAL(decoder.skipped_frames(), 9);
+        CHECK_EQUAL(feed(decoder, encode(encoder, 2000)), 1);
+        CHECK_EQUAL(decoder.frame().sequence, 10);
+        CHECK(!decoder.frame().delta);
+        CHECK_EQUAL(decoder.frame().time_ms, 2000);
+        CHECK_EQUAL(decoder.frame().records_num, 2);
+        CHECK_EQUAL(decoder.frame().records[0].values[0], 2200);
+        CHECK_EQUAL(decoder.frame().records[1].values[0], 101325);
+        CHECK_EQUAL(decoder.lost_frames(), 0);
+        CHECK_EQUAL(decoder.errors(), 1);
+
+        // 続く差分フレームも読み込める
+        CHECK_EQUAL(feed(decoder, encode(encoder, 2100)), 1);
+        CHECK(decoder.frame().delta);
+        CHECK_EQUAL(decoder.frame().time_ms, 2100);
+        CHECK_EQUAL(decoder.frame().records[0].values[0], 2210);
+    }
+
+    // 1バイト壊れたフレームはCRCで捨て，失われたフレームとして数える  差分フレームはキーフレームとの差なので，続く差分フレームは読み込める
+    {
+        sc::TelemetryEncoder encoder;
+        sc::TelemetryDecoder decoder;
+        feed(decoder, encode(encoder, 0));
+        Frame broken = encode(encoder, 100);
+        broken[broken.size() / 2] ^= 0x10;
+        CHECK_EQUAL(feed(decoder, broken), 0);
+        CHECK_EQUAL(feed(decoder, encode(encoder, 200)), 1);
+        CHECK(decoder.frame().delta);
+        CHECK_EQUAL(decoder.frame().time_ms, 200);
+        CHECK_EQUAL(decoder.frame().records[0].values[0], 2020);
+        CHECK_EQUAL(decoder.frames(), 2);
+        CHECK_EQUAL(decoder.errors(), 1);
+        CHECK_EQUAL(decoder.skipped_frames(), 0);
+        CHECK_EQUAL(decoder.lost_frames(), 1);
+    }
+
+    // キーフレームが失われた場合は，次のキーフレームまで差分フレームを読み込めない
+    {
+        sc::TelemetryEncoder encoder;
+        sc::TelemetryDecoder decoder;
+        for (uint32_t i = 0; i < 10; ++i) feed(decoder, encode(encoder, i * 100));
+        encode(encoder, 1000);  // 2つ目のキーフレームが失われる
+        for (uint32_t i = 11; i < 15; ++i) CHECK_EQUAL(feed(decoder, encode(encoder, i * 100)), 0);  // 1つ目のキーフレームを元にして読み込まない
+        CHECK_EQUAL(decoder.skipped_frames(), 4);
+        CHECK_EQUAL(decoder.lost_frames(), 1);
+
+        // キーフレームを要求すると，すぐに読み込めるようになる
+        encoder.request_keyframe();
+        CHECK_EQUAL(feed(decoder, encode(encoder, 1500)), 1);
+        CHECK(!decoder.frame().delta);
+        CHECK_EQUAL(feed(decoder, encode(encoder, 1600)), 1);
+        CHECK(decoder.frame().delta);
+        CHECK_EQUAL(decoder.frame().records[0].values[0], 2160);
+        CHECK_EQUAL(decoder.lost_frames(), 1);
+    }
+
+    // 差分フレームが多く失われても，キーフレームを受信していれば残りの差分フレームは読み込める
+    {
+        sc::TelemetryEncoder encoder;
+        sc::TelemetryDecoder decoder;
+        std::size_t frames = 0;
+        for (uint32_t i = 0; i < 100; ++i)
+        {
+            Frame frame = encode(encoder, i * 100);
+            if (i % 10 == 0 || i % 3 == 0) frames += feed(decoder, frame);  // キーフレームと，3つに1つの差分フレームだけ受信する
+        }
+        CHECK_EQUAL(frames, 40);
+        CHECK_EQUAL(decoder.skipped_frames(), 0);
+        CHECK_EQUAL(decoder.frame().time_ms, 9900);
+        CHECK_EQUAL(decoder.frame().records[0].values[0], 2990);
+    }
+
+    // 番号が少しだけ飛んだ場合は，飛んだ分を失われたフレームとして数える  番号が一周しても同じ
+    {
+        sc::TelemetryEncoder encoder;
+        sc::TelemetryDecoder decoder;
+        for (uint32_t i = 0; i < 32768 + 10; ++i)
+        {
+            Frame frame = encode(encoder, i);
+            if (i < 32763 || i % 3 == 0) feed(decoder, frame);
+        }
+        CHECK_EQUAL(decoder.lost_frames(), 4 * 2);  // 32763以降は3つに1つだけ受信する  (番号は15ビットなので32768で0に戻る)
+        CHECK_EQUAL(decoder.resyncs(), 0);
+    }
+
+    // 送信側が再起動して番号が0に戻った場合は，失われたフレームとして数えずに数え直す
+    {
+        sc::TelemetryEncoder encoder;
+        sc::TelemetryDecoder decoder;
+        for (uint32_t i = 0; i < 100; ++i) feed(decoder, encode(encoder, i * 100));
+        sc::TelemetryEncoder restarted;
+        CHECK_EQUAL(feed(decoder, encode(restarted, 0)), 1);
+        CHECK_EQUAL(decoder.frame().sequence, 0);
+        CHECK_EQUAL(decoder.lost_frames(), 0);
+        CHECK_EQUAL(decoder.resyncs(), 1);
+
+        // 数え直した後も，番号の飛びは数えられる
+        encode(restarted, 100);
+        feed(decoder, encode(restarted, 200));
+        CHECK_EQUAL(decoder.lost_frames(), 1);
+    }
+
+    // 同じフレームが重複した場合や，順番が入れ替わった場合も数えない
+    {
+        sc::TelemetryEncoder encoder;
+        sc::TelemetryDecoder decoder;
+        Frame frame0 = encode(encoder, 0);
+        Frame frame1 = encode(encoder, 100);
+        Frame frame2 = encode(encoder, 200);
+        feed(decoder, frame0);
+        feed(decoder, frame0);
+        CHECK_EQUAL(decoder.lost_frames(), 0);
+        feed(decoder, frame2);
+        feed(decoder, frame1);
+        CHECK_EQUAL(decoder.lost_frames(), 1);  // frame2を受信した時点では，frame1は失われたように見える
+        CHECK_EQUAL(decoder.resyncs(), 2);
+        CHECK_EQUAL(decoder.frames(), 4);  // 差分フレームはどちらもキーフレームのframe0を元にするので，順番が入れ替わっても読み込める
+        CHECK_EQUAL(decoder.skipped_frames(), 0);
+        CHECK_EQUAL(decoder.frame().time_ms, 100);
+    }
+
+    // 番号が大きく飛んだ場合(長い間受信できなかった場合など)も，失われたフレームの数は分からないので数え直す
+    {
+        sc::TelemetryEncoder encoder;
+        sc::TelemetryDecoder decoder;
+        feed(decoder, encode(encoder, 0));
+        for (uint32_t i = 0; i < sc::TelemetryDecoder::MaxSequenceGap + 1; ++i) encode(encoder, 0);
+        feed(decoder, encode(encoder, 0));
+        CHECK_EQUAL(decoder.lost_frames(), 0);
+        CHECK_EQUAL(decoder.resyncs(), 1);
+    }
+
+    // 差分フレームを含めて，送った値(固定小数点にしたもの)がそのまま受信できる
+    {
+        sc::TelemetryEncoder encoder;
+        sc::TelemetryDecoder decoder;
+        uint32_t random = 12345;
+        double temperature = 20.0, latitude = 35.6812345, x = 0.0;
+        std::size_t frames = 0, delta_frames = 0;
+        bool matched = true;
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            random = random * 1103515245 + 12345;
+            temperature += (static_cast<int>((random >> 16) % 21) - 10) * 0.01;
+            latitude += ((random >> 8) % 101) * 1e-7;
+            x = (i % 250 == 0 ? -x - 1000.0 : x + 0.5);  // 時々大きく変わる値
+
+            uint8_t frame[sc::TelemetryEncoder::MaxFrameBytes];
+            encoder.begin(i * 100);
+            encoder.add(sc::TelemetryType::TEMPERATURE, temperature);
+            encoder.add(sc::TelemetryType::LATITUDE, latitude);
+            encoder.add(sc::TelemetryType::A_POSITION, x, -x, 1.0);
+            std::size_t frame_bytes = encoder.end(frame);
+            for (std::size_t j = 0; j < frame_bytes; ++j)
+                if (decoder.feed(frame[j]))
+                {
+                    const sc::TelemetryFrame& decoded = decoder.frame();
+                    ++frames;
+                    delta_frames += decoded.delta;
+                    matched &= (decoded.sequence == i && decoded.time_ms == i * 100 && decoded.records_num == 3);
+                    matched &= (decoded.records[0].type == sc::TelemetryType::TEMPERATURE && decoded.records[0].values[0] == std::lround(temperature * 1e2));
+                    matched &= (decoded.records[1].type == sc::TelemetryType::LATITUDE && decoded.records[1].values[0] == std::lround(latitude * 1e7));
+                    matched &= (decoded.records[2].values_num == 3 && decoded.records[2].values[0] == std::lround(x * 1e3) && decoded.records[2].values[1] == std::lround(-x * 1e3) && decoded.records[2].values[2] == 1000);
+                }
+        }
+        CHECK(matched);
+        CHECK_EQUAL(frames, 1000);
+        CHECK_EQUAL(delta_frames, 900);  // 10フレームに1回キーフレーム  (値が大きく変わっても，種類を省く分だけ差分フレームの方が短い)
+        CHECK_EQUAL(decoder.errors(), 0);
+    }
+
+    // 記録の種類や数が前のフレームと違う場合はキーフレームになる
+    {
+        sc::TelemetryEncoder encoder;
+        sc::TelemetryDecoder decoder;
+        feed(decoder, encode(encoder, 0));
+        feed(decoder, encode(encoder, 100));
+        CHECK(decoder.frame().delta);
+
+        uint8_t frame[sc::TelemetryEncoder::MaxFrameBytes];
+        encoder.begin(200);
+        encoder.add(sc::TelemetryType::TEMPERATURE, 20.2);
+        encoder.add(sc::TelemetryType::HUMIDITY, 45.0);
+        CHECK_EQUAL(feed(decoder, Frame(frame, frame + encoder.end(frame))), 1);
+        CHECK(!decoder.frame().delta);
+        CHECK_EQUAL(decoder.frame().records[1].type, sc::TelemetryType::HUMIDITY);
+    }
+
+    // キーフレームの間隔を1にすると，差分フレームを使わない
+    {
+        sc::TelemetryEncoder encoder;
+        sc::TelemetryDecoder decoder;
+        encoder.set_keyframe_interval(1);
+        std::size_t delta_frames = 0;
+        for (uint32_t i = 0; i < 20; ++i)
+        {
+            feed(decoder, encode(encoder, i * 100));
+            delta_frames += decoder.frame().delta;
+        }
+        CHECK_EQUAL(decoder.frames(), 20);
+        CHECK_EQUAL(delta_frames, 0);
+    }
+
+    // beginを呼ぶ前は，記録を追加できず，フレームも作らない
+    {
+        sc::TelemetryEncoder encoder;
+        uint8_t frame[sc::TelemetryEncoder::MaxFrameBytes];
+        CHECK(!encoder.add(sc::TelemetryType::TEMPERATURE, 20.0));
+        CHECK_EQUAL(encoder.end(frame), 0);
+        encoder.begin(0);
+        CHECK(encoder.add(sc::TelemetryType::TEMPERATURE, 20.0));
+        CHECK(!encoder.add(sc::TelemetryType::TEMPERATURE, 1.0, 2.0, 3.0));  // 値の数が違う
+        CHECK(encoder.end(frame) > 0);
+        CHECK(!encoder.add(sc::TelemetryType::TEMPERATURE, 20.0));  // endの後も，次のbeginまで追加できない
+        CHECK_EQUAL(encoder.end(frame), 0);
+    }
+
+    return check::result();
+}
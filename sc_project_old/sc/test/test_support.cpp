@@ -0,0 +1,7 @@
+#include "sc.hpp"
+
+namespace sc
+{
+    // ライブラリが使うログの保存先  テストでは標準出力への表示だけにする
+    void save_log(const std::string&) {}
+}
@@ -0,0 +1,110 @@
+// GNSS受信機のキャプチャを実際の間隔で流し，DMAによる受信(UART::set_dma)で受け取るテスト
+// 受信が途切れたときの通知(IdleCallback)でだけメインループが処理を行い，1回の測位(バースト)ごとに1回だけ起きればよいことを確認する
+// 使い方: uart_capture_test [NMEAのログ]  ログを指定した場合は，合成のキャプチャの後にそのログも10Hzで流す
+#include <cstdio>
+
+#include "check.hpp"
+#include "fake_sdk.hpp"
+#include "gnss.hpp"
+#include "serial_capture.hpp"
+
+namespace
+{
+    const uint64_t EpochUs = 100000;  // 10Hz
+    const std::size_t Epochs = 100;
+
+    volatile std::size_t IdleCalls = 0;
+    volatile std::size_t IdleReceivedBytes = 0;
+
+    void on_idle(std::size_t received_bytes)
+    {
+        IdleCalls = IdleCalls + 1;
+        IdleReceivedBytes = received_bytes;
+    }
+
+    // 受信の状況
+    struct Result
+    {
+        std::size_t bytes = 0;  // 読み取ったバイト数
+        std::size_t wakeups = 0;  // メインループが処理を行った回数
+        std::size_t fixes = 0;  // 測位結果を更新した回数
+        bool ordered = true;  // キャプチャと同じ順番で届いたか
+    };
+
+    // キャプチャを流し，通知が来たときにだけ受信バッファを読み取ってNMEAParserに渡す
+    Result play_and_parse(const sc::UART& uart, const capture::SerialCapture& capture, sc::NMEAParser& parser, sc::GNSSFix& fix)
+    {
+        Result result;
+        std::string expected = capture.joined();
+        std::size_t notified = IdleReceivedBytes;
+        capture.play(uart0);
+        uint64_t end_ns = fake::uart_receive_end_ns(uart0) + 5000000;
+        while (fake::now_ns() < end_ns)
+        {
+            sleep_us(100);  // 実機では __wfi() で次の割り込みまで眠る
+            if (IdleReceivedBytes == notified)
+        continue;
+            notified = IdleReceivedBytes;
+            ++result.wakeups;
+
+            uint8_t input[256];
+            std::size_t n;
+            while ((n = uart.read_some(input)) > 0)
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    result.ordered &= (result.bytes < expected.size() && input[i] == static_cast<uint8_t>(expected[result.bytes]));
+                    ++result.bytes;
+                    if (parser.feed(static_cast<char>(input[i]), fix)) ++result.fixes;
+                }
+        }
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    sc::UART uart(false, sc::Pin(0), sc::Pin(1), 115200);
+    uart.set_dma(on_idle);
+    sc::NMEAParser parser;
+    sc::GNSSFix fix;
+
+    // 合成のNMEAのキャプチャ  (1回の測位で8文，約560バイト)
+    capture::SerialCapture nmea = capture::synthetic_gnss(Epochs, EpochUs);
+    Result result = play_and_parse(uart, nmea, parser, fix);
+    std::printf("synthetic NMEA at 10Hz, 115200bps: %u bytes in %u bursts, %u wakeups (%.0f bytes per wakeup), %u sentences, %u errors\n",
+                static_cast<unsigned>(result.bytes), static_cast<unsigned>(nmea.bursts().size()), static_cast<unsigned>(result.wakeups),
+                double(result.bytes) / (result.wakeups ? result.wakeups : 1), static_cast<unsigned>(parser.sentences()), static_cast<unsigned>(parser.errors()));
+
+    CHECK_EQUAL(result.bytes, nmea.bytes());
+    CHECK(result.ordered);
+    CHECK_EQUAL(result.wakeups, Epochs);  // 1回の測位につき1回だけ起きる
+    CHECK_EQUAL(IdleCalls, Epochs);
+    CHECK_EQUAL(result.fixes, 3 * Epochs);  // RMC, VTG, GGA
+    CHECK_EQUAL(parser.errors(), 0);
+    CHECK_EQUAL(uart.dropped_bytes(), 0);
+    CHECK_EQUAL(fake::uart_overruns(uart0), 0);
+
+    capture::Epoch last = capture::synthetic_epoch(Epochs - 1, EpochUs);
+    CHECK(fix.valid);
+    CHECK(fix.latitude_e7 >= last.latitude_e7 - 2 && fix.latitude_e7 <= last.latitude_e7 + 2);
+    CHECK(fix.longitude_e7 >= last.longitude_e7 - 2 && fix.longitude_e7 <= last.longitude_e7 + 2);
+    CHECK_EQUAL(fix.altitude_mm, last.altitude_mm);
+    CHECK_EQUAL(fix.time_ms, last.time_ms);
+
+    // 記録したログ
+    if (argc > 1)
+    {
+        capture::SerialCapture log;
+        if (!CHECK(log.load_nmea_log(argv[1], EpochUs)))
+    return check::result();
+        uint32_t errors = parser.errors();
+        Result log_result = play_and_parse(uart, log, parser, fix);
+        std::printf("%s: %u bytes in %u bursts, %u wakeups, %u fixes, %u checksum errors, %u dropped\n", argv[1],
+                    static_cast<unsigned>(log_result.bytes), static_cast<unsigned>(log.bursts().size()), static_cast<unsigned>(log_result.wakeups),
+                    static_cast<unsigned>(log_result.fixes), static_cast<unsigned>(parser.errors() - errors), static_cast<unsigned>(uart.dropped_bytes()));
+        CHECK_EQUAL(log_result.bytes, log.bytes());
+        CHECK(log_result.ordered);
+    }
+
+    return check::result();
+}
@@ -0,0 +1,102 @@
+// UART::set_dmaのテスト  シミュレーション上のUART(115200bps)とDMAで，受信したデータが欠けずに受信バッファへ届くことと，
+// DMAの転送回数を使い切る前に開始し直して，受信が止まらないことと，受信していない間はタイマーでCPUを起こさないことを確認する
+#include <cstdio>
+
+#include "check.hpp"
+#include "fake_sdk.hpp"
+#include "sc.hpp"
+
+namespace
+{
+    std::size_t IdleCalls = 0;
+    std::size_t IdleReceivedBytes = 0;
+
+    void on_idle(std::size_t received_bytes)
+    {
+        ++IdleCalls;
+        IdleReceivedBytes = received_bytes;
+    }
+
+    uint8_t pattern(std::size_t i) {return static_cast<uint8_t>(i * 31 + (i >> 8));}
+
+    // bytesバイトを流し，受信し終えるまで500μsごとに読み取って，順番どおりに届いたかを返す
+    bool receive_and_check(const sc::UART& uart, std::size_t offset, std::size_t bytes)
+    {
+        static uint8_t data[8192];
+        for (std::size_t i = 0; i < bytes; ++i) data[i] = pattern(offset + i);
+        fake::uart_receive(uart0, data, bytes);
+
+        bool ok = true;
+        std::size_t received = 0;
+        while (received < bytes)
+        {
+            if (fake::now_ns() > fake::uart_receive_end_ns(uart0) + 10000000) break;  // 届かないデータがある
+            sleep_us(500);
+            uint8_t input[256];
+            std::size_t n = uart.read_some(input);
+            for (std::size_t i = 0; i < n; ++i) ok &= (input[i] == pattern(offset + received + i));
+            received += n;
+        }
+        return ok && received == bytes;
+    }
+}
+
+int main()
+{
+    sc::UART uart(false, sc::Pin(0), sc::Pin(1), 115200);
+    uart.set_dma(on_idle);
+    int channel = fake::dma_active_channel(DREQ_UART0_RX);
+    CHECK(channel >= 0);
+
+    // 受信したデータが順番どおりに届き，受信が途切れると受信済みのバイト数が知らされる
+    CHECK(receive_and_check(uart, 0, 5000));
+    sleep_ms(5);
+    CHECK(IdleCalls >= 1);
+    CHECK_EQUAL(IdleReceivedBytes, 5000);
+    CHECK_EQUAL(uart.dropped_bytes(), 0);
+
+    // 約2^32バイト受信した後の状態にするため，DMAの残りの転送回数を直接減らす  (受信バッファの大きさの倍数だけ減らし，書き込み先の位置とそろえる)
+    // 受信位置はその分だけ進むので，飛ばした分は読み取る前に上書きされたデータとして捨てる
+    uint32_t remaining = dma_channel_hw_addr(channel)->transfer_count % sc::UART::RxBufferSize + sc::UART::RxBufferSize;
+    dma_channel_hw_addr(channel)->transfer_count = remaining;
+    uint8_t skipped[sc::UART::RxBufferSize];
+    while (uart.available()) uart.read_some(skipped);
+    uint32_t dropped = uart.dropped_bytes();
+
+    // 残りの転送回数(2048バイト未満)より多くのデータを受信しても，DMAを開始し直して受信を続ける
+    CHECK(receive_and_check(uart, 5000, 3000));
+    CHECK(receive_and_check(uart, 8000, 3000));
+    CHECK_EQUAL(uart.dropped_bytes(), dropped);
+    CHECK_EQUAL(fake::uart_overruns(uart0), 0);
+    CHECK_EQUAL(fake::dma_active_channel(DREQ_UART0_RX), channel);
+    CHECK(dma_channel_hw_addr(channel)->transfer_count > 0x80000000);
+
+    // 受信していない間は確認のタイマーを止めているので，CPUを起こさない
+    sleep_ms(5);
+    uint32_t timer_wakes = fake::irq_count(TIMER_IRQ_0);
+    uint32_t uart_wakes = fake::irq_count(UART0_IRQ);
+    sleep_ms(100);
+    CHECK_EQUAL(fake::irq_count(TIMER_IRQ_0), timer_wakes);
+    CHECK_EQUAL(fake::irq_count(UART0_IRQ), uart_wakes);
+
+    // 受信し始めたときに1回だけ割り込みが発生し，受信している間(1000バイトで約87ms)だけ1msごとに確認する
+    std::size_t idle_calls = IdleCalls;
+    CHECK(receive_and_check(uart, 11000, 1000));
+    sleep_ms(5);
+    CHECK_EQUAL(fake::irq_count(UART0_IRQ), uart_wakes + 1);
+    uint32_t burst_wakes = fake::irq_count(TIMER_IRQ_0) - timer_wakes;
+    CHECK(burst_wakes >= 87 && burst_wakes <= 90);
+    CHECK_EQUAL(IdleCalls, idle_calls + 1);
+
+    // 割り込みの基準(4バイト)より短いデータも，受信が途切れたときの割り込みで受信し始め，途切れたことが知らされる
+    std::size_t received_bytes = IdleReceivedBytes;
+    CHECK(receive_and_check(uart, 12000, 3));
+    sleep_ms(5);
+    CHECK_EQUAL(IdleCalls, idle_calls + 2);
+    CHECK_EQUAL(IdleReceivedBytes, received_bytes + 3);
+    CHECK_EQUAL(fake::irq_count(UART0_IRQ), uart_wakes + 2);
+    CHECK_EQUAL(uart.dropped_bytes(), dropped);
+    CHECK_EQUAL(fake::uart_overruns(uart0), 0);
+
+    return check::result();
+}
@@ -0,0 +1,76 @@
+// UART::set_irqのテスト  シミュレーション上のUART(115200bps)で，受信したデータが割り込み処理で受信バッファへ届くことと，
+// 割り込みがFIFOの量と受信が途切れたときにだけ発生すること，受信バッファがいっぱいのときは新しいデータを捨てることを確認する
+#include "check.hpp"
+#include "fake_sdk.hpp"
+#include "sc.hpp"
+
+namespace
+{
+    uint8_t pattern(std::size_t i) {return static_cast<uint8_t>(i * 13 + (i >> 8));}
+
+    // offsetからbytesバイトを流し，届き終えて受信が途切れたとみなされるまで待つ
+    void receive(std::size_t offset, std::size_t bytes)
+    {
+        static uint8_t data[4096];
+        for (std::size_t i = 0; i < bytes; ++i) data[i] = pattern(offset + i);
+        fake::uart_receive(uart0, data, bytes);
+        fake::run_for_us((fake::uart_receive_end_ns(uart0) - fake::now_ns()) / 1000 + 1000);
+    }
+
+    // 受信バッファからbytesバイト読み取り，offsetから順番どおりかを返す
+    bool read_and_check(const sc::UART& uart, std::size_t offset, std::size_t bytes)
+    {
+        bool ok = true;
+        std::size_t read_bytes = 0;
+        while (read_bytes < bytes)
+        {
+            uint8_t input[256];
+            std::size_t n = uart.read_some(input);
+            if (!n)
+        break;
+            for (std::size_t i = 0; i < n; ++i) ok &= (input[i] == pattern(offset + read_bytes + i));
+            read_bytes += n;
+        }
+        return ok && read_bytes == bytes;
+    }
+}
+
+int main()
+{
+    sc::UART uart(false, sc::Pin(0), sc::Pin(1), 115200);
+    uart.set_irq();
+
+    // 1バイトごとではなく，FIFOが半分(16バイト)たまったときと，受信が途切れたときにだけ割り込みが発生する
+    {
+        uint32_t irqs = fake::irq_count(UART0_IRQ);
+        receive(0, 100);
+        CHECK_EQUAL(uart.available(), 100);
+        CHECK(fake::irq_count(UART0_IRQ) - irqs <= 100 / 16 + 1);
+        CHECK(read_and_check(uart, 0, 100));
+        CHECK_EQUAL(uart.available(), 0);
+        CHECK_EQUAL(uart.dropped_bytes(), 0);
+    }
+
+    // 受信バッファの終わりをまたいでも順番どおりに読み取れる
+    {
+        receive(100, 1000);
+        CHECK(read_and_check(uart, 100, 1000));
+    }
+
+    // 受信バッファがいっぱいになったら，読み取っていない古いデータを残し，新しく受信したデータを捨てる
+    {
+        receive(1100, sc::UART::RxBufferSize + 100);
+        CHECK_EQUAL(uart.available(), sc::UART::RxBufferSize);
+        CHECK_EQUAL(uart.dropped_bytes(), 100);
+        CHECK_EQUAL(fake::uart_overruns(uart0), 0);  // FIFOはあふれていない
+        CHECK(read_and_check(uart, 1100, sc::UART::RxBufferSize));
+
+        // 空いた後に受信したデータは，捨てた分を飛ばして続けて読み取れる
+        receive(1100 + sc::UART::RxBufferSize + 100, 50);
+        CHECK_EQUAL(uart.available(), 50);
+        CHECK(read_and_check(uart, 1100 + sc::UART::RxBufferSize + 100, 50));
+        CHECK_EQUAL(uart.dropped_bytes(), 100);
+    }
+
+    return check::result();
+}
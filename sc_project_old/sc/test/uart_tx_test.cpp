@@ -0,0 +1,115 @@
+// UART::set_tx_irqのテスト  シミュレーション上のUART(115200bps)で，writeが送信バッファにコピーしてすぐに戻り，
+// 割り込み処理で順番どおりに送信することと，送信バッファがいっぱいのときのBLOCK/DROPの動作を確認する
+#include <vector>
+
+#include "check.hpp"
+#include "fake_sdk.hpp"
+#include "sc.hpp"
+
+namespace
+{
+    const uint64_t ByteNs = 10000000000ULL / 115200;  // 1バイト(10bit)を送る時間
+
+    std::vector<uint8_t> Expected;  // これまでに送信したはずのデータ
+    const sc::UART* TimerUart = nullptr;
+
+    uint8_t pattern(std::size_t i) {return static_cast<uint8_t>(i * 7 + (i >> 8));}
+
+    // Expectedに続くbytesバイトを書き込む  accepted がfalseの場合は捨てられるはずなので，Expectedに加えない
+    void write_next(const sc::UART& uart, std::size_t bytes, bool accepted = true)
+    {
+        static uint8_t data[4096];
+        std::size_t offset = Expected.size();
+        for (std::size_t i = 0; i < bytes; ++i) data[i] = pattern(offset + i);
+        uart.write(bytes, data);
+        if (accepted) Expected.insert(Expected.end(), data, data + bytes);
+    }
+
+    // 割り込み処理の中から，送信バッファに収まらない大きさを書き込む
+    bool write_from_irq(repeating_timer_t*)
+    {
+        write_next(*TimerUart, 10, false);
+        return false;
+    }
+}
+
+int main()
+{
+    sc::UART uart(false, sc::Pin(0), sc::Pin(1), 115200);
+    uart.set_tx_irq();
+
+    // writeは待たずに戻り，FIFOに入りきらない分は割り込み処理で少しずつFIFOに移す
+    {
+        uint64_t start_ns = fake::now_ns();
+        write_next(uart, 100);
+        CHECK_EQUAL(fake::now_ns(), start_ns);
+        CHECK_EQUAL(uart.tx_pending(), 100 - 33);  // 1バイトは送り始め，32バイトはFIFOへ
+        uint32_t irqs = fake::irq_count(UART0_IRQ);
+        uart.flush();
+        CHECK(fake::uart_sent(uart0) == Expected);
+        CHECK(fake::now_ns() - start_ns >= 100 * ByteNs);
+        CHECK(fake::irq_count(UART0_IRQ) - irqs <= 6);  // FIFOが半分以下になるたびに16バイトずつ移す
+        CHECK_EQUAL(uart.tx_high_water(), 100);
+    }
+
+    // 送信バッファの終わりをまたぐデータも，折り返して順番どおりに送信する
+    {
+        write_next(uart, 1000);  // 送信バッファの100〜1099バイト目  1024バイト目で先頭に戻る
+        CHECK_EQUAL(uart.tx_pending(), 1000 - 33);
+        uart.flush();
+        CHECK(fake::uart_sent(uart0) == Expected);
+        CHECK_EQUAL(uart.tx_high_water(), 1000);
+    }
+
+    // BLOCK: 送信バッファより大きいデータは，空くのを待ちながら書き込む
+    {
+        uint64_t start_ns = fake::now_ns();
+        write_next(uart, 3000);
+        uint64_t waited_bytes = (fake::now_ns() - start_ns) / ByteNs;
+        CHECK(waited_bytes >= 3000 - 1024 - 33 && waited_bytes <= 3000 - 1024 - 16);  // FIFOが半分以下になるたびに移すので，FIFOに残っている量だけずれる
+        CHECK_EQUAL(uart.tx_high_water(), 1024);
+        uart.flush();
+        CHECK(fake::uart_sent(uart0) == Expected);
+        CHECK_EQUAL(uart.tx_dropped_bytes(), 0);
+    }
+
+    // BLOCKでも，割り込み処理の中や割り込みを禁止した状態では待たずに捨てる  (待つと送信の割り込みが発生せず止まってしまう)
+    {
+        write_next(uart, 1024 + 33);  // 送信バッファとFIFOをいっぱいにする
+        CHECK_EQUAL(uart.tx_pending(), 1024);
+
+        TimerUart = &uart;
+        repeating_timer_t timer;
+        add_repeating_timer_us(1, write_from_irq, nullptr, &timer);
+        sleep_us(2);
+        CHECK_EQUAL(uart.tx_dropped_bytes(), 10);
+
+        uint64_t start_ns = fake::now_ns();
+        uint32_t status = save_and_disable_interrupts();
+        write_next(uart, 10, false);
+        restore_interrupts(status);
+        CHECK_EQUAL(fake::now_ns(), start_ns);
+        CHECK_EQUAL(uart.tx_dropped_bytes(), 20);
+
+        uart.flush();
+        CHECK(fake::uart_sent(uart0) == Expected);
+    }
+
+    // DROP: 送信バッファに収まらないデータは，一部も送らずにまとめて捨てる
+    {
+        uart.set_tx_irq(sc::UART::TxFullPolicy::DROP);
+        write_next(uart, 1000);  // 33バイトは送り始めるかFIFOへ，967バイトは送信バッファへ
+        uint64_t start_ns = fake::now_ns();
+        write_next(uart, 100, false);  // 残りの57バイトには収まらない
+        CHECK_EQUAL(fake::now_ns(), start_ns);
+        CHECK_EQUAL(uart.tx_dropped_bytes(), 20 + 100);
+        write_next(uart, 57);  // ちょうど収まる
+        CHECK_EQUAL(uart.tx_pending(), 1024);
+        CHECK_EQUAL(uart.tx_dropped_bytes(), 20 + 100);
+        uart.flush();
+        CHECK(fake::uart_sent(uart0) == Expected);
+        CHECK_EQUAL(uart.tx_pending(), 0);
+    }
+
+    return check::result();
+}